@@ -3,6 +3,7 @@
 FULLBUILD=false
 NONINTERACTIVE=false
 BUILD_TYPE='Release'
+BUILD_BENCHMARKS='OFF'
 LIBTINS_VERSION=0
 
 while test $# -gt 0
@@ -17,6 +18,9 @@ do
         --debug)
             BUILD_TYPE='Debug'
             ;;
+        --benchmarks)
+            BUILD_BENCHMARKS='ON'
+            ;;
     esac
     shift
 done
@@ -62,7 +66,7 @@ else
     exit
 fi
 
-CMAKE_ARGS="-D CMAKE_BUILD_TYPE="${BUILD_TYPE}" -D LIBTINS_VERSION="${LIBTINS_VERSION}
+CMAKE_ARGS="-D CMAKE_BUILD_TYPE="${BUILD_TYPE}" -D LIBTINS_VERSION="${LIBTINS_VERSION}" -D BUILD_BENCHMARKS="${BUILD_BENCHMARKS}
 
 which ninja &>/dev/null
 if [ $? != 0 ]; then
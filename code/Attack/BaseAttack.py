@@ -13,7 +13,6 @@ import time
 import collections
 import typing as t
 
-import Lib.libpcapreader as pr
 import lea
 import numpy as np
 import scapy.layers.inet as inet
@@ -130,7 +129,7 @@ class BaseAttack(metaclass=abc.ABCMeta):
         packet = self.get_param_value(self.INJECT_AFTER_PACKET)
 
         if timestamp is None:
-            ts = pr.pcap_processor(self.statistics.pcap_filepath, "False", Util.RESOURCE_DIR, "").get_timestamp_mu_sec(int(packet))
+            ts = self.statistics.get_packet_timestamps([int(packet)])[int(packet)]
             timestamp = (ts / 1000000)
             self.add_param_value(self.INJECT_AT_TIMESTAMP, timestamp)
 
@@ -39,7 +39,8 @@ class CLI(object):
         required_args_group = required_group.add_mutually_exclusive_group(required=True)
 
         required_args_group.add_argument('-i', '--input', metavar="PCAP_FILE",
-                                         help='path to the input pcap file')
+                                         help='path to the input pcap file or a quoted glob pattern like "capture_*.pcap" '
+                                              'selecting rotated pcap files, which are read as one timeline')
         required_args_group.add_argument('-l', '--list-attacks', action='store_true')
 
         # Optional arguments
@@ -91,6 +92,13 @@ class CLI(object):
                                  'does not recalculate old interval statistics, but keeps them.'
                                  'surpresses (yes, no, delete) prompt.', action='store_true',
                             default=False)
+        parser.add_argument('-inc', '--incremental', action='store_true', default=False,
+                            help='keeps the statistics state of the input pcap file, so that the statistics of a pcap '
+                                 'file which is appended to are updated by processing only the appended packets.')
+        parser.add_argument('-ms', '--merge-statistics', action='store_true', default=False,
+                            help='writes the statistics of the output pcap file by merging the statistics of the '
+                                 'injected packets into a snapshot of the input pcap file statistics, instead of '
+                                 'processing the whole output pcap file.')
         parser.add_argument('-li', '--list-intervals', action='store_true',
                             help='prints all interval statistics tables available in the database')
         parser.add_argument('--skip', action='store_true', help='skips every initialization right to query mode\n'
@@ -183,7 +191,8 @@ class CLI(object):
                 self.args.recalculate = True
             controller.load_pcap_statistics(self.args.export, self.args.recalculate, self.args.statistics,
                                             self.args.statistics_interval, self.args.recalculate_delete,
-                                            recalculate_intervals)
+                                            recalculate_intervals, self.args.incremental,
+                                            self.args.merge_statistics)
 
             if self.args.list_intervals:
                 controller.list_interval_statistics()
@@ -202,7 +211,8 @@ class CLI(object):
             # Process attack(s) with given attack params
             if self.args.attack is not None:
                 # If attack is present, load attack with params
-                controller.process_attacks(self.args.attack, self.args.rngSeed, self.args.time, self.args.inject_empty)
+                controller.process_attacks(self.args.attack, self.args.rngSeed, self.args.time, self.args.inject_empty,
+                                           self.args.merge_statistics)
 
         # Parameter -q without arguments was given -> go into query loop
         if self.args.query == [None]:
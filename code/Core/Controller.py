@@ -6,6 +6,7 @@ import time
 import re
 
 import pyparsing as pp
+import Attack.BaseAttack as BaseAttack
 import Core.AttackController as atkCtrl
 import Core.LabelManager as LabelManager
 import Core.Statistics as Statistics
@@ -58,7 +59,8 @@ class Controller:
         self.statistics.list_previous_interval_statistic_tables()
 
     def load_pcap_statistics(self, flag_write_file: bool, flag_recalculate_stats: bool, flag_print_statistics: bool,
-                             intervals, delete: bool=False, recalculate_intervals: bool=None):
+                             intervals, delete: bool=False, recalculate_intervals: bool=None, incremental: bool=False,
+                             snapshot: bool=False):
         """
         Loads the PCAP statistics either from the database, if the statistics were calculated earlier, or calculates
         the statistics and creates a new database.
@@ -69,13 +71,17 @@ class Controller:
         :param intervals: user specified interval in seconds
         :param delete: Delete old interval statistics.
         :param recalculate_intervals: Recalculate old interval statistics or not. Prompt user if None.
+        :param incremental: Only process the packets appended to the PCAP since the last incremental run.
+        :param snapshot: Keep a snapshot of the statistics, from which the statistics of the output PCAP are derived.
         :return: None
         """
         self.statistics.load_pcap_statistics(flag_write_file, flag_recalculate_stats, flag_print_statistics,
                                              self.non_verbose, intervals=intervals, delete=delete,
-                                             recalculate_intervals=recalculate_intervals)
+                                             recalculate_intervals=recalculate_intervals, incremental=incremental,
+                                             snapshot=snapshot)
 
-    def process_attacks(self, attacks_config: list, seeds=None, measure_time: bool=False, inject_empty: bool=False):
+    def process_attacks(self, attacks_config: list, seeds=None, measure_time: bool=False, inject_empty: bool=False,
+                        merge_statistics: bool=False):
         """
         Creates the attack based on the attack name and the attack parameters given in the attacks_config. The
         attacks_config is a list of attacks.
@@ -87,8 +93,20 @@ class Controller:
         :param seeds: A list of random seeds for the given attacks.
         :param measure_time: Measure time for packet generation.
         :param inject_empty: if flag is set, Attack PCAPs will not be merged with the base PCAP, ie. Attacks are injected into an empty PCAP
+        :param merge_statistics: Write the statistics of the output PCAP by merging the statistics of the attack PCAP
+        into the statistics snapshot of the base PCAP.
         """
 
+        # look up the timestamps of all attacks injected after a given packet with a single pass over the PCAP
+        after_packets = []
+        for attack in attacks_config:
+            for param in attack[1:]:
+                key, _, value = param.partition('=')
+                if key == BaseAttack.BaseAttack.INJECT_AFTER_PACKET and value.isdigit():
+                    after_packets.append(int(value))
+        if after_packets:
+            self.statistics.get_packet_timestamps(after_packets)
+
         # load attacks sequentially
         i = 0
         for attack in attacks_config:
@@ -139,8 +157,12 @@ class Controller:
                 self.pcap_dest_path = self.pcap_file.merge_attack(attacks_pcap_path)
 
             if self.pcap_out_path:
-                if not self.pcap_out_path.endswith(".pcap"):
-                    self.pcap_out_path += ".pcap"
+                # merged PCAPs keep the compression of the base PCAP
+                compression_ext = next((ext for ext in [".gz", ".xz", ".zst"] if self.pcap_dest_path.endswith(ext)), "")
+                if not self.pcap_out_path.endswith(".pcap" + compression_ext):
+                    if not self.pcap_out_path.endswith(".pcap"):
+                        self.pcap_out_path += ".pcap"
+                    self.pcap_out_path += compression_ext
                 result_path = self.pcap_out_path
             else:
                 tmp_path_tuple = self.pcap_dest_path.rpartition("/")
@@ -159,6 +181,15 @@ class Controller:
 
             print("done.")
 
+            # derive the statistics of the output PCAP from the base statistics, only the attack PCAP is processed
+            if merge_statistics and not inject_empty:
+                print("Merging statistics of the attack pcap into the base pcap statistics...", end=" ")
+                sys.stdout.flush()  # force python to print text immediately
+                if self.statistics.write_injected_statistics(attacks_pcap_path, self.pcap_dest_path):
+                    print("done.")
+                else:
+                    print("failed, there is no statistics snapshot of the base pcap.")
+
             # delete intermediate PCAP files
             if self.debug:
                 print('NOT deleting intermediate attack pcap while in debug mode.')
@@ -33,17 +33,24 @@ class Statistics(object):
         # Fields
         self.pcap_filepath = None
         self.path_db = None
+        self.path_state = None
+        self.path_state_db = None
+        self.path_snapshot = None
         self.do_extra_tests = False
         self.file_info = None
         self.kbyte_rate = {"local": None, "public": None}
         self.interval_stat = {}
         self.interval_len = None
+        self.packet_timestamps = {}
 
         if pcap_file:
             self.pcap_filepath = pcap_file.pcap_file_path
 
             # Create folder for statistics database if required
             self.path_db = pcap_file.get_db_path()
+            self.path_state = pcap_file.get_state_path()
+            self.path_state_db = os.path.splitext(self.path_state)[0] + ".db_path"
+            self.path_snapshot = os.path.splitext(self.path_db)[0] + ".snapshot"
 
             # Class instances
             self.stats_db = self.create_stats_db(self.path_db)
@@ -56,6 +63,24 @@ class Statistics(object):
             os.makedirs(path_dir)
         return statsDB.StatsDatabase(path_db)
 
+    def move_incremental_db(self, stats_db: statsDB.StatsDatabase) -> bool:
+        """
+        Moves the statistics database of the previous incremental run to the path of stats_db. The database path depends
+        on the file size, so the PCAP grown since the previous run gets a new one, which would leave the database of
+        every previous run behind.
+
+        :param stats_db: the statistics database of the grown PCAP, which does not exist yet
+        :return: True if the database of the previous incremental run was moved
+        """
+        if not self.path_state_db or not os.path.exists(self.path_state_db):
+            return False
+        with open(self.path_state_db) as f:
+            previous_db_path = f.read()
+        if previous_db_path == stats_db.db_path or not os.path.exists(previous_db_path):
+            return False
+        stats_db.move_database(previous_db_path)
+        return True
+
     def list_previous_interval_statistic_tables(self, output: bool=True):
         """
         Prints a list of all interval statistic tables from the database.
@@ -106,7 +131,8 @@ class Statistics(object):
     def load_pcap_statistics(self, flag_write_file: bool, flag_recalculate_stats: bool, flag_print_statistics: bool,
                              flag_non_verbose: bool, intervals, delete: bool = False,
                              recalculate_intervals: bool = None, extra_tests: bool = None, pcap_filepath: str = None,
-                             path_db: str = None, stats_db: statsDB.StatsDatabase = None):
+                             path_db: str = None, stats_db: statsDB.StatsDatabase = None, incremental: bool = False,
+                             snapshot: bool = False):
         """
         Loads the PCAP statistics for the file specified by pcap_filepath. If the database is not existing yet, the
         statistics are calculated by the PCAP file processor and saved into the newly created database. Otherwise the
@@ -124,6 +150,10 @@ class Statistics(object):
         :param pcap_filepath:
         :param path_db:
         :param stats_db:
+        :param incremental: Only process the packets appended to the PCAP since the last incremental run, whose
+        statistics state is kept at path_state and whose database is moved to path_db
+        :param snapshot: Keep a snapshot of the statistics at path_snapshot, from which write_injected_statistics derives
+        the statistics of a PCAP with injected packets
         """
         # Load pcap and get loading time
         time_start = time.perf_counter()
@@ -153,15 +183,22 @@ class Statistics(object):
 
         # Recalculate statistics if database does not exist OR param -r/--recalculate is provided
         # FIXME: probably wanna add a "calculate only extra tests" case in the future
-        if (not stats_db.get_db_exists()) or flag_recalculate_stats or stats_db.get_db_outdated():
+        missing_snapshot = snapshot and self.path_snapshot and not os.path.exists(self.path_snapshot)
+        if (not stats_db.get_db_exists()) or flag_recalculate_stats or stats_db.get_db_outdated() or missing_snapshot:
+            moved_db = incremental and not stats_db.get_db_exists() and self.move_incremental_db(stats_db)
+
             # Get interval statistics tables which already exist
             previous_intervals = self.list_previous_interval_statistic_tables()
 
             pcap_proc = pr.pcap_processor(pcap_filepath, str(extra_tests), Util.RESOURCE_DIR, path_db)
+            if incremental and self.path_state:
+                os.makedirs(os.path.dirname(self.path_state), exist_ok=True)
+                pcap_proc.set_incremental(self.path_state)
 
             recalc_intervals = None
             if previous_intervals:
-                if delete:
+                # The tables of the intervals of the previous incremental run are replaced with the appended packets
+                if delete or moved_db:
                     recalc_intervals = False
                 else:
                     recalc_intervals = recalculate_intervals
@@ -191,6 +228,11 @@ class Statistics(object):
 
             pcap_proc.collect_statistics(intervals)
             pcap_proc.write_to_database(path_db, intervals, delete)
+            if incremental and self.path_state_db:
+                with open(self.path_state_db, 'w') as f:
+                    f.write(path_db)
+            if snapshot and self.path_snapshot:
+                pcap_proc.write_snapshot(self.path_snapshot)
             outstring_datasource = "by PCAP file processor."
 
             # only print summary of new db if -s flag not set
@@ -232,6 +274,33 @@ class Statistics(object):
         if flag_print_statistics:
             self.print_statistics()
 
+    def write_injected_statistics(self, attack_pcap_path: str, pcap_filepath: str) -> bool:
+        """
+        Writes the statistics database of a PCAP into which the packets of attack_pcap_path were injected, without
+        processing the whole PCAP: only the injected packets are processed and merged into the snapshot of the
+        statistics of the loaded PCAP. The interval statistics are approximated, the injected packets are added to the
+        packet counts of the intervals containing them, but not to their entropy and novelty values.
+
+        :param attack_pcap_path: path to the PCAP containing only the injected packets
+        :param pcap_filepath: path to the PCAP containing the packets of the loaded PCAP and the injected packets
+        :return: False if there is no snapshot of the statistics of the loaded PCAP
+        """
+        if not self.path_snapshot or not os.path.exists(self.path_snapshot):
+            return False
+        intervals = self.list_previous_interval_statistic_tables(output=False) or [0.0]
+
+        path_db = PcapFile.PcapFile(pcap_filepath).get_db_path()
+        os.makedirs(os.path.dirname(path_db), exist_ok=True)
+        pcap_proc = pr.pcap_processor(pcap_filepath, str(self.do_extra_tests), Util.RESOURCE_DIR, path_db)
+        if not pcap_proc.load_snapshot(self.path_snapshot):
+            return False
+
+        attack_proc = pr.pcap_processor(attack_pcap_path, str(self.do_extra_tests), Util.RESOURCE_DIR, "")
+        attack_proc.collect_statistics([min(intervals)])
+        pcap_proc.merge_statistics(attack_proc)
+        pcap_proc.write_to_database(path_db, intervals, True)
+        return True
+
     def get_file_information(self):
         """
         Returns a list of tuples, each containing a information of the file.
@@ -845,6 +914,20 @@ class Statistics(object):
         """
         return self.file_info['packetCount']
 
+    def get_packet_timestamps(self, packets: list):
+        """
+        Determines the timestamps of several packets of the loaded PCAP file with a single pass over the file.
+        The timestamps are cached, so that packets which were already looked up do not cause another pass.
+
+        :param packets: The packet numbers, starting with 1
+        :return: dict of packet number and timestamp in microseconds plus 1 microsecond, -1 if there is no such packet
+        """
+        missing = sorted({packet for packet in packets if packet not in self.packet_timestamps})
+        if missing:
+            pcap_proc = pr.pcap_processor(self.pcap_filepath, "False", Util.RESOURCE_DIR, self.path_db or "")
+            self.packet_timestamps.update(zip(missing, pcap_proc.get_timestamps_mu_sec(missing)))
+        return {packet: self.packet_timestamps[packet] for packet in packets}
+
     def get_rnd_packet_index(self, divisor: int=1):
         """
         Calculates a random packet index. Either over all packets or the first part of the packets.
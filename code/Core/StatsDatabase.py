@@ -36,6 +36,7 @@ class StatsDatabase:
         """
         self.query_parser = qp.QueryParser()
 
+        self.db_path = db_path
         self.existing_db = os.path.exists(db_path)
         self.database = sqlite3.connect(db_path)
         self.cursor = self.database.cursor()
@@ -69,6 +70,17 @@ class StatsDatabase:
         return [r for r in dict_gen(
             self.cursor.execute('SELECT * FROM file_statistics'))][0]
 
+    def move_database(self, previous_db_path: str):
+        """
+        Replaces the database by the database file at previous_db_path, which is moved to the path of this database.
+
+        :param previous_db_path: The path to the database file to move
+        """
+        self.database.close()
+        os.replace(previous_db_path, self.db_path)
+        self.database = sqlite3.connect(self.db_path)
+        self.cursor = self.database.cursor()
+
     def get_db_exists(self):
         """
         :return: True if the database was already existent, otherwise False
@@ -1,3 +1,4 @@
+import glob
 import hashlib
 import os.path
 
@@ -25,6 +26,19 @@ class PcapFile(object):
         file_out_path = pcap.merge_pcaps(attack_pcap_path)
         return file_out_path
 
+    def get_capture_files(self):
+        """
+        Returns the files of the loaded PCAP. A glob pattern like "capture_*.pcap" selects a capture set, whose files
+        are processed as one timeline.
+
+        :return: The sorted paths of the PCAP files
+        """
+        if glob.has_magic(self.pcap_file_path):
+            matches = sorted(glob.glob(self.pcap_file_path))
+            if matches:
+                return matches
+        return [self.pcap_file_path]
+
     def get_file_hash(self):
         """
         Returns the hash for the loaded PCAP file. The hash is calculated based on:
@@ -32,6 +46,8 @@ class PcapFile(object):
         - the file size in bytes
         - the first 224*40000 bytes of the file
 
+        For a capture set, both are hashed for every file.
+
         :return: The hash for the PCAP file as string.
         """
         # Blocksize in bytes
@@ -41,26 +57,27 @@ class PcapFile(object):
 
         # Initialize required variables
         hasher = hashlib.sha224()
-        blocks_read = 0
 
-        # Hash calculation
-        with open(self.pcap_file_path, 'rb') as afile:
-            # Add filename -> makes trouble when renaming the PCAP
-            # hasher.update(afile.name.encode('utf-8'))
+        # Hash calculation, the files of a capture set are hashed one after the other
+        for file_path in self.get_capture_files():
+            blocks_read = 0
+            with open(file_path, 'rb') as afile:
+                # Add filename -> makes trouble when renaming the PCAP
+                # hasher.update(afile.name.encode('utf-8'))
 
-            # Add file's last modification date -> makes trouble when copying the PCAP
-            # hasher.update(str(time.ctime(os.path.getmtime(self.pcap_file_path))).encode('utf-8'))
+                # Add file's last modification date -> makes trouble when copying the PCAP
+                # hasher.update(str(time.ctime(os.path.getmtime(file_path))).encode('utf-8'))
 
-            # Add file size
-            hasher.update(str(os.path.getsize(self.pcap_file_path)).encode('utf-8'))
+                # Add file size
+                hasher.update(str(os.path.getsize(file_path)).encode('utf-8'))
 
-            # Add max. first 40000 * 224 bytes = 8,5 MB of file
-            buf = afile.read(const_blocksize)
-            blocks_read += 1
-            while len(buf) > 0 and blocks_read < const_max_blocks_read:
-                hasher.update(buf)
+                # Add max. first 40000 * 224 bytes = 8,5 MB of file
                 buf = afile.read(const_blocksize)
                 blocks_read += 1
+                while len(buf) > 0 and blocks_read < const_max_blocks_read:
+                    hasher.update(buf)
+                    buf = afile.read(const_blocksize)
+                    blocks_read += 1
 
         return hasher.hexdigest()
 
@@ -96,3 +113,14 @@ class PcapFile(object):
         dir_second_level = (hashcode >> 8) & mask
 
         return os.path.join(root_directory, str(dir_first_level), str(dir_second_level), file_hash[0:12] + ".sqlite3")
+
+    def get_state_path(self, root_directory: str = os.path.join(Util.CACHE_DIR, 'state')):
+        """
+        Returns the path of the file keeping the statistics state of the loaded PCAP between incremental runs. Unlike
+        the database path, it only depends on the path of the PCAP, so that it stays the same while the PCAP grows.
+
+        :param root_directory: The root directory of the state files (optional)
+        :return: The full path to the state file
+        """
+        path_hash = hashlib.sha224(os.path.abspath(self.pcap_file_path).encode('utf-8')).hexdigest()
+        return os.path.join(root_directory, path_hash[0:12] + ".state")
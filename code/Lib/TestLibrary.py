@@ -1,8 +1,14 @@
 import hashlib
 import os
 import random as rnd
+import shutil
+import sqlite3
+import struct
+import tempfile
+import unittest
 
 import Lib.Utility as Util
+import Lib.libpcapreader as pr
 # Directory of test resource files
 test_resource_dir = Util.TEST_DIR
 # Path to reference pcap
@@ -12,6 +18,252 @@ test_pcap_ips = ["10.0.2.15", "52.85.173.182"]
 # Empty array for testing purposes
 test_pcap_empty = []
 
+# Statistics tables of a statistics database, besides the interval statistics tables listed in interval_tables
+statistics_tables = ["file_statistics", "ip_statistics", "ip_degrees", "ip_ttl", "tcp_mss", "ip_tos", "tcp_win",
+                     "ip_protocols", "ip_ports", "ip_mac", "conv_statistics", "conv_statistics_extended",
+                     "unrecognized_pdus"]
+# Columns of ip_statistics derived from the interval statistics
+interval_rate_columns = ["maxPktRate", "minPktRate", "maxKByteRate", "minKByteRate"]
+
+"""
+helper functions for statistics tests
+"""
+
+
+def read_pcap(pcap_path: str):
+    """
+    Reads the file header and the packet records of a classic PCAP.
+
+    :param pcap_path: path to the PCAP
+    :return: the file header, the struct byte order of the file and the list of packet records, each a tuple of
+             its timestamp in microseconds, its captured length, its original length and the record including its header
+    """
+    with open(pcap_path, 'rb') as f:
+        data = f.read()
+    magic = data[:4]
+    byte_order = '<' if magic in (b'\xd4\xc3\xb2\xa1', b'\x4d\x3c\xb2\xa1') else '>'
+    nanoseconds = magic in (b'\x4d\x3c\xb2\xa1', b'\xa1\xb2\x3c\x4d')
+
+    records = []
+    offset = 24
+    while offset + 16 <= len(data):
+        seconds, fraction, caplen, length = struct.unpack(byte_order + 'IIII', data[offset:offset + 16])
+        timestamp = seconds * 1000000 + (fraction // 1000 if nanoseconds else fraction)
+        records.append((timestamp, caplen, length, data[offset:offset + 16 + caplen]))
+        offset += 16 + caplen
+    return data[:24], byte_order, records
+
+
+def write_pcap(pcap_path: str, file_header: bytes, records):
+    """
+    Writes packet records read by read_pcap to a classic PCAP.
+
+    :param pcap_path: path to the PCAP to write
+    :param file_header: file header of the PCAP the records were read from
+    :param records: packet records as returned by read_pcap
+    """
+    with open(pcap_path, 'wb') as f:
+        f.write(file_header + b''.join(record[3] for record in records))
+
+
+def read_statistics_tables(db_path: str, interval_statistics: bool=True) -> dict:
+    """
+    Reads the rows of the statistics tables of a statistics database.
+
+    :param db_path: path to the statistics database
+    :param interval_statistics: whether to read the interval statistics tables and the interval rates of the IPs,
+                                which merged statistics only approximate
+    :return: dict of table name and sorted table rows, including every interval statistics table
+    """
+    connection = sqlite3.connect(db_path)
+    tables = {}
+    for table in statistics_tables:
+        columns = [row[1] for row in connection.execute("PRAGMA table_info(" + table + ")").fetchall()]
+        if not interval_statistics:
+            columns = [column for column in columns if column not in interval_rate_columns]
+        tables[table] = sorted(connection.execute("SELECT " + ", ".join(columns) + " FROM " + table).fetchall(),
+                               key=str)
+    if interval_statistics:
+        tables["interval_tables"] = sorted(connection.execute("SELECT * FROM interval_tables").fetchall())
+        for table, _, _ in tables["interval_tables"]:
+            tables[table] = sorted(connection.execute("SELECT * FROM " + table).fetchall(), key=str)
+    connection.close()
+    return tables
+
+
+def read_interval_rates(db_path: str) -> dict:
+    """
+    Reads the interval rates of the IPs of a statistics database.
+
+    :param db_path: path to the statistics database
+    :return: dict of IP address and its max and min packet rate and max and min kbyte rate
+    """
+    connection = sqlite3.connect(db_path)
+    rows = connection.execute("SELECT ipAddress, " + ", ".join(interval_rate_columns) + " FROM ip_statistics")
+    rates = {row[0]: row[1:] for row in rows.fetchall()}
+    connection.close()
+    return rates
+
+
+def merge_interval_rates(rates: dict, other_rates: dict) -> dict:
+    """
+    Combines the interval rates of the IPs of two statistics databases the way merged statistics do: the max rates
+    are the higher max rates, the min rates are the lower min rates other than 0.
+
+    :param rates: interval rates as returned by read_interval_rates
+    :param other_rates: interval rates as returned by read_interval_rates
+    :return: dict of IP address and its combined max and min packet rate and max and min kbyte rate
+    """
+    merged = {}
+    for ip in set(rates) | set(other_rates):
+        parts = [part[ip] for part in (rates, other_rates) if ip in part]
+        merged[ip] = tuple(max(part[i] for part in parts) if i % 2 == 0 else
+                           min([part[i] for part in parts if part[i] != 0] or [0.0]) for i in range(4))
+    return merged
+
+
+def float32(value: float) -> float:
+    """
+    Rounds a value to single precision, like a C++ float.
+
+    :param value: the value to round
+    :return: the rounded value
+    """
+    return struct.unpack('f', struct.pack('f', value))[0]
+
+
+def calculate_interval_rates(pcap_path: str, interval: float) -> dict:
+    """
+    Calculates the interval rates of the IPs of an Ethernet PCAP in a single pass over its packets, independently of
+    the statistics: At the first packet after the end of an interval, the packets and kbytes every IP sent in the
+    interval give its rates, the last interval, which ends after the last packet, is not rated. The min rates are
+    reset to 0 by an interval without packets of the IP and set by the next interval with packets again. The rates
+    are single precision.
+
+    :param pcap_path: path to the PCAP
+    :param interval: length of the intervals in seconds
+    :return: dict of IP address and its max and min packet rate and max and min kbyte rate
+    """
+    _, _, records = read_pcap(pcap_path)
+    interval_us = int(round(interval * 1000000))
+    first_timestamp = records[0][0]
+    barrier = interval_us
+    sent = {}
+    rates = {}
+
+    for timestamp, caplen, _, data in records:
+        frame = data[16:]
+        if caplen <= 14 or frame[12] < 8:
+            continue
+        is_ipv4 = struct.unpack('>H', frame[12:14])[0] == 0x0800
+        if is_ipv4:
+            available = caplen - 14
+            header_size = (frame[14] & 0x0f) * 4
+            if available < 20 or header_size < 20 or header_size > available:
+                continue
+            length = struct.unpack('>H', frame[16:18])[0]
+            if 0 < length < header_size:
+                continue
+            length = available if length == 0 else min(length, available)
+
+        if timestamp - first_timestamp > barrier:
+            barrier += interval_us
+            for ip, ip_rates in rates.items():
+                pkts, size = sent.get(ip, (0, 0))
+                pkt_rate = float32(float32(pkts * 1000000) / interval_us)
+                kbyte_rate = float32(float32(float32(float32(size) / 1024) * 100000) / interval_us)
+                for i, rate in ((0, pkt_rate), (2, kbyte_rate)):
+                    if rate > ip_rates[i] or ip_rates[i] == 0:
+                        ip_rates[i] = rate
+                    if rate < ip_rates[i + 1] or ip_rates[i + 1] == 0:
+                        ip_rates[i + 1] = rate
+            sent = {}
+
+        if is_ipv4:
+            src, dst = ".".join(map(str, frame[26:30])), ".".join(map(str, frame[30:34]))
+            for ip in (src, dst):
+                rates.setdefault(ip, [0.0, 0.0, 0.0, 0.0])
+            pkts, size = sent.get(src, (0, 0))
+            sent[src] = (pkts + 1, size + 14 + length)
+    return {ip: tuple(ip_rates) for ip, ip_rates in rates.items()}
+
+
+def read_interval_table(db_path: str, interval: float=None):
+    """
+    Reads an interval statistics table of a statistics database.
+
+    :param db_path: path to the statistics database
+    :param interval: length of the intervals in seconds, None for the default interval table
+    :return: the length of the intervals in seconds and the sorted rows of the table
+    """
+    connection = sqlite3.connect(db_path)
+    if interval is None:
+        table = connection.execute("SELECT name FROM interval_tables WHERE is_default=1").fetchone()[0]
+    else:
+        table = "interval_statistics_" + str(int(round(interval * 1000000)))
+    rows = sorted(connection.execute("SELECT * FROM " + table).fetchall(), key=str)
+    connection.close()
+    return int(table.split("_")[-1]) / 1000000, rows
+
+
+class StatisticsTestCase(unittest.TestCase):
+    """
+    Base class of the statistics tests, which write their PCAPs and statistics databases to a temporary directory.
+    """
+
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_dir)
+
+    def tmp_path(self, name: str) -> str:
+        """
+        :param name: name of a file
+        :return: the path of the file in the temporary directory
+        """
+        return os.path.join(self.tmp_dir, name)
+
+    def create_processor(self, pcap_path, db_name: str=None, extra_tests: bool=True, **setters):
+        """
+        Creates a pcap_processor and configures it with its setters.
+
+        :param pcap_path: path to the PCAP or list of paths of a capture set
+        :param db_name: name of the statistics database in the temporary directory without extension, None for none
+        :param extra_tests: whether the extra tests are enabled
+        :param setters: arguments of the setters by setter name without the set_ prefix, e.g. sampling=(10, "flow"),
+                        a tuple is passed as the arguments, a setter whose argument is None is not called
+        :return: the pcap_processor
+        """
+        db_path = self.tmp_path(db_name + ".sqlite3") if db_name is not None else ""
+        pcap_proc = pr.pcap_processor(pcap_path, str(extra_tests), Util.RESOURCE_DIR, db_path)
+        for setter, arguments in setters.items():
+            if arguments is not None:
+                getattr(pcap_proc, "set_" + setter)(*(arguments if isinstance(arguments, tuple) else (arguments,)))
+        return pcap_proc
+
+    def collect_statistics(self, pcap_path, db_name: str, threads: int=1, chunked: bool=False, intervals: list=None,
+                           extra_tests: bool=True, **setters) -> str:
+        """
+        Collects the statistics of a PCAP and writes them to a statistics database in the temporary directory.
+
+        :param pcap_path: path to the PCAP or list of paths of a capture set
+        :param db_name: name of the statistics database without extension
+        :param threads: number of threads
+        :param chunked: whether the PCAP is processed in chunks
+        :param intervals: lengths of the intervals in seconds, by default the default interval
+        :param extra_tests: whether the extra tests are enabled
+        :param setters: arguments of the pcap_processor setters, see create_processor
+        :return: the path to the statistics database
+        """
+        intervals = [0.0] if intervals is None else intervals
+        pcap_proc = self.create_processor(pcap_path, db_name, extra_tests, **setters)
+        pcap_proc.collect_statistics(intervals, threads, chunked)
+        db_path = self.tmp_path(db_name + ".sqlite3")
+        pcap_proc.write_to_database(db_path, intervals, True)
+        return db_path
+
+
 """
 helper functions for ID2TAttackTest
 """
@@ -0,0 +1,45 @@
+import Lib.TestLibrary as Lib
+
+
+def distribute_pcap(pcap_path: str, file_paths: list, block_size: int):
+    """
+    Writes blocks of consecutive packets of a PCAP to several PCAP files in turn.
+
+    :param pcap_path: path to the PCAP to distribute
+    :param file_paths: paths to the PCAP files receiving the blocks
+    :param block_size: number of packets per block
+    """
+    file_header, _, records = Lib.read_pcap(pcap_path)
+    for i, file_path in enumerate(file_paths):
+        Lib.write_pcap(file_path, file_header, [record for packet, record in enumerate(records)
+                                                if (packet // block_size) % len(file_paths) == i])
+
+
+class UnitTestCaptureSet(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_paths, name: str, threads: int=1):
+        return Lib.read_statistics_tables(self.collect_statistics(pcap_paths, name, threads))
+
+    def check_capture_set(self, pcap_paths, threads: int=1):
+        pcap_tables = self.write_statistics(Lib.test_pcap, "pcap")
+        capture_set_tables = self.write_statistics(pcap_paths, "capture_set", threads)
+        self.assertEqual(pcap_tables.keys(), capture_set_tables.keys())
+        for table in pcap_tables:
+            self.assertEqual(pcap_tables[table], capture_set_tables[table], table)
+
+    def test_sequential_files_glob(self):
+        # The file names are not in timeline order, the files are ordered by their first packet
+        file_paths = [self.tmp_path("capture_" + suffix + ".pcap") for suffix in ["b", "a", "c"]]
+        distribute_pcap(Lib.test_pcap, file_paths, 700)
+        self.check_capture_set(self.tmp_path("capture_*.pcap"))
+
+    def test_overlapping_files_list(self):
+        file_paths = [self.tmp_path("capture_" + str(i) + ".pcap") for i in range(2)]
+        distribute_pcap(Lib.test_pcap, file_paths, 100)
+        self.check_capture_set(file_paths, 4)
+
+    def test_capture_set_timestamps(self):
+        file_paths = [self.tmp_path("capture_" + str(i) + ".pcap") for i in range(2)]
+        distribute_pcap(Lib.test_pcap, file_paths, 100)
+        packets = [1, 100, 101, 1000, 1998, 1999]
+        self.assertEqual(self.create_processor(Lib.test_pcap, extra_tests=False).get_timestamps_mu_sec(packets),
+                         self.create_processor(file_paths, extra_tests=False).get_timestamps_mu_sec(packets))
@@ -0,0 +1,65 @@
+import os
+
+import Lib.TestLibrary as Lib
+
+# Interval of the interval statistics in seconds, fixed as the default interval depends on the last packet of the file
+INTERVAL = 10.0
+
+class UnitTestCheckpoint(Lib.StatisticsTestCase):
+    def setUp(self):
+        super().setUp()
+        self.checkpoint_path = self.tmp_path("statistics.checkpoint")
+
+    def checkpoint(self, checkpoint: bool=True):
+        # A checkpoint after every packet, the last one is written after the last packet
+        return (self.checkpoint_path, 0) if checkpoint else None
+
+    def write_statistics(self, name: str, checkpoint: bool=True, pcap_path: str=Lib.test_pcap, interval: float=0.0):
+        return self.collect_statistics(pcap_path, name, intervals=[interval], checkpoint=self.checkpoint(checkpoint))
+
+    def check_statistics(self, db_path: str, resumed_db_path: str):
+        tables = Lib.read_statistics_tables(db_path)
+        resumed_tables = Lib.read_statistics_tables(resumed_db_path)
+        self.assertEqual(tables.keys(), resumed_tables.keys())
+        for table in tables:
+            self.assertEqual(tables[table], resumed_tables[table], table)
+
+    def test_resume(self):
+        db_path = self.write_statistics("uninterrupted", False)
+
+        # Interrupted before the statistics are written, the checkpoint is kept
+        pcap_proc = self.create_processor(Lib.test_pcap, "interrupted", checkpoint=self.checkpoint())
+        pcap_proc.collect_statistics([0.0])
+        self.assertTrue(os.path.exists(self.checkpoint_path))
+
+        resumed_db_path = self.write_statistics("resumed")
+        self.assertFalse(os.path.exists(self.checkpoint_path))
+        self.check_statistics(db_path, resumed_db_path)
+
+    def test_resume_mid_file(self):
+        db_path = self.write_statistics("uninterrupted", False, interval=INTERVAL)
+
+        # Interrupted in the middle of the file, the last checkpoint is written after the packets read so far
+        pcap_path = self.tmp_path("interrupted.pcap")
+        file_header, _, records = Lib.read_pcap(Lib.test_pcap)
+        Lib.write_pcap(pcap_path, file_header, records[:999])
+        pcap_proc = self.create_processor(pcap_path, "interrupted", checkpoint=self.checkpoint())
+        pcap_proc.collect_statistics([INTERVAL])
+        self.assertTrue(os.path.exists(self.checkpoint_path))
+
+        # The resumed run continues with the remaining packets, the intervals continue across the interruption
+        Lib.write_pcap(pcap_path, file_header, records)
+        resumed_db_path = self.write_statistics("resumed", pcap_path=pcap_path, interval=INTERVAL)
+        self.assertFalse(os.path.exists(self.checkpoint_path))
+        self.check_statistics(db_path, resumed_db_path)
+
+    def test_checkpoint_of_other_configuration(self):
+        db_path = self.write_statistics("uninterrupted", False)
+
+        pcap_proc = self.create_processor(Lib.test_pcap, "filtered", filter="tcp", checkpoint=self.checkpoint())
+        pcap_proc.collect_statistics([0.0])
+        self.assertTrue(os.path.exists(self.checkpoint_path))
+
+        # The checkpoint of the filtered statistics is not resumed
+        self.check_statistics(db_path, self.write_statistics("unfiltered"))
+        self.assertFalse(os.path.exists(self.checkpoint_path))
@@ -0,0 +1,43 @@
+import gzip
+import lzma
+import os
+import shutil
+
+import Lib.TestLibrary as Lib
+
+
+class UnitTestCompressedPcap(Lib.StatisticsTestCase):
+    def compress(self, compressor, extension: str) -> str:
+        pcap_path = self.tmp_path("capture.pcap" + extension)
+        with open(Lib.test_pcap, 'rb') as source, compressor(pcap_path, 'wb') as target:
+            shutil.copyfileobj(source, target)
+        return pcap_path
+
+    def write_statistics(self, pcap_path: str, name: str, threads: int=1):
+        return Lib.read_statistics_tables(self.collect_statistics(pcap_path, name, threads))
+
+    def check_statistics(self, pcap_path: str, threads: int=1):
+        pcap_tables = self.write_statistics(Lib.test_pcap, "pcap")
+        compressed_tables = self.write_statistics(pcap_path, "compressed", threads)
+        self.assertEqual(pcap_tables.keys(), compressed_tables.keys())
+        for table in pcap_tables:
+            self.assertEqual(pcap_tables[table], compressed_tables[table], table)
+
+    def test_gzip_statistics(self):
+        self.check_statistics(self.compress(gzip.open, ".gz"))
+
+    def test_xz_statistics_pipeline(self):
+        self.check_statistics(self.compress(lzma.open, ".xz"), 4)
+
+    def test_gzip_timestamps(self):
+        packets = [1, 2, 1000, 1998, 1999]
+        pcap_path = self.compress(gzip.open, ".gz")
+        self.assertEqual(self.create_processor(Lib.test_pcap, extra_tests=False).get_timestamps_mu_sec(packets),
+                         self.create_processor(pcap_path, extra_tests=False).get_timestamps_mu_sec(packets))
+
+    def test_gzip_merge(self):
+        pcap_path = self.compress(gzip.open, ".gz")
+        merged_path = self.create_processor(pcap_path, extra_tests=False).merge_pcaps(Lib.test_pcap)
+        self.assertTrue(merged_path.endswith(".pcap.gz"))
+        with gzip.open(merged_path, 'rb') as merged:
+            self.assertEqual(len(merged.read()), 2 * os.path.getsize(Lib.test_pcap) - 24)
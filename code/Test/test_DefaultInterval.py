@@ -0,0 +1,31 @@
+import Lib.TestLibrary as Lib
+
+
+class UnitTestDefaultInterval(Lib.StatisticsTestCase):
+    @staticmethod
+    def two_pass_interval(records) -> float:
+        # A full pass over the records, as read_pcap_info did before the first pass over the packets
+        return ((records[-1][0] - records[0][0]) // 100) / 1000000
+
+    def test_default_interval(self):
+        _, _, records = Lib.read_pcap(Lib.test_pcap)
+        db_path = self.collect_statistics(Lib.test_pcap, "statistics")
+
+        self.assertEqual(Lib.read_interval_table(db_path)[0], self.two_pass_interval(records))
+
+    def test_default_interval_truncated(self):
+        file_header, _, records = Lib.read_pcap(Lib.test_pcap)
+        # The last record is cut in its payload, its length field points past the end of the file
+        truncated_pcap = self.tmp_path("truncated.pcap")
+        with open(Lib.test_pcap, 'rb') as f:
+            data = f.read()
+        with open(truncated_pcap, 'wb') as f:
+            f.write(data[:len(data) - records[-1][1] // 2])
+        complete_pcap = self.tmp_path("complete.pcap")
+        Lib.write_pcap(complete_pcap, file_header, records[:-1])
+
+        truncated_db = self.collect_statistics(truncated_pcap, "truncated")
+        complete_db = self.collect_statistics(complete_pcap, "complete")
+
+        self.assertEqual(Lib.read_interval_table(truncated_db)[0], self.two_pass_interval(records[:-1]))
+        self.assertEqual(Lib.read_statistics_tables(truncated_db), Lib.read_statistics_tables(complete_db))
@@ -0,0 +1,101 @@
+import glob
+import os
+import shutil
+
+import Core.Statistics as Statistics
+import Lib.PcapFile as PcapFile
+import Lib.TestLibrary as Lib
+import Lib.Utility as Util
+
+# Interval of the interval statistics in seconds, fixed as the default interval depends on the capture duration
+INTERVAL = 10.0
+
+
+class TmpPcapFile(PcapFile.PcapFile):
+    def __init__(self, pcap_file_path: str, cache_dir: str):
+        """
+        A PcapFile whose statistics database and state are kept in cache_dir instead of the cache of ID2T.
+        """
+        super().__init__(pcap_file_path)
+        self.cache_dir = cache_dir
+
+    def get_db_path(self, root_directory: str=None):
+        return super().get_db_path(os.path.join(self.cache_dir, "db"))
+
+    def get_state_path(self, root_directory: str=None):
+        return super().get_state_path(os.path.join(self.cache_dir, "state"))
+
+
+class UnitTestIncremental(Lib.StatisticsTestCase):
+    def setUp(self):
+        super().setUp()
+        self.pcap_path = self.tmp_path("capture.pcap")
+        self.state_path = self.tmp_path("capture.state")
+
+    def write_statistics(self, name: str, pcap_path: str, incremental: bool=True):
+        return self.collect_statistics(pcap_path, name, intervals=[INTERVAL],
+                                       incremental=self.state_path if incremental else None)
+
+    def test_appended_packets(self):
+        with open(Lib.test_pcap, 'rb') as f:
+            data = f.read()
+        # The first part ends within a packet record, as if the record was still being written
+        split = len(data) // 2 + 7
+
+        with open(self.pcap_path, 'wb') as f:
+            f.write(data[:split])
+        self.write_statistics("first", self.pcap_path)
+        self.assertTrue(os.path.exists(self.state_path))
+
+        with open(self.pcap_path, 'ab') as f:
+            f.write(data[split:])
+        db_path = self.write_statistics("incremental", self.pcap_path)
+        full_db_path = self.write_statistics("full", Lib.test_pcap, False)
+
+        tables = Lib.read_statistics_tables(db_path)
+        full_tables = Lib.read_statistics_tables(full_db_path)
+        self.assertEqual(full_tables.keys(), tables.keys())
+        for table in full_tables:
+            self.assertEqual(full_tables[table], tables[table], table)
+
+    def load_pcap_statistics(self) -> str:
+        # Statistics is a singleton, a new instance stands for a new run of ID2T
+        self.addCleanup(setattr, Statistics.Statistics, "_instance", Statistics.Statistics._instance)
+        Statistics.Statistics._instance = None
+        statistics = Statistics.Statistics(TmpPcapFile(self.pcap_path, self.tmp_path("cache")))
+        statistics.do_extra_tests = True
+        statistics.load_pcap_statistics(False, False, False, True, [INTERVAL], incremental=True)
+        statistics.stats_db.database.close()
+        return statistics.path_db
+
+    def test_load_pcap_statistics(self):
+        with open(Lib.test_pcap, 'rb') as f:
+            data = f.read()
+        split = len(data) // 2 + 7
+        with open(self.pcap_path, 'wb') as f:
+            f.write(data[:split])
+        first_db_path = self.load_pcap_statistics()
+
+        # The grown file gets another database path, the database of the first run is moved there
+        with open(self.pcap_path, 'ab') as f:
+            f.write(data[split:])
+        db_path = self.load_pcap_statistics()
+        self.assertNotEqual(first_db_path, db_path)
+        self.assertEqual([db_path], glob.glob(self.tmp_path(os.path.join("cache", "db", "**", "*.sqlite3")),
+                                              recursive=True))
+
+        full_db_path = self.write_statistics("full", Lib.test_pcap, False)
+        self.assertEqual(Lib.read_statistics_tables(full_db_path), Lib.read_statistics_tables(db_path))
+
+    def test_replaced_file(self):
+        with open(Lib.test_pcap, 'rb') as f:
+            data = f.read()
+        with open(self.pcap_path, 'wb') as f:
+            f.write(data[:len(data) // 2])
+        self.write_statistics("first", self.pcap_path)
+
+        # A file which does not start with the packets processed before is processed from the start
+        shutil.copyfile(Util.TEST_DIR + "reference_telnet.pcap", self.pcap_path)
+        db_path = self.write_statistics("replaced", self.pcap_path)
+        full_db_path = self.write_statistics("full", Util.TEST_DIR + "reference_telnet.pcap", False)
+        self.assertEqual(Lib.read_statistics_tables(full_db_path), Lib.read_statistics_tables(db_path))
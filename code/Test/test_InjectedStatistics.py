@@ -0,0 +1,80 @@
+import Lib.TestLibrary as Lib
+
+# Interval of the interval statistics in seconds, fixed as the default interval depends on the captured packets
+INTERVAL = 10.0
+
+
+def extract_packets(pcap_path: str, base_path: str, injected_path: str, every: int):
+    """
+    Moves every n-th packet of a PCAP to a second PCAP, as if these packets had been injected into the first PCAP.
+
+    :param pcap_path: path to the PCAP to split
+    :param base_path: path to the PCAP receiving the remaining packets
+    :param injected_path: path to the PCAP receiving every n-th packet
+    :param every: n, the distance of the extracted packets
+    """
+    file_header, _, records = Lib.read_pcap(pcap_path)
+    Lib.write_pcap(base_path, file_header, [record for i, record in enumerate(records, 1) if i % every != 0])
+    Lib.write_pcap(injected_path, file_header, [record for i, record in enumerate(records, 1) if i % every == 0])
+
+
+class UnitTestInjectedStatistics(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str, name: str) -> str:
+        return self.collect_statistics(pcap_path, name, intervals=[INTERVAL])
+
+    def check_injected(self, pcap_path: str, every: int):
+        base_path = self.tmp_path("base.pcap")
+        injected_path = self.tmp_path("injected.pcap")
+        snapshot_path = self.tmp_path("base.snapshot")
+        extract_packets(pcap_path, base_path, injected_path, every)
+
+        db_path = self.write_statistics(pcap_path, "single_pass")
+        base_db_path = self.write_statistics(base_path, "base")
+        injected_db_path = self.write_statistics(injected_path, "injected")
+
+        base = self.create_processor(base_path)
+        base.collect_statistics([INTERVAL])
+        self.assertTrue(base.write_snapshot(snapshot_path))
+
+        # The statistics of the base capture are restored from the snapshot, only the injected packets are processed
+        merged_db_path = self.tmp_path("merged.sqlite3")
+        merged = self.create_processor(pcap_path, "merged")
+        self.assertTrue(merged.load_snapshot(snapshot_path))
+        injected = self.create_processor(injected_path)
+        injected.collect_statistics([INTERVAL])
+        merged.merge_statistics(injected)
+        merged.write_to_database(merged_db_path, [INTERVAL], True)
+
+        single_pass_tables = Lib.read_statistics_tables(db_path, False)
+        merged_tables = Lib.read_statistics_tables(merged_db_path, False)
+        self.assertEqual(single_pass_tables.keys(), merged_tables.keys())
+        for table in single_pass_tables:
+            self.assertEqual(single_pass_tables[table], merged_tables[table], table)
+
+        # The rows of the injected packets are added to the rows of the base capture containing them
+        _, base_rows = Lib.read_interval_table(base_db_path, INTERVAL)
+        _, injected_rows = Lib.read_interval_table(injected_db_path, INTERVAL)
+        _, merged_rows = Lib.read_interval_table(merged_db_path, INTERVAL)
+        self.assertTrue({row[0] for row in base_rows} <= {row[0] for row in merged_rows})
+        self.assertEqual(sum(row[2] for row in merged_rows), sum(row[2] for row in base_rows + injected_rows))
+        self.assertAlmostEqual(sum(row[4] for row in merged_rows), sum(row[4] for row in base_rows + injected_rows),
+                               places=3)
+        self.assertEqual(Lib.read_interval_rates(merged_db_path),
+                         Lib.merge_interval_rates(Lib.read_interval_rates(base_db_path),
+                                                  Lib.read_interval_rates(injected_db_path)))
+
+    def test_injected_packets(self):
+        self.check_injected(Lib.test_pcap, 10)
+
+    def test_interleaved_conversation(self):
+        self.check_injected(Lib.test_resource_dir + "reference_telnet.pcap", 3)
+
+    def test_snapshot_of_other_configuration(self):
+        snapshot_path = self.tmp_path("base.snapshot")
+        base = self.create_processor(Lib.test_pcap)
+        base.collect_statistics([0.0])
+        self.assertTrue(base.write_snapshot(snapshot_path))
+
+        # Statistics without the extra tests cannot be merged with the extra tests of a snapshot
+        self.assertFalse(self.create_processor(Lib.test_pcap, extra_tests=False).load_snapshot(snapshot_path))
+        self.assertFalse(self.create_processor(Lib.test_pcap).load_snapshot(self.tmp_path("missing.snapshot")))
@@ -0,0 +1,23 @@
+import Lib.TestLibrary as Lib
+
+
+class UnitTestIntervalRates(Lib.StatisticsTestCase):
+    def check_rates(self, interval: float):
+        db_path = self.collect_statistics(Lib.test_pcap, "statistics", intervals=[interval])
+
+        rates = Lib.read_interval_rates(db_path)
+        self.assertEqual(rates, Lib.calculate_interval_rates(Lib.test_pcap, interval))
+        # Packets and kbytes of the intervals are counted per IP, they are not taken from the whole capture
+        self.assertTrue(any(ip_rates[0] != ip_rates[1] for ip_rates in rates.values()))
+
+    def test_rates_short_intervals(self):
+        self.check_rates(0.5)
+
+    def test_rates(self):
+        self.check_rates(10.0)
+
+    def test_rates_default_interval(self):
+        db_path = self.collect_statistics(Lib.test_pcap, "statistics")
+
+        interval = Lib.read_interval_table(db_path)[0]
+        self.assertEqual(Lib.read_interval_rates(db_path), Lib.calculate_interval_rates(Lib.test_pcap, interval))
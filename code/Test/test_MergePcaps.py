@@ -0,0 +1,66 @@
+import shutil
+import struct
+
+import Lib.TestLibrary as Lib
+
+
+class UnitTestMergePcaps(Lib.StatisticsTestCase):
+    @staticmethod
+    def retime(byte_order: str, record, timestamp: int):
+        header = struct.pack(byte_order + 'IIII', timestamp // 1000000, timestamp % 1000000, record[1], record[2])
+        return timestamp, record[1], record[2], header + record[3][16:]
+
+    def write_attack_pcap(self, base_records) -> tuple:
+        """
+        Writes an attack PCAP whose packets share the timestamps of base packets, besides one after the last base packet.
+
+        :param base_records: packet records of the base PCAP
+        :return: the path to the attack PCAP and its packet records
+        """
+        file_header, byte_order, telnet_records = Lib.read_pcap(Lib.test_resource_dir + "reference_telnet.pcap")
+        timestamps = [base_records[i][0] for i in (0, 1, 500, 1000, len(base_records) - 1)]
+        timestamps.append(base_records[-1][0] + 1000000)
+        records = [self.retime(byte_order, record, timestamp)
+                   for record, timestamp in zip(telnet_records, timestamps)]
+        attack_pcap = self.tmp_path("attack.pcap")
+        Lib.write_pcap(attack_pcap, file_header, records)
+        return attack_pcap, records
+
+    @staticmethod
+    def merge(base_records, attack_records):
+        # Attack packets are written before base packets with the same timestamp
+        merged = []
+        base, attack = 0, 0
+        while base < len(base_records) or attack < len(attack_records):
+            if attack < len(attack_records) and \
+                    (base == len(base_records) or attack_records[attack][0] <= base_records[base][0]):
+                merged.append(attack_records[attack])
+                attack += 1
+            else:
+                merged.append(base_records[base])
+                base += 1
+        return merged
+
+    def check_merge(self, base_pcap: str, link_type: int):
+        _, _, base_records = Lib.read_pcap(base_pcap)
+        attack_pcap, attack_records = self.write_attack_pcap(base_records)
+
+        merged_path = self.create_processor(base_pcap, extra_tests=False).merge_pcaps(attack_pcap)
+        merged_header, byte_order, merged_records = Lib.read_pcap(merged_path)
+
+        self.assertEqual(len(merged_records), len(base_records) + len(attack_records))
+        self.assertEqual([record[3] for record in merged_records],
+                         [record[3] for record in self.merge(base_records, attack_records)])
+        self.assertEqual(struct.unpack(byte_order + 'I', merged_header[20:24])[0], link_type)
+
+    def test_merge(self):
+        base_pcap = self.tmp_path("base.pcap")
+        shutil.copyfile(Lib.test_pcap, base_pcap)
+        self.check_merge(base_pcap, 1)
+
+    def test_merge_link_type(self):
+        # The merged PCAP keeps the link type of the base PCAP, here Linux cooked capture
+        file_header, byte_order, base_records = Lib.read_pcap(Lib.test_pcap)
+        base_pcap = self.tmp_path("base.pcap")
+        Lib.write_pcap(base_pcap, file_header[:20] + struct.pack(byte_order + 'I', 113), base_records)
+        self.check_merge(base_pcap, 113)
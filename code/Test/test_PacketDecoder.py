@@ -0,0 +1,21 @@
+import Lib.TestLibrary as Lib
+
+
+class UnitTestPacketDecoder(Lib.StatisticsTestCase):
+    def read_statistics(self, pcap_path: str, db_name: str, libtins_decoding: bool) -> dict:
+        return Lib.read_statistics_tables(self.collect_statistics(pcap_path, db_name, intervals=[10.0],
+                                                                  libtins_decoding=libtins_decoding))
+
+    def check_decoders(self, pcap_path: str):
+        statistics = self.read_statistics(pcap_path, "decoder", False)
+        libtins_statistics = self.read_statistics(pcap_path, "libtins", True)
+
+        self.assertEqual(statistics.keys(), libtins_statistics.keys())
+        for table in statistics:
+            self.assertEqual(statistics[table], libtins_statistics[table], table)
+
+    def test_decoders_reference(self):
+        self.check_decoders(Lib.test_pcap)
+
+    def test_decoders_telnet(self):
+        self.check_decoders(Lib.test_resource_dir + "reference_telnet.pcap")
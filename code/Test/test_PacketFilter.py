@@ -0,0 +1,43 @@
+import Lib.TestLibrary as Lib
+
+# Interval of the interval statistics in seconds, fixed as the default interval depends on the last packet of the file
+INTERVAL = 10.0
+
+
+def write_tcp_packets(pcap_path: str, tcp_path: str):
+    """
+    Writes the Ethernet/IPv4 TCP packets of a PCAP to another PCAP.
+
+    :param pcap_path: path to the PCAP to read
+    :param tcp_path: path to the PCAP receiving the TCP packets
+    """
+    file_header, _, records = Lib.read_pcap(pcap_path)
+    # The frame follows the 16 byte record header, the IPv4 protocol field is at byte 23 of the frame
+    Lib.write_pcap(tcp_path, file_header, [record for record in records if len(record[3]) >= 50 and
+                                           record[3][28:30] == b'\x08\x00' and record[3][39] == 6])
+
+
+class UnitTestPacketFilter(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str, name: str, bpf_filter: str="", threads: int=1, chunked: bool=False):
+        return self.collect_statistics(pcap_path, name, threads, chunked, [INTERVAL], filter=bpf_filter)
+
+    def check_filter(self, threads: int, chunked: bool):
+        tcp_path = self.tmp_path("tcp.pcap")
+        write_tcp_packets(Lib.test_pcap, tcp_path)
+
+        tcp_db_path = self.write_statistics(tcp_path, "tcp")
+        filtered_db_path = self.write_statistics(Lib.test_pcap, "filtered", "tcp", threads, chunked)
+        tcp_tables = Lib.read_statistics_tables(tcp_db_path)
+        filtered_tables = Lib.read_statistics_tables(filtered_db_path)
+        self.assertEqual(tcp_tables.keys(), filtered_tables.keys())
+        for table in tcp_tables:
+            self.assertEqual(tcp_tables[table], filtered_tables[table], table)
+
+    def test_filter(self):
+        self.check_filter(1, False)
+
+    def test_filter_pipeline(self):
+        self.check_filter(4, False)
+
+    def test_filter_chunked(self):
+        self.check_filter(3, True)
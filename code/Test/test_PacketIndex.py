@@ -0,0 +1,38 @@
+import Lib.TestLibrary as Lib
+
+
+class UnitTestPacketIndex(Lib.StatisticsTestCase):
+    def write_statistics(self, threads: int=1, chunked: bool=False):
+        self.collect_statistics(Lib.test_pcap, "statistics", threads, chunked, extra_tests=False)
+
+    def check_timestamps(self):
+        without_index = self.create_processor(Lib.test_pcap, extra_tests=False)
+        with_index = self.create_processor(Lib.test_pcap, "statistics", False)
+        for packet in [1, 2, 1024, 1025, 1500, 1998]:
+            self.assertEqual(without_index.get_timestamp_mu_sec(packet), with_index.get_timestamp_mu_sec(packet),
+                             packet)
+        self.assertEqual(with_index.get_timestamp_mu_sec(1999), -1.0)
+
+    def test_timestamp_lookup(self):
+        self.write_statistics()
+        self.check_timestamps()
+
+    def test_timestamp_lookup_chunked(self):
+        self.write_statistics(4, True)
+        self.check_timestamps()
+
+    def test_batched_timestamp_lookup(self):
+        self.write_statistics()
+        pcap_proc = self.create_processor(Lib.test_pcap, "statistics", False)
+        packets = [1998, 5, 1025, 0, 5, 1999, 1]
+        timestamps = pcap_proc.get_timestamps_mu_sec(packets)
+        self.assertEqual([pcap_proc.get_timestamp_mu_sec(packet) for packet in packets], timestamps)
+
+    def test_packet_number_lookup(self):
+        pcap_proc = self.create_processor(Lib.test_pcap, extra_tests=False)
+        packet_timestamps = [timestamp - 1 for timestamp in pcap_proc.get_timestamps_mu_sec(list(range(1, 1999)))]
+        queries = [0, packet_timestamps[1000] + 1, packet_timestamps[0], packet_timestamps[0] + 1,
+                   packet_timestamps[-1] + 1]
+        expected = [sum(1 for timestamp in packet_timestamps if timestamp < query) for query in queries]
+        self.assertEqual(pcap_proc.get_packet_numbers(queries), expected)
+        self.assertEqual(expected[2:], [0, 1, 1998])
@@ -0,0 +1,70 @@
+import struct
+
+import Lib.TestLibrary as Lib
+
+
+def pcapng_block(byte_order: str, block_type: int, body: bytes) -> bytes:
+    """
+    Creates a pcapng block.
+
+    :param byte_order: struct byte order of the section
+    :param block_type: type of the block
+    :param body: content of the block, padded to 32 bits
+    :return: the block
+    """
+    body += b'\0' * (-len(body) % 4)
+    length = len(body) + 12
+    return struct.pack(byte_order + 'II', block_type, length) + body + struct.pack(byte_order + 'I', length)
+
+
+def write_pcapng(pcap_path: str, pcapng_path: str, byte_order: str='<', resolution: int=6):
+    """
+    Writes the packets of a classic PCAP to a pcapng file with a single section and interface.
+
+    :param pcap_path: path to the classic PCAP
+    :param pcapng_path: path to the pcapng file to write
+    :param byte_order: struct byte order of the section
+    :param resolution: timestamp resolution of the interface as negative power of 10
+    """
+    file_header, pcap_byte_order, records = Lib.read_pcap(pcap_path)
+    link_type = struct.unpack(pcap_byte_order + 'I', file_header[20:24])[0]
+
+    units = 10 ** resolution
+    blocks = [pcapng_block(byte_order, 0x0a0d0d0a, struct.pack(byte_order + 'IHHq', 0x1a2b3c4d, 1, 0, -1)),
+              pcapng_block(byte_order, 1, struct.pack(byte_order + 'HHIHHB', link_type, 0, 0, 9, 1, resolution) +
+                           b'\0' * 3 + struct.pack(byte_order + 'HH', 0, 0))]
+    for timestamp_mu_sec, caplen, length, record in records:
+        timestamp = timestamp_mu_sec * units // 1000000
+        blocks.append(pcapng_block(byte_order, 6, struct.pack(byte_order + 'IIIII', 0, timestamp >> 32,
+                                                              timestamp & 0xffffffff, caplen, length) + record[16:]))
+
+    with open(pcapng_path, 'wb') as f:
+        f.write(b''.join(blocks))
+
+
+class UnitTestPcapng(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str, name: str):
+        return Lib.read_statistics_tables(self.collect_statistics(pcap_path, name))
+
+    def check_pcapng(self, byte_order: str, resolution: int):
+        pcapng_path = self.tmp_path("capture.pcapng")
+        write_pcapng(Lib.test_pcap, pcapng_path, byte_order, resolution)
+
+        pcap_tables = self.write_statistics(Lib.test_pcap, "pcap")
+        pcapng_tables = self.write_statistics(pcapng_path, "pcapng")
+        self.assertEqual(pcap_tables.keys(), pcapng_tables.keys())
+        for table in pcap_tables:
+            self.assertEqual(pcap_tables[table], pcapng_tables[table], table)
+
+    def test_pcapng_microseconds(self):
+        self.check_pcapng('<', 6)
+
+    def test_pcapng_big_endian_nanoseconds(self):
+        self.check_pcapng('>', 9)
+
+    def test_pcapng_timestamps(self):
+        pcapng_path = self.tmp_path("capture.pcapng")
+        write_pcapng(Lib.test_pcap, pcapng_path, '<', 9)
+        packets = [1, 2, 1000, 1998, 1999]
+        self.assertEqual(self.create_processor(Lib.test_pcap, extra_tests=False).get_timestamps_mu_sec(packets),
+                         self.create_processor(pcapng_path, extra_tests=False).get_timestamps_mu_sec(packets))
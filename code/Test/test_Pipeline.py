@@ -0,0 +1,38 @@
+import Lib.TestLibrary as Lib
+
+class UnitTestPipeline(Lib.StatisticsTestCase):
+    def check_pipeline(self, pcap_path: str, threads: int, intervals: list):
+        db_path = self.collect_statistics(pcap_path, "single_thread", intervals=intervals)
+        # Up to three threads, the packets are read and decoded by the pipeline and collected in file order, from four
+        # threads on they are routed to the statistics shards owning their hosts
+        pipeline_db_path = self.collect_statistics(pcap_path, "pipeline", threads, intervals=intervals)
+
+        tables = Lib.read_statistics_tables(db_path)
+        pipeline_tables = Lib.read_statistics_tables(pipeline_db_path)
+        self.assertEqual(tables.keys(), pipeline_tables.keys())
+        for table in tables:
+            self.assertEqual(tables[table], pipeline_tables[table], table)
+
+    def test_pipeline_default_interval(self):
+        self.check_pipeline(Lib.test_pcap, 2, [0.0])
+
+    def test_pipeline_intervals(self):
+        self.check_pipeline(Lib.test_pcap, 2, [0.5, 1.0, 10.0])
+
+    def test_pipeline_decoder_threads(self):
+        self.check_pipeline(Lib.test_pcap, 3, [0.0])
+
+    def test_pipeline_single_conversation(self):
+        self.check_pipeline(Lib.test_resource_dir + "reference_telnet.pcap", 2, [0.0])
+
+    def test_shards(self):
+        self.check_pipeline(Lib.test_pcap, 4, [0.0])
+
+    def test_shards_intervals(self):
+        self.check_pipeline(Lib.test_pcap, 8, [0.5, 1.0, 10.0])
+
+    def test_many_shards(self):
+        self.check_pipeline(Lib.test_pcap, 16, [0.0])
+
+    def test_shards_single_conversation(self):
+        self.check_pipeline(Lib.test_resource_dir + "reference_telnet.pcap", 8, [0.0])
@@ -0,0 +1,54 @@
+import sqlite3
+
+import Lib.TestLibrary as Lib
+
+
+class UnitTestSampling(Lib.StatisticsTestCase):
+    def write_statistics(self, name: str, rate: int=1, mode: str="packet", threads: int=1, chunked: bool=False):
+        return self.collect_statistics(Lib.test_pcap, name, threads, chunked, sampling=(rate, mode))
+
+    @staticmethod
+    def read_sampling(db_path: str) -> dict:
+        connection = sqlite3.connect(db_path)
+        rows = connection.execute("SELECT tableName, mode, rate, sampledCount, scaled, relativeError FROM sampling")
+        sampling = {row[0]: row[1:] for row in rows.fetchall()}
+        connection.close()
+        return sampling
+
+    def test_packet_sampling(self):
+        db_path = self.write_statistics("packet", 4, "packet")
+        connection = sqlite3.connect(db_path)
+        packet_count = connection.execute("SELECT packetCount FROM file_statistics").fetchone()[0]
+        ttl_counts = [row[0] for row in connection.execute("SELECT ttlCount FROM ip_ttl").fetchall()]
+        connection.close()
+
+        # The first and then every fourth of the 1998 packets is sampled
+        self.assertEqual(packet_count, 500 * 4)
+        self.assertTrue(all(count % 4 == 0 for count in ttl_counts))
+
+        sampling = self.read_sampling(db_path)
+        self.assertEqual(sampling["file_statistics"][:4], ("packet", 4, 500, 1))
+        self.assertGreater(sampling["ip_ttl"][4], 0)
+        self.assertEqual(sampling["conv_statistics_extended"][3], 0)
+
+    def test_flow_sampling_keeps_conversations(self):
+        full_tables = Lib.read_statistics_tables(self.write_statistics("full"))
+        sampled_tables = Lib.read_statistics_tables(self.write_statistics("flow", 4, "flow"))
+
+        # Every sampled conversation is complete
+        full_conversations = set(full_tables["conv_statistics_extended"])
+        self.assertTrue(sampled_tables["conv_statistics_extended"])
+        self.assertTrue(set(sampled_tables["conv_statistics_extended"]) <= full_conversations)
+
+    def test_flow_sampling_chunked(self):
+        sampled_db_path = self.write_statistics("flow", 4, "flow")
+        chunked_db_path = self.write_statistics("chunked", 4, "flow", 3, True)
+        sampled_tables = Lib.read_statistics_tables(sampled_db_path)
+        chunked_tables = Lib.read_statistics_tables(chunked_db_path)
+        self.assertEqual(sampled_tables.keys(), chunked_tables.keys())
+        for table in sampled_tables:
+            self.assertEqual(sampled_tables[table], chunked_tables[table], table)
+
+    def test_no_sampling(self):
+        db_path = self.write_statistics("full")
+        self.assertEqual(self.read_sampling(db_path), {})
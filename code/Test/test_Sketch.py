@@ -0,0 +1,133 @@
+import collections
+import math
+import random
+import struct
+
+import Lib.TestLibrary as Lib
+
+# Number of values of a distribution listed per host in sketch mode, see statistics_sketch.h
+SKETCH_MAX_HOST_VALUES = 32
+# Number of counters per row of the Count-Min Sketch, see statistics_sketch.h
+CMS_WIDTH = 1 << 18
+
+# Tables listing the values of a distribution per host, with the column of the count of a value
+SKETCH_VALUE_TABLES = {"ip_ttl": 2, "tcp_mss": 2, "tcp_win": 2, "ip_tos": 2, "ip_ports": 3}
+
+
+def read_value_counts(tables: dict, table: str) -> dict:
+    """
+    Reads the counts of the values of every host from a table listing the values of a distribution per host.
+
+    :param tables: statistics tables, see Lib.read_statistics_tables
+    :param table: name of the table
+    :return: dict of host and dict of value and count
+    """
+    column = SKETCH_VALUE_TABLES[table]
+    counts = collections.defaultdict(dict)
+    for row in tables[table]:
+        # The byte count of a port follows its count
+        value = row[1:column] + row[column + 2:] if table == "ip_ports" else row[1:column]
+        counts[row[0]][value] = row[column]
+    return counts
+
+
+def write_port_scan(pcap_path: str, heavy_ports: int, light_ports: int):
+    """
+    Writes a PCAP of TCP packets from one host to another with many distinct ports, so that the counts of the values
+    collide in the Count-Min Sketch. The destination ports are heavy_ports frequent ports, each with a different count,
+    and light_ports ports with two packets each, in random order.
+
+    :param pcap_path: path to the PCAP to write
+    :param heavy_ports: number of frequent destination ports
+    :param light_ports: number of rare destination ports
+    """
+    file_header, byte_order, records = Lib.read_pcap(Lib.test_pcap)
+    # The first Ethernet/IPv4 TCP packet is the template, the frame follows the 16 byte record header
+    template = next(record for record in records if len(record[3]) >= 54 and
+                    record[3][28:30] == b'\x08\x00' and record[3][39] == 6)
+    tcp_offset = 16 + 14 + (template[3][30] & 0x0f) * 4
+    ports = [port for port in range(heavy_ports) for _ in range(20 * (port + 1))]
+    ports += [heavy_ports + port % light_ports for port in range(2 * light_ports)]
+    random.Random(1).shuffle(ports)
+
+    scan = []
+    for i, port in enumerate(ports):
+        timestamp = template[0] + i * 1000
+        data = struct.pack(byte_order + 'II', timestamp // 1000000, timestamp % 1000000) + template[3][8:tcp_offset] + \
+            struct.pack('>HH', 1024 + i % 50000, 1024 + port) + template[3][tcp_offset + 4:]
+        scan.append((timestamp, template[1], template[2], data))
+    Lib.write_pcap(pcap_path, file_header, scan)
+
+
+class UnitTestSketch(Lib.StatisticsTestCase):
+    def write_statistics(self, name: str, sketch_mode: bool, threads: int=1, chunked: bool=False,
+                         pcap_path: str=Lib.test_pcap):
+        return self.collect_statistics(pcap_path, name, threads, chunked, sketch_mode=sketch_mode)
+
+    def check_values(self, exact_tables: dict, sketch_tables: dict, error_bound: int):
+        """
+        Checks the values listed per host in sketch mode against the exact values of every host.
+
+        :param exact_tables: statistics tables without sketch mode
+        :param sketch_tables: statistics tables in sketch mode
+        :param error_bound: amount by which an estimated count may exceed the exact count
+        """
+        for table in SKETCH_VALUE_TABLES:
+            exact_counts = read_value_counts(exact_tables, table)
+            sketch_counts = read_value_counts(sketch_tables, table)
+            self.assertEqual(exact_counts.keys(), sketch_counts.keys(), table)
+            for host, counts in exact_counts.items():
+                listed = sketch_counts[host]
+                self.assertEqual(len(listed), min(len(counts), SKETCH_MAX_HOST_VALUES), (table, host))
+                # The estimates are never lower than the exact counts
+                for value, count in listed.items():
+                    self.assertTrue(counts[value] <= count <= counts[value] + error_bound, (table, host, value))
+                # The listed values are the most frequent values of the host, ties with unlisted values are allowed
+                unlisted = [count for value, count in counts.items() if value not in listed]
+                if unlisted:
+                    self.assertGreaterEqual(min(counts[value] for value in listed) + error_bound, max(unlisted),
+                                            (table, host))
+
+    def check_sketch(self, threads: int, chunked: bool):
+        exact_tables = Lib.read_statistics_tables(self.write_statistics("exact", False))
+        sketch_tables = Lib.read_statistics_tables(self.write_statistics("sketch", True, threads, chunked))
+
+        # The counts of the test PCAP are far below the error bound and its hosts have few peers
+        self.assertEqual(exact_tables.keys(), sketch_tables.keys())
+        for table in exact_tables:
+            if table not in SKETCH_VALUE_TABLES:
+                self.assertEqual(exact_tables[table], sketch_tables[table], table)
+
+        # The listed values keep their exact counts
+        for table in SKETCH_VALUE_TABLES:
+            self.assertTrue(set(sketch_tables[table]) <= set(exact_tables[table]), table)
+        self.check_values(exact_tables, sketch_tables, 0)
+
+    def test_sketch(self):
+        self.check_sketch(1, False)
+
+    def test_sketch_sharded(self):
+        self.check_sketch(8, False)
+
+    def test_sketch_chunked(self):
+        self.check_sketch(3, True)
+
+    def test_sketch_error_bound(self):
+        pcap_path = self.tmp_path("scan.pcap")
+        # The counts of the frequent ports differ by more than the error bound
+        write_port_scan(pcap_path, 40, 60000)
+        exact_tables = Lib.read_statistics_tables(self.write_statistics("exact", False, pcap_path=pcap_path))
+        sketch_tables = Lib.read_statistics_tables(self.write_statistics("sketch", True, pcap_path=pcap_path))
+
+        # Every value of every distribution is counted in the same Count-Min Sketch
+        total = sum(sum(counts.values()) for table in SKETCH_VALUE_TABLES
+                    for counts in read_value_counts(exact_tables, table).values())
+        error_bound = math.ceil(math.e / CMS_WIDTH * total)
+        self.assertLess(error_bound, 20)
+        self.check_values(exact_tables, sketch_tables, error_bound)
+
+        # The rare ports collide with other values, some of their estimates exceed their exact counts
+        exact_counts = read_value_counts(exact_tables, "ip_ports")
+        self.assertTrue(any(count > exact_counts[host][value]
+                            for host, counts in read_value_counts(sketch_tables, "ip_ports").items()
+                            for value, count in counts.items()))
@@ -0,0 +1,88 @@
+import Lib.TestLibrary as Lib
+
+# Interval of the interval statistics in seconds, fixed as the default interval of a part depends on its duration
+INTERVAL = 10.0
+
+def split_pcap(pcap_path: str, first_path: str, second_path: str, split_packet: int):
+    """
+    Writes the packets of a PCAP before and after the given packet number to two PCAP files.
+
+    :param pcap_path: path to the PCAP to split
+    :param first_path: path to the PCAP receiving the packets before split_packet
+    :param second_path: path to the PCAP receiving the packets from split_packet on
+    :param split_packet: number of the first packet of the second PCAP
+    """
+    file_header, _, records = Lib.read_pcap(pcap_path)
+    Lib.write_pcap(first_path, file_header, records[:split_packet])
+    Lib.write_pcap(second_path, file_header, records[split_packet:])
+
+
+class UnitTestStatisticsMerge(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str, extra_tests: bool, name: str) -> str:
+        return self.collect_statistics(pcap_path, name, intervals=[INTERVAL], extra_tests=extra_tests)
+
+    def check_merge(self, pcap_path: str, split_packet: int, extra_tests: bool):
+        first_path = self.tmp_path("first.pcap")
+        second_path = self.tmp_path("second.pcap")
+        split_pcap(pcap_path, first_path, second_path, split_packet)
+
+        single_pass_db = self.write_statistics(pcap_path, extra_tests, "single_pass")
+        first_db = self.write_statistics(first_path, extra_tests, "first")
+        second_db = self.write_statistics(second_path, extra_tests, "second")
+
+        merged = self.create_processor(first_path, "merged", extra_tests)
+        merged.collect_statistics([INTERVAL])
+        second = self.create_processor(second_path, "merged_second", extra_tests)
+        second.collect_statistics([INTERVAL])
+        merged.merge_statistics(second)
+        merged_db = self.tmp_path("merged.sqlite3")
+        merged.write_to_database(merged_db, [INTERVAL], True)
+
+        single_pass_tables = Lib.read_statistics_tables(single_pass_db, False)
+        merged_tables = Lib.read_statistics_tables(merged_db, False)
+        self.assertEqual(single_pass_tables.keys(), merged_tables.keys())
+        for table in single_pass_tables:
+            self.assertEqual(single_pass_tables[table], merged_tables[table], table)
+
+        # The interval statistics of the parts are combined, the intervals of the second part start at its first packet
+        _, single_pass_rows = Lib.read_interval_table(single_pass_db, INTERVAL)
+        _, first_rows = Lib.read_interval_table(first_db, INTERVAL)
+        _, second_rows = Lib.read_interval_table(second_db, INTERVAL)
+        self.assertEqual(Lib.read_interval_table(merged_db, INTERVAL)[1], sorted(first_rows + second_rows, key=str))
+        self.assertTrue(set(first_rows) <= set(single_pass_rows))
+        merged_rates = Lib.merge_interval_rates(Lib.read_interval_rates(first_db), Lib.read_interval_rates(second_db))
+        self.assertEqual(Lib.read_interval_rates(merged_db), merged_rates)
+
+    def test_merge_halves(self):
+        self.check_merge(Lib.test_pcap, 999, False)
+
+    def test_merge_halves_extra_tests(self):
+        self.check_merge(Lib.test_pcap, 999, True)
+
+    def test_merge_uneven_parts_extra_tests(self):
+        self.check_merge(Lib.test_pcap, 1500, True)
+
+    def test_merge_single_conversation(self):
+        self.check_merge(Lib.test_resource_dir + "reference_telnet.pcap", 100, True)
+
+    def check_chunked(self, pcap_path: str, threads: int, interval: float=0.0):
+        single_pass_db = self.collect_statistics(pcap_path, "single_pass", intervals=[interval])
+        chunked_db = self.collect_statistics(pcap_path, "chunked", threads, True, [interval])
+
+        # The intervals of the later chunks continue the intervals of the chunks before, so the interval statistics
+        # and the interval rates of the IPs are exact as well
+        single_pass_tables = Lib.read_statistics_tables(single_pass_db)
+        chunked_tables = Lib.read_statistics_tables(chunked_db)
+        self.assertEqual(single_pass_tables.keys(), chunked_tables.keys())
+        for table in single_pass_tables:
+            self.assertEqual(single_pass_tables[table], chunked_tables[table], table)
+
+    def test_chunked_two_threads(self):
+        self.check_chunked(Lib.test_pcap, 2)
+
+    def test_chunked_many_threads(self):
+        self.check_chunked(Lib.test_pcap, 7)
+
+    def test_chunked_short_interval(self):
+        # The barriers of a short interval lag behind the packets, so chunks are processed again
+        self.check_chunked(Lib.test_resource_dir + "reference_telnet.pcap", 4, 0.01)
@@ -0,0 +1,88 @@
+import os
+import struct
+import subprocess
+
+import Lib.TestLibrary as Lib
+
+
+def write_to_fifo(pcap_path: str, fifo_path: str) -> subprocess.Popen:
+    """
+    Starts writing a PCAP to a named pipe, like tcpdump -w does. The pipe is written by another process, as the
+    statistics are collected without releasing the GIL.
+
+    :param pcap_path: path to the PCAP to write
+    :param fifo_path: path to the named pipe
+    :return: the writing process
+    """
+    return subprocess.Popen(["dd", "if=" + pcap_path, "of=" + fifo_path, "bs=4096"], stderr=subprocess.DEVNULL)
+
+
+def delay_pcap(pcap_path: str, delayed_path: str, first_packet: int, seconds: int):
+    """
+    Writes a PCAP whose packets from the given packet on are delayed, i.e. the capture pauses before that packet.
+
+    :param pcap_path: path to the PCAP to read
+    :param delayed_path: path to the PCAP to write
+    :param first_packet: number of the first delayed packet
+    :param seconds: length of the pause in seconds
+    """
+    file_header, byte_order, records = Lib.read_pcap(pcap_path)
+    delayed = records[:first_packet]
+    for record in records[first_packet:]:
+        data = record[3]
+        (timestamp_seconds,) = struct.unpack(byte_order + 'I', data[:4])
+        data = struct.pack(byte_order + 'I', timestamp_seconds + seconds) + data[4:]
+        delayed.append((record[0] + seconds * 1000000, record[1], record[2], data))
+    Lib.write_pcap(delayed_path, file_header, delayed)
+
+
+class UnitTestStreaming(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str=Lib.test_pcap):
+        return self.collect_statistics(pcap_path, "file")
+
+    def stream_statistics(self, pcap_path: str, interval: float, flush_interval: float, idle_timeout: float=1e9):
+        self.create_processor(pcap_path, "stream").stream_statistics(interval, flush_interval, idle_timeout)
+        return self.tmp_path("stream.sqlite3")
+
+    def check_stream(self, file_db_path: str, stream_db_path: str):
+        file_tables = Lib.read_statistics_tables(file_db_path)
+        stream_tables = Lib.read_statistics_tables(stream_db_path)
+        self.assertEqual(file_tables.keys(), stream_tables.keys())
+        for table in file_tables:
+            self.assertEqual(file_tables[table], stream_tables[table], table)
+
+    def test_stream_fifo(self):
+        file_db_path = self.write_statistics()
+        interval = Lib.read_interval_table(file_db_path)[0]
+
+        fifo_path = self.tmp_path("capture.fifo")
+        os.mkfifo(fifo_path)
+        writer = write_to_fifo(Lib.test_pcap, fifo_path)
+        # Flushing after almost every packet, the flushed rows add up to the statistics of the whole capture
+        stream_db_path = self.stream_statistics(fifo_path, interval, 0.001)
+        self.assertEqual(writer.wait(), 0)
+        self.check_stream(file_db_path, stream_db_path)
+
+    def test_stream_file(self):
+        file_db_path = self.write_statistics()
+        interval = Lib.read_interval_table(file_db_path)[0]
+        self.check_stream(file_db_path, self.stream_statistics(Lib.test_pcap, interval, 10))
+
+    def test_stream_conversations_resumed(self):
+        pcap_path = self.tmp_path("paused.pcap")
+        delay_pcap(Lib.test_pcap, pcap_path, 999, 1000)
+        file_db_path = self.write_statistics(pcap_path)
+        interval = Lib.read_interval_table(file_db_path)[0]
+
+        # The conversations continued after the pause are evicted during the pause and written with both parts
+        stream_db_path = self.stream_statistics(pcap_path, interval, 0.001, 100)
+        self.check_stream(file_db_path, stream_db_path)
+
+    def test_collect_statistics_rejects_fifo(self):
+        fifo_path = self.tmp_path("capture.fifo")
+        os.mkfifo(fifo_path)
+        db_path = self.tmp_path("fifo.sqlite3")
+        pcap_proc = self.create_processor(fifo_path, "fifo")
+        # Returns without opening the pipe, which would block without a writer
+        pcap_proc.collect_statistics([0.0])
+        self.assertFalse(os.path.exists(db_path))
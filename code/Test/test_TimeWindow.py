@@ -0,0 +1,55 @@
+import Lib.TestLibrary as Lib
+
+
+def cut_pcap(pcap_path: str, window_path: str, first_packet: int, last_packet: int):
+    """
+    Writes the packets of a PCAP within the time window between two of its packets to another PCAP.
+
+    :param pcap_path: path to the PCAP to read
+    :param window_path: path to the PCAP receiving the packets of the time window
+    :param first_packet: index of the packet starting the time window
+    :param last_packet: index of the packet ending the time window
+    :return: the timestamps of the first and the last packet in microseconds
+    """
+    file_header, _, records = Lib.read_pcap(pcap_path)
+    start = records[first_packet][0]
+    end = records[last_packet][0]
+    Lib.write_pcap(window_path, file_header, [record for record in records if start <= record[0] <= end])
+    return start, end
+
+
+class UnitTestTimeWindow(Lib.StatisticsTestCase):
+    def write_statistics(self, pcap_path: str, name: str, time_window=None, threads: int=1, chunked: bool=False):
+        return self.collect_statistics(pcap_path, name, threads, chunked, time_window=time_window)
+
+    def check_time_window(self, threads: int, chunked: bool):
+        window_path = self.tmp_path("window.pcap")
+        time_window = cut_pcap(Lib.test_pcap, window_path, 500, 1500)
+
+        window_db_path = self.write_statistics(window_path, "window")
+        restricted_db_path = self.write_statistics(Lib.test_pcap, "restricted", time_window, threads, chunked)
+        window_tables = Lib.read_statistics_tables(window_db_path)
+        restricted_tables = Lib.read_statistics_tables(restricted_db_path)
+        self.assertEqual(window_tables.keys(), restricted_tables.keys())
+        for table in window_tables:
+            self.assertEqual(window_tables[table], restricted_tables[table], table)
+
+    def test_time_window(self):
+        self.check_time_window(1, False)
+
+    def test_time_window_pipeline(self):
+        self.check_time_window(4, False)
+
+    def test_time_window_chunked(self):
+        self.check_time_window(3, True)
+
+    def test_open_time_window(self):
+        window_path = self.tmp_path("window.pcap")
+        start, end = cut_pcap(Lib.test_pcap, window_path, 1000, 1997)
+
+        window_tables = Lib.read_statistics_tables(self.write_statistics(window_path, "window"))
+        restricted_tables = Lib.read_statistics_tables(self.write_statistics(Lib.test_pcap, "restricted",
+                                                                             (start, float('inf'))))
+        self.assertEqual(window_tables.keys(), restricted_tables.keys())
+        for table in window_tables:
+            self.assertEqual(window_tables[table], restricted_tables[table], table)
@@ -0,0 +1,130 @@
+#include <functional>
+#include "address_dictionary.h"
+#include "packet_decoder.h"
+#include "statistics_checkpoint.h"
+
+address_dictionary::address_dictionary() {
+    intern("");
+}
+
+/**
+ * Returns the id of an address, a new id is assigned to an address seen for the first time.
+ * @param address The IP or MAC address as text.
+ * @return the id of the address.
+ */
+address_id address_dictionary::intern(const std::string &address) {
+    auto found = ids.find(address);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    address_id id = static_cast<address_id>(addresses.size());
+    addresses.push_back(address);
+    // The hash of the text, so that the hosts are assigned to the same statistics shards as by their text
+    hashes.push_back(std::hash<std::string>()(address));
+    ids.emplace(address, id);
+    return id;
+}
+
+/**
+ * Returns the id of an IPv4 address, the address is only formatted if it was not seen before.
+ * @param address The IPv4 address in host byte order.
+ * @return the id of the address.
+ */
+address_id address_dictionary::intern_ipv4(uint32_t address) {
+    auto found = ipv4Ids.find(address);
+    if (found != ipv4Ids.end()) {
+        return found->second;
+    }
+    address_id id = intern(ipv4_to_string(address));
+    ipv4Ids.emplace(address, id);
+    return id;
+}
+
+/**
+ * Returns the id of a MAC address, the address is only formatted if it was not seen before.
+ * @param address The 6 bytes of the MAC address.
+ * @return the id of the address.
+ */
+address_id address_dictionary::intern_mac(const uint8_t *address) {
+    uint64_t value = 0;
+    for (int i = 0; i < 6; i++) {
+        value = (value << 8) | address[i];
+    }
+    auto found = macIds.find(value);
+    if (found != macIds.end()) {
+        return found->second;
+    }
+    address_id id = intern(mac_to_string(address));
+    macIds.emplace(value, id);
+    return id;
+}
+
+/**
+ * Looks up the id of an address without interning it.
+ * @param address The IP or MAC address as text.
+ * @param id The id of the address, if it was found.
+ * @return true, if the address was interned before.
+ */
+bool address_dictionary::find(const std::string &address, address_id &id) const {
+    auto found = ids.find(address);
+    if (found == ids.end()) {
+        return false;
+    }
+    id = found->second;
+    return true;
+}
+
+/**
+ * @return the number of interned addresses, including the empty address.
+ */
+std::size_t address_dictionary::size() const {
+    return addresses.size();
+}
+
+/**
+ * Interns all addresses of another dictionary, e.g. of statistics which are merged into the statistics of this
+ * dictionary.
+ * @param other The other dictionary.
+ * @return the ids in this dictionary, indexed by the ids in the other dictionary.
+ */
+std::vector<address_id> address_dictionary::import(const address_dictionary &other) {
+    std::vector<address_id> remap;
+    remap.reserve(other.addresses.size());
+    for (const std::string &address: other.addresses) {
+        remap.push_back(intern(address));
+    }
+    return remap;
+}
+
+/**
+ * Writes the addresses to a checkpoint. The ids of the binary addresses are not saved, they are found again by
+ * their text.
+ * @param out The checkpoint.
+ */
+void address_dictionary::save(checkpoint_writer &out) const {
+    checkpoint_save(out, static_cast<uint64_t>(addresses.size()));
+    for (const std::string &address: addresses) {
+        checkpoint_save(out, address);
+    }
+}
+
+/**
+ * Restores the addresses from a checkpoint with their ids, see save.
+ * @param in The checkpoint.
+ */
+void address_dictionary::load(checkpoint_reader &in) {
+    addresses.clear();
+    hashes.clear();
+    ids.clear();
+    ipv4Ids.clear();
+    macIds.clear();
+    std::size_t size = in.read_length(1);
+    for (std::size_t i = 0; i < size && !in.is_damaged(); i++) {
+        std::string address;
+        checkpoint_load(in, address);
+        intern(address);
+    }
+    if (addresses.empty()) {
+        intern("");
+    }
+}
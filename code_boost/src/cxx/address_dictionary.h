@@ -0,0 +1,60 @@
+/**
+ * Dictionary interning the IP and MAC addresses of the statistics: every distinct address is stored once and the
+ * statistics containers are keyed by its dense id, the text is only needed when the statistics are written.
+ */
+
+#ifndef CPP_PCAPREADER_ADDRESS_DICTIONARY_H
+#define CPP_PCAPREADER_ADDRESS_DICTIONARY_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Id of an interned address. The id 0 is the empty address, used for packets without Ethernet or IPv4 layer.
+ */
+typedef uint32_t address_id;
+
+class checkpoint_writer;
+class checkpoint_reader;
+
+class address_dictionary {
+public:
+    address_dictionary();
+
+    address_id intern(const std::string &address);
+
+    address_id intern_ipv4(uint32_t address);
+
+    address_id intern_mac(const uint8_t *address);
+
+    bool find(const std::string &address, address_id &id) const;
+
+    /*
+     * The addresses are kept in a deque, so the returned references stay valid while further addresses are interned
+     */
+    const std::string &get(address_id id) const { return addresses[id]; }
+
+    std::size_t get_hash(address_id id) const { return hashes[id]; }
+
+    std::size_t size() const;
+
+    std::vector<address_id> import(const address_dictionary &other);
+
+    void save(checkpoint_writer &out) const;
+
+    void load(checkpoint_reader &in);
+
+private:
+    std::deque<std::string> addresses;
+    std::vector<std::size_t> hashes;
+    std::unordered_map<std::string, address_id> ids;
+
+    // Ids of the binary addresses, so that an address seen before is not formatted again
+    std::unordered_map<uint32_t, address_id> ipv4Ids;
+    std::unordered_map<uint64_t, address_id> macIds;
+};
+
+#endif //CPP_PCAPREADER_ADDRESS_DICTIONARY_H
@@ -0,0 +1,253 @@
+/**
+ * Microbenchmark of the containers of the per-host distributions: replays the distribution updates of a capture
+ * into std::unordered_map with the former XOR/shift hashes, into std::unordered_map and flat_hash_map with mixed
+ * hashes of packed keys and into the per-host histograms, and reports the insert and lookup throughput of each.
+ * The statistics count into flat_hash_map and group the counts into the per-host histograms when they are written,
+ * the throughput of this grouping is reported as well.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "address_dictionary.h"
+#include "flat_hash_map.h"
+#include "packet_decoder.h"
+#include "pcap_reader.h"
+#include "statistics.h"
+
+#define BENCHMARK_DEFAULT_ROUNDS 10
+
+/*
+ * Hashes of the distribution keys before they were packed, the port hash ignores the protocol
+ */
+struct legacy_value_hash {
+    std::size_t operator()(const ipAddress_value &k) const {
+        return ((std::hash<address_id>()(k.ipAddress) ^ (std::hash<int>()(k.value) << 1)) >> 1);
+    }
+};
+
+struct legacy_port_hash {
+    std::size_t operator()(const ipAddress_inOut_port &k) const {
+        static const std::size_t in = std::hash<std::string>()("in");
+        static const std::size_t out = std::hash<std::string>()("out");
+        return ((std::hash<address_id>()(k.ipAddress) ^ ((k.incoming ? in : out) << 1)) >> 1)
+               ^ (std::hash<int>()(k.portNumber) << 1);
+    }
+};
+
+/*
+ * The keys of the distribution updates of a capture, in the order of the packets: the 8 bit values (TTL and ToS),
+ * the 16 bit values (window size and MSS) and the ports.
+ */
+struct distribution_keys {
+    std::vector<ipAddress_value> byteValues;
+    std::vector<ipAddress_value> shortValues;
+    std::vector<ipAddress_inOut_port> ports;
+
+    std::size_t size() const { return byteValues.size() + shortValues.size() + ports.size(); }
+};
+
+/**
+ * Collects the keys of the distribution updates of all IPv4 packets of a capture, as collected by the statistics.
+ * @param reader The reader of the capture.
+ * @param keys The collected keys.
+ * @return the number of packets read.
+ */
+static long collect_keys(pcap_reader &reader, distribution_keys &keys) {
+    address_dictionary addresses;
+    const pcap_pkthdr *header = nullptr;
+    const u_char *data = nullptr;
+    decoded_packet pkt;
+    long packets = 0;
+    while (reader.next(header, data)) {
+        packets++;
+        if (!decode_ethernet_packet(*header, data, pkt) || pkt.l3 != l3_protocol::IPV4) {
+            continue;
+        }
+        address_id sender = addresses.intern_ipv4(pkt.ip_src);
+        address_id receiver = addresses.intern_ipv4(pkt.ip_dst);
+        keys.byteValues.push_back({sender, pkt.ttl});
+        keys.byteValues.push_back({sender, pkt.tos});
+        if (pkt.l4 == l4_protocol::TCP) {
+            keys.shortValues.push_back({sender, pkt.window});
+            if (pkt.has_mss) {
+                keys.shortValues.push_back({sender, pkt.mss});
+            }
+        }
+        if (pkt.l4 == l4_protocol::TCP || pkt.l4 == l4_protocol::UDP) {
+            bool udp = pkt.l4 == l4_protocol::UDP;
+            keys.ports.push_back({sender, pkt.sport, false, udp});
+            keys.ports.push_back({receiver, pkt.dport, true, udp});
+        }
+    }
+    return packets;
+}
+
+/*
+ * Access to the count of a value distribution entry, in a map of all hosts or in the histograms of the hosts
+ */
+template<typename Map>
+static int &count_of(Map &map, const ipAddress_value &key) {
+    return map[key];
+}
+
+template<uint32_t Width>
+static int &count_of(host_histograms<Width> &map, const ipAddress_value &key) {
+    return map[key.ipAddress][static_cast<uint32_t>(key.value)];
+}
+
+template<typename Map>
+static int find_count(const Map &map, const ipAddress_value &key) {
+    return map.find(key)->second;
+}
+
+template<uint32_t Width>
+static int find_count(const host_histograms<Width> &map, const ipAddress_value &key) {
+    return map.find(key.ipAddress)->second.count(static_cast<uint32_t>(key.value));
+}
+
+template<typename ByteMap, typename ShortMap, typename PortMap>
+static void fill(const distribution_keys &keys, ByteMap &byteValues, ShortMap &shortValues, PortMap &ports) {
+    for (const ipAddress_value &key: keys.byteValues) {
+        count_of(byteValues, key)++;
+    }
+    for (const ipAddress_value &key: keys.shortValues) {
+        count_of(shortValues, key)++;
+    }
+    for (const ipAddress_inOut_port &key: keys.ports) {
+        ports[key].count++;
+    }
+}
+
+/**
+ * Replays the distribution updates into empty maps.
+ * @param keys The keys of the updates.
+ * @param rounds The number of replays.
+ * @return the seconds of all replays.
+ */
+template<typename ByteMap, typename ShortMap, typename PortMap>
+static double time_inserts(const distribution_keys &keys, int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        ByteMap byteValues;
+        ShortMap shortValues;
+        PortMap ports;
+        fill(keys, byteValues, shortValues, ports);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Looks up the keys of the distribution updates in filled maps.
+ * @param keys The keys of the updates.
+ * @param rounds The number of passes over the keys.
+ * @param checksum The sum of the counts found, so that the lookups are not optimized away.
+ * @return the seconds of all passes.
+ */
+template<typename ByteMap, typename ShortMap, typename PortMap>
+static double time_lookups(const distribution_keys &keys, int rounds, long &checksum) {
+    ByteMap byteValues;
+    ShortMap shortValues;
+    PortMap ports;
+    fill(keys, byteValues, shortValues, ports);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const ipAddress_value &key: keys.byteValues) {
+            checksum += find_count(byteValues, key);
+        }
+        for (const ipAddress_value &key: keys.shortValues) {
+            checksum += find_count(shortValues, key);
+        }
+        for (const ipAddress_inOut_port &key: keys.ports) {
+            checksum += ports.find(key)->second.count;
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Times one kind of containers and prints its throughput in million operations per second.
+ * @param name The name of the containers.
+ * @param keys The keys of the distribution updates.
+ * @param rounds The number of replays.
+ */
+template<typename ByteMap, typename ShortMap, typename PortMap>
+static void run(const std::string &name, const distribution_keys &keys, int rounds) {
+    double operations = static_cast<double>(keys.size()) * rounds;
+    long checksum = 0;
+    double insertSeconds = time_inserts<ByteMap, ShortMap, PortMap>(keys, rounds);
+    double lookupSeconds = time_lookups<ByteMap, ShortMap, PortMap>(keys, rounds, checksum);
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << operations / insertSeconds / 1e6 << " M inserts/s"
+              << std::setw(10) << operations / lookupSeconds / 1e6 << " M lookups/s"
+              << " (checksum " << checksum << ")" << std::endl;
+}
+
+/**
+ * Times the grouping of filled distributions into the per-host histograms, as done when the statistics are written,
+ * and prints its throughput in million entries per second.
+ * @param keys The keys of the distribution updates.
+ * @param rounds The number of groupings.
+ */
+static void run_builds(const distribution_keys &keys, int rounds) {
+    host_values byteValues;
+    host_values shortValues;
+    flat_hash_map<ipAddress_inOut_port, entry_portStat> ports;
+    fill(keys, byteValues, shortValues, ports);
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        checksum += static_cast<long>(buildHostHistograms<HISTOGRAM_BYTE_VALUES>(byteValues).size());
+        checksum += static_cast<long>(buildHostHistograms<HISTOGRAM_SHORT_VALUES>(shortValues).size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double entries = static_cast<double>(byteValues.size() + shortValues.size()) * rounds;
+    std::cout << std::left << std::setw(40) << "histograms per host, built from flat" << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << entries / seconds / 1e6 << " M entries/s"
+              << " (" << byteValues.size() + shortValues.size() << " entries, checksum " << checksum << ")"
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <path_to_pcap_file> [rounds]" << std::endl;
+        return 1;
+    }
+    int rounds = argc > 2 ? std::atoi(argv[2]) : BENCHMARK_DEFAULT_ROUNDS;
+    if (rounds < 1) {
+        std::cerr << "ERROR: The number of rounds has to be positive." << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<pcap_reader> reader = pcap_reader::open(argv[1]);
+    if (!reader || !reader->is_open()) {
+        std::cerr << "ERROR: Could not open " << argv[1] << "." << std::endl;
+        return 1;
+    }
+    distribution_keys keys;
+    long packets = collect_keys(*reader, keys);
+    std::cout << packets << " packets, " << keys.byteValues.size() + keys.shortValues.size() << " value updates, "
+              << keys.ports.size() << " port updates, " << rounds << " rounds" << std::endl;
+
+    typedef std::unordered_map<ipAddress_value, int, legacy_value_hash> legacy_values;
+    typedef std::unordered_map<ipAddress_inOut_port, entry_portStat, legacy_port_hash> legacy_ports;
+    run<legacy_values, legacy_values, legacy_ports>("unordered_map, XOR/shift hash", keys, rounds);
+
+    typedef std::unordered_map<ipAddress_value, int> mixed_values;
+    typedef std::unordered_map<ipAddress_inOut_port, entry_portStat> mixed_ports;
+    run<mixed_values, mixed_values, mixed_ports>("unordered_map, mixed packed key", keys, rounds);
+
+    typedef flat_hash_map<ipAddress_inOut_port, entry_portStat> flat_ports;
+    run<host_values, host_values, flat_ports>("flat_hash_map, mixed packed key", keys, rounds);
+
+    run<host_histograms<HISTOGRAM_BYTE_VALUES>, host_histograms<HISTOGRAM_SHORT_VALUES>, flat_ports>(
+            "flat_hash_map, histograms per host", keys, rounds);
+    run_builds(keys, rounds);
+    return 0;
+}
@@ -0,0 +1,632 @@
+#include "compressed_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define GZIP_WINDOW_BITS 15
+#define GZIP_HEADER_WINDOW_BITS 16
+#define GZIP_AUTODETECT_WINDOW_BITS 32
+#define GZIP_MEMORY_LEVEL 8
+#define XZ_PRESET 6
+#define ZSTD_LEVEL 3
+
+/*
+ * Results of stream_codec::process
+ */
+enum codec_status {
+    CODEC_OK,
+    CODEC_END,
+    CODEC_ERROR
+};
+
+/*
+ * Compression or decompression state of one of the supported formats. process() consumes input and produces
+ * output until one of the buffers is exhausted, finish tells it that no more input follows.
+ */
+class stream_codec {
+public:
+    virtual ~stream_codec() {}
+
+    virtual codec_status process(const char *&input, std::size_t &inputSize, char *&output, std::size_t &outputSize,
+                                 bool finish) = 0;
+
+    const std::string &get_error() const {
+        return error;
+    }
+
+protected:
+    std::string error;
+};
+
+#ifdef HAVE_ZLIB
+class gzip_codec : public stream_codec {
+public:
+    gzip_codec(bool compress) : compress(compress), memberEnded(false), initialized(false) {
+        std::memset(&stream, 0, sizeof(stream));
+        int result = compress ? deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                             GZIP_WINDOW_BITS + GZIP_HEADER_WINDOW_BITS, GZIP_MEMORY_LEVEL,
+                                             Z_DEFAULT_STRATEGY)
+                              : inflateInit2(&stream, GZIP_WINDOW_BITS + GZIP_AUTODETECT_WINDOW_BITS);
+        initialized = (result == Z_OK);
+        if (!initialized) {
+            error = "could not initialize zlib";
+        }
+    }
+
+    ~gzip_codec() {
+        if (initialized) {
+            compress ? deflateEnd(&stream) : inflateEnd(&stream);
+        }
+    }
+
+    codec_status process(const char *&input, std::size_t &inputSize, char *&output, std::size_t &outputSize,
+                         bool finish) override {
+        if (!initialized) {
+            return CODEC_ERROR;
+        }
+        // Concatenated gzip members are decompressed as one stream
+        if (!compress && finish && inputSize == 0 && memberEnded) {
+            return CODEC_END;
+        }
+        if (inputSize > 0) {
+            memberEnded = false;
+        }
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+        stream.avail_in = static_cast<uInt>(std::min<std::size_t>(inputSize, UINT32_MAX));
+        stream.next_out = reinterpret_cast<Bytef *>(output);
+        stream.avail_out = static_cast<uInt>(std::min<std::size_t>(outputSize, UINT32_MAX));
+        uInt availableIn = stream.avail_in;
+        uInt availableOut = stream.avail_out;
+
+        int result = compress ? deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH) : inflate(&stream, Z_NO_FLUSH);
+
+        input += availableIn - stream.avail_in;
+        inputSize -= availableIn - stream.avail_in;
+        output += availableOut - stream.avail_out;
+        outputSize -= availableOut - stream.avail_out;
+
+        if (result == Z_STREAM_END) {
+            if (compress) {
+                return CODEC_END;
+            }
+            memberEnded = true;
+            inflateReset(&stream);
+            return (finish && inputSize == 0) ? CODEC_END : CODEC_OK;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            error = stream.msg != nullptr ? stream.msg : "invalid gzip data";
+            return CODEC_ERROR;
+        }
+        return CODEC_OK;
+    }
+
+private:
+    z_stream stream;
+    bool compress;
+    bool memberEnded;
+    bool initialized;
+};
+#endif
+
+#ifdef HAVE_LZMA
+class xz_codec : public stream_codec {
+public:
+    xz_codec(bool compress) {
+        lzma_stream initialStream = LZMA_STREAM_INIT;
+        stream = initialStream;
+        lzma_ret result = compress ? lzma_easy_encoder(&stream, XZ_PRESET, LZMA_CHECK_CRC64)
+                                   : lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED);
+        if (result != LZMA_OK) {
+            error = "could not initialize liblzma";
+        }
+    }
+
+    ~xz_codec() {
+        lzma_end(&stream);
+    }
+
+    codec_status process(const char *&input, std::size_t &inputSize, char *&output, std::size_t &outputSize,
+                         bool finish) override {
+        if (!error.empty()) {
+            return CODEC_ERROR;
+        }
+        stream.next_in = reinterpret_cast<const uint8_t *>(input);
+        stream.avail_in = inputSize;
+        stream.next_out = reinterpret_cast<uint8_t *>(output);
+        stream.avail_out = outputSize;
+
+        lzma_ret result = lzma_code(&stream, finish ? LZMA_FINISH : LZMA_RUN);
+
+        input += inputSize - stream.avail_in;
+        inputSize = stream.avail_in;
+        output += outputSize - stream.avail_out;
+        outputSize = stream.avail_out;
+
+        if (result == LZMA_STREAM_END) {
+            return CODEC_END;
+        }
+        if (result != LZMA_OK && result != LZMA_BUF_ERROR) {
+            error = result == LZMA_MEM_ERROR ? "out of memory" : "invalid xz data";
+            return CODEC_ERROR;
+        }
+        return CODEC_OK;
+    }
+
+private:
+    lzma_stream stream;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+class zstd_codec : public stream_codec {
+public:
+    zstd_codec(bool compress) : compressStream(nullptr), decompressStream(nullptr), frameEnded(false) {
+        if (compress) {
+            compressStream = ZSTD_createCStream();
+            if (compressStream == nullptr || ZSTD_isError(ZSTD_initCStream(compressStream, ZSTD_LEVEL))) {
+                error = "could not initialize zstd";
+            }
+        } else {
+            decompressStream = ZSTD_createDStream();
+            if (decompressStream == nullptr || ZSTD_isError(ZSTD_initDStream(decompressStream))) {
+                error = "could not initialize zstd";
+            }
+        }
+    }
+
+    ~zstd_codec() {
+        ZSTD_freeCStream(compressStream);
+        ZSTD_freeDStream(decompressStream);
+    }
+
+    codec_status process(const char *&input, std::size_t &inputSize, char *&output, std::size_t &outputSize,
+                         bool finish) override {
+        if (!error.empty()) {
+            return CODEC_ERROR;
+        }
+        // Consecutive zstd frames are decompressed as one stream
+        if (decompressStream != nullptr && finish && inputSize == 0 && frameEnded) {
+            return CODEC_END;
+        }
+        ZSTD_inBuffer in = {input, inputSize, 0};
+        ZSTD_outBuffer out = {output, outputSize, 0};
+
+        std::size_t result;
+        if (compressStream == nullptr) {
+            result = ZSTD_decompressStream(decompressStream, &out, &in);
+        } else if (!finish || inputSize > 0) {
+            result = ZSTD_compressStream(compressStream, &out, &in);
+        } else {
+            result = ZSTD_endStream(compressStream, &out);
+        }
+
+        input += in.pos;
+        inputSize -= in.pos;
+        output += out.pos;
+        outputSize -= out.pos;
+
+        if (ZSTD_isError(result)) {
+            error = ZSTD_getErrorName(result);
+            return CODEC_ERROR;
+        }
+        if (compressStream != nullptr) {
+            return (finish && inputSize == 0 && in.size == 0 && result == 0) ? CODEC_END : CODEC_OK;
+        }
+        if (in.pos > 0 || out.pos > 0) {
+            frameEnded = (result == 0);
+        }
+        return (finish && inputSize == 0 && frameEnded) ? CODEC_END : CODEC_OK;
+    }
+
+private:
+    ZSTD_CStream *compressStream;
+    ZSTD_DStream *decompressStream;
+    bool frameEnded;
+};
+#endif
+
+/**
+ * Creates the compression or decompression state of a format.
+ * @param format The compression format.
+ * @param compress Whether to compress or to decompress.
+ * @param error Set to the error message, if the format is not supported by this build.
+ * @return the codec, nullptr if the format is not supported.
+ */
+static std::unique_ptr<stream_codec> create_codec(compression_format format, bool compress, std::string &error) {
+    std::unique_ptr<stream_codec> codec;
+    switch (format) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP:
+            codec.reset(new gzip_codec(compress));
+            break;
+#endif
+#ifdef HAVE_LZMA
+        case COMPRESSION_XZ:
+            codec.reset(new xz_codec(compress));
+            break;
+#endif
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD:
+            codec.reset(new zstd_codec(compress));
+            break;
+#endif
+        default:
+            error = "compression format not supported by this build";
+            return nullptr;
+    }
+    if (!codec->get_error().empty()) {
+        error = codec->get_error();
+        return nullptr;
+    }
+    return codec;
+}
+
+/**
+ * Detects the compression format of a file by its magic number.
+ * @param filePath The path to the file.
+ * @return the compression format, COMPRESSION_NONE if the file is not compressed or cannot be read.
+ */
+compression_format detect_compression(const std::string &filePath) {
+    static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+    static const unsigned char xzMagic[] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+    static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+    unsigned char magic[sizeof(xzMagic)] = {0};
+    FILE *file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) {
+        return COMPRESSION_NONE;
+    }
+    std::size_t size = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (size >= sizeof(gzipMagic) && std::memcmp(magic, gzipMagic, sizeof(gzipMagic)) == 0) {
+        return COMPRESSION_GZIP;
+    }
+    if (size >= sizeof(xzMagic) && std::memcmp(magic, xzMagic, sizeof(xzMagic)) == 0) {
+        return COMPRESSION_XZ;
+    }
+    if (size >= sizeof(zstdMagic) && std::memcmp(magic, zstdMagic, sizeof(zstdMagic)) == 0) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+/**
+ * @param format The compression format.
+ * @return the usual file extension of the format including the dot, empty for COMPRESSION_NONE.
+ */
+std::string get_compression_extension(compression_format format) {
+    switch (format) {
+        case COMPRESSION_GZIP:
+            return ".gz";
+        case COMPRESSION_XZ:
+            return ".xz";
+        case COMPRESSION_ZSTD:
+            return ".zst";
+        default:
+            return "";
+    }
+}
+
+/*
+ * Callbacks connecting the FILE streams of the readers and writers, glibc provides fopencookie, BSD and macOS funopen
+ */
+#ifdef __APPLE__
+static int read_cookie(void *cookie, char *buffer, int size) {
+    return static_cast<int>(static_cast<compressed_file_reader *>(cookie)->read(buffer, static_cast<std::size_t>(size)));
+}
+
+static int write_cookie(void *cookie, const char *buffer, int size) {
+    return static_cast<compressed_file_writer *>(cookie)->write(buffer, static_cast<std::size_t>(size)) ? size : -1;
+}
+#else
+static ssize_t read_cookie(void *cookie, char *buffer, size_t size) {
+    return static_cast<ssize_t>(static_cast<compressed_file_reader *>(cookie)->read(buffer, size));
+}
+
+static ssize_t write_cookie(void *cookie, const char *buffer, size_t size) {
+    return static_cast<compressed_file_writer *>(cookie)->write(buffer, size) ? static_cast<ssize_t>(size) : -1;
+}
+#endif
+
+static int close_reader_cookie(void *) {
+    return 0;
+}
+
+static int close_writer_cookie(void *cookie) {
+    return static_cast<compressed_file_writer *>(cookie)->close() ? 0 : EOF;
+}
+
+/**
+ * Opens a compressed file and starts decompressing it into the ring of buffers.
+ * @param filePath The path to the compressed file.
+ * @param format The compression format of the file.
+ */
+compressed_file_reader::compressed_file_reader(const std::string &filePath, compression_format format)
+        : file(nullptr), fileSize(0), buffers(DECOMPRESSION_RING_BUFFERS), freeBuffers(DECOMPRESSION_RING_BUFFERS),
+          filledBuffers(DECOMPRESSION_RING_BUFFERS), current({0, 0, false}), currentOffset(0), hasCurrent(false),
+          finished(false), position(0), stopped(false) {
+    codec = create_codec(format, false, openError);
+    if (codec == nullptr) {
+        return;
+    }
+    file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) {
+        openError = std::strerror(errno);
+        return;
+    }
+    struct stat buffer;
+    if (stat(filePath.c_str(), &buffer) == 0) {
+        fileSize = static_cast<uint64_t>(buffer.st_size);
+    }
+
+    for (std::size_t i = 0; i < buffers.size(); i++) {
+        buffers[i].resize(DECOMPRESSION_BUFFER_SIZE);
+        freeBuffers.try_push(i);
+    }
+    worker = std::thread(&compressed_file_reader::decompress, this);
+}
+
+compressed_file_reader::~compressed_file_reader() {
+    stopped.store(true);
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+/**
+ * Decompression thread: Fills the free buffers of the ring with decompressed data until the end of the file, an
+ * error or until the reader is destroyed. The last buffer is marked, errors are reported by get_error().
+ */
+void compressed_file_reader::decompress() {
+    std::vector<char> input(COMPRESSION_BUFFER_SIZE);
+    const char *nextInput = input.data();
+    std::size_t inputSize = 0;
+    bool endOfFile = false;
+    uint64_t readBytes = 0;
+
+    std::size_t buffer;
+    codec_status status = CODEC_OK;
+    while (status == CODEC_OK && freeBuffers.pop(buffer, stopped)) {
+        char *output = buffers[buffer].data();
+        std::size_t outputSize = buffers[buffer].size();
+
+        while (outputSize > 0 && status == CODEC_OK) {
+            if (inputSize == 0 && !endOfFile) {
+                inputSize = fread(input.data(), 1, input.size(), file);
+                nextInput = input.data();
+                endOfFile = inputSize < input.size();
+                if (ferror(file)) {
+                    decompressError = std::strerror(errno);
+                    status = CODEC_ERROR;
+                    break;
+                }
+                readBytes += inputSize;
+                position.store(readBytes, std::memory_order_relaxed);
+            }
+
+            std::size_t previousInputSize = inputSize;
+            std::size_t previousOutputSize = outputSize;
+            status = codec->process(nextInput, inputSize, output, outputSize, endOfFile);
+            if (status == CODEC_ERROR) {
+                decompressError = codec->get_error();
+            } else if (status == CODEC_OK && endOfFile && previousInputSize == 0 &&
+                       outputSize == previousOutputSize) {
+                decompressError = "unexpected end of compressed data";
+                status = CODEC_ERROR;
+            }
+        }
+
+        ring_block block = {buffer, buffers[buffer].size() - outputSize, status != CODEC_OK};
+        if (!filledBuffers.push(block, stopped)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @return true if the file could be opened and its format is supported.
+ */
+bool compressed_file_reader::is_open() const {
+    return file != nullptr;
+}
+
+/**
+ * @return the reason the file could not be opened, or the decompression error once all data was read.
+ */
+std::string compressed_file_reader::get_error() const {
+    return finished ? decompressError : openError;
+}
+
+/**
+ * Copies the next decompressed bytes, waits for the decompression thread if needed.
+ * @param destination Buffer receiving the bytes.
+ * @param size Maximum number of bytes to copy.
+ * @return the number of bytes copied, less than size only at the end of the file or after an error.
+ */
+std::size_t compressed_file_reader::read(char *destination, std::size_t size) {
+    std::size_t copied = 0;
+    while (copied < size && !finished) {
+        if (hasCurrent && currentOffset == current.size) {
+            if (current.last) {
+                finished = true;
+                break;
+            }
+            freeBuffers.try_push(current.buffer);
+            hasCurrent = false;
+        }
+        if (!hasCurrent) {
+            if (!filledBuffers.pop(current, stopped)) {
+                break;
+            }
+            currentOffset = 0;
+            hasCurrent = true;
+        }
+
+        std::size_t length = std::min(size - copied, current.size - currentOffset);
+        std::memcpy(destination + copied, buffers[current.buffer].data() + currentOffset, length);
+        currentOffset += length;
+        copied += length;
+    }
+    return copied;
+}
+
+/**
+ * Creates a read-only FILE returning the decompressed bytes, e.g. for pcap_fopen_offline. Closing it does not
+ * close the reader, which has to outlive it.
+ * @return the FILE, nullptr if it could not be created.
+ */
+FILE *compressed_file_reader::open_stream() {
+#ifdef __APPLE__
+    return funopen(this, read_cookie, nullptr, nullptr, close_reader_cookie);
+#else
+    cookie_io_functions_t functions = {read_cookie, nullptr, nullptr, close_reader_cookie};
+    return fopencookie(this, "rb", functions);
+#endif
+}
+
+/**
+ * @return the number of compressed bytes read so far.
+ */
+uint64_t compressed_file_reader::get_position() const {
+    return position.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return the size of the compressed file in bytes.
+ */
+uint64_t compressed_file_reader::get_file_size() const {
+    return fileSize;
+}
+
+/**
+ * Creates a compressed file.
+ * @param filePath The path to the file.
+ * @param format The compression format to write.
+ */
+compressed_file_writer::compressed_file_writer(const std::string &filePath, compression_format format)
+        : file(nullptr), buffer(COMPRESSION_BUFFER_SIZE) {
+    codec = create_codec(format, true, error);
+    if (codec == nullptr) {
+        return;
+    }
+    file = fopen(filePath.c_str(), "wb");
+    if (file == nullptr) {
+        error = std::strerror(errno);
+    }
+}
+
+compressed_file_writer::~compressed_file_writer() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+/**
+ * @return true if the file could be created and its format is supported.
+ */
+bool compressed_file_writer::is_open() const {
+    return file != nullptr;
+}
+
+/**
+ * @return the error message of the last failed operation.
+ */
+const std::string &compressed_file_writer::get_error() const {
+    return error;
+}
+
+/**
+ * Writes the first size bytes of the output buffer to the file.
+ * @param size Number of bytes to write.
+ * @return false if the file could not be written.
+ */
+bool compressed_file_writer::flush_buffer(std::size_t size) {
+    if (fwrite(buffer.data(), 1, size, file) != size) {
+        error = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Compresses bytes and writes the compressed data to the file whenever the output buffer is full.
+ * @param source The bytes to compress.
+ * @param size Number of bytes.
+ * @return false if the data could not be compressed or written.
+ */
+bool compressed_file_writer::write(const char *source, std::size_t size) {
+    if (file == nullptr) {
+        return false;
+    }
+    while (size > 0) {
+        char *output = buffer.data();
+        std::size_t outputSize = buffer.size();
+        if (codec->process(source, size, output, outputSize, false) == CODEC_ERROR) {
+            error = codec->get_error();
+            return false;
+        }
+        if (!flush_buffer(buffer.size() - outputSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Finishes the compressed stream and closes the file.
+ * @return false if the file could not be completed.
+ */
+bool compressed_file_writer::close() {
+    if (file == nullptr) {
+        return false;
+    }
+    const char *input = nullptr;
+    std::size_t inputSize = 0;
+    codec_status status = CODEC_OK;
+    bool written = true;
+    while (status == CODEC_OK && written) {
+        char *output = buffer.data();
+        std::size_t outputSize = buffer.size();
+        status = codec->process(input, inputSize, output, outputSize, true);
+        written = flush_buffer(buffer.size() - outputSize);
+    }
+    if (status == CODEC_ERROR) {
+        error = codec->get_error();
+    }
+    bool closed = (fclose(file) == 0);
+    file = nullptr;
+    if (!closed && error.empty()) {
+        error = std::strerror(errno);
+    }
+    return status == CODEC_END && written && closed;
+}
+
+/**
+ * Creates a write-only FILE compressing everything written to it, e.g. for pcap_dump_fopen. Closing it completes
+ * the compressed file, the writer has to outlive it.
+ * @return the FILE, nullptr if it could not be created.
+ */
+FILE *compressed_file_writer::open_stream() {
+#ifdef __APPLE__
+    return funopen(this, nullptr, write_cookie, nullptr, close_writer_cookie);
+#else
+    cookie_io_functions_t functions = {nullptr, write_cookie, nullptr, close_writer_cookie};
+    return fopencookie(this, "wb", functions);
+#endif
+}
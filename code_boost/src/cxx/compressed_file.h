@@ -0,0 +1,131 @@
+/**
+ * Classes reading and writing gzip, xz and zstd compressed files as a stream of bytes.
+ */
+
+#ifndef CPP_PCAPREADER_COMPRESSED_FILE_H
+#define CPP_PCAPREADER_COMPRESSED_FILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.h"
+
+#define DECOMPRESSION_RING_BUFFERS 8
+#define DECOMPRESSION_BUFFER_SIZE (1024 * 1024)
+#define COMPRESSION_BUFFER_SIZE (256 * 1024)
+
+/*
+ * Compression formats detected by their magic numbers
+ */
+enum compression_format {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_XZ,
+    COMPRESSION_ZSTD
+};
+
+compression_format detect_compression(const std::string &filePath);
+
+std::string get_compression_extension(compression_format format);
+
+/*
+ * Compression or decompression state of one of the supported formats, defined in compressed_file.cpp
+ */
+class stream_codec;
+
+/*
+ * Struct used to represent a buffer of the decompression ring which was filled by the decompression thread:
+ * - Index of the buffer
+ * - Number of bytes in the buffer
+ * - Whether it is the last buffer of the file
+ */
+struct ring_block {
+    std::size_t buffer;
+    std::size_t size;
+    bool last;
+};
+
+/*
+ * Reader decompressing a file on a separate thread into a ring of buffers. The decompressed bytes are read with
+ * read() or through the FILE returned by open_stream() by exactly one consumer thread.
+ */
+class compressed_file_reader {
+public:
+    compressed_file_reader(const std::string &filePath, compression_format format);
+
+    ~compressed_file_reader();
+
+    compressed_file_reader(const compressed_file_reader &) = delete;
+
+    compressed_file_reader &operator=(const compressed_file_reader &) = delete;
+
+    bool is_open() const;
+
+    std::string get_error() const;
+
+    std::size_t read(char *destination, std::size_t size);
+
+    FILE *open_stream();
+
+    uint64_t get_position() const;
+
+    uint64_t get_file_size() const;
+
+private:
+    FILE *file;
+    uint64_t fileSize;
+    std::unique_ptr<stream_codec> codec;
+    std::vector<std::vector<char>> buffers;
+    spsc_queue<std::size_t> freeBuffers;
+    spsc_queue<ring_block> filledBuffers;
+    ring_block current;
+    std::size_t currentOffset;
+    bool hasCurrent;
+    bool finished;
+    std::atomic<uint64_t> position;
+    std::atomic<bool> stopped;
+    std::thread worker;
+    std::string openError;
+    std::string decompressError;
+
+    void decompress();
+};
+
+/*
+ * Writer compressing everything written to the FILE returned by open_stream(). The file is complete once that FILE
+ * was closed, check get_error() afterwards.
+ */
+class compressed_file_writer {
+public:
+    compressed_file_writer(const std::string &filePath, compression_format format);
+
+    ~compressed_file_writer();
+
+    compressed_file_writer(const compressed_file_writer &) = delete;
+
+    compressed_file_writer &operator=(const compressed_file_writer &) = delete;
+
+    bool is_open() const;
+
+    const std::string &get_error() const;
+
+    bool write(const char *source, std::size_t size);
+
+    bool close();
+
+    FILE *open_stream();
+
+private:
+    FILE *file;
+    std::unique_ptr<stream_codec> codec;
+    std::vector<char> buffer;
+    std::string error;
+
+    bool flush_buffer(std::size_t size);
+};
+
+#endif //CPP_PCAPREADER_COMPRESSED_FILE_H
@@ -0,0 +1,239 @@
+/**
+ * Open-addressing hash map storing its entries in one flat array, used for the per-host distributions of the
+ * statistics, whose small keys are looked up for almost every packet.
+ */
+
+#ifndef CPP_PCAPREADER_FLAT_HASH_MAP_H
+#define CPP_PCAPREADER_FLAT_HASH_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#define FLAT_HASH_MAP_MIN_CAPACITY 16
+
+/*
+ * Mixes the bits of a value, so that the hashes of similar values are spread evenly (splitmix64 finalizer)
+ */
+inline uint64_t mix_bits(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/*
+ * Hash of integer keys for flat_hash_map, as std::hash of integers does not mix their bits
+ */
+struct mixed_integer_hash {
+    std::size_t operator()(uint64_t key) const { return mix_bits(key); }
+};
+
+/*
+ * Hash map with linear probing in a power of two sized array, filled at most to three quarters. The hash of the keys
+ * must mix all bits of the key, as the slot is taken from its low bits. Entries are never erased.
+ *
+ * The iteration starts behind the first empty slot and wraps around. Inserting the entries in this order into an empty
+ * map of the same capacity restores the same layout, so that restored maps iterate in the same order.
+ * Inserting an entry invalidates all iterators.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class flat_hash_map {
+public:
+    typedef std::pair<Key, Value> value_type;
+
+    template<typename Map, typename Entry>
+    class basic_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename flat_hash_map::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Entry *pointer;
+        typedef Entry &reference;
+
+        basic_iterator(Map *map, std::size_t start, std::size_t offset) : map(map), start(start), offset(offset) {
+            skip_empty();
+        }
+
+        reference operator*() const { return map->entries[slot()]; }
+
+        pointer operator->() const { return &map->entries[slot()]; }
+
+        basic_iterator &operator++() {
+            offset++;
+            skip_empty();
+            return *this;
+        }
+
+        bool operator==(const basic_iterator &other) const { return offset == other.offset; }
+
+        bool operator!=(const basic_iterator &other) const { return offset != other.offset; }
+
+    private:
+        std::size_t slot() const { return (start + offset) & (map->used.size() - 1); }
+
+        void skip_empty() {
+            while (offset < map->used.size() && !map->used[slot()]) {
+                offset++;
+            }
+        }
+
+        Map *map;
+        std::size_t start;
+        std::size_t offset;
+    };
+
+    typedef basic_iterator<flat_hash_map, value_type> iterator;
+    typedef basic_iterator<const flat_hash_map, const value_type> const_iterator;
+
+    flat_hash_map() : filled(0), firstEmpty(0) {}
+
+    Value &operator[](const Key &key) {
+        return entries[insert_slot(key)].second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type &entry) {
+        std::size_t size = filled;
+        std::size_t slot = insert_slot(entry.first);
+        bool inserted = filled != size;
+        if (inserted) {
+            entries[slot].second = entry.second;
+        }
+        return std::make_pair(iterator_at(slot), inserted);
+    }
+
+    iterator find(const Key &key) {
+        std::size_t slot = find_slot(key);
+        return slot == used.size() ? end() : iterator_at(slot);
+    }
+
+    const_iterator find(const Key &key) const {
+        std::size_t slot = find_slot(key);
+        return slot == used.size() ? end() : const_iterator(this, first_slot(), (slot - first_slot()) & mask());
+    }
+
+    std::size_t count(const Key &key) const { return find_slot(key) == used.size() ? 0 : 1; }
+
+    std::size_t size() const { return filled; }
+
+    bool empty() const { return filled == 0; }
+
+    std::size_t capacity() const { return used.size(); }
+
+    /*
+     * Removes all entries and releases the array
+     */
+    void clear() {
+        std::vector<value_type>().swap(entries);
+        std::vector<uint8_t>().swap(used);
+        filled = 0;
+        firstEmpty = 0;
+    }
+
+    /*
+     * Grows the array, so that at least size entries fit without growing it again
+     */
+    void reserve(std::size_t size) {
+        if (size == 0) {
+            return;
+        }
+        std::size_t newCapacity = used.empty() ? FLAT_HASH_MAP_MIN_CAPACITY : used.size();
+        while (size > newCapacity / 4 * 3) {
+            newCapacity *= 2;
+        }
+        if (newCapacity != used.size()) {
+            rehash(newCapacity);
+        }
+    }
+
+    iterator begin() { return iterator(this, first_slot(), 0); }
+
+    iterator end() { return iterator(this, 0, used.size()); }
+
+    const_iterator begin() const { return const_iterator(this, first_slot(), 0); }
+
+    const_iterator end() const { return const_iterator(this, 0, used.size()); }
+
+private:
+    std::size_t mask() const { return used.size() - 1; }
+
+    /*
+     * Returns the slot behind the first empty slot, where the iteration starts
+     */
+    std::size_t first_slot() const { return (firstEmpty + 1) & mask(); }
+
+    iterator iterator_at(std::size_t slot) {
+        std::size_t start = first_slot();
+        return iterator(this, start, (slot - start) & mask());
+    }
+
+    /*
+     * Returns the slot of a key or the capacity, if the key is missing
+     */
+    std::size_t find_slot(const Key &key) const {
+        if (filled == 0) {
+            return used.size();
+        }
+        std::size_t slot = Hash()(key) & mask();
+        while (used[slot]) {
+            if (entries[slot].first == key) {
+                return slot;
+            }
+            slot = (slot + 1) & mask();
+        }
+        return used.size();
+    }
+
+    /*
+     * Returns the slot of a key, a value initialized entry is inserted if the key is missing
+     */
+    std::size_t insert_slot(const Key &key) {
+        if (filled + 1 > used.size() / 4 * 3) {
+            reserve(filled + 1);
+        }
+        std::size_t slot = Hash()(key) & mask();
+        while (used[slot]) {
+            if (entries[slot].first == key) {
+                return slot;
+            }
+            slot = (slot + 1) & mask();
+        }
+        used[slot] = 1;
+        entries[slot] = value_type(key, Value());
+        filled++;
+        // Slots are never freed, so the first empty slot only moves forward
+        while (used[firstEmpty]) {
+            firstEmpty++;
+        }
+        return slot;
+    }
+
+    /*
+     * Moves the entries into a new array, in iteration order to keep maps with the same entries in the same layout
+     */
+    void rehash(std::size_t newCapacity) {
+        std::vector<value_type> oldEntries(newCapacity);
+        std::vector<uint8_t> oldUsed(newCapacity, 0);
+        std::size_t start = first_slot();
+        oldEntries.swap(entries);
+        oldUsed.swap(used);
+        filled = 0;
+        firstEmpty = 0;
+        for (std::size_t offset = 0; offset < oldUsed.size(); offset++) {
+            std::size_t slot = (start + offset) & (oldUsed.size() - 1);
+            if (oldUsed[slot]) {
+                std::size_t newSlot = insert_slot(oldEntries[slot].first);
+                entries[newSlot].second = std::move(oldEntries[slot].second);
+            }
+        }
+    }
+
+    std::vector<value_type> entries;
+    std::vector<uint8_t> used;
+    std::size_t filled;
+    std::size_t firstEmpty;
+};
+
+#endif //CPP_PCAPREADER_FLAT_HASH_MAP_H
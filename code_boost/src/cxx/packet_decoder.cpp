@@ -0,0 +1,305 @@
+#include <algorithm>
+#include "packet_decoder.h"
+
+#define ETHERNET_HEADER_SIZE 14
+#define DOT1Q_HEADER_SIZE 4
+#define ARP_PACKET_SIZE 28
+#define IPV4_MIN_HEADER_SIZE 20
+#define IPV6_HEADER_SIZE 40
+#define TCP_MIN_HEADER_SIZE 20
+#define UDP_HEADER_SIZE 8
+#define ICMP_HEADER_SIZE 8
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_ARP 0x0806
+#define ETHERTYPE_DOT1Q 0x8100
+#define ETHERTYPE_IPV6 0x86DD
+
+#define IP_PROTO_ICMP 1
+#define IP_PROTO_TCP 6
+#define IP_PROTO_UDP 17
+#define IP_PROTO_ICMPV6 58
+#define IPV6_EXT_HOP_BY_HOP 0
+#define IPV6_EXT_ROUTING 43
+#define IPV6_EXT_DEST_OPTS 60
+
+#define TCP_OPTION_EOL 0
+#define TCP_OPTION_NOP 1
+#define TCP_OPTION_MSS 2
+
+static inline uint16_t read_be16(const uint8_t *p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t read_be32(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+           | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+/**
+ * Returns the length of an IPv4 packet the way libtins determines it: the total length field limits the
+ * captured bytes (dropping the Ethernet trailer), unless it is zero (e.g. TCP segmentation offload).
+ * @param ip Pointer to the IPv4 header.
+ * @param available The number of captured bytes starting at the IPv4 header.
+ * @return the packet length, or 0 if the header is malformed.
+ */
+static uint32_t ipv4_packet_length(const uint8_t *ip, uint32_t available) {
+    if (available < IPV4_MIN_HEADER_SIZE)
+        return 0;
+    uint32_t headerSize = (ip[0] & 0x0f) * 4u;
+    if (headerSize < IPV4_MIN_HEADER_SIZE || headerSize > available)
+        return 0;
+    uint32_t totalLength = read_be16(ip + 2);
+    if (totalLength == 0)
+        return available;
+    if (totalLength < headerSize)
+        return 0;
+    return totalLength < available ? totalLength : available;
+}
+
+/**
+ * Decodes the transport layer header.
+ * @param protocol The IP protocol number.
+ * @param segment Pointer to the transport layer header.
+ * @param size The size of the transport layer segment.
+ * @param pkt The decoded packet to fill in.
+ * @return false if the header is malformed.
+ */
+static bool decode_transport(uint8_t protocol, const uint8_t *segment, uint32_t size, decoded_packet &pkt) {
+    // libtins does not create an inner PDU for an empty payload
+    if (size == 0) {
+        pkt.l4 = l4_protocol::NONE;
+        return true;
+    }
+
+    switch (protocol) {
+        case IP_PROTO_TCP: {
+            if (size < TCP_MIN_HEADER_SIZE)
+                return false;
+            uint32_t headerSize = (segment[12] >> 4) * 4u;
+            if (headerSize < TCP_MIN_HEADER_SIZE || headerSize > size)
+                return false;
+            pkt.l4 = l4_protocol::TCP;
+            pkt.sport = read_be16(segment);
+            pkt.dport = read_be16(segment + 2);
+            pkt.tcp_flags = static_cast<uint16_t>(((segment[12] & 0x0f) << 8) | segment[13]);
+            pkt.window = read_be16(segment + 14);
+            pkt.l4_payload_size = size - headerSize;
+            pkt.tcp_segment = segment;
+            pkt.tcp_segment_size = size;
+
+            // Search the options for the first well-formed MSS option
+            uint32_t i = TCP_MIN_HEADER_SIZE;
+            while (i < headerSize) {
+                uint8_t kind = segment[i];
+                if (kind == TCP_OPTION_EOL)
+                    break;
+                if (kind == TCP_OPTION_NOP) {
+                    i++;
+                    continue;
+                }
+                if (i + 1 >= headerSize)
+                    break;
+                uint8_t length = segment[i + 1];
+                if (length < 2 || i + length > headerSize)
+                    break;
+                if (kind == TCP_OPTION_MSS && length == 4 && !pkt.has_mss) {
+                    pkt.has_mss = true;
+                    pkt.mss = read_be16(segment + i + 2);
+                }
+                i += length;
+            }
+            return true;
+        }
+        case IP_PROTO_UDP:
+            if (size < UDP_HEADER_SIZE)
+                return false;
+            pkt.l4 = l4_protocol::UDP;
+            pkt.sport = read_be16(segment);
+            pkt.dport = read_be16(segment + 2);
+            pkt.l4_payload_size = size - UDP_HEADER_SIZE;
+            return true;
+        case IP_PROTO_ICMP:
+        case IP_PROTO_ICMPV6:
+            if (size < ICMP_HEADER_SIZE)
+                return false;
+            pkt.l4 = protocol == IP_PROTO_ICMP ? l4_protocol::ICMP : l4_protocol::ICMPV6;
+            pkt.l4_payload_size = size - ICMP_HEADER_SIZE;
+            return true;
+        default:
+            pkt.l4 = l4_protocol::OTHER;
+            return true;
+    }
+}
+
+/**
+ * Decodes an IPv4 header and its transport layer header.
+ * @param ip Pointer to the IPv4 header.
+ * @param available The number of captured bytes starting at the IPv4 header.
+ * @param pkt The decoded packet to fill in.
+ * @return false if the packet is malformed.
+ */
+static bool decode_ipv4(const uint8_t *ip, uint32_t available, decoded_packet &pkt) {
+    uint32_t length = ipv4_packet_length(ip, available);
+    if (length == 0)
+        return false;
+    uint32_t headerSize = (ip[0] & 0x0f) * 4u;
+
+    pkt.l3 = l3_protocol::IPV4;
+    pkt.size = ETHERNET_HEADER_SIZE + length;
+    pkt.tos = ip[1];
+    pkt.ttl = ip[8];
+    pkt.ip_src = read_be32(ip + 12);
+    pkt.ip_dst = read_be32(ip + 16);
+
+    // Fragments are not reassembled, their payload is treated as raw data
+    uint16_t fragment = read_be16(ip + 6);
+    if ((fragment & 0x2000) || (fragment & 0x1fff)) {
+        pkt.l4 = length > headerSize ? l4_protocol::OTHER : l4_protocol::NONE;
+        return true;
+    }
+    return decode_transport(ip[9], ip + headerSize, length - headerSize, pkt);
+}
+
+/**
+ * Decodes an IPv6 header, skips its extension headers and decodes the transport layer header.
+ * @param ip Pointer to the IPv6 header.
+ * @param available The number of captured bytes starting at the IPv6 header.
+ * @param pkt The decoded packet to fill in.
+ * @return false if the packet is malformed.
+ */
+static bool decode_ipv6(const uint8_t *ip, uint32_t available, decoded_packet &pkt) {
+    if (available < IPV6_HEADER_SIZE)
+        return false;
+    uint32_t length = IPV6_HEADER_SIZE + read_be16(ip + 4);
+    if (length == IPV6_HEADER_SIZE || length > available)
+        length = available;
+
+    pkt.l3 = l3_protocol::IPV6;
+    pkt.size = ETHERNET_HEADER_SIZE + length;
+
+    uint8_t nextHeader = ip[6];
+    uint32_t offset = IPV6_HEADER_SIZE;
+    while (nextHeader == IPV6_EXT_HOP_BY_HOP || nextHeader == IPV6_EXT_ROUTING || nextHeader == IPV6_EXT_DEST_OPTS) {
+        if (offset + 2 > length)
+            return false;
+        uint32_t extensionSize = (ip[offset + 1] + 1) * 8u;
+        if (offset + extensionSize > length)
+            return false;
+        nextHeader = ip[offset];
+        offset += extensionSize;
+    }
+    return decode_transport(nextHeader, ip + offset, length - offset, pkt);
+}
+
+/**
+ * Decodes the header fields of an Ethernet frame without building a PDU tree. Frames which libtins rejects
+ * as malformed are rejected as well, so both decoders see the same set of packets.
+ * @param header The pcap record header of the packet.
+ * @param data The captured packet bytes.
+ * @param pkt The decoded packet to fill in.
+ * @return true if the packet was decoded, false if it is malformed and should be skipped.
+ */
+bool decode_ethernet_packet(const pcap_pkthdr &header, const uint8_t *data, decoded_packet &pkt) {
+    uint32_t caplen = header.caplen;
+
+    pkt.timestamp = std::chrono::microseconds(static_cast<int64_t>(header.ts.tv_sec) * 1000000 + header.ts.tv_usec);
+    pkt.size = caplen;
+    pkt.has_ethernet = false;
+    pkt.payload_type = 0;
+    pkt.l3 = l3_protocol::NONE;
+    pkt.ip_src = 0;
+    pkt.ip_dst = 0;
+    pkt.ttl = 0;
+    pkt.tos = 0;
+    pkt.l4 = l4_protocol::NONE;
+    pkt.sport = 0;
+    pkt.dport = 0;
+    pkt.tcp_flags = 0;
+    pkt.window = 0;
+    pkt.has_mss = false;
+    pkt.mss = 0;
+    pkt.l4_payload_size = 0;
+    pkt.tcp_segment = nullptr;
+    pkt.tcp_segment_size = 0;
+
+    // An empty frame would not have any inner PDU
+    if (caplen <= ETHERNET_HEADER_SIZE)
+        return false;
+
+    const uint8_t *payload = data + ETHERNET_HEADER_SIZE;
+    uint32_t available = caplen - ETHERNET_HEADER_SIZE;
+    pkt.payload_type = read_be16(data + 12);
+    pkt.l3 = l3_protocol::OTHER;
+
+    // IEEE 802.3 frames carry a length field instead of the payload type, libtins parses them as Dot3
+    if (data[12] < 8) {
+        return available >= 3;
+    }
+
+    pkt.has_ethernet = true;
+    std::copy(data, data + 6, pkt.mac_dst);
+    std::copy(data + 6, data + 12, pkt.mac_src);
+
+    switch (pkt.payload_type) {
+        case ETHERTYPE_IPV4:
+            return decode_ipv4(payload, available, pkt);
+        case ETHERTYPE_IPV6:
+            return decode_ipv6(payload, available, pkt);
+        case ETHERTYPE_ARP:
+            if (available < ARP_PACKET_SIZE)
+                return false;
+            pkt.size = ETHERNET_HEADER_SIZE + ARP_PACKET_SIZE;
+            return true;
+        case ETHERTYPE_DOT1Q:
+            if (available < DOT1Q_HEADER_SIZE)
+                return false;
+            if (read_be16(payload + 2) == ETHERTYPE_IPV4) {
+                uint32_t length = ipv4_packet_length(payload + DOT1Q_HEADER_SIZE, available - DOT1Q_HEADER_SIZE);
+                if (length == 0)
+                    return false;
+                pkt.size = ETHERNET_HEADER_SIZE + DOT1Q_HEADER_SIZE + length;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+/**
+ * Formats an IPv4 address in dotted decimal notation.
+ * @param address The address in host byte order.
+ * @return the formatted address.
+ */
+std::string ipv4_to_string(uint32_t address) {
+    char buf[16];
+    char *p = buf;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        unsigned int octet = (address >> shift) & 0xff;
+        if (octet >= 100)
+            *p++ = static_cast<char>('0' + octet / 100);
+        if (octet >= 10)
+            *p++ = static_cast<char>('0' + (octet / 10) % 10);
+        *p++ = static_cast<char>('0' + octet % 10);
+        if (shift != 0)
+            *p++ = '.';
+    }
+    return std::string(buf, p - buf);
+}
+
+/**
+ * Formats a MAC address like libtins does (lower case hex digits separated by colons).
+ * @param address Pointer to the 6 address bytes.
+ * @return the formatted address.
+ */
+std::string mac_to_string(const uint8_t *address) {
+    static const char digits[] = "0123456789abcdef";
+    char buf[17];
+    for (int i = 0; i < 6; i++) {
+        buf[i * 3] = digits[address[i] >> 4];
+        buf[i * 3 + 1] = digits[address[i] & 0x0f];
+        if (i != 5)
+            buf[i * 3 + 2] = ':';
+    }
+    return std::string(buf, sizeof(buf));
+}
@@ -0,0 +1,76 @@
+/*
+ * Decoder extracting the header fields needed for statistics directly from raw packet bytes.
+ */
+
+#ifndef CPP_PCAPREADER_PACKET_DECODER_H
+#define CPP_PCAPREADER_PACKET_DECODER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <pcap.h>
+
+/*
+ * Network layer protocols recognized by the decoder
+ */
+enum class l3_protocol : uint8_t {
+    NONE,
+    IPV4,
+    IPV6,
+    OTHER
+};
+
+/*
+ * Transport layer protocols recognized by the decoder
+ */
+enum class l4_protocol : uint8_t {
+    NONE,
+    TCP,
+    UDP,
+    ICMP,
+    ICMPV6,
+    OTHER
+};
+
+/*
+ * Struct used to represent the header fields of a packet which are relevant for the statistics:
+ * - Timestamp and size of the packet
+ * - Ethernet addresses and payload type
+ * - IPv4 addresses, TTL and ToS
+ * - Ports, TCP flags, window size and MSS option
+ * The pointer tcp_segment refers to the packet buffer and is only valid as long as the buffer is.
+ */
+struct decoded_packet {
+    std::chrono::microseconds timestamp;
+    uint32_t size;
+
+    bool has_ethernet;
+    uint8_t mac_src[6];
+    uint8_t mac_dst[6];
+    uint16_t payload_type;
+
+    l3_protocol l3;
+    uint32_t ip_src;
+    uint32_t ip_dst;
+    uint8_t ttl;
+    uint8_t tos;
+
+    l4_protocol l4;
+    uint16_t sport;
+    uint16_t dport;
+    uint16_t tcp_flags;
+    uint16_t window;
+    bool has_mss;
+    uint16_t mss;
+    uint32_t l4_payload_size;
+    const uint8_t *tcp_segment;
+    uint32_t tcp_segment_size;
+};
+
+bool decode_ethernet_packet(const pcap_pkthdr &header, const uint8_t *data, decoded_packet &pkt);
+
+std::string ipv4_to_string(uint32_t address);
+
+std::string mac_to_string(const uint8_t *address);
+
+#endif //CPP_PCAPREADER_PACKET_DECODER_H
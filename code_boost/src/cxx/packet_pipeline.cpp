@@ -0,0 +1,159 @@
+#include "packet_pipeline.h"
+
+/**
+ * Creates the pipeline and starts its threads. Batch i is decoded by decoder i % decoderThreads, so the
+ * batches can be returned in the order of the file without any sequence numbers.
+ * @param reader The reader to read the packets from, must outlive the pipeline.
+ * @param firstHeader The header of the first packet, which was already read from reader.
+ * @param firstData The data of the first packet.
+ * @param decoderThreads The number of decoder threads.
+ */
+packet_pipeline::packet_pipeline(pcap_reader &reader, const pcap_pkthdr &firstHeader, const u_char *firstData,
+                                 std::size_t decoderThreads)
+        : reader(reader), firstHeader(firstHeader), firstData(firstData, firstData + firstHeader.caplen),
+          decoderCount(decoderThreads > 0 ? decoderThreads : 1), nextDecoder(0), stopped(false),
+          freeBatches(decoderCount * PIPELINE_BATCHES_PER_DECODER) {
+    for (std::size_t i = 0; i < decoderCount * PIPELINE_BATCHES_PER_DECODER; i++) {
+        batches.emplace_back(new packet_batch());
+        freeBatches.try_push(batches.back().get());
+    }
+    // One extra slot for the end marker
+    for (std::size_t i = 0; i < decoderCount; i++) {
+        readQueues.emplace_back(new spsc_queue<packet_batch *>(batches.size() + 1));
+        decodedQueues.emplace_back(new spsc_queue<packet_batch *>(batches.size() + 1));
+    }
+
+    threads.emplace_back(&packet_pipeline::read_packets, this);
+    for (std::size_t i = 0; i < decoderCount; i++) {
+        threads.emplace_back(&packet_pipeline::decode_packets, this, i);
+    }
+}
+
+/**
+ * Stops the threads of the pipeline, also if not all batches were consumed.
+ */
+packet_pipeline::~packet_pipeline() {
+    stop();
+}
+
+/**
+ * Returns the next batch of decoded packets in file order. Blocks until the batch is decoded.
+ * The batch has to be returned with release_batch after processing it.
+ * @return the batch, or nullptr if all packets were returned.
+ */
+packet_batch *packet_pipeline::next_batch() {
+    packet_batch *batch;
+    if (!decodedQueues[nextDecoder]->pop(batch, stopped)) {
+        return nullptr;
+    }
+    nextDecoder = (nextDecoder + 1) % decoderCount;
+    return batch;
+}
+
+/**
+ * Hands a processed batch back to the reader thread for reuse.
+ * @param batch The batch returned by next_batch.
+ */
+void packet_pipeline::release_batch(packet_batch *batch) {
+    freeBatches.push(batch, stopped);
+}
+
+/**
+ * @return the error message of the reader. Only valid after next_batch returned nullptr.
+ */
+std::string packet_pipeline::get_error() {
+    return error;
+}
+
+/**
+ * Reader thread: Fills free batches with consecutive packet records and passes them to the decoders.
+ * The packet data is copied into the batch if the reader does not keep it.
+ */
+void packet_pipeline::read_packets() {
+    const pcap_pkthdr *header = &firstHeader;
+    const u_char *data = firstData.data();
+    bool copyData = !reader.keeps_data();
+    bool packetsLeft = true;
+    std::size_t batchNumber = 0;
+
+    while (packetsLeft) {
+        packet_batch *batch;
+        if (!freeBatches.pop(batch, stopped)) {
+            return;
+        }
+        batch->headers.clear();
+        batch->data.clear();
+        batch->offsets.clear();
+        batch->buffer.clear();
+
+        while (batch->headers.size() < PIPELINE_BATCH_SIZE) {
+            batch->headers.push_back(*header);
+            if (copyData && data != firstData.data()) {
+                batch->data.push_back(nullptr);
+                batch->offsets.push_back(batch->buffer.size());
+                batch->buffer.insert(batch->buffer.end(), data, data + header->caplen);
+            } else {
+                batch->data.push_back(data);
+                batch->offsets.push_back(0);
+            }
+            if (!reader.next(header, data)) {
+                packetsLeft = false;
+                break;
+            }
+        }
+        // The buffer may have been reallocated while it was filled, so the pointers are set afterwards
+        for (std::size_t i = 0; i < batch->data.size(); i++) {
+            if (batch->data[i] == nullptr) {
+                batch->data[i] = batch->buffer.data() + batch->offsets[i];
+            }
+        }
+        batch->position = reader.get_position();
+
+        if (!readQueues[batchNumber % decoderCount]->push(batch, stopped)) {
+            return;
+        }
+        batchNumber++;
+    }
+
+    error = reader.get_error();
+    for (std::size_t i = 0; i < decoderCount; i++) {
+        readQueues[i]->push(nullptr, stopped);
+    }
+}
+
+/**
+ * Decoder thread: Decodes the packets of every batch it receives and passes the batches on.
+ * @param decoder The number of the decoder.
+ */
+void packet_pipeline::decode_packets(std::size_t decoder) {
+    packet_batch *batch;
+    while (readQueues[decoder]->pop(batch, stopped)) {
+        if (batch == nullptr) {
+            decodedQueues[decoder]->push(nullptr, stopped);
+            return;
+        }
+
+        std::size_t count = batch->headers.size();
+        batch->packets.resize(count);
+        batch->decoded.resize(count);
+        for (std::size_t i = 0; i < count; i++) {
+            batch->decoded[i] = decode_ethernet_packet(batch->headers[i], batch->data[i], batch->packets[i]);
+        }
+
+        if (!decodedQueues[decoder]->push(batch, stopped)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Signals all threads to stop and waits for them.
+ */
+void packet_pipeline::stop() {
+    stopped.store(true);
+    for (std::size_t i = 0; i < threads.size(); i++) {
+        if (threads[i].joinable()) {
+            threads[i].join();
+        }
+    }
+}
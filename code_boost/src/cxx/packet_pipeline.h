@@ -0,0 +1,104 @@
+/**
+ * Pipeline reading and decoding packets on worker threads, while the statistics are collected by the caller.
+ */
+
+#ifndef CPP_PCAPREADER_PACKET_PIPELINE_H
+#define CPP_PCAPREADER_PACKET_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "packet_decoder.h"
+#include "pcap_reader.h"
+#include "spsc_queue.h"
+
+#define PIPELINE_BATCH_SIZE 1024
+#define PIPELINE_BATCHES_PER_DECODER 4
+
+/*
+ * Struct used to represent a time interval ending before a packet of a batch:
+ * - Index of the packet in the batch
+ * - Interval length, start and end timestamp as passed to statistics::addIntervalStat
+ */
+struct interval_barrier {
+    std::size_t packet;
+    std::chrono::duration<int, std::micro> interval;
+    std::chrono::microseconds start;
+    std::chrono::microseconds end;
+};
+
+/*
+ * Struct used to represent a batch of consecutive packet records on their way through the pipeline:
+ * - Record headers and pointers to the packet data
+ * - Copy of the packet data, if the reader does not keep it
+ * - Decoded packets and whether decoding succeeded
+ * - Number of bytes of the file read after the batch
+ * - Time intervals ending within the batch, if the statistics are collected by several threads
+ * - Numbers of the packets in the capture and indices of the packets routed to every statistics shard, if the
+ *   statistics are collected by several threads
+ */
+struct packet_batch {
+    std::vector<pcap_pkthdr> headers;
+    std::vector<const u_char *> data;
+    std::vector<std::size_t> offsets;
+    std::vector<uint8_t> buffer;
+    std::vector<decoded_packet> packets;
+    std::vector<char> decoded;
+    uint64_t position;
+    std::vector<interval_barrier> barriers;
+    std::vector<int> numbers;
+    std::vector<std::vector<uint32_t>> routes;
+};
+
+class packet_pipeline {
+public:
+    /*
+     * Constructor: Starts one reader thread and decoderThreads decoder threads. The record passed in is
+     * the first packet already read from reader.
+     */
+    packet_pipeline(pcap_reader &reader, const pcap_pkthdr &firstHeader, const u_char *firstData,
+                    std::size_t decoderThreads);
+
+    ~packet_pipeline();
+
+    packet_pipeline(const packet_pipeline &) = delete;
+
+    packet_pipeline &operator=(const packet_pipeline &) = delete;
+
+    /*
+     * Methods
+     */
+    packet_batch *next_batch();
+
+    void release_batch(packet_batch *batch);
+
+    std::string get_error();
+
+    std::size_t get_batch_count() const { return batches.size(); }
+
+private:
+    pcap_reader &reader;
+    pcap_pkthdr firstHeader;
+    std::vector<uint8_t> firstData;
+    std::size_t decoderCount;
+    std::size_t nextDecoder;
+    std::atomic<bool> stopped;
+    std::string error;
+
+    std::vector<std::unique_ptr<packet_batch>> batches;
+    spsc_queue<packet_batch *> freeBatches;
+    std::vector<std::unique_ptr<spsc_queue<packet_batch *>>> readQueues;
+    std::vector<std::unique_ptr<spsc_queue<packet_batch *>>> decodedQueues;
+    std::vector<std::thread> threads;
+
+    void read_packets();
+
+    void decode_packets(std::size_t decoder);
+
+    void stop();
+};
+
+#endif //CPP_PCAPREADER_PACKET_PIPELINE_H
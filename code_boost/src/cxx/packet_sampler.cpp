@@ -0,0 +1,149 @@
+#include <algorithm>
+#include "packet_sampler.h"
+
+/**
+ * Packs a MAC address and a port into one value.
+ * @param address The MAC address.
+ * @param port The port.
+ * @return the packed value.
+ */
+static inline uint64_t pack_mac_port(const uint8_t *address, uint16_t port) {
+    uint64_t value = port;
+    for (int i = 0; i < 6; i++) {
+        value = (value << 8) | address[i];
+    }
+    return value;
+}
+
+/**
+ * Hashes the flow of a packet, both directions of a flow have the same hash. IPv4 flows are identified by their
+ * addresses, ports and transport protocol, other flows by their MAC addresses, ports and transport protocol.
+ * @param pkt The decoded packet.
+ * @return the hash of the flow.
+ */
+static uint64_t flow_hash(const decoded_packet &pkt) {
+    uint64_t endpointA = 0;
+    uint64_t endpointB = 0;
+    if (pkt.l3 == l3_protocol::IPV4) {
+        endpointA = (static_cast<uint64_t>(pkt.ip_src) << 16) | pkt.sport;
+        endpointB = (static_cast<uint64_t>(pkt.ip_dst) << 16) | pkt.dport;
+    } else if (pkt.has_ethernet) {
+        endpointA = pack_mac_port(pkt.mac_src, pkt.sport);
+        endpointB = pack_mac_port(pkt.mac_dst, pkt.dport);
+    }
+    if (endpointA > endpointB) {
+        std::swap(endpointA, endpointB);
+    }
+    return mix_bits(mix_bits(endpointA ^ static_cast<uint64_t>(pkt.l4)) ^ endpointB);
+}
+
+/**
+ * Parses the name of a sampling mode.
+ * @param name "packet", "flow" or "none".
+ * @param mode Set to the sampling mode.
+ * @return false if the name is unknown.
+ */
+bool parse_sampling_mode(const std::string &name, sampling_mode &mode) {
+    if (name == "packet") {
+        mode = sampling_mode::PACKET;
+    } else if (name == "flow") {
+        mode = sampling_mode::FLOW;
+    } else if (name == "none" || name.empty()) {
+        mode = sampling_mode::NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param mode A sampling mode.
+ * @return the name of the sampling mode, see parse_sampling_mode.
+ */
+std::string get_sampling_mode_name(sampling_mode mode) {
+    switch (mode) {
+        case sampling_mode::PACKET:
+            return "packet";
+        case sampling_mode::FLOW:
+            return "flow";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * Creates a sampler selecting every packet.
+ */
+packet_sampler::packet_sampler() : mode(sampling_mode::NONE), rate(1), packetNumber(0) {}
+
+/**
+ * Sets the sampling mode and rate and starts counting the packets anew.
+ * @param mode The sampling mode.
+ * @param rate The sampling rate N, one in N packets or flows is selected. A rate below 2 disables the sampling.
+ */
+void packet_sampler::configure(sampling_mode mode, unsigned int rate) {
+    this->mode = rate > 1 ? mode : sampling_mode::NONE;
+    this->rate = this->mode == sampling_mode::NONE ? 1 : rate;
+    packetNumber = 0;
+}
+
+/**
+ * Starts counting the packets anew, so that the first packet is selected in packet sampling mode.
+ */
+void packet_sampler::reset() {
+    packetNumber = 0;
+}
+
+/**
+ * @return true if not every packet is selected.
+ */
+bool packet_sampler::is_enabled() const {
+    return mode != sampling_mode::NONE;
+}
+
+/**
+ * @return the sampling mode.
+ */
+sampling_mode packet_sampler::get_mode() const {
+    return mode;
+}
+
+/**
+ * @return the sampling rate N, 1 if the sampling is disabled.
+ */
+unsigned int packet_sampler::get_rate() const {
+    return rate;
+}
+
+/**
+ * Decides whether the statistics of a packet are collected. Packets have to be passed in capture order, in packet
+ * sampling mode the first and then every rate-th packet is selected. In flow sampling mode, the packets of a flow
+ * are either all selected or all dropped.
+ * @param pkt The decoded packet.
+ * @return true if the packet is selected.
+ */
+bool packet_sampler::selects(const decoded_packet &pkt) {
+    switch (mode) {
+        case sampling_mode::PACKET:
+            return packetNumber++ % rate == 0;
+        case sampling_mode::FLOW:
+            return flow_hash(pkt) % rate == 0;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @return the number of packets passed to selects so far in packet sampling mode.
+ */
+uint64_t packet_sampler::get_packet_number() const {
+    return packetNumber;
+}
+
+/**
+ * Continues counting the packets at a number returned by get_packet_number, e.g. when resuming from a checkpoint.
+ * @param packetNumber The number of packets passed to selects before.
+ */
+void packet_sampler::set_packet_number(uint64_t packetNumber) {
+    this->packetNumber = packetNumber;
+}
@@ -0,0 +1,53 @@
+/**
+ * Sampler selecting the packets whose statistics are collected, either one in N packets or the packets of one in N
+ * flows.
+ */
+
+#ifndef CPP_PCAPREADER_PACKET_SAMPLER_H
+#define CPP_PCAPREADER_PACKET_SAMPLER_H
+
+#include <cstdint>
+#include <string>
+#include "flat_hash_map.h"
+#include "packet_decoder.h"
+
+/*
+ * Sampling modes: every packet, one in N packets or the packets of one in N flows
+ */
+enum class sampling_mode : uint8_t {
+    NONE,
+    PACKET,
+    FLOW
+};
+
+bool parse_sampling_mode(const std::string &name, sampling_mode &mode);
+
+std::string get_sampling_mode_name(sampling_mode mode);
+
+class packet_sampler {
+public:
+    packet_sampler();
+
+    void configure(sampling_mode mode, unsigned int rate);
+
+    void reset();
+
+    bool is_enabled() const;
+
+    sampling_mode get_mode() const;
+
+    unsigned int get_rate() const;
+
+    bool selects(const decoded_packet &pkt);
+
+    uint64_t get_packet_number() const;
+
+    void set_packet_number(uint64_t packetNumber);
+
+private:
+    sampling_mode mode;
+    unsigned int rate;
+    uint64_t packetNumber;
+};
+
+#endif //CPP_PCAPREADER_PACKET_SAMPLER_H
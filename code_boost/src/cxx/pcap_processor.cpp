@@ -1,40 +1,158 @@
+#include <cmath>
 #include "pcap_processor.h"
+#include "statistics_shards.h"
 
 using namespace Tins;
 
 /**
  * Creates a new pcap_processor object.
- * @param path The path where the PCAP to get analyzed is locatated.
+ * @param path The path where the PCAP to get analyzed is locatated. A glob pattern like "capture_*.pcap" selects a
+ * capture set, whose files are processed as one timeline.
  */
 pcap_processor::pcap_processor(std::string path, std::string extraTests, std::string resource_path, std::string database_path) : stats(resource_path) {
     filePath = path;
+    filePaths = pcap_reader::expand_capture_set(path);
     resourcePath = resource_path;
     databasePath = database_path;
     hasUnrecognized = false;
+    fileSize = 0;
+    window = unrestricted_time_window();
+    checkpointInterval = std::chrono::seconds(CHECKPOINT_INTERVAL);
+    incremental = false;
+    libtinsDecoding = false;
     if(extraTests == "True")
         stats.setDoExtraTests(true);
     else stats.setDoExtraTests(false);
 }
 
+/**
+ * Creates a new pcap_processor object for a capture set, whose files are processed as one timeline.
+ * @param paths The paths or glob patterns of the PCAP files.
+ */
+pcap_processor::pcap_processor(const py::list &paths, std::string extraTests, std::string resource_path, std::string database_path)
+        : pcap_processor("", extraTests, resource_path, database_path) {
+    filePaths.clear();
+    for (auto path: paths) {
+        std::vector<std::string> matches = pcap_reader::expand_capture_set(path.cast<std::string>());
+        filePaths.insert(filePaths.end(), matches.begin(), matches.end());
+    }
+    if (!filePaths.empty()) {
+        filePath = filePaths[0];
+    }
+}
+
 /**
  * Iterates over all packets, starting by packet no. 1, and stops if
  * after_packet_number equals the current packet number.
+ * If the statistics database has a packet index of the PCAP, the iteration starts at the closest indexed packet.
  * @param after_packet_number The packet position in the PCAP file whose timestamp is wanted.
  * @return The timestamp of the last processed packet plus 1 microsecond.
  */
 long double pcap_processor::get_timestamp_mu_sec(const int after_packet_number) {
-    if (file_exists(filePath)) {
-        FileSniffer sniffer(filePath);
+    return find_timestamps_mu_sec(std::vector<int>(1, after_packet_number))[0];
+}
+
+/**
+ * Determines the timestamps of several packets with a single pass over the PCAP file, see get_timestamp_mu_sec.
+ * @param packet_numbers The packet positions in the PCAP file whose timestamps are wanted.
+ * @return The timestamps of the packets plus 1 microsecond in the order of packet_numbers, -1 for packets which
+ * are not in the file.
+ */
+py::list pcap_processor::get_timestamps_mu_sec(const py::list &packet_numbers) {
+    std::vector<int> packetNumbers;
+    for (auto packetNumber: packet_numbers) {
+        packetNumbers.push_back(packetNumber.cast<int>());
+    }
+    py::list timestamps;
+    for (long double timestamp: find_timestamps_mu_sec(packetNumbers)) {
+        timestamps.append(timestamp);
+    }
+    return timestamps;
+}
+
+/**
+ * Determines the packet positions of several timestamps with a single pass over the PCAP file. The position of a
+ * timestamp is the number of packets with an earlier timestamp. For a capture in chronological order, it is the
+ * number of the last packet before the timestamp, which is the inverse of get_timestamp_mu_sec.
+ * @param timestamps_mu_sec The timestamps in microseconds.
+ * @return The packet positions in the order of timestamps_mu_sec.
+ */
+py::list pcap_processor::get_packet_numbers(const py::list &timestamps_mu_sec) {
+    std::vector<std::pair<long double, std::size_t>> queries;
+    for (auto timestamp: timestamps_mu_sec) {
+        queries.push_back({timestamp.cast<long double>(), queries.size()});
+    }
+    std::sort(queries.begin(), queries.end());
+    std::vector<long double> sortedTimestamps;
+    for (auto &query: queries) {
+        sortedTimestamps.push_back(query.first);
+    }
+
+    // earlierPackets[i]: number of packets whose timestamp is between the timestamps of queries i - 1 and i
+    std::vector<int> earlierPackets(queries.size() + 1, 0);
+    if (!queries.empty() && capture_exists()) {
+        std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePaths);
+        const pcap_pkthdr *header;
+        const u_char *data;
+        while (reader->is_open() && reader->next(header, data)) {
+            long double timestamp = (long double) ((header->ts.tv_sec * 1000000) + header->ts.tv_usec);
+            earlierPackets[std::upper_bound(sortedTimestamps.begin(), sortedTimestamps.end(), timestamp) -
+                           sortedTimestamps.begin()]++;
+        }
+    }
+
+    std::vector<int> packetNumbers(queries.size(), 0);
+    int packetCount = 0;
+    for (std::size_t i = 0; i < queries.size(); i++) {
+        packetCount += earlierPackets[i];
+        packetNumbers[queries[i].second] = packetCount;
+    }
+    py::list result;
+    for (int packetNumber: packetNumbers) {
+        result.append(packetNumber);
+    }
+    return result;
+}
+
+/**
+ * Iterates over the packets once, starting at the indexed packet closest to the first wanted packet, if the
+ * statistics database has a packet index of the PCAP.
+ * @param packetNumbers The packet positions in the PCAP file whose timestamps are wanted.
+ * @return The timestamps of the packets plus 1 microsecond in the order of packetNumbers, -1 for packets which
+ * are not in the file.
+ */
+std::vector<long double> pcap_processor::find_timestamps_mu_sec(const std::vector<int> &packetNumbers) {
+    std::vector<long double> timestamps(packetNumbers.size(), -1.0);
+    std::vector<std::pair<int, std::size_t>> queries;
+    for (std::size_t i = 0; i < packetNumbers.size(); i++) {
+        if (packetNumbers[i] >= 1) {
+            queries.push_back({packetNumbers[i], i});
+        }
+    }
+    std::sort(queries.begin(), queries.end());
+
+    if (!queries.empty() && capture_exists()) {
+        std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePaths);
+        const pcap_pkthdr *header;
+        const u_char *data;
         int current_packet = 1;
-        for (SnifferIterator i = sniffer.begin(); i != sniffer.end(); i++) {
-            if (after_packet_number == current_packet) {
-                const Timestamp &ts = i->timestamp();
-                return (long double) ((ts.seconds() * 1000000) + ts.microseconds() + 1);
+
+        pcap_mmap_reader *mmapReader = dynamic_cast<pcap_mmap_reader *>(reader.get());
+        packet_index_entry entry;
+        if (mmapReader != nullptr && queries[0].first > 1 &&
+            read_packet_index(static_cast<uint64_t>(queries[0].first), entry) && mmapReader->seek(entry)) {
+            current_packet = static_cast<int>(entry.packetNumber);
+        }
+        std::size_t nextQuery = 0;
+        while (nextQuery < queries.size() && reader->is_open() && reader->next(header, data)) {
+            for (; nextQuery < queries.size() && queries[nextQuery].first == current_packet; nextQuery++) {
+                timestamps[queries[nextQuery].second] =
+                        (long double) ((header->ts.tv_sec * 1000000) + header->ts.tv_usec + 1);
             }
             current_packet++;
         }
     }
-    return -1.0;
+    return timestamps;
 }
 
 /**
@@ -51,12 +169,20 @@ std::string pcap_processor::merge_pcaps(const std::string pcap_path) {
     strftime(buff, sizeof(buff), "%Y%m%d-%H%M%S", now);
     std::string tstmp(buff);
 
-    // Replace filename with 'timestamp_filename'
-    std::string new_filepath = filePath;
+    // The merged PCAP is compressed like the base PCAP, the compression extension is moved behind the new extension
+    compression_format compression = detect_compression(filePaths[0]);
+    std::string compressionExt = get_compression_extension(compression);
+
+    // Replace filename with 'timestamp_filename', capture sets are named after their first file
+    std::string new_filepath = filePaths[0];
+    if (!compressionExt.empty() && new_filepath.length() > compressionExt.length() &&
+        new_filepath.compare(new_filepath.length() - compressionExt.length(), compressionExt.length(), compressionExt) == 0) {
+        new_filepath.erase(new_filepath.length() - compressionExt.length());
+    }
     const std::string &newExt = "_" + tstmp + ".pcap";
     std::string::size_type h = new_filepath.rfind('.', new_filepath.length());
 
-    if ((filePath.length() + newExt.length()) < 250) {
+    if ((new_filepath.length() + newExt.length()) < 250) {
 
         if (h != std::string::npos) {
             new_filepath.replace(h, newExt.length(), newExt);
@@ -68,193 +194,405 @@ std::string pcap_processor::merge_pcaps(const std::string pcap_path) {
     else {
         new_filepath = (new_filepath.substr(0, new_filepath.find('_'))).append(newExt);
     }
+    new_filepath.append(compressionExt);
 
-    FileSniffer sniffer_base(filePath);
-    SnifferIterator iterator_base = sniffer_base.begin();
+    std::unique_ptr<pcap_reader> reader_base = pcap_reader::open(filePaths);
+    if (!reader_base->is_open()) {
+        throw std::runtime_error("Could not open PCAP '" + filePath + "': " + reader_base->get_error());
+    }
+    std::unique_ptr<pcap_reader> reader_attack = pcap_reader::open(pcap_path);
+    if (!reader_attack->is_open()) {
+        throw std::runtime_error("Could not open PCAP '" + pcap_path + "': " + reader_attack->get_error());
+    }
+    if (reader_attack->get_link_type() != reader_base->get_link_type()) {
+        std::cerr << "WARNING: The attack PCAP has a different link type than the base PCAP" << std::endl;
+    }
 
-    FileSniffer sniffer_attack(pcap_path);
-    SnifferIterator iterator_attack = sniffer_attack.begin();
+    // The packet records are copied unchanged, so they do not need to be parsed and serialized again
+    std::unique_ptr<pcap_t, void (*)(pcap_t *)> pcap_out(pcap_open_dead(reader_base->get_link_type(), 65535), pcap_close);
+    std::unique_ptr<compressed_file_writer> compressor;
+    pcap_dumper_t *writer;
+    if (compression != COMPRESSION_NONE) {
+        compressor.reset(new compressed_file_writer(new_filepath, compression));
+        FILE *file = compressor->is_open() ? compressor->open_stream() : nullptr;
+        if (file == nullptr) {
+            throw std::runtime_error("Could not write PCAP '" + new_filepath + "': " + compressor->get_error());
+        }
+        writer = pcap_dump_fopen(pcap_out.get(), file);
+        if (writer == nullptr) {
+            fclose(file);
+        }
+    } else {
+        writer = pcap_dump_open(pcap_out.get(), new_filepath.c_str());
+    }
+    if (writer == nullptr) {
+        throw std::runtime_error("Could not write PCAP '" + new_filepath + "': " + pcap_geterr(pcap_out.get()));
+    }
 
-    PacketWriter writer(new_filepath, PacketWriter::ETH2);
+    const pcap_pkthdr *header_base;
+    const u_char *data_base;
+    const pcap_pkthdr *header_attack;
+    const u_char *data_attack;
+    bool base_pkts_left = reader_base->next(header_base, data_base);
+    bool attack_pkts_left = reader_attack->next(header_attack, data_attack);
 
-    bool all_attack_pkts_processed = false;
     // Go through base PCAP and merge packets by timestamp
-    for (; iterator_base != sniffer_base.end();) {
-        auto tstmp_base = (iterator_base->timestamp().seconds()) + (iterator_base->timestamp().microseconds()*1e-6);
-        auto tstmp_attack = (iterator_attack->timestamp().seconds()) + (iterator_attack->timestamp().microseconds()*1e-6);
-        if (!all_attack_pkts_processed && tstmp_attack <= tstmp_base) {
-            try {
-                writer.write(*iterator_attack);
-            } catch (serialization_error&) {
-                std::cerr << std::setprecision(15) << "Could not serialize attack packet with timestamp " << tstmp_attack << std::endl;
-            }
-            iterator_attack++;
-            if (iterator_attack == sniffer_attack.end())
-                all_attack_pkts_processed = true;
+    // If the base PCAP is smaller than the attack PCAP, the remaining packets of the attack PCAP are appended
+    while (base_pkts_left || attack_pkts_left) {
+        if (attack_pkts_left && (!base_pkts_left || !timercmp(&header_attack->ts, &header_base->ts, >))) {
+            pcap_dump(reinterpret_cast<u_char *>(writer), header_attack, data_attack);
+            attack_pkts_left = reader_attack->next(header_attack, data_attack);
         } else {
-            try {
-                writer.write(*iterator_base);
-            } catch (serialization_error&) {
-                    std::cerr << "Could not serialize base packet with timestamp " << std::setprecision(15) << tstmp_base << std::endl;
-            }
-            iterator_base++;
+            pcap_dump(reinterpret_cast<u_char *>(writer), header_base, data_base);
+            base_pkts_left = reader_base->next(header_base, data_base);
         }
     }
+    pcap_dump_close(writer);
+    if (compressor != nullptr && !compressor->get_error().empty()) {
+        throw std::runtime_error("Could not write PCAP '" + new_filepath + "': " + compressor->get_error());
+    }
 
-    // This may happen if the base PCAP is smaller than the attack PCAP
-    // In this case append the remaining packets of the attack PCAP
-    for (; iterator_attack != sniffer_attack.end(); iterator_attack++) {
-        try {
-            writer.write(*iterator_attack);
-        } catch (serialization_error&) {
-            auto tstmp_attack = (iterator_attack->timestamp().seconds()) + (iterator_attack->timestamp().microseconds()*1e-6);
-            std::cerr << "Could not serialize attack packet with timestamp " << std::setprecision(15) << tstmp_attack << std::endl;
-        }
+    if (!reader_base->get_error().empty() || !reader_attack->get_error().empty()) {
+        std::cerr << "WARNING: Could not read all packets: " << reader_base->get_error() << reader_attack->get_error() << std::endl;
     }
     return new_filepath;
 }
 
-bool pcap_processor::read_pcap_info(const std::string &filePath, std::size_t &totalPakets) {
-    // libtins has a lot of overhead when just iterating through, so we use libpcap directly
-    char errbuf[PCAP_ERRBUF_SIZE];
-    pcap_t *pcap_handle = pcap_open_offline(filePath.c_str(), errbuf);
-    if (pcap_handle == nullptr) {
-        std::cerr << "ERROR: Could not open PCAP '" << filePath << "': " << errbuf << std::endl;
+bool pcap_processor::read_pcap_info(const std::vector<std::string> &filePaths, std::size_t &totalPakets) {
+    // libtins has a lot of overhead when just iterating through, so we use the packet readers directly
+    std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePaths);
+    if (!reader->is_open()) {
+        std::cerr << "ERROR: Could not open PCAP '" << filePath << "': " << reader->get_error() << std::endl;
         return false;
     }
 
-    const u_char *packet;
-    pcap_pkthdr header;
-
-    packet = pcap_next(pcap_handle, &header);
-    if (packet == nullptr)
+    const pcap_pkthdr *header;
+    const u_char *data;
+    if (!reader->next(header, data))
     {
         std::cerr << "ERROR: PCAP file is empty!" << std::endl;
-        pcap_close(pcap_handle);
         return false;
     }
 
     // Extract first timestamp
-    stats.setTimestampFirstPacket(Tins::Timestamp(header.ts));
+    stats.setTimestampFirstPacket(Tins::Timestamp(header->ts));
 
     totalPakets = 0;
     timeval lv;
-    while (packet != nullptr) {
+    do {
         totalPakets++;
         // Extract last timestamp
-        lv = header.ts;
-        packet = pcap_next(pcap_handle, &header);
-    }
+        lv = header->ts;
+    } while (reader->next(header, data));
 
     stats.setTimestampLastPacket(Tins::Timestamp(lv));
-
-    pcap_close(pcap_handle);
     return true;
 }
 
 /**
  * Collect statistics of the loaded PCAP file. Calls for each packet the method process_packets.
+ * Ethernet captures are read with libpcap and decoded without building PDU objects, captures of other
+ * link types are read with libtins. The file is read only once, the progress is derived from the bytes read.
+ * With more than one thread, Ethernet captures are read and decoded by a pipeline of worker threads.
+ * From four threads on, the statistics are collected by several shard threads, each receiving only the packets of
+ * the hosts whose address hash it owns and keeping their statistics, besides one shard keeping the capture-wide
+ * statistics. The shards are combined after the last packet.
+ * In chunked mode, memory mapped Ethernet captures are instead cut into one chunk of packet records per thread,
+ * which are processed independently and merged in capture order afterwards, see collect_chunk_statistics.
+ * If sampling is enabled, only the statistics of the sampled packets are collected and scaled up afterwards, see
+ * set_sampling. In sketch mode, the per-host distributions and degrees are estimated in bounded memory, see
+ * set_sketch_mode. If a time window is set, only its packets are processed. Memory mapped captures are read from the first packet
+ * of the window on, which is found by bisection, up to the end of the window, see pcap_mmap_reader::find_timestamp.
+ * If checkpoints are enabled, the collection resumes from the checkpoint of an interrupted run, see set_checkpoint.
  * param: user specified interval in seconds
+ * param: number of threads, one reader, threads / 4 decoder and the remaining shard threads besides the calling thread
+ * param: whether the file should be processed in chunks, one per thread
  */
-void pcap_processor::collect_statistics(py::list& intervals) {
+void pcap_processor::collect_statistics(py::list& intervals, int threads, bool chunked) {
+    if (filePaths.size() == 1 && pcap_reader::is_stream(filePath)) {
+        std::cerr << "ERROR: '" << filePath << "' is a stream, its statistics are collected by stream_statistics"
+                  << std::endl;
+        return;
+    }
     // Only process PCAP if file exists
-    if (file_exists(filePath)) {
+    if (capture_exists()) {
         std::cout << "Loading pcap..." << std::endl;
-        FileSniffer sniffer(filePath);
-
-        SnifferIterator i = sniffer.begin();
         std::chrono::microseconds currentPktTimestamp;
 
-        // Read PCAP file info
-        std::size_t totalPackets = 0;
-        if (!read_pcap_info(filePath, totalPackets)) return;
-
-        // choose a suitable time interval
-        int timeIntervalCounter = 1;
-        long timeInterval_microsec = 0;
-        std::vector<std::chrono::microseconds> intervalStartTimestamp;
-        std::chrono::microseconds firstTimestamp = stats.getTimestampFirstPacket();
-
-        std::vector<std::chrono::duration<int, std::micro>> timeIntervals;
-        std::vector<std::chrono::microseconds> barriers;
+        // Read the first packet to get the first timestamp, the file is only read once
+        std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePaths);
+        if (!reader->is_open()) {
+            std::cerr << "ERROR: Could not open PCAP '" << filePath << "': " << reader->get_error() << std::endl;
+            return;
+        }
+        // Classic PCAP files are indexed while they are read, unless only the records of a time window are read
+        pcap_mmap_reader *mmapReader = dynamic_cast<pcap_mmap_reader *>(reader.get());
+        packetIndex.clear();
+        uint64_t rangeBegin = PCAP_FILE_HEADER_SIZE;
+        uint64_t rangeEnd = reader->get_file_size();
+        if (mmapReader != nullptr && window.is_restricted()) {
+            rangeBegin = mmapReader->find_timestamp(window.get_read_start());
+            if (window.get_read_end() < std::numeric_limits<int64_t>::max()) {
+                rangeEnd = mmapReader->find_timestamp(window.get_read_end() + 1);
+            }
+            mmapReader->set_range(rangeBegin, rangeEnd);
+        } else if (mmapReader != nullptr) {
+            mmapReader->set_index_interval(PACKET_INDEX_INTERVAL);
+        }
+        // Packets not matching the filter or outside the time window are rejected by the reader, before they are decoded
+        pcap_reader *fileReader = reader.get();
+        filter.reset();
+        if (!filterExpression.empty()) {
+            std::shared_ptr<packet_filter> compiledFilter(new packet_filter());
+            if (!compiledFilter->compile(filterExpression, reader->get_link_type())) {
+                std::cerr << "ERROR: Invalid filter '" << filterExpression << "': " << compiledFilter->get_error()
+                          << std::endl;
+                return;
+            }
+            filter = compiledFilter;
+        }
+        if (filter != nullptr || window.is_restricted()) {
+            reader.reset(new pcap_filtered_reader(std::move(reader), filter, window));
+        }
+        sampler.reset();
 
         std::vector<double> intervals_vec;
         for (auto interval: intervals) {
             intervals_vec.push_back(interval.cast<double>());
         }
 
-        if (intervals_vec.size() == 0 || intervals_vec[0] == 0) {
-            int timeIntervalsNum = 100;
-            std::chrono::microseconds lastTimestamp = stats.getTimestampLastPacket();
-            std::chrono::microseconds captureDuration = lastTimestamp - firstTimestamp;
-            if(captureDuration.count()<=0){
-                std::cerr << "ERROR: PCAP file is empty!" << std::endl;
-                return;
+        // Checkpoints are written while a classic PCAP file is read sequentially, a later run resumes from the last one
+        bool checkpointing = false;
+        bool resumed = false;
+        if (!checkpointPath.empty()) {
+            if (mmapReader == nullptr || filePaths.size() > 1) {
+                std::cerr << "WARNING: Checkpoints are only supported for single uncompressed classic PCAP files, '"
+                          << filePath << "' is processed without checkpoints" << std::endl;
+            } else {
+                checkpointing = true;
+                if (threads > 1) {
+                    std::cout << "Checkpoints are written by the sequential reader, the PCAP is processed by one thread"
+                              << std::endl;
+                    threads = 1;
+                }
+                resumed = read_checkpoint(*mmapReader, currentPktTimestamp, intervals_vec);
+                lastCheckpoint = std::chrono::steady_clock::now();
             }
-            timeInterval_microsec = captureDuration.count() / timeIntervalsNum;
-            stats.setDefaultInterval(static_cast<int>(timeInterval_microsec));
-            intervalStartTimestamp.push_back(firstTimestamp);
-            std::chrono::duration<int, std::micro> timeInterval(timeInterval_microsec);
-            std::chrono::microseconds barrier = timeInterval;
-            timeIntervals.push_back(timeInterval);
-            barriers.push_back(barrier);
-        } else {
-            if (stats.getDoExtraTests()) {
-                statistics_db stats_db(databasePath, resourcePath);
-                stats_db.getNoneExtraTestsInveralStats(intervals_vec);
+        }
+
+        const pcap_pkthdr *header;
+        const u_char *data;
+        bool hasPacket = reader->next(header, data);
+        if (!hasPacket && !resumed) {
+            if (window.is_restricted()) {
+                std::cerr << "ERROR: No packet of the PCAP file lies within the time window"
+                          << (filter != nullptr ? " and matches the filter!" : "!") << std::endl;
+            } else {
+                std::cerr << "ERROR: " << (filter != nullptr ? "No packet of the PCAP file matches the filter!"
+                                                             : "PCAP file is empty!") << std::endl;
             }
-            for (auto interval: intervals_vec) {
-                timeInterval_microsec = static_cast<long>(interval * 1000000);
+            return;
+        }
+        // A resumed run continues with the timestamps and interval barriers of the checkpoint
+        if (!resumed) {
+            stats.setTimestampFirstPacket(Tins::Timestamp(header->ts));
+
+            // choose a suitable time interval
+            long timeInterval_microsec = 0;
+            intervalStartTimestamp.clear();
+            firstTimestamp = stats.getTimestampFirstPacket();
+
+            timeIntervals.clear();
+            barriers.clear();
+
+            if (intervals_vec.size() == 0 || intervals_vec[0] == 0) {
+                int timeIntervalsNum = 100;
+
+                // The last timestamp is read from the end of the file, only damaged files need a full scan
+                timeval lastTs;
+                if (pcap_reader::read_last_timestamp(filePaths, lastTs)) {
+                    stats.setTimestampLastPacket(Tins::Timestamp(lastTs));
+                } else if (window.end != std::numeric_limits<int64_t>::max()) {
+                    stats.setTimestampLastPacket(std::chrono::microseconds(window.end));
+                } else {
+                    std::size_t packetCount = 0;
+                    if (!read_pcap_info(filePaths, packetCount)) return;
+                    stats.setTimestampFirstPacket(firstTimestamp);
+                }
+                // The intervals divide the part of the capture within the time window
+                std::chrono::microseconds lastTimestamp = stats.getTimestampLastPacket();
+                if (lastTimestamp.count() > window.end) {
+                    lastTimestamp = std::chrono::microseconds(window.end);
+                }
+                std::chrono::microseconds captureDuration = lastTimestamp - firstTimestamp;
+                if(captureDuration.count()<=0){
+                    std::cerr << "ERROR: PCAP file is empty!" << std::endl;
+                    return;
+                }
+                timeInterval_microsec = captureDuration.count() / timeIntervalsNum;
+                stats.setDefaultInterval(static_cast<int>(timeInterval_microsec));
                 intervalStartTimestamp.push_back(firstTimestamp);
                 std::chrono::duration<int, std::micro> timeInterval(timeInterval_microsec);
                 std::chrono::microseconds barrier = timeInterval;
                 timeIntervals.push_back(timeInterval);
                 barriers.push_back(barrier);
+            } else {
+                if (stats.getDoExtraTests()) {
+                    statistics_db stats_db(databasePath, resourcePath);
+                    stats_db.getNoneExtraTestsInveralStats(intervals_vec);
+                }
+                for (auto interval: intervals_vec) {
+                    timeInterval_microsec = static_cast<long>(interval * 1000000);
+                    intervalStartTimestamp.push_back(firstTimestamp);
+                    std::chrono::duration<int, std::micro> timeInterval(timeInterval_microsec);
+                    std::chrono::microseconds barrier = timeInterval;
+                    timeIntervals.push_back(timeInterval);
+                    barriers.push_back(barrier);
+                }
             }
-        }
 
-        std::sort(timeIntervals.begin(), timeIntervals.end());
-        std::sort(barriers.begin(), barriers.end());
+            std::sort(timeIntervals.begin(), timeIntervals.end());
+            std::sort(barriers.begin(), barriers.end());
+        }
 
         std::cout << std::endl;
-        std::chrono::system_clock::time_point lastPrinted = std::chrono::system_clock::now();
-
-        int barrier_count = static_cast<int>(barriers.size());
+        lastPrinted = std::chrono::system_clock::now();
 
         // Iterate over all packets and collect statistics
-        for (; i != sniffer.end(); i++) {
-            currentPktTimestamp = i->timestamp();
-            std::chrono::microseconds currentDuration = currentPktTimestamp - firstTimestamp;
-
-            // For each interval
-            // drops last interval too small
-            for (int j = 0; j < barrier_count; j++) {
-                if(currentDuration>barriers[j]){
-                    stats.addIntervalStat(timeIntervals[j], intervalStartTimestamp[j], currentPktTimestamp);
-                    timeIntervalCounter++;
-
-                    barriers[j] =  barriers[j] + timeIntervals[j];
-                    intervalStartTimestamp[j] = currentPktTimestamp;
+        if (reader->get_link_type() == DLT_EN10MB && !libtinsDecoding) {
+            fileSize = reader->get_file_size();
+            std::string readError;
+            // With enough threads, the statistics are collected by shards partitioned by address hash
+            int decoderThreads = std::max(1, threads / 4);
+            int shardThreads = threads - 1 - decoderThreads;
+            if (chunked && threads > 1 && mmapReader != nullptr &&
+                collect_chunk_statistics(*mmapReader, static_cast<std::size_t>(threads), rangeBegin, rangeEnd)) {
+                currentPktTimestamp = stats.getTimestampLastPacket();
+            } else if (threads > 1 && shardThreads >= 2) {
+                packet_pipeline pipeline(*reader, *header, data, static_cast<std::size_t>(decoderThreads));
+                statistics_shards shards(*this, static_cast<std::size_t>(shardThreads), pipeline.get_batch_count());
+                std::deque<packet_batch *> dispatched;
+                std::size_t released = 0;
+                int packetCount = 0;
+                while (true) {
+                    // Batches are reused by the reader as soon as all shards processed them
+                    while (dispatched.size() >= pipeline.get_batch_count() || released < shards.get_completed_count()) {
+                        if (released < shards.get_completed_count()) {
+                            pipeline.release_batch(dispatched.front());
+                            dispatched.pop_front();
+                            released++;
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+
+                    packet_batch *batch = pipeline.next_batch();
+                    if (batch == nullptr) break;
+                    batch->barriers.clear();
+                    for (std::size_t i = 0; i < batch->packets.size(); i++) {
+                        if (!batch->decoded[i]) continue;
+
+                        currentPktTimestamp = batch->packets[i].timestamp;
+                        find_interval_barriers(currentPktTimestamp, i, batch->barriers);
+                        // The shards still register the interval barriers of packets which are not sampled
+                        if (!sampler.selects(batch->packets[i])) {
+                            batch->decoded[i] = 0;
+                            continue;
+                        }
+                        packetCount++;
+                    }
+                    shards.dispatch(batch);
+                    dispatched.push_back(batch);
+                    print_progress(batch->position, packetCount);
+                }
+                shards.finish();
+                readError = pipeline.get_error();
+            } else if (threads > 1) {
+                // Reading and decoding run on worker threads, the statistics are still collected in file order
+                packet_pipeline pipeline(*reader, *header, data, static_cast<std::size_t>(threads - 1));
+                while (packet_batch *batch = pipeline.next_batch()) {
+                    for (std::size_t i = 0; i < batch->packets.size(); i++) {
+                        if (!batch->decoded[i]) continue;
+                        const decoded_packet &pkt = batch->packets[i];
+
+                        currentPktTimestamp = pkt.timestamp;
+                        process_interval_barriers(currentPktTimestamp);
+                        if (!sampler.selects(pkt)) continue;
+
+                        stats.incrementPacketCount();
+                        this->process_packets(pkt);
+                    }
+                    print_progress(batch->position, stats.getPacketCount());
+                    pipeline.release_batch(batch);
                 }
+                readError = pipeline.get_error();
+            } else {
+                decoded_packet pkt;
+                for (; hasPacket; hasPacket = reader->next(header, data)) {
+                    if (!decode_ethernet_packet(*header, data, pkt)) continue;
+
+                    currentPktTimestamp = pkt.timestamp;
+                    process_interval_barriers(currentPktTimestamp);
+                    if (!sampler.selects(pkt)) continue;
+
+                    stats.incrementPacketCount();
+                    this->process_packets(pkt);
+
+                    print_progress(reader->get_position(), stats.getPacketCount());
+                    if (checkpointing && std::chrono::steady_clock::now() - lastCheckpoint >= checkpointInterval) {
+                        write_checkpoint(*mmapReader, currentPktTimestamp, intervals_vec);
+                    }
+                }
+                readError = reader->get_error();
+                // The next incremental run continues after the last packet, e.g. at a record still being written
+                if (checkpointing && incremental) {
+                    write_checkpoint(*mmapReader, currentPktTimestamp, intervals_vec);
+                }
+            }
+            if (mmapReader != nullptr && packetIndex.empty()) {
+                packetIndex = mmapReader->get_index();
+            }
+
+            if (!readError.empty()) {
+                std::cerr << std::endl << "WARNING: Stopped reading PCAP '" << filePath << "': " << readError << std::endl;
             }
+            pcapng_mmap_reader *pcapngReader = dynamic_cast<pcapng_mmap_reader *>(fileReader);
+            if (pcapngReader != nullptr && pcapngReader->get_skipped_count() > 0) {
+                std::cerr << std::endl << "WARNING: Skipped " << pcapngReader->get_skipped_count() << " packets of "
+                          << "interfaces whose link type differs from the first interface" << std::endl;
+            }
+        } else if (dynamic_cast<pcap_compressed_reader *>(fileReader) != nullptr) {
+            std::cerr << "ERROR: Compressed PCAPs are only supported for Ethernet captures, decompress '" << filePath
+                      << "' first" << std::endl;
+            return;
+        } else if (filePaths.size() > 1) {
+            std::cerr << "ERROR: Capture sets are only supported for Ethernet captures, merge '" << filePath
+                      << "' first" << std::endl;
+            return;
+        } else if (sampler.is_enabled()) {
+            std::cerr << "ERROR: Sampling is only supported for Ethernet captures" << std::endl;
+            return;
+        } else {
+            fileSize = 0;
+            reader.reset();
+            FileSniffer sniffer(filePath, filterExpression);
+            for (SnifferIterator i = sniffer.begin(); i != sniffer.end(); i++) {
+                std::chrono::microseconds packetTimestamp = i->timestamp();
+                if (window.is_passed(packetTimestamp.count())) break;
+                if (!window.contains(packetTimestamp.count())) continue;
 
-            stats.incrementPacketCount();
-            this->process_packets(*i);
+                currentPktTimestamp = packetTimestamp;
+                process_interval_barriers(currentPktTimestamp);
 
-            // Indicate progress once every second
-            if (std::chrono::system_clock::now() - lastPrinted >= std::chrono::seconds(1)) {
-                int packetCount = stats.getPacketCount();
-                std::cout << "\rInspected packets: ";
-                std::cout << std::fixed << std::setprecision(1) << (static_cast<float>(packetCount)*100/totalPackets) << "%";
-                std::cout << " (" << packetCount << "/" << totalPackets << ")" << std::flush;
-                lastPrinted = std::chrono::system_clock::now();
+                stats.incrementPacketCount();
+                this->process_packets(*i);
 
-                if (PyErr_CheckSignals()) throw py::error_already_set();
+                print_progress(0, stats.getPacketCount());
             }
         }
 
         std::cout << "\rInspected packets: ";
-        std::cout << "100.0% (" << totalPackets << "/" << totalPackets << ")" << std::endl;
+        std::cout << "100.0% (" << stats.getPacketCount() << ")" << std::endl;
 
         // Save timestamp of last packet into statistics
         stats.setTimestampLastPacket(currentPktTimestamp);
@@ -262,26 +600,731 @@ void pcap_processor::collect_statistics(py::list& intervals) {
         // Create the communication interval statistics from the gathered communication intervals within every extended conversation statistic
         stats.createCommIntervalStats();
 
+        // In sketch mode, the per-host distributions and degrees are estimated from the sketches
+        if (stats.getSketchMode()) {
+            stats.materializeSketches();
+            std::cout << "Per-host distributions estimated with sketches, counts may exceed the true counts by up to "
+                      << stats.getSketchErrorBound() << std::endl;
+        }
+
+        // The counts of the sampled packets are estimates for the whole capture
+        if (sampler.is_enabled()) {
+            std::cout << "Sampled 1 in " << sampler.get_rate() << " " << get_sampling_mode_name(sampler.get_mode())
+                      << "s, the counts are scaled up accordingly" << std::endl;
+            stats.scaleSampledCounts(get_sampling_mode_name(sampler.get_mode()), static_cast<int>(sampler.get_rate()));
+        }
+
         if(hasUnrecognized) {
             std::cout << "Unrecognized PDUs detected: Check 'unrecognized_pdus' table!" << std::endl;
         }
     }
 }
 
+/**
+ * Collects statistics from a PCAP stream, e.g. the standard input ("-") or a named pipe written by tcpdump -w, until
+ * it ends. Every flush_interval seconds, the statistics database is updated while the stream is read: The completed
+ * time intervals and the conversations without packets for idle_timeout seconds are added to their tables and
+ * evicted from memory, the file statistics are replaced by the current ones. An evicted conversation which receives
+ * packets again is continued in its table. After the last packet, the remaining conversations and the host statistics
+ * are written, write_to_database must not be called afterwards.
+ * Only Ethernet streams are supported. The filter, the time window and sketch mode apply, sampling does not.
+ * param: length of the time intervals in seconds
+ * param: wall-clock seconds between two flushes, the flushes take place when packets arrive
+ * param: capture-time seconds after which a conversation without packets is written and evicted
+ */
+void pcap_processor::stream_statistics(double interval, double flush_interval, double idle_timeout) {
+    if (filePath != PCAP_STDIN_PATH && !file_exists(filePath)) {
+        std::cerr << "ERROR: PCAP stream '" << filePath << "' does not exist" << std::endl;
+        return;
+    }
+    if (interval <= 0) {
+        std::cerr << "ERROR: Streams need a time interval greater than 0" << std::endl;
+        return;
+    }
+    if (sampler.is_enabled()) {
+        std::cerr << "ERROR: Sampling is not supported for streams" << std::endl;
+        return;
+    }
+
+    std::cout << "Reading pcap stream..." << std::endl;
+    std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePath);
+    if (!reader->is_open()) {
+        std::cerr << "ERROR: Could not open PCAP stream '" << filePath << "': " << reader->get_error() << std::endl;
+        return;
+    }
+    if (reader->get_link_type() != DLT_EN10MB) {
+        std::cerr << "ERROR: Streams are only supported for Ethernet captures" << std::endl;
+        return;
+    }
+    filter.reset();
+    if (!filterExpression.empty()) {
+        std::shared_ptr<packet_filter> compiledFilter(new packet_filter());
+        if (!compiledFilter->compile(filterExpression, reader->get_link_type())) {
+            std::cerr << "ERROR: Invalid filter '" << filterExpression << "': " << compiledFilter->get_error()
+                      << std::endl;
+            return;
+        }
+        filter = compiledFilter;
+    }
+    if (filter != nullptr || window.is_restricted()) {
+        reader.reset(new pcap_filtered_reader(std::move(reader), filter, window));
+    }
+
+    const pcap_pkthdr *header;
+    const u_char *data;
+    if (!reader->next(header, data)) {
+        std::cerr << "ERROR: The PCAP stream ended before its first packet!" << std::endl;
+        return;
+    }
+    stats.setTimestampFirstPacket(Tins::Timestamp(header->ts));
+    firstTimestamp = stats.getTimestampFirstPacket();
+
+    // The intervals of a stream have a fixed length, as its duration is not known in advance
+    std::chrono::duration<int, std::micro> timeInterval(static_cast<int>(std::llround(interval * 1000000)));
+    stats.setDefaultInterval(timeInterval.count());
+    timeIntervals.assign(1, timeInterval);
+    barriers.assign(1, std::chrono::microseconds(timeInterval));
+    intervalStartTimestamp.assign(1, firstTimestamp);
+    fileSize = 0;
+
+    std::chrono::microseconds idleTimeout(std::llround(idle_timeout * 1000000));
+    std::chrono::system_clock::duration flushInterval =
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(flush_interval));
+    std::chrono::microseconds currentPktTimestamp = firstTimestamp;
+    bool firstFlush = true;
+    lastPrinted = std::chrono::system_clock::now();
+    std::chrono::system_clock::time_point lastFlushed = lastPrinted;
+
+    decoded_packet pkt;
+    do {
+        if (!decode_ethernet_packet(*header, data, pkt)) continue;
+
+        currentPktTimestamp = pkt.timestamp;
+        process_interval_barriers(currentPktTimestamp);
+
+        stats.incrementPacketCount();
+        this->process_packets(pkt);
+
+        print_progress(0, stats.getPacketCount());
+        if (std::chrono::system_clock::now() - lastFlushed >= flushInterval) {
+            stats.setTimestampLastPacket(currentPktTimestamp);
+            stats.writeStreamToDatabase(databasePath, timeIntervals, currentPktTimestamp - idleTimeout, firstFlush, false);
+            firstFlush = false;
+            lastFlushed = std::chrono::system_clock::now();
+        }
+    } while (reader->next(header, data));
+
+    std::cout << "\rInspected packets: (" << stats.getPacketCount() << ")" << std::endl;
+    if (!reader->get_error().empty()) {
+        std::cerr << "WARNING: Stopped reading PCAP stream '" << filePath << "': " << reader->get_error() << std::endl;
+    }
+
+    stats.setTimestampLastPacket(currentPktTimestamp);
+    if (stats.getSketchMode()) {
+        stats.materializeSketches();
+    }
+    stats.writeStreamToDatabase(databasePath, timeIntervals, currentPktTimestamp, firstFlush, true);
+
+    if(hasUnrecognized) {
+        std::cout << "Unrecognized PDUs detected: Check 'unrecognized_pdus' table!" << std::endl;
+    }
+}
+
+/**
+ * Registers the interval statistics of every time interval whose barrier is passed by the given packet.
+ * Drops the last interval, if it is too small.
+ * @param currentPktTimestamp The timestamp of the packet which is about to be processed.
+ */
+void pcap_processor::process_interval_barriers(std::chrono::microseconds currentPktTimestamp) {
+    passedBarriers.clear();
+    find_interval_barriers(currentPktTimestamp, 0, passedBarriers);
+    for (std::size_t j = 0; j < passedBarriers.size(); j++) {
+        stats.addIntervalStat(passedBarriers[j].interval, passedBarriers[j].start, passedBarriers[j].end);
+    }
+}
+
+/**
+ * Determines the time intervals whose barrier is passed by the given packet and advances the barriers.
+ * @param currentPktTimestamp The timestamp of the packet which is about to be processed.
+ * @param packetIndex The index of the packet, which is stored with the intervals.
+ * @param passed The passed intervals are appended to this vector.
+ */
+void pcap_processor::find_interval_barriers(std::chrono::microseconds currentPktTimestamp, std::size_t packetIndex,
+                                            std::vector<interval_barrier> &passed) {
+    std::chrono::microseconds currentDuration = currentPktTimestamp - firstTimestamp;
+
+    for (std::size_t j = 0; j < barriers.size(); j++) {
+        if(currentDuration>barriers[j]){
+            passed.push_back({packetIndex, timeIntervals[j], intervalStartTimestamp[j], currentPktTimestamp});
+
+            barriers[j] =  barriers[j] + timeIntervals[j];
+            intervalStartTimestamp[j] = currentPktTimestamp;
+        }
+    }
+}
+
+/**
+ * Collects the statistics of a memory mapped Ethernet capture in chunks processed by one thread each. The chunks
+ * are byte ranges of the file, whose boundaries are moved forward to the next packet record. Every chunk is
+ * processed by its own processor, the processors are merged in capture order afterwards. The processors of the
+ * later chunks defer their time intervals, which are registered when they are merged, see statistics::merge, so the
+ * interval statistics equal those of a sequential pass. The barriers of a later chunk are aligned to its first
+ * packet, assuming that the barriers before did not lag behind the packets; a chunk for which this does not hold is
+ * processed again once the barriers of the chunks before are known, see continue_chunk_intervals.
+ * In packet sampling mode, every chunk selects one in N of its own packets.
+ * If a chunk does not end exactly at the start of the next chunk, because a boundary was not found correctly,
+ * nothing is collected and false is returned, so that the file can be processed sequentially.
+ * @param fileReader The reader of the file, which is only used to find the chunk boundaries.
+ * @param chunkCount The number of chunks and threads.
+ * @param begin The offset of the first packet record to process, a record boundary.
+ * @param end The offset after which no more packet records are processed.
+ * @return true, if the statistics of the records in [begin, end) were collected.
+ */
+bool pcap_processor::collect_chunk_statistics(const pcap_mmap_reader &fileReader, std::size_t chunkCount,
+                                              uint64_t begin, uint64_t end) {
+    std::vector<uint64_t> boundaries;
+    boundaries.push_back(begin);
+    for (std::size_t k = 1; k < chunkCount; k++) {
+        uint64_t position = begin + (end - begin) * k / chunkCount;
+        uint64_t boundary = fileReader.find_record_boundary(position);
+        if (boundary > boundaries.back() && boundary < end) {
+            boundaries.push_back(boundary);
+        }
+    }
+    boundaries.push_back(end);
+    chunkCount = boundaries.size() - 1;
+    if (chunkCount < 2) {
+        return false;
+    }
+
+    // The state is restored if the chunks cannot be merged
+    statistics initialStats = stats;
+    packet_sampler initialSampler = sampler;
+    std::vector<std::chrono::microseconds> initialBarriers = barriers;
+    std::vector<std::chrono::microseconds> initialIntervalStartTimestamp = intervalStartTimestamp;
+    stats.setTimestampLastPacket(firstTimestamp);
+
+    // The first chunk is processed by this processor
+    std::vector<std::unique_ptr<pcap_processor>> chunkProcessors;
+    std::vector<pcap_processor *> processors;
+    std::vector<std::unique_ptr<pcap_mmap_reader>> readers;
+    std::vector<std::unique_ptr<chunk_progress>> progress;
+    processors.push_back(this);
+    for (std::size_t k = 0; k < chunkCount; k++) {
+        if (k > 0) {
+            processors.push_back(create_chunk_processor(chunkProcessors, sampler));
+        }
+        readers.emplace_back(new pcap_mmap_reader(filePaths[0]));
+        readers.back()->set_range(boundaries[k], boundaries[k + 1]);
+        if (!window.is_restricted()) {
+            readers.back()->set_index_interval(PACKET_INDEX_INTERVAL);
+        }
+        progress.emplace_back(new chunk_progress());
+        progress.back()->position.store(boundaries[k]);
+        progress.back()->packetCount.store(0);
+        progress.back()->done.store(false);
+        progress.back()->started = false;
+    }
+
+    std::atomic<bool> stopped(false);
+    std::vector<std::thread> workers;
+    for (std::size_t k = 0; k < chunkCount; k++) {
+        workers.emplace_back(&pcap_processor::process_chunk, processors[k], std::ref(*readers[k]), k > 0,
+                             std::ref(*progress[k]), std::cref(stopped));
+    }
+
+    try {
+        bool done = false;
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            done = true;
+            uint64_t position = begin;
+            int packetCount = 0;
+            for (std::size_t k = 0; k < chunkCount; k++) {
+                done = done && progress[k]->done.load(std::memory_order_acquire);
+                position += progress[k]->position.load(std::memory_order_relaxed) - boundaries[k];
+                packetCount += progress[k]->packetCount.load(std::memory_order_relaxed);
+            }
+            print_progress(position, packetCount);
+        }
+    } catch (...) {
+        stopped.store(true);
+        for (std::size_t k = 0; k < chunkCount; k++) {
+            workers[k].join();
+        }
+        throw;
+    }
+    for (std::size_t k = 0; k < chunkCount; k++) {
+        workers[k].join();
+    }
+
+    for (std::size_t k = 0; k + 1 < chunkCount; k++) {
+        if (!readers[k]->get_error().empty() || readers[k]->get_position() != boundaries[k + 1]) {
+            std::cerr << std::endl << "WARNING: Could not split PCAP '" << filePath << "' into chunks, "
+                      << "processing it sequentially" << std::endl;
+            stats = initialStats;
+            sampler = initialSampler;
+            barriers = initialBarriers;
+            intervalStartTimestamp = initialIntervalStartTimestamp;
+            hasUnrecognized = false;
+            return false;
+        }
+    }
+    if (!readers.back()->get_error().empty()) {
+        std::cerr << std::endl << "WARNING: Stopped reading PCAP '" << filePath << "': "
+                  << readers.back()->get_error() << std::endl;
+    }
+
+    // The intervals of a chunk continue the intervals of the chunks before, which end with the barriers of this
+    // processor. A chunk whose aligned barriers do not continue them is processed again with these barriers.
+    for (std::size_t k = 1; k < chunkCount; k++) {
+        if (!progress[k]->started) continue;
+
+        if (!continue_chunk_intervals(*processors[k], *progress[k])) {
+            processors[k] = create_chunk_processor(chunkProcessors, initialSampler);
+            processors[k]->barriers = barriers;
+            processors[k]->intervalStartTimestamp = intervalStartTimestamp;
+            readers[k].reset(new pcap_mmap_reader(filePaths[0]));
+            readers[k]->set_range(boundaries[k], boundaries[k + 1]);
+            if (!window.is_restricted()) {
+                readers[k]->set_index_interval(PACKET_INDEX_INTERVAL);
+            }
+            processors[k]->process_chunk(*readers[k], false, *progress[k], stopped);
+            barriers = processors[k]->barriers;
+            intervalStartTimestamp = processors[k]->intervalStartTimestamp;
+        }
+        merge_statistics(*processors[k]);
+    }
+    stats.setTimestampFirstPacket(firstTimestamp);
+
+    // The packets of a chunk are numbered after the packets of the chunks before
+    uint64_t packetsBefore = 0;
+    for (std::size_t k = 0; k < chunkCount; k++) {
+        for (const packet_index_entry &entry: readers[k]->get_index()) {
+            packetIndex.push_back({packetsBefore + entry.packetNumber, entry.offset, entry.timestamp});
+        }
+        packetsBefore += readers[k]->get_record_count();
+    }
+    return true;
+}
+
+/**
+ * Creates the processor of a chunk after the first chunk, which has the configuration and the interval barriers of
+ * this processor and defers its time intervals.
+ * @param chunkProcessors The created processor is added to these processors, which own it.
+ * @param chunkSampler The sampler of the chunk, a copy of the sampler before the first chunk.
+ * @return the created processor.
+ */
+pcap_processor *pcap_processor::create_chunk_processor(std::vector<std::unique_ptr<pcap_processor>> &chunkProcessors,
+                                                       const packet_sampler &chunkSampler) {
+    chunkProcessors.emplace_back(new pcap_processor(filePath, stats.getDoExtraTests() ? "True" : "False",
+                                                    resourcePath, databasePath));
+    pcap_processor *processor = chunkProcessors.back().get();
+    processor->stats.setTimestampFirstPacket(firstTimestamp);
+    processor->stats.setDefaultInterval(stats.getDefaultInterval());
+    processor->stats.setDeferredIntervals(true);
+    processor->firstTimestamp = firstTimestamp;
+    processor->timeIntervals = timeIntervals;
+    processor->barriers = barriers;
+    processor->intervalStartTimestamp = intervalStartTimestamp;
+    processor->filter = filter;
+    processor->window = window;
+    processor->sampler = chunkSampler;
+    processor->stats.setSketchMode(stats.getSketchMode());
+    return processor;
+}
+
+/**
+ * Chunk worker thread: Collects the statistics of the packets of one chunk, like the single threaded
+ * loop of collect_statistics.
+ * @param chunkReader The reader restricted to the packet records of the chunk.
+ * @param alignBarriers Whether the interval barriers have to be moved to the first packet of the chunk.
+ * @param progress The progress of the worker, which is updated regularly.
+ * @param stopped Signals the worker to stop early.
+ */
+void pcap_processor::process_chunk(pcap_mmap_reader &chunkReader, bool alignBarriers, chunk_progress &progress,
+                                   const std::atomic<bool> &stopped) {
+    const pcap_pkthdr *header;
+    const u_char *data;
+    decoded_packet pkt;
+    bool firstPacket = true;
+    int packetCount = 0;
+    while (!stopped.load(std::memory_order_relaxed) && chunkReader.next(header, data)) {
+        if (!window.contains(get_packet_timestamp(*header))) continue;
+        if (filter != nullptr && !filter->matches(*header, data)) continue;
+        if (!decode_ethernet_packet(*header, data, pkt)) continue;
+
+        if (firstPacket) {
+            progress.started = true;
+            progress.firstTimestamp = pkt.timestamp;
+            if (alignBarriers) align_interval_barriers(pkt.timestamp);
+            progress.firstBarriers = barriers;
+        }
+        firstPacket = false;
+        process_interval_barriers(pkt.timestamp);
+        stats.setTimestampLastPacket(pkt.timestamp);
+        if (!sampler.selects(pkt)) continue;
+
+        stats.incrementPacketCount();
+        this->process_packets(pkt);
+
+        packetCount++;
+        if (packetCount % 1024 == 0) {
+            progress.position.store(chunkReader.get_position(), std::memory_order_relaxed);
+            progress.packetCount.store(packetCount, std::memory_order_relaxed);
+        }
+    }
+    progress.position.store(chunkReader.get_position(), std::memory_order_relaxed);
+    progress.packetCount.store(packetCount, std::memory_order_relaxed);
+    progress.done.store(true, std::memory_order_release);
+}
+
+/**
+ * Continues the intervals of the chunks before, which end with the barriers of this processor, with the deferred
+ * intervals of a chunk whose barriers were aligned to its first packet. An interval whose barrier the first packet of
+ * the chunk passes, but not the aligned barrier, is registered here, the other intervals continue into the chunk.
+ * Afterwards, the barriers of this processor are the barriers after the chunk.
+ * @param chunk The processor of the chunk.
+ * @param progress The progress of the chunk.
+ * @return false if the aligned barriers of the chunk differ from the barriers a sequential pass has at the first
+ * packet of the chunk, because these lag behind the packets, or if the intervals passed by the first packet would be
+ * registered in another order. Nothing is changed then.
+ */
+bool pcap_processor::continue_chunk_intervals(pcap_processor &chunk, const chunk_progress &progress) {
+    std::chrono::microseconds currentDuration = progress.firstTimestamp - firstTimestamp;
+    std::vector<bool> registered(barriers.size(), false);
+    bool chunkPassed = false;
+    for (std::size_t j = 0; j < barriers.size(); j++) {
+        const std::chrono::microseconds &chunkBarrier = progress.firstBarriers[j];
+        if (currentDuration > barriers[j] && chunkBarrier == barriers[j] + timeIntervals[j] &&
+            currentDuration <= chunkBarrier) {
+            // The chunk registers the intervals its first packet passed after the intervals registered here
+            if (chunkPassed)
+                return false;
+            registered[j] = true;
+        } else if (chunkBarrier == barriers[j]) {
+            chunkPassed = chunkPassed || currentDuration > chunkBarrier;
+        } else {
+            return false;
+        }
+    }
+
+    for (std::size_t j = 0; j < barriers.size(); j++) {
+        if (registered[j]) {
+            stats.addIntervalStat(timeIntervals[j], intervalStartTimestamp[j], progress.firstTimestamp);
+            intervalStartTimestamp[j] = chunk.intervalStartTimestamp[j];
+        } else if (chunk.stats.continueDeferredInterval(timeIntervals[j], intervalStartTimestamp[j])) {
+            intervalStartTimestamp[j] = chunk.intervalStartTimestamp[j];
+        }
+        barriers[j] = chunk.barriers[j];
+    }
+    return true;
+}
+
+/**
+ * Moves the interval barriers to the first packet of a chunk, as if the intervals before had been registered.
+ * The intervals of the chunk start with this packet.
+ * @param chunkTimestamp The timestamp of the first packet of the chunk.
+ */
+void pcap_processor::align_interval_barriers(std::chrono::microseconds chunkTimestamp) {
+    std::chrono::microseconds currentDuration = chunkTimestamp - firstTimestamp;
+
+    for (std::size_t j = 0; j < barriers.size(); j++) {
+        if (currentDuration > barriers[j] && timeIntervals[j].count() > 0) {
+            auto passedIntervals = (currentDuration - barriers[j] + timeIntervals[j] - std::chrono::microseconds(1)) / timeIntervals[j];
+            barriers[j] = barriers[j] + passedIntervals * timeIntervals[j];
+        }
+        intervalStartTimestamp[j] = chunkTimestamp;
+    }
+}
+
+/**
+ * Indicates the progress of collect_statistics once every second and checks for pending signals.
+ * The progress is the share of the file read so far, if the file size is known.
+ * @param position The number of bytes of the file read so far.
+ * @param packetCount The number of packets read so far.
+ */
+void pcap_processor::print_progress(uint64_t position, int packetCount) {
+    if (std::chrono::system_clock::now() - lastPrinted >= std::chrono::seconds(1)) {
+        std::cout << "\rInspected packets: ";
+        if (fileSize > 0) {
+            std::cout << std::fixed << std::setprecision(1) << (static_cast<double>(position)*100/fileSize) << "% ";
+        }
+        std::cout << "(" << packetCount << ")" << std::flush;
+        lastPrinted = std::chrono::system_clock::now();
+
+        if (PyErr_CheckSignals()) throw py::error_already_set();
+    }
+}
+
+/**
+ * Writes a checkpoint of collect_statistics: the configuration it applies to, the position of the reader, the interval
+ * barrier state and the statistics collected so far. The previous checkpoint is kept if the checkpoint cannot be
+ * written.
+ * @param fileReader The reader of the PCAP file, positioned after the last processed packet.
+ * @param currentPktTimestamp The timestamp of the last processed packet.
+ * @param intervals The intervals passed to collect_statistics.
+ */
+void pcap_processor::write_checkpoint(const pcap_mmap_reader &fileReader, std::chrono::microseconds currentPktTimestamp,
+                                      const std::vector<double> &intervals) {
+    checkpoint_writer out(checkpointPath);
+    checkpoint_save(out, static_cast<uint64_t>(CHECKPOINT_MAGIC));
+    checkpoint_save(out, static_cast<uint32_t>(CHECKPOINT_VERSION));
+    checkpoint_save(out, filePath);
+    checkpoint_save(out, fileReader.get_position());
+    checkpoint_save(out, fileReader.get_fingerprint(fileReader.get_position()));
+    checkpoint_save(out, stats.getDoExtraTests());
+    checkpoint_save(out, stats.getSketchMode());
+    checkpoint_save(out, filterExpression);
+    checkpoint_save(out, window.start);
+    checkpoint_save(out, window.end);
+    checkpoint_save(out, static_cast<uint8_t>(sampler.get_mode()));
+    checkpoint_save(out, sampler.get_rate());
+    checkpoint_save(out, intervals);
+
+    checkpoint_save(out, fileReader.get_record_count());
+    checkpoint_save(out, fileReader.get_index());
+    checkpoint_save(out, firstTimestamp);
+    checkpoint_save(out, currentPktTimestamp);
+    checkpoint_save(out, timeIntervals);
+    checkpoint_save(out, barriers);
+    checkpoint_save(out, intervalStartTimestamp);
+    checkpoint_save(out, sampler.get_packet_number());
+    checkpoint_save(out, hasUnrecognized);
+    stats.saveCheckpoint(out);
+
+    if (!out.commit()) {
+        std::cerr << std::endl << "WARNING: Could not write checkpoint '" << checkpointPath << "': " << out.get_error()
+                  << std::endl;
+    }
+    lastCheckpoint = std::chrono::steady_clock::now();
+}
+
+/**
+ * Restores the state of collect_statistics from the checkpoint, if one was written for the same PCAP file and
+ * configuration, and positions the reader after the last packet processed before.
+ * @param fileReader The reader of the PCAP file.
+ * @param currentPktTimestamp Set to the timestamp of the last processed packet.
+ * @param intervals The intervals passed to collect_statistics.
+ * @return true if the state was restored.
+ */
+bool pcap_processor::read_checkpoint(pcap_mmap_reader &fileReader, std::chrono::microseconds &currentPktTimestamp,
+                                     const std::vector<double> &intervals) {
+    checkpoint_reader in(checkpointPath);
+    if (!in.is_open()) {
+        return false;
+    }
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    checkpoint_load(in, magic);
+    checkpoint_load(in, version);
+    if (magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        std::cerr << "WARNING: '" << checkpointPath << "' is not a checkpoint of this version, it is replaced by new "
+                  << "checkpoints" << std::endl;
+        return false;
+    }
+
+    std::string checkpointFilePath;
+    uint64_t position = 0;
+    uint64_t fingerprint = 0;
+    bool extraTests = false;
+    bool sketchMode = false;
+    std::string expression;
+    time_window checkpointWindow = unrestricted_time_window();
+    uint8_t mode = 0;
+    unsigned int rate = 0;
+    std::vector<double> checkpointIntervals;
+    checkpoint_load(in, checkpointFilePath);
+    checkpoint_load(in, position);
+    checkpoint_load(in, fingerprint);
+    checkpoint_load(in, extraTests);
+    checkpoint_load(in, sketchMode);
+    checkpoint_load(in, expression);
+    checkpoint_load(in, checkpointWindow.start);
+    checkpoint_load(in, checkpointWindow.end);
+    checkpoint_load(in, mode);
+    checkpoint_load(in, rate);
+    checkpoint_load(in, checkpointIntervals);
+    // The file may have grown since, as long as it still starts with the packets processed before
+    if (checkpointFilePath != filePath || position > fileReader.get_file_size() ||
+        fileReader.get_fingerprint(position) != fingerprint || extraTests != stats.getDoExtraTests() || sketchMode != stats.getSketchMode() ||
+        expression != filterExpression || checkpointWindow.start != window.start ||
+        checkpointWindow.end != window.end || mode != static_cast<uint8_t>(sampler.get_mode()) ||
+        rate != sampler.get_rate() || checkpointIntervals != intervals) {
+        std::cerr << "WARNING: Checkpoint '" << checkpointPath << "' was written for another PCAP file or "
+                  << "configuration, it is replaced by new checkpoints" << std::endl;
+        return false;
+    }
+
+    uint64_t recordCount = 0;
+    std::vector<packet_index_entry> index;
+    std::chrono::microseconds checkpointFirstTimestamp;
+    std::chrono::microseconds checkpointPktTimestamp;
+    std::vector<std::chrono::duration<int, std::micro>> checkpointTimeIntervals;
+    std::vector<std::chrono::microseconds> checkpointBarriers;
+    std::vector<std::chrono::microseconds> checkpointIntervalStartTimestamp;
+    uint64_t samplerPacketNumber = 0;
+    bool unrecognized = false;
+    statistics checkpointStats(resourcePath);
+    checkpoint_load(in, recordCount);
+    checkpoint_load(in, index);
+    checkpoint_load(in, checkpointFirstTimestamp);
+    checkpoint_load(in, checkpointPktTimestamp);
+    checkpoint_load(in, checkpointTimeIntervals);
+    checkpoint_load(in, checkpointBarriers);
+    checkpoint_load(in, checkpointIntervalStartTimestamp);
+    checkpoint_load(in, samplerPacketNumber);
+    checkpoint_load(in, unrecognized);
+    checkpointStats.loadCheckpoint(in);
+    if (in.is_damaged()) {
+        std::cerr << "WARNING: Checkpoint '" << checkpointPath << "' is damaged, it is replaced by new checkpoints"
+                  << std::endl;
+        return false;
+    }
+
+    fileReader.resume(position, recordCount, index);
+    firstTimestamp = checkpointFirstTimestamp;
+    currentPktTimestamp = checkpointPktTimestamp;
+    timeIntervals = checkpointTimeIntervals;
+    barriers = checkpointBarriers;
+    intervalStartTimestamp = checkpointIntervalStartTimestamp;
+    sampler.set_packet_number(samplerPacketNumber);
+    hasUnrecognized = unrecognized;
+    stats = std::move(checkpointStats);
+    std::cout << "Resuming from checkpoint '" << checkpointPath << "' after " << stats.getPacketCount() << " packets"
+              << std::endl;
+    return true;
+}
+
+/**
+ * Analyzes a packet decoded by decode_ethernet_packet and collects statistical information.
+ * Collects the same information as process_packets for libtins packets.
+ * @param pkt The decoded packet to get analyzed.
+ */
+void pcap_processor::process_packets(const decoded_packet &pkt) {
+    process_packets(pkt, stats);
+}
+
+/**
+ * Analyzes a packet decoded by decode_ethernet_packet and collects statistical information into the given
+ * statistics, which may be one of several shards.
+ * @param pkt The decoded packet to get analyzed.
+ * @param shardStats The statistics to collect the information into.
+ */
+void pcap_processor::process_packets(const decoded_packet &pkt, statistics &shardStats) {
+    // The addresses are only formatted the first time they are seen
+    address_dictionary &addresses = shardStats.getAddresses();
+
+    // Layer 2: Data Link Layer ------------------------
+    address_id macAddressSender = 0;
+    address_id macAddressReceiver = 0;
+    if (pkt.has_ethernet) {
+        macAddressSender = addresses.intern_mac(pkt.mac_src);
+        macAddressReceiver = addresses.intern_mac(pkt.mac_dst);
+    }
+    uint32_t sizeCurrentPacket = pkt.size;
+
+    shardStats.addPacketSize(sizeCurrentPacket);
+
+    // Layer 3 - Network -------------------------------
+    address_id ipAddressSender = 0;
+    address_id ipAddressReceiver = 0;
+
+    // PDU is IPv4
+    if (pkt.l3 == l3_protocol::IPV4) {
+        ipAddressSender = addresses.intern_ipv4(pkt.ip_src);
+        ipAddressReceiver = addresses.intern_ipv4(pkt.ip_dst);
+
+        // IP distribution
+        shardStats.addIpStat_packetSent(ipAddressSender, ipAddressReceiver, sizeCurrentPacket);
+
+        // TTL distribution
+        shardStats.incrementTTLcount(ipAddressSender, pkt.ttl);
+
+        // ToS distribution
+        shardStats.incrementToScount(ipAddressSender, pkt.tos);
+
+        // Protocol distribution
+        shardStats.incrementProtocolCount(ipAddressSender, "IPv4");
+        shardStats.increaseProtocolByteCount(ipAddressSender, "IPv4", sizeCurrentPacket);
+
+        // Assign IP Address to MAC Address
+        shardStats.assignMacAddress(ipAddressSender, macAddressSender);
+        shardStats.assignMacAddress(ipAddressReceiver, macAddressReceiver);
+    } //PDU is unrecognized
+    else if (shardStats.ownsCaptureCounters()) {
+        hasUnrecognized = true;
+
+        long long ts = pkt.timestamp.count();
+        std::string timestamp_pkt = shardStats.getFormattedTimestamp(static_cast<time_t>(ts / 1000000), static_cast<suseconds_t>(ts % 1000000));
+
+        shardStats.incrementUnrecognizedPDUCount(macAddressSender, macAddressReceiver, pkt.payload_type, timestamp_pkt);
+    }
+
+    // Layer 4 - Transport -------------------------------
+    if (pkt.l4 != l4_protocol::NONE) {
+        // Check for IPv4: payload
+        if (pkt.l3 == l3_protocol::IPV4) {
+            shardStats.checkPayload(pkt.l4_payload_size);
+        }
+
+        if (pkt.l4 == l4_protocol::TCP) {
+            // Check TCP checksum
+            if (pkt.l3 == l3_protocol::IPV4) {
+                shardStats.checkTCPChecksum(pkt.ip_src, pkt.ip_dst, pkt.tcp_segment, pkt.tcp_segment_size);
+            }
+
+            shardStats.incrementProtocolCount(ipAddressSender, "TCP");
+            shardStats.increaseProtocolByteCount(ipAddressSender, "TCP", sizeCurrentPacket);
+
+            // Conversation statistics
+            shardStats.addConvStat(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, pkt.timestamp, small_uint<12>(pkt.tcp_flags));
+            shardStats.addConvStatExt(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, "TCP", pkt.timestamp);
+
+            // Window Size distribution
+            shardStats.incrementWinCount(ipAddressSender, pkt.window);
+
+            // MSS distribution
+            if (pkt.has_mss) {
+                shardStats.incrementMSScount(ipAddressSender, pkt.mss);
+            }
+
+            shardStats.incrementPortCount(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, "TCP");
+            shardStats.increasePortByteCount(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, sizeCurrentPacket, "TCP");
+
+          // UDP Packet
+        } else if (pkt.l4 == l4_protocol::UDP) {
+            shardStats.incrementProtocolCount(ipAddressSender, "UDP");
+            shardStats.increaseProtocolByteCount(ipAddressSender, "UDP", sizeCurrentPacket);
+            shardStats.incrementPortCount(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, "UDP");
+            shardStats.increasePortByteCount(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, sizeCurrentPacket, "UDP");
+            shardStats.addConvStatExt(ipAddressSender, pkt.sport, ipAddressReceiver, pkt.dport, "UDP", pkt.timestamp);
+        } else if (pkt.l4 == l4_protocol::ICMP) {
+            shardStats.incrementProtocolCount(ipAddressSender, "ICMP");
+            shardStats.increaseProtocolByteCount(ipAddressSender, "ICMP", sizeCurrentPacket);
+        } else if (pkt.l4 == l4_protocol::ICMPV6) {
+            shardStats.incrementProtocolCount(ipAddressSender, "ICMPv6");
+            shardStats.increaseProtocolByteCount(ipAddressSender, "ICMPv6", sizeCurrentPacket);
+        }
+    }
+}
+
 /**
  * Analyzes a given packet and collects statistical information.
  * @param pkt The packet to get analyzed.
  */
 void pcap_processor::process_packets(const Packet &pkt) {
+    address_dictionary &addresses = stats.getAddresses();
+
     // Layer 2: Data Link Layer ------------------------
-    std::string macAddressSender;
-    std::string macAddressReceiver;
+    address_id macAddressSender = 0;
+    address_id macAddressReceiver = 0;
     const PDU *pdu_l2 = pkt.pdu();
     uint32_t sizeCurrentPacket = pdu_l2->size();
     if (pdu_l2->pdu_type() == PDU::ETHERNET_II) {
         const EthernetII &eth = (const EthernetII &) *pdu_l2;
-        macAddressSender = eth.src_addr().to_string();
-        macAddressReceiver = eth.dst_addr().to_string();
+        macAddressSender = addresses.intern(eth.src_addr().to_string());
+        macAddressReceiver = addresses.intern(eth.dst_addr().to_string());
         sizeCurrentPacket = eth.size();
     }
 
@@ -290,17 +1333,17 @@ void pcap_processor::process_packets(const Packet &pkt) {
     // Layer 3 - Network -------------------------------
     const PDU *pdu_l3 = pkt.pdu()->inner_pdu();
     const PDU::PDUType pdu_l3_type = pdu_l3->pdu_type();
-    std::string ipAddressSender;
-    std::string ipAddressReceiver;
+    address_id ipAddressSender = 0;
+    address_id ipAddressReceiver = 0;
 
     // PDU is IPv4
     if (pdu_l3_type == PDU::PDUType::IP) {
         const IP &ipLayer = (const IP &) *pdu_l3;
-        ipAddressSender = ipLayer.src_addr().to_string();
-        ipAddressReceiver = ipLayer.dst_addr().to_string();
+        ipAddressSender = addresses.intern(ipLayer.src_addr().to_string());
+        ipAddressReceiver = addresses.intern(ipLayer.dst_addr().to_string());
 
         // IP distribution
-        stats.addIpStat_packetSent(ipAddressSender, ipAddressReceiver, sizeCurrentPacket, pkt.timestamp());
+        stats.addIpStat_packetSent(ipAddressSender, ipAddressReceiver, sizeCurrentPacket);
 
         // TTL distribution
         stats.incrementTTLcount(ipAddressSender, ipLayer.ttl());
@@ -321,11 +1364,11 @@ void pcap_processor::process_packets(const Packet &pkt) {
     /*else if (pdu_l3_type == PDU::PDUType::IPv6) {
         return;
         const IPv6 &ipLayer = (const IPv6 &) *pdu_l3;
-        ipAddressSender = ipLayer.src_addr().to_string();
-        ipAddressReceiver = ipLayer.dst_addr().to_string();
+        ipAddressSender = addresses.intern(ipLayer.src_addr().to_string());
+        ipAddressReceiver = addresses.intern(ipLayer.dst_addr().to_string());
 
         // IP distribution
-        stats.addIpStat_packetSent(ipAddressSender, ipAddressReceiver, sizeCurrentPacket, pkt.timestamp());
+        stats.addIpStat_packetSent(ipAddressSender, ipAddressReceiver, sizeCurrentPacket);
 
         // TTL distribution
         stats.incrementTTLcount(ipAddressSender, ipLayer.hop_limit());
@@ -364,7 +1407,7 @@ void pcap_processor::process_packets(const Packet &pkt) {
             
             // Check TCP checksum
             if (pdu_l3_type == PDU::PDUType::IP) {
-                stats.checkTCPChecksum(ipAddressSender, ipAddressReceiver, tcpPkt);
+                stats.checkTCPChecksum(addresses.get(ipAddressSender), addresses.get(ipAddressReceiver), tcpPkt);
             }
 
             stats.incrementProtocolCount(ipAddressSender, "TCP");
@@ -428,6 +1471,90 @@ void pcap_processor::write_to_database(std::string database_path, const py::list
         timeIntervals.push_back(timeInterval);
     }
     stats.writeToDatabase(database_path, timeIntervals, del);
+    if (!packetIndex.empty()) {
+        statistics_db stats_db(database_path, resourcePath);
+        stats_db.writePacketIndex(packetIndex);
+    }
+    // The statistics are stored, a later run does not need to resume them unless it processes appended packets
+    if (!checkpointPath.empty() && !incremental) {
+        std::remove(checkpointPath.c_str());
+    }
+}
+
+/**
+ * Merges the statistics collected by another processor into the statistics of this processor.
+ * The packets of the other processor have to follow the packets of this processor, see statistics::merge. The
+ * interval statistics and interval rates are those of both processors combined, each with its own interval origin,
+ * and only approximate the statistics of a single pass over both captures.
+ * @param other The processor whose statistics should be merged.
+ */
+void pcap_processor::merge_statistics(const pcap_processor &other) {
+    stats.merge(other.stats);
+    hasUnrecognized = hasUnrecognized || other.hasUnrecognized;
+    // The packet index only describes a single file
+    packetIndex.clear();
+}
+
+/**
+ * Writes the statistics collected by collect_statistics to a snapshot at path, from which load_snapshot restores them.
+ * Together with merge_statistics, this gives the statistics of a capture into which packets were injected without
+ * processing the capture again: only the injected packets are processed and merged into the restored statistics.
+ * @param path The path of the snapshot file.
+ * @return false if the snapshot could not be written.
+ */
+bool pcap_processor::write_snapshot(const std::string &path) {
+    checkpoint_writer out(path);
+    checkpoint_save(out, static_cast<uint64_t>(SNAPSHOT_MAGIC));
+    checkpoint_save(out, static_cast<uint32_t>(CHECKPOINT_VERSION));
+    checkpoint_save(out, stats.getDoExtraTests());
+    checkpoint_save(out, stats.getSketchMode());
+    checkpoint_save(out, hasUnrecognized);
+    stats.saveCheckpoint(out);
+    if (!out.commit()) {
+        std::cerr << "WARNING: Could not write statistics snapshot '" << path << "': " << out.get_error() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces the statistics of this processor by the statistics of a snapshot written by write_snapshot. The snapshot
+ * has to be collected with the same extra tests and sketch mode setting.
+ * @param path The path of the snapshot file.
+ * @return false if there is no usable snapshot at path, the statistics are unchanged then.
+ */
+bool pcap_processor::load_snapshot(const std::string &path) {
+    checkpoint_reader in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    bool extraTests = false;
+    bool sketchMode = false;
+    bool unrecognized = false;
+    checkpoint_load(in, magic);
+    checkpoint_load(in, version);
+    checkpoint_load(in, extraTests);
+    checkpoint_load(in, sketchMode);
+    if (magic != SNAPSHOT_MAGIC || version != CHECKPOINT_VERSION || extraTests != stats.getDoExtraTests() ||
+        sketchMode != stats.getSketchMode()) {
+        std::cerr << "WARNING: '" << path << "' is not a statistics snapshot of this version and configuration"
+                  << std::endl;
+        return false;
+    }
+
+    statistics snapshotStats(resourcePath);
+    checkpoint_load(in, unrecognized);
+    snapshotStats.loadCheckpoint(in);
+    if (in.is_damaged()) {
+        std::cerr << "WARNING: Statistics snapshot '" << path << "' is damaged" << std::endl;
+        return false;
+    }
+    stats = std::move(snapshotStats);
+    hasUnrecognized = unrecognized;
+    packetIndex.clear();
+    return true;
 }
 
 void pcap_processor::write_new_interval_statistics(std::string database_path, const py::list& intervals) {
@@ -457,6 +1584,138 @@ bool inline pcap_processor::file_exists(const std::string &filePath) {
     return stat(filePath.c_str(), &buffer) == 0;
 }
 
+/**
+ * Sets a BPF filter, only the packets matching it are included in the statistics collected afterwards.
+ * @param expression The filter expression in pcap-filter syntax, e.g. "net 10.1.0.0/16", empty to disable it.
+ */
+void pcap_processor::set_filter(const std::string &expression) {
+    filterExpression = expression;
+}
+
+/**
+ * Converts a timestamp passed from Python to a bound of the time window.
+ * @param timestamp The timestamp in microseconds, which may be infinite.
+ * @return the timestamp, limited to the range of int64_t.
+ */
+static int64_t to_window_bound(long double timestamp) {
+    if (timestamp <= static_cast<long double>(std::numeric_limits<int64_t>::min())) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    if (timestamp >= static_cast<long double>(std::numeric_limits<int64_t>::max())) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    return static_cast<int64_t>(timestamp);
+}
+
+/**
+ * Restricts the statistics collected afterwards to the packets with a timestamp in [start_mu_sec, end_mu_sec].
+ * Memory mapped captures are then only read around the time window.
+ * @param start_mu_sec The timestamp of the first packet to be processed in microseconds, -inf for no limit.
+ * @param end_mu_sec The timestamp of the last packet to be processed in microseconds, inf for no limit.
+ */
+void pcap_processor::set_time_window(long double start_mu_sec, long double end_mu_sec) {
+    window.start = to_window_bound(start_mu_sec);
+    window.end = to_window_bound(end_mu_sec);
+}
+
+/**
+ * Enables sampling for the statistics collected afterwards: Only the statistics of one in rate packets, or of the
+ * packets of one in rate flows, are collected. The counts and byte totals are scaled up by the rate, the sampling
+ * and the estimated error of every table are written to the sampling table. In chunked mode, every chunk counts
+ * its packets on its own.
+ * @param rate The sampling rate N, 1 to disable the sampling.
+ * @param mode "packet" to sample every N-th packet, "flow" to sample whole flows, which are kept or dropped by
+ * the hash of their addresses, ports and transport protocol.
+ */
+void pcap_processor::set_sampling(int rate, const std::string &mode) {
+    sampling_mode samplingMode;
+    if (!parse_sampling_mode(mode, samplingMode)) {
+        std::cerr << "ERROR: Unknown sampling mode '" << mode << "', sampling is disabled" << std::endl;
+        samplingMode = sampling_mode::NONE;
+    }
+    sampler.configure(samplingMode, rate > 1 ? static_cast<unsigned int>(rate) : 1);
+}
+
+/**
+ * Enables sketch mode for the statistics collected afterwards: The per-host TTL, MSS, window size, ToS and port
+ * distributions are counted by a Count-Min Sketch, of which the most frequent values of every host are written, and
+ * the degrees are estimated with HyperLogLog. This bounds the memory of these statistics for captures with many hosts.
+ * @param enabled Whether sketch mode is enabled.
+ */
+void pcap_processor::set_sketch_mode(bool enabled) {
+    stats.setSketchMode(enabled);
+}
+
+/**
+ * Decodes the packets of Ethernet captures with libtins, as the packets of other link types are decoded, instead of
+ * decode_ethernet_packet. The statistics are the same, this is meant for comparing both decoders.
+ * Only single uncompressed captures can be decoded with libtins, which are processed by one thread without sampling.
+ * @param enabled Whether the packets are decoded with libtins.
+ */
+void pcap_processor::set_libtins_decoding(bool enabled) {
+    libtinsDecoding = enabled;
+}
+
+/**
+ * Enables checkpoints of collect_statistics: Every interval_seconds seconds of wall-clock time, the statistics collected
+ * so far are written to a binary snapshot at path, replacing the previous one. If collect_statistics finds a
+ * checkpoint of the same PCAP file and configuration, it resumes after the last packet processed before, so that the
+ * statistics are the same as without the interruption. The checkpoint is removed by write_to_database, unless
+ * incremental statistics are enabled, see set_incremental.
+ * Checkpoints are only written for single uncompressed classic PCAP files, which are then processed by one thread.
+ * @param path The path of the checkpoint file, an empty path disables the checkpoints.
+ * @param interval_seconds The seconds of wall-clock time between two checkpoints.
+ */
+void pcap_processor::set_checkpoint(const std::string &path, double interval_seconds) {
+    checkpointPath = path;
+    checkpointInterval = std::chrono::duration<double>(std::max(0.0, interval_seconds));
+}
+
+/**
+ * Enables incremental statistics for a capture file which is appended to: After its last packet, collect_statistics
+ * keeps its state in a checkpoint at state_path. The next run on the grown file continues with the packets appended
+ * since, instead of processing the whole file again, and write_to_database replaces the statistics tables with the
+ * statistics of the whole file. The time intervals of the first run are kept, so the default interval is not adapted
+ * to the grown capture duration. If the file does not start with the packets processed before anymore, it is
+ * processed from the start. The checkpoints are also written periodically, see set_checkpoint.
+ * @param state_path The path of the checkpoint file, an empty path disables incremental statistics.
+ */
+void pcap_processor::set_incremental(const std::string &state_path) {
+    checkpointPath = state_path;
+    incremental = !state_path.empty();
+}
+
+/**
+ * Checks whether all files of the PCAP or capture set exist.
+ * @return True iff all files exist, otherweise False.
+ */
+bool pcap_processor::capture_exists() {
+    for (const std::string &path: filePaths) {
+        if (!file_exists(path)) {
+            return false;
+        }
+    }
+    return !filePaths.empty();
+}
+
+/**
+ * Reads the packet index entry of the given packet or of the closest packet before it from the statistics database.
+ * @param packetNumber The number of the packet, starting with 1.
+ * @param entry Set to the packet index entry.
+ * @return false if there is no statistics database or it has no packet index.
+ */
+bool pcap_processor::read_packet_index(uint64_t packetNumber, packet_index_entry &entry) {
+    std::string path = databasePath;
+    if (path.find(".sqlite3") == path.npos) {
+        path += ".sqlite3";
+    }
+    if (databasePath.empty() || !file_exists(path)) {
+        return false;
+    }
+    statistics_db stats_db(path, resourcePath);
+    return stats_db.readPacketIndex(packetNumber, entry);
+}
+
 /*
  * Comment in if executable should be build & run
  * Comment out if library should be build
@@ -489,10 +1748,27 @@ bool inline pcap_processor::file_exists(const std::string &filePath) {
 PYBIND11_MODULE (libpcapreader, m) {
     py::class_<pcap_processor>(m, "pcap_processor")
             .def(py::init<std::string, std::string, std::string, std::string>())
+            .def(py::init<py::list, std::string, std::string, std::string>())
             .def("merge_pcaps", &pcap_processor::merge_pcaps)
-            .def("collect_statistics", &pcap_processor::collect_statistics)
+            .def("collect_statistics", &pcap_processor::collect_statistics, py::arg("intervals"), py::arg("threads") = 1,
+                 py::arg("chunked") = false)
+            .def("stream_statistics", &pcap_processor::stream_statistics, py::arg("interval"),
+                 py::arg("flush_interval") = STREAM_FLUSH_INTERVAL, py::arg("idle_timeout") = STREAM_IDLE_TIMEOUT)
             .def("get_timestamp_mu_sec", &pcap_processor::get_timestamp_mu_sec)
+            .def("get_timestamps_mu_sec", &pcap_processor::get_timestamps_mu_sec)
+            .def("get_packet_numbers", &pcap_processor::get_packet_numbers)
             .def("write_to_database", &pcap_processor::write_to_database)
             .def("write_new_interval_statistics", &pcap_processor::write_new_interval_statistics)
+            .def("merge_statistics", &pcap_processor::merge_statistics)
+            .def("write_snapshot", &pcap_processor::write_snapshot)
+            .def("load_snapshot", &pcap_processor::load_snapshot)
+            .def("set_filter", &pcap_processor::set_filter)
+            .def("set_time_window", &pcap_processor::set_time_window)
+            .def("set_sampling", &pcap_processor::set_sampling)
+            .def("set_sketch_mode", &pcap_processor::set_sketch_mode)
+            .def("set_checkpoint", &pcap_processor::set_checkpoint, py::arg("path"),
+                 py::arg("interval_seconds") = CHECKPOINT_INTERVAL)
+            .def("set_incremental", &pcap_processor::set_incremental)
+            .def("set_libtins_decoding", &pcap_processor::set_libtins_decoding)
             .def_static("get_db_version", &pcap_processor::get_db_version);
 }
@@ -6,6 +6,8 @@
 #define CPP_PCAPREADER_MAIN_H
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iomanip>
 #include <tins/tins.h>
 #include <iostream>
@@ -14,13 +16,51 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <unordered_map>
+#include "packet_decoder.h"
+#include "packet_pipeline.h"
+#include "packet_sampler.h"
+#include "pcap_reader.h"
 #include "statistics.h"
+#include "statistics_checkpoint.h"
 #include "statistics_db.h"
 
 namespace py = pybind11;
 
+/*
+ * Default seconds of wall-clock time between two flushes of stream_statistics
+ */
+#define STREAM_FLUSH_INTERVAL 10
+
+/*
+ * Default seconds of capture time after which stream_statistics considers a conversation without packets finished
+ */
+#define STREAM_IDLE_TIMEOUT 120
+
+/*
+ * Default seconds of wall-clock time between two checkpoints of collect_statistics
+ */
+#define CHECKPOINT_INTERVAL 300
+
 using namespace Tins;
 
+/*
+ * Struct used to represent the progress of a worker thread processing a chunk of a PCAP file:
+ * - Offset of the next packet record
+ * - Number of packets processed
+ * - Whether the worker is done
+ * - Whether the chunk has a packet, the first packet and the barriers it saw are valid once the worker is done
+ * - Timestamp of the first packet of the chunk
+ * - Interval barriers at the first packet of the chunk
+ */
+struct chunk_progress {
+    std::atomic<uint64_t> position;
+    std::atomic<int> packetCount;
+    std::atomic<bool> done;
+    bool started;
+    std::chrono::microseconds firstTimestamp;
+    std::vector<std::chrono::microseconds> firstBarriers;
+};
+
 class pcap_processor {
 
 public:
@@ -29,15 +69,19 @@ public:
     */
     pcap_processor(std::string path, std::string extraTests, std::string resource_path, std::string database_path);
 
+    pcap_processor(const py::list &paths, std::string extraTests, std::string resource_path, std::string database_path);
+
     /*
      * Attributes
      */
     statistics stats;
     std::string filePath;
+    std::vector<std::string> filePaths;
     std::string databasePath;
     std::string resourcePath;
     bool hasUnrecognized;
     std::chrono::duration<int, std::micro> timeInterval;
+    std::vector<packet_index_entry> packetIndex;
 
     /*
      * Methods
@@ -46,19 +90,103 @@ public:
 
     void process_packets(const Packet &pkt);
 
+    void process_packets(const decoded_packet &pkt);
+
+    void process_packets(const decoded_packet &pkt, statistics &shardStats);
+
     long double get_timestamp_mu_sec(const int after_packet_number);
 
+    py::list get_timestamps_mu_sec(const py::list &packet_numbers);
+
+    py::list get_packet_numbers(const py::list &timestamps_mu_sec);
+
     std::string merge_pcaps(const std::string pcap_path);
 
-    bool read_pcap_info(const std::string &filePath, std::size_t &totalPakets);
+    bool read_pcap_info(const std::vector<std::string> &filePaths, std::size_t &totalPakets);
 
-    void collect_statistics(py::list& intervals);
+    void collect_statistics(py::list& intervals, int threads = 1, bool chunked = false);
+
+    void stream_statistics(double interval, double flush_interval = STREAM_FLUSH_INTERVAL,
+                           double idle_timeout = STREAM_IDLE_TIMEOUT);
 
     void write_to_database(std::string database_path, const py::list& intervals, bool del);
 
     void write_new_interval_statistics(std::string database_path, const py::list& intervals);
 
+    void merge_statistics(const pcap_processor &other);
+
+    bool write_snapshot(const std::string &path);
+
+    bool load_snapshot(const std::string &path);
+
+    void set_filter(const std::string &expression);
+
+    void set_time_window(long double start_mu_sec, long double end_mu_sec);
+
+    void set_sampling(int rate, const std::string &mode);
+
+    void set_sketch_mode(bool enabled);
+
+    void set_checkpoint(const std::string &path, double interval_seconds = CHECKPOINT_INTERVAL);
+
+    void set_incremental(const std::string &state_path);
+
+    void set_libtins_decoding(bool enabled);
+
     static int get_db_version() { return statistics_db::DB_VERSION; }
+
+private:
+    /*
+     * Interval barrier and progress state of collect_statistics
+     */
+    std::chrono::microseconds firstTimestamp;
+    std::vector<std::chrono::duration<int, std::micro>> timeIntervals;
+    std::vector<std::chrono::microseconds> barriers;
+    std::vector<std::chrono::microseconds> intervalStartTimestamp;
+    std::vector<interval_barrier> passedBarriers;
+    std::chrono::system_clock::time_point lastPrinted;
+    uint64_t fileSize;
+    std::string filterExpression;
+    std::shared_ptr<const packet_filter> filter;
+    time_window window;
+    packet_sampler sampler;
+    std::string checkpointPath;
+    std::chrono::duration<double> checkpointInterval;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    bool incremental;
+    bool libtinsDecoding;
+
+    void process_interval_barriers(std::chrono::microseconds currentPktTimestamp);
+
+    void find_interval_barriers(std::chrono::microseconds currentPktTimestamp, std::size_t packetIndex,
+                                std::vector<interval_barrier> &passed);
+
+    void print_progress(uint64_t position, int packetCount);
+
+    bool capture_exists();
+
+    bool read_packet_index(uint64_t packetNumber, packet_index_entry &entry);
+
+    std::vector<long double> find_timestamps_mu_sec(const std::vector<int> &packetNumbers);
+
+    bool collect_chunk_statistics(const pcap_mmap_reader &fileReader, std::size_t chunkCount, uint64_t begin,
+                                  uint64_t end);
+
+    pcap_processor *create_chunk_processor(std::vector<std::unique_ptr<pcap_processor>> &chunkProcessors,
+                                           const packet_sampler &chunkSampler);
+
+    void process_chunk(pcap_mmap_reader &chunkReader, bool alignBarriers, chunk_progress &progress,
+                       const std::atomic<bool> &stopped);
+
+    bool continue_chunk_intervals(pcap_processor &chunk, const chunk_progress &progress);
+
+    void align_interval_barriers(std::chrono::microseconds chunkTimestamp);
+
+    void write_checkpoint(const pcap_mmap_reader &fileReader, std::chrono::microseconds currentPktTimestamp,
+                          const std::vector<double> &intervals);
+
+    bool read_checkpoint(pcap_mmap_reader &fileReader, std::chrono::microseconds &currentPktTimestamp,
+                         const std::vector<double> &intervals);
 };
 
 
@@ -0,0 +1,1578 @@
+#include "pcap_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <glob.h>
+#include <limits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PCAP_MAX_RECORD_SIZE 262144
+#define PCAP_LINKTYPE_MASK 0x03ffffff
+#define LINKTYPE_RAW 101
+#define MMAP_READAHEAD_WINDOW (16 * 1024 * 1024)
+#define TAIL_SCAN_WINDOW 65536
+#define TAIL_SCAN_MAX_WINDOW (16 * 1024 * 1024)
+#define TAIL_SCAN_MIN_RECORDS 4
+#define TAIL_SCAN_MAX_TIME_GAP 86400
+#define RESYNC_MIN_RECORDS 8
+#define RESYNC_MAX_SCAN (16 * 1024 * 1024)
+#define TIMESTAMP_SEARCH_LINEAR_SCAN (64 * 1024)
+#define FINGERPRINT_WINDOW (64 * 1024)
+
+/*
+ * Block types, sizes and option codes of the pcapng file format
+ */
+#define PCAPNG_SECTION_HEADER_BLOCK 0x0a0d0d0a
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK 0x00000001
+#define PCAPNG_PACKET_BLOCK 0x00000002
+#define PCAPNG_SIMPLE_PACKET_BLOCK 0x00000003
+#define PCAPNG_ENHANCED_PACKET_BLOCK 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_MIN_BLOCK_SIZE 12
+#define PCAPNG_SECTION_HEADER_SIZE 28
+#define PCAPNG_INTERFACE_DESCRIPTION_SIZE 20
+#define PCAPNG_PACKET_BLOCK_SIZE 32
+#define PCAPNG_SIMPLE_PACKET_BLOCK_SIZE 16
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_IF_TSRESOL 9
+#define PCAPNG_IF_TSOFFSET 14
+
+/**
+ * Reads a 32 bit value of the PCAP file format.
+ * @param p Pointer to the value.
+ * @param swapped Whether the file was written with the opposite byte order.
+ * @return the value in host byte order.
+ */
+static inline uint32_t read_file_u32(const uint8_t *p, bool swapped) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+}
+
+/**
+ * Reads a 16 bit value of the pcapng file format.
+ * @param p Pointer to the value.
+ * @param swapped Whether the section was written with the opposite byte order.
+ * @return the value in host byte order.
+ */
+static inline uint16_t read_file_u16(const uint8_t *p, bool swapped) {
+    uint16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap16(value) : value;
+}
+
+/**
+ * Converts a link type of the file formats (LINKTYPE_*) to the corresponding libpcap link type (DLT_*).
+ * @param linkType The link type stored in the file.
+ * @return the libpcap link type.
+ */
+static int to_dlt(uint32_t linkType) {
+    linkType &= PCAP_LINKTYPE_MASK;
+    // The only common link type whose DLT_* value differs from the value in the file
+    return linkType == LINKTYPE_RAW ? DLT_RAW : static_cast<int>(linkType);
+}
+
+/**
+ * Maps a whole file into memory for sequential reading.
+ * @param filePath The path to the file.
+ * @param minimumSize The size the file needs to have at least.
+ * @param fileSize Set to the size of the file.
+ * @param error Set to the error message, if the file could not be mapped.
+ * @return the mapping, nullptr if the file could not be mapped.
+ */
+static const uint8_t *map_file(const std::string &filePath, uint64_t minimumSize, uint64_t &fileSize,
+                               std::string &error) {
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return nullptr;
+    }
+    struct stat buffer;
+    if (fstat(fd, &buffer) != 0 || static_cast<uint64_t>(buffer.st_size) < minimumSize ||
+        static_cast<uint64_t>(buffer.st_size) > std::numeric_limits<std::size_t>::max()) {
+        error = "could not determine the file size";
+        close(fd);
+        return nullptr;
+    }
+    fileSize = static_cast<uint64_t>(buffer.st_size);
+
+    void *address = mmap(nullptr, static_cast<std::size_t>(fileSize), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        error = std::strerror(errno);
+        return nullptr;
+    }
+    madvise(address, static_cast<std::size_t>(fileSize), MADV_SEQUENTIAL);
+    return static_cast<const uint8_t *>(address);
+}
+
+/**
+ * Requests the next readahead window of a mapping from the kernel, once the current position reaches the
+ * second half of the previous window.
+ * @param mapping The mapped file.
+ * @param fileSize The size of the file.
+ * @param offset The current position in the file.
+ * @param prefetchEnd The end of the requested windows, advanced by the new window.
+ */
+static void prefetch_mapping(const uint8_t *mapping, uint64_t fileSize, uint64_t offset, uint64_t &prefetchEnd) {
+    if (prefetchEnd >= fileSize || offset + MMAP_READAHEAD_WINDOW / 2 < prefetchEnd) {
+        return;
+    }
+    uint64_t length = std::min<uint64_t>(MMAP_READAHEAD_WINDOW, fileSize - prefetchEnd);
+    madvise(const_cast<uint8_t *>(mapping) + prefetchEnd, static_cast<std::size_t>(length), MADV_WILLNEED);
+    prefetchEnd += length;
+}
+
+/**
+ * @return the time window containing every packet.
+ */
+time_window unrestricted_time_window() {
+    return {std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+}
+
+/**
+ * @param header The record header of a packet.
+ * @return the timestamp of the packet in microseconds.
+ */
+int64_t get_packet_timestamp(const pcap_pkthdr &header) {
+    return static_cast<int64_t>(header.ts.tv_sec) * 1000000 + header.ts.tv_usec;
+}
+
+/**
+ * @return true if the time window excludes any packets.
+ */
+bool time_window::is_restricted() const {
+    return start != std::numeric_limits<int64_t>::min() || end != std::numeric_limits<int64_t>::max();
+}
+
+/**
+ * @param timestamp The timestamp of a packet in microseconds.
+ * @return true if the packet is to be processed.
+ */
+bool time_window::contains(int64_t timestamp) const {
+    return timestamp >= start && timestamp <= end;
+}
+
+/**
+ * @return the timestamp in microseconds from which on packets have to be read, the start minus TIME_WINDOW_MARGIN.
+ */
+int64_t time_window::get_read_start() const {
+    return start >= std::numeric_limits<int64_t>::min() + TIME_WINDOW_MARGIN ? start - TIME_WINDOW_MARGIN
+                                                                             : std::numeric_limits<int64_t>::min();
+}
+
+/**
+ * @return the timestamp in microseconds up to which packets have to be read, the end plus TIME_WINDOW_MARGIN.
+ */
+int64_t time_window::get_read_end() const {
+    return end <= std::numeric_limits<int64_t>::max() - TIME_WINDOW_MARGIN ? end + TIME_WINDOW_MARGIN
+                                                                           : std::numeric_limits<int64_t>::max();
+}
+
+/**
+ * @param timestamp The timestamp of a packet in microseconds.
+ * @return true if the packet lies so far after the window that no more packets of the window are expected.
+ */
+bool time_window::is_passed(int64_t timestamp) const {
+    return timestamp > get_read_end();
+}
+
+packet_filter::packet_filter() : compiled(false) {
+    std::memset(&program, 0, sizeof(program));
+}
+
+packet_filter::~packet_filter() {
+    if (compiled) {
+        pcap_freecode(&program);
+    }
+}
+
+/**
+ * Compiles a BPF filter expression for packets of the given link type.
+ * @param expression The filter expression in pcap-filter syntax, e.g. "net 10.1.0.0/16".
+ * @param linkType The libpcap link type (DLT_*) of the packets.
+ * @return false if the expression is invalid, see get_error().
+ */
+bool packet_filter::compile(const std::string &expression, int linkType) {
+    if (compiled) {
+        pcap_freecode(&program);
+        compiled = false;
+    }
+    std::unique_ptr<pcap_t, void (*)(pcap_t *)> handle(pcap_open_dead(linkType, PCAP_MAX_RECORD_SIZE), pcap_close);
+    if (handle == nullptr) {
+        error = "could not create a pcap handle";
+        return false;
+    }
+    if (pcap_compile(handle.get(), &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+        error = pcap_geterr(handle.get());
+        return false;
+    }
+    compiled = true;
+    return true;
+}
+
+/**
+ * Runs the compiled filter on a packet.
+ * @param header The record header of the packet.
+ * @param data The captured packet bytes.
+ * @return true if the packet matches the filter.
+ */
+bool packet_filter::matches(const pcap_pkthdr &header, const u_char *data) const {
+    return pcap_offline_filter(&program, &header, data) != 0;
+}
+
+/**
+ * @return the error message of the last failed compilation.
+ */
+const std::string &packet_filter::get_error() const {
+    return error;
+}
+
+/**
+ * Wraps a reader so that only packets matching the filter and lying within the time window are returned.
+ * @param reader The reader of the PCAP file.
+ * @param filter The compiled filter, which is shared with other readers of the same file, or null.
+ * @param window The time window of the packets to return.
+ */
+pcap_filtered_reader::pcap_filtered_reader(std::unique_ptr<pcap_reader> reader,
+                                           std::shared_ptr<const packet_filter> filter, const time_window &window)
+        : reader(std::move(reader)), filter(filter), window(window) {}
+
+/**
+ * @return true if the wrapped reader could open the PCAP file.
+ */
+bool pcap_filtered_reader::is_open() const {
+    return reader->is_open();
+}
+
+/**
+ * @return the error message of the wrapped reader.
+ */
+const std::string &pcap_filtered_reader::get_error() const {
+    return reader->get_error();
+}
+
+/**
+ * Reads the next packet record matching the filter and the time window, the others are skipped before any decoding.
+ * @param header Set to the record header of the packet.
+ * @param data Set to the captured packet bytes.
+ * @return false if there are no more matching packets, the time window is passed or the file is damaged.
+ */
+bool pcap_filtered_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    while (reader->next(header, data)) {
+        int64_t timestamp = get_packet_timestamp(*header);
+        if (window.is_passed(timestamp)) {
+            return false;
+        }
+        if (window.contains(timestamp) && (filter == nullptr || filter->matches(*header, data))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return whether the wrapped reader keeps the packet data valid.
+ */
+bool pcap_filtered_reader::keeps_data() const {
+    return reader->keeps_data();
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the PCAP file.
+ */
+int pcap_filtered_reader::get_link_type() const {
+    return reader->get_link_type();
+}
+
+/**
+ * @return the number of bytes of the file read so far, including rejected packets.
+ */
+uint64_t pcap_filtered_reader::get_position() const {
+    return reader->get_position();
+}
+
+/**
+ * @return the size of the PCAP file in bytes.
+ */
+uint64_t pcap_filtered_reader::get_file_size() const {
+    return reader->get_file_size();
+}
+
+/**
+ * Opens the PCAP file at filePath with libpcap.
+ * @param filePath The path to the PCAP file.
+ */
+pcap_stream_reader::pcap_stream_reader(const std::string &filePath) : handle(nullptr), fileSize(0) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    handle = pcap_open_offline(filePath.c_str(), errbuf);
+    if (handle == nullptr) {
+        error = errbuf;
+        return;
+    }
+
+    struct stat buffer;
+    if (stat(filePath.c_str(), &buffer) == 0) {
+        fileSize = static_cast<uint64_t>(buffer.st_size);
+    }
+}
+
+pcap_stream_reader::~pcap_stream_reader() {
+    if (handle != nullptr) {
+        pcap_close(handle);
+    }
+}
+
+/**
+ * @return true if the PCAP file could be opened.
+ */
+bool pcap_stream_reader::is_open() const {
+    return handle != nullptr;
+}
+
+/**
+ * @return the error message of the last failed operation.
+ */
+const std::string &pcap_stream_reader::get_error() const {
+    return error;
+}
+
+/**
+ * Reads the next packet record. The returned header and data stay valid until the next call.
+ * @param header Set to the record header of the packet.
+ * @param data Set to the captured packet bytes.
+ * @return false if there are no more packets or the file is damaged.
+ */
+bool pcap_stream_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    pcap_pkthdr *pkthdr;
+    int result = pcap_next_ex(handle, &pkthdr, &data);
+    if (result == 1) {
+        header = pkthdr;
+        return true;
+    }
+    if (result == -1) {
+        error = pcap_geterr(handle);
+    }
+    return false;
+}
+
+/**
+ * @return false, libpcap reuses its buffer for every packet.
+ */
+bool pcap_stream_reader::keeps_data() const {
+    return false;
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the PCAP file.
+ */
+int pcap_stream_reader::get_link_type() const {
+    return pcap_datalink(handle);
+}
+
+/**
+ * @return the number of bytes of the file read so far.
+ */
+uint64_t pcap_stream_reader::get_position() const {
+    FILE *file = pcap_file(handle);
+    if (file == nullptr) {
+        return 0;
+    }
+    long position = ftell(file);
+    return position < 0 ? 0 : static_cast<uint64_t>(position);
+}
+
+/**
+ * @return the size of the PCAP file in bytes.
+ */
+uint64_t pcap_stream_reader::get_file_size() const {
+    return fileSize;
+}
+
+/**
+ * Opens the compressed PCAP file at filePath with libpcap, reading the bytes decompressed by a separate thread.
+ * @param filePath The path to the compressed PCAP file.
+ * @param format The compression format of the file.
+ */
+pcap_compressed_reader::pcap_compressed_reader(const std::string &filePath, compression_format format)
+        : stream(filePath, format), handle(nullptr) {
+    if (!stream.is_open()) {
+        error = stream.get_error();
+        return;
+    }
+    FILE *file = stream.open_stream();
+    if (file == nullptr) {
+        error = std::strerror(errno);
+        return;
+    }
+    char errbuf[PCAP_ERRBUF_SIZE];
+    handle = pcap_fopen_offline(file, errbuf);
+    if (handle == nullptr) {
+        error = errbuf;
+        fclose(file);
+    }
+}
+
+pcap_compressed_reader::~pcap_compressed_reader() {
+    if (handle != nullptr) {
+        pcap_close(handle);
+    }
+}
+
+/**
+ * @return true if the compressed PCAP file could be opened.
+ */
+bool pcap_compressed_reader::is_open() const {
+    return handle != nullptr;
+}
+
+/**
+ * @return the error message of the last failed operation.
+ */
+const std::string &pcap_compressed_reader::get_error() const {
+    return error;
+}
+
+/**
+ * Reads the next packet record. The returned header and data stay valid until the next call.
+ * @param header Set to the record header of the packet.
+ * @param data Set to the captured packet bytes.
+ * @return false if there are no more packets or the file is damaged.
+ */
+bool pcap_compressed_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    pcap_pkthdr *pkthdr;
+    int result = pcap_next_ex(handle, &pkthdr, &data);
+    if (result == 1) {
+        header = pkthdr;
+        return true;
+    }
+    // A damaged compressed stream looks like a truncated PCAP to libpcap, so the decompression error comes first
+    error = stream.get_error();
+    if (result == -1) {
+        error += (error.empty() ? "" : ", ") + std::string(pcap_geterr(handle));
+    }
+    return false;
+}
+
+/**
+ * @return false, libpcap reuses its buffer for every packet.
+ */
+bool pcap_compressed_reader::keeps_data() const {
+    return false;
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the PCAP file.
+ */
+int pcap_compressed_reader::get_link_type() const {
+    return pcap_datalink(handle);
+}
+
+/**
+ * @return the number of bytes of the compressed file read so far.
+ */
+uint64_t pcap_compressed_reader::get_position() const {
+    return stream.get_position();
+}
+
+/**
+ * @return the size of the compressed file in bytes.
+ */
+uint64_t pcap_compressed_reader::get_file_size() const {
+    return stream.get_file_size();
+}
+
+/**
+ * Maps the classic PCAP file at filePath into memory.
+ * @param filePath The path to the PCAP file.
+ */
+pcap_mmap_reader::pcap_mmap_reader(const std::string &filePath) : mapping(nullptr), fileSize(0),
+                                                                  offset(PCAP_FILE_HEADER_SIZE), rangeEnd(0), prefetchEnd(0),
+                                                                  recordCount(0), indexInterval(0) {
+    if (!read_file_info(filePath, info)) {
+        error = "not a classic PCAP file";
+        return;
+    }
+
+    mapping = map_file(filePath, PCAP_FILE_HEADER_SIZE, fileSize, error);
+    rangeEnd = fileSize;
+    prefetch();
+}
+
+pcap_mmap_reader::~pcap_mmap_reader() {
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t *>(mapping), static_cast<std::size_t>(fileSize));
+    }
+}
+
+/**
+ * Requests the next readahead window of the mapping from the kernel, once the current position reaches the
+ * second half of the previous window.
+ */
+void pcap_mmap_reader::prefetch() {
+    if (mapping != nullptr) {
+        prefetch_mapping(mapping, fileSize, offset, prefetchEnd);
+    }
+}
+
+/**
+ * @return true if the PCAP file could be mapped.
+ */
+bool pcap_mmap_reader::is_open() const {
+    return mapping != nullptr;
+}
+
+/**
+ * @return the error message of the last failed operation.
+ */
+const std::string &pcap_mmap_reader::get_error() const {
+    return error;
+}
+
+/**
+ * Reads the next packet record in place. Like libpcap, the captured length is limited to the snapshot length.
+ * @param header Set to the record header of the packet.
+ * @param data Set to the captured packet bytes within the mapping.
+ * @return false if there are no more packets or the file is damaged.
+ */
+bool pcap_mmap_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    if (offset >= rangeEnd && rangeEnd < fileSize) {
+        return false;
+    }
+    if (offset + PCAP_RECORD_HEADER_SIZE > fileSize) {
+        if (offset != fileSize) {
+            error = "truncated dump file";
+        }
+        return false;
+    }
+
+    const uint8_t *record = mapping + offset;
+    uint32_t caplen = read_file_u32(record + 8, info.swapped);
+    uint32_t maxCaplen = info.snaplen > PCAP_MAX_RECORD_SIZE ? info.snaplen : PCAP_MAX_RECORD_SIZE;
+    if (caplen > maxCaplen) {
+        error = "invalid packet capture length";
+        return false;
+    }
+    if (offset + PCAP_RECORD_HEADER_SIZE + caplen > fileSize) {
+        error = "truncated dump file";
+        return false;
+    }
+
+    uint32_t fraction = read_file_u32(record + 4, info.swapped);
+    currentHeader.ts.tv_sec = static_cast<time_t>(read_file_u32(record, info.swapped));
+    currentHeader.ts.tv_usec = static_cast<suseconds_t>(info.nanoseconds ? fraction / 1000 : fraction);
+    currentHeader.caplen = info.snaplen != 0 && caplen > info.snaplen ? info.snaplen : caplen;
+    currentHeader.len = read_file_u32(record + 12, info.swapped);
+
+    if (indexInterval > 0 && recordCount % indexInterval == 0) {
+        index.push_back({recordCount + 1, offset, get_packet_timestamp(currentHeader)});
+    }
+    recordCount++;
+
+    header = &currentHeader;
+    data = record + PCAP_RECORD_HEADER_SIZE;
+    offset += PCAP_RECORD_HEADER_SIZE + caplen;
+    prefetch();
+    return true;
+}
+
+/**
+ * Restricts the reader to the packet records starting in [begin, end). begin has to be a record boundary,
+ * see find_record_boundary.
+ * @param begin The offset of the first record to read.
+ * @param end The offset after which no more records are started.
+ */
+void pcap_mmap_reader::set_range(uint64_t begin, uint64_t end) {
+    offset = std::max<uint64_t>(begin, PCAP_FILE_HEADER_SIZE);
+    rangeEnd = std::min(end, fileSize);
+    prefetchEnd = offset;
+    prefetch();
+}
+
+/**
+ * Finds the first packet record starting at or after position, without reading the records before it.
+ * A position is taken as a record boundary if it starts a chain of plausible record headers with consistent
+ * timestamps, which either has enough records or ends exactly at the end of the file.
+ * @param position The offset to start searching at.
+ * @return the offset of the record, or the file size if no record was found.
+ */
+uint64_t pcap_mmap_reader::find_record_boundary(uint64_t position) const {
+    if (position <= PCAP_FILE_HEADER_SIZE) {
+        return PCAP_FILE_HEADER_SIZE;
+    }
+    if (fileSize < PCAP_FILE_HEADER_SIZE + PCAP_RECORD_HEADER_SIZE) {
+        return fileSize;
+    }
+    uint32_t firstSeconds = read_file_u32(mapping + PCAP_FILE_HEADER_SIZE, info.swapped);
+    uint32_t maxCaplen = info.snaplen > PCAP_MAX_RECORD_SIZE ? info.snaplen : PCAP_MAX_RECORD_SIZE;
+    uint32_t maxFraction = info.nanoseconds ? 1000000000 : 1000000;
+
+    uint64_t scanEnd = std::min<uint64_t>(fileSize, position + RESYNC_MAX_SCAN);
+    for (uint64_t candidate = position; candidate < scanEnd; candidate++) {
+        uint64_t next = candidate;
+        std::size_t records = 0;
+        uint32_t previousSeconds = firstSeconds;
+        bool plausible = true;
+        while (plausible && records < RESYNC_MIN_RECORDS && next + PCAP_RECORD_HEADER_SIZE <= fileSize) {
+            const uint8_t *record = mapping + next;
+            uint32_t seconds = read_file_u32(record, info.swapped);
+            uint32_t fraction = read_file_u32(record + 4, info.swapped);
+            uint32_t caplen = read_file_u32(record + 8, info.swapped);
+            uint32_t len = read_file_u32(record + 12, info.swapped);
+            uint32_t gap = seconds > previousSeconds ? seconds - previousSeconds : previousSeconds - seconds;
+            plausible = fraction < maxFraction && caplen <= maxCaplen && caplen <= len &&
+                        next + PCAP_RECORD_HEADER_SIZE + caplen <= fileSize &&
+                        seconds + TAIL_SCAN_MAX_TIME_GAP >= firstSeconds && (records == 0 || gap <= TAIL_SCAN_MAX_TIME_GAP);
+            previousSeconds = seconds;
+            next += PCAP_RECORD_HEADER_SIZE + caplen;
+            records++;
+        }
+        if (plausible && (records == RESYNC_MIN_RECORDS || next == fileSize)) {
+            return candidate;
+        }
+    }
+    return fileSize;
+}
+
+/**
+ * Finds the first packet record with a timestamp of at least the given one, assuming that the records are ordered
+ * by their timestamps. The records are searched by bisecting the file with find_record_boundary, only the last
+ * TIMESTAMP_SEARCH_LINEAR_SCAN bytes are scanned record by record.
+ * @param timestamp The timestamp in microseconds.
+ * @return the offset of the record, or the file size if every record is older.
+ */
+uint64_t pcap_mmap_reader::find_timestamp(int64_t timestamp) const {
+    uint64_t low = PCAP_FILE_HEADER_SIZE;
+    uint64_t high = fileSize;
+    if (low + PCAP_RECORD_HEADER_SIZE > fileSize || read_record_timestamp(low) >= timestamp) {
+        return low;
+    }
+
+    // The record at low is older than the timestamp, the records from high on are not
+    while (high - low > TIMESTAMP_SEARCH_LINEAR_SCAN) {
+        uint64_t middle = low + (high - low) / 2;
+        uint64_t boundary = find_record_boundary(middle);
+        if (boundary >= high) {
+            high = middle;
+        } else if (read_record_timestamp(boundary) < timestamp) {
+            low = boundary;
+        } else {
+            high = boundary;
+        }
+    }
+
+    uint32_t maxCaplen = info.snaplen > PCAP_MAX_RECORD_SIZE ? info.snaplen : PCAP_MAX_RECORD_SIZE;
+    uint64_t position = low;
+    while (position + PCAP_RECORD_HEADER_SIZE <= fileSize && read_record_timestamp(position) < timestamp) {
+        uint32_t caplen = read_file_u32(mapping + position + 8, info.swapped);
+        if (caplen > maxCaplen) {
+            // Damaged records are reported by next()
+            return position;
+        }
+        position += PCAP_RECORD_HEADER_SIZE + caplen;
+    }
+    return std::min(position, fileSize);
+}
+
+/**
+ * @param position The offset of a packet record header within the mapping.
+ * @return the timestamp of the packet record in microseconds.
+ */
+int64_t pcap_mmap_reader::read_record_timestamp(uint64_t position) const {
+    const uint8_t *record = mapping + position;
+    uint32_t fraction = read_file_u32(record + 4, info.swapped);
+    return static_cast<int64_t>(read_file_u32(record, info.swapped)) * 1000000 +
+           (info.nanoseconds ? fraction / 1000 : fraction);
+}
+
+/**
+ * Hashes the beginning of the file and the bytes before end with 64 bit FNV-1a, to recognize the file once more
+ * packets were appended to it.
+ * @param end The offset up to which the file is hashed, at most the file size.
+ * @return the hash of the first and the last FINGERPRINT_WINDOW bytes before end.
+ */
+uint64_t pcap_mmap_reader::get_fingerprint(uint64_t end) const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    if (mapping == nullptr) {
+        return hash;
+    }
+    end = std::min(end, fileSize);
+    uint64_t headEnd = std::min<uint64_t>(end, FINGERPRINT_WINDOW);
+    uint64_t tailBegin = std::max<uint64_t>(headEnd, end > FINGERPRINT_WINDOW ? end - FINGERPRINT_WINDOW : 0);
+    for (uint64_t i = 0; i < headEnd; i++) {
+        hash = (hash ^ mapping[i]) * 0x100000001b3ULL;
+    }
+    for (uint64_t i = tailBegin; i < end; i++) {
+        hash = (hash ^ mapping[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Continues reading at a packet of the packet index, if the record at its offset still has its timestamp.
+ * @param entry The packet index entry of the packet.
+ * @return false if the entry does not match the file, the position is unchanged then.
+ */
+bool pcap_mmap_reader::seek(const packet_index_entry &entry) {
+    if (entry.offset < PCAP_FILE_HEADER_SIZE || entry.offset + PCAP_RECORD_HEADER_SIZE > fileSize) {
+        return false;
+    }
+    if (read_record_timestamp(entry.offset) != entry.timestamp) {
+        return false;
+    }
+    offset = entry.offset;
+    rangeEnd = fileSize;
+    prefetchEnd = offset;
+    prefetch();
+    return true;
+}
+
+/**
+ * Continues reading where another reader of the file stopped, e.g. when resuming from a checkpoint. The end of the
+ * range is kept.
+ * @param position The offset of the next record to read, a record boundary.
+ * @param records The number of records read before, see get_record_count.
+ * @param entries The packet index built before, see get_index.
+ */
+void pcap_mmap_reader::resume(uint64_t position, uint64_t records, const std::vector<packet_index_entry> &entries) {
+    offset = std::max<uint64_t>(position, PCAP_FILE_HEADER_SIZE);
+    recordCount = records;
+    index = entries;
+    prefetchEnd = offset;
+    prefetch();
+}
+
+/**
+ * Records every interval-th packet record read from now on in the packet index.
+ * @param interval The number of records between two index entries, 0 disables the index.
+ */
+void pcap_mmap_reader::set_index_interval(std::size_t interval) {
+    indexInterval = interval;
+}
+
+/**
+ * @return the packet index, the packet numbers are counted from the first record read by this reader.
+ */
+const std::vector<packet_index_entry> &pcap_mmap_reader::get_index() const {
+    return index;
+}
+
+/**
+ * @return the number of packet records read so far.
+ */
+uint64_t pcap_mmap_reader::get_record_count() const {
+    return recordCount;
+}
+
+/**
+ * @return true, the packet data stays valid as long as the file is mapped.
+ */
+bool pcap_mmap_reader::keeps_data() const {
+    return true;
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the PCAP file.
+ */
+int pcap_mmap_reader::get_link_type() const {
+    return to_dlt(info.linkType);
+}
+
+/**
+ * @return the number of bytes of the file read so far.
+ */
+uint64_t pcap_mmap_reader::get_position() const {
+    return offset;
+}
+
+/**
+ * @return the size of the PCAP file in bytes.
+ */
+uint64_t pcap_mmap_reader::get_file_size() const {
+    return fileSize;
+}
+
+/**
+ * Maps the pcapng file at filePath into memory and reads the blocks up to the description of the first interface,
+ * which determines the link type.
+ * @param filePath The path to the pcapng file.
+ */
+pcapng_mmap_reader::pcapng_mmap_reader(const std::string &filePath) : mapping(nullptr), fileSize(0), offset(0),
+                                                                      prefetchEnd(0), swapped(false), linkType(-1),
+                                                                      skippedCount(0) {
+    std::ifstream file(filePath, std::ios::binary);
+    uint8_t blockType[4];
+    if (!file.read(reinterpret_cast<char *>(blockType), sizeof(blockType)) ||
+        read_file_u32(blockType, false) != PCAPNG_SECTION_HEADER_BLOCK) {
+        error = "not a pcapng file";
+        return;
+    }
+
+    mapping = map_file(filePath, PCAPNG_SECTION_HEADER_SIZE, fileSize, error);
+    if (mapping == nullptr) {
+        return;
+    }
+    prefetch_mapping(mapping, fileSize, offset, prefetchEnd);
+
+    uint32_t type;
+    uint32_t length;
+    while (linkType < 0 && read_block_header(offset, type, length)) {
+        if (type == PCAPNG_SECTION_HEADER_BLOCK) {
+            if (!read_section_header(offset)) break;
+        } else if (type == PCAPNG_INTERFACE_DESCRIPTION_BLOCK) {
+            if (!read_interface(mapping + offset, length)) break;
+        } else if (type == PCAPNG_ENHANCED_PACKET_BLOCK || type == PCAPNG_SIMPLE_PACKET_BLOCK ||
+                   type == PCAPNG_PACKET_BLOCK) {
+            break;
+        }
+        offset += length;
+    }
+    if (linkType < 0) {
+        if (error.empty()) {
+            error = "no interface described before the first packet";
+        }
+        munmap(const_cast<uint8_t *>(mapping), static_cast<std::size_t>(fileSize));
+        mapping = nullptr;
+    }
+}
+
+pcapng_mmap_reader::~pcapng_mmap_reader() {
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t *>(mapping), static_cast<std::size_t>(fileSize));
+    }
+}
+
+/**
+ * Reads the type and length of a block. The byte order of a section header block is given by its byte order magic,
+ * it becomes the byte order of the following blocks.
+ * @param blockOffset The offset of the block.
+ * @param type Set to the block type.
+ * @param length Set to the total length of the block.
+ * @return false at the end of the file or if the block is damaged.
+ */
+bool pcapng_mmap_reader::read_block_header(uint64_t blockOffset, uint32_t &type, uint32_t &length) {
+    if (blockOffset + PCAPNG_MIN_BLOCK_SIZE > fileSize) {
+        if (blockOffset != fileSize) {
+            error = "truncated pcapng block";
+        }
+        return false;
+    }
+    const uint8_t *block = mapping + blockOffset;
+    type = read_file_u32(block, swapped);
+    if (type == PCAPNG_SECTION_HEADER_BLOCK) {
+        uint32_t magic = read_file_u32(block + 8, false);
+        if (magic == PCAPNG_BYTE_ORDER_MAGIC) {
+            swapped = false;
+        } else if (__builtin_bswap32(magic) == PCAPNG_BYTE_ORDER_MAGIC) {
+            swapped = true;
+        } else {
+            error = "invalid pcapng byte order magic";
+            return false;
+        }
+    }
+    length = read_file_u32(block + 4, swapped);
+    if (length < PCAPNG_MIN_BLOCK_SIZE || length % 4 != 0) {
+        error = "invalid pcapng block length";
+        return false;
+    }
+    if (blockOffset + length > fileSize) {
+        error = "truncated pcapng block";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Starts a new section, whose interfaces are described by the following blocks.
+ * @param blockOffset The offset of the section header block.
+ * @return false if the section header is damaged or has an unsupported version.
+ */
+bool pcapng_mmap_reader::read_section_header(uint64_t blockOffset) {
+    const uint8_t *block = mapping + blockOffset;
+    if (read_file_u32(block + 4, swapped) < PCAPNG_SECTION_HEADER_SIZE) {
+        error = "invalid pcapng section header";
+        return false;
+    }
+    if (read_file_u16(block + 12, swapped) != 1) {
+        error = "unsupported pcapng version";
+        return false;
+    }
+    interfaces.clear();
+    return true;
+}
+
+/**
+ * Adds the interface of an interface description block, including its timestamp resolution and offset.
+ * @param block The interface description block.
+ * @param length The total length of the block.
+ * @return false if the block is damaged.
+ */
+bool pcapng_mmap_reader::read_interface(const uint8_t *block, uint32_t length) {
+    if (length < PCAPNG_INTERFACE_DESCRIPTION_SIZE) {
+        error = "invalid pcapng interface description";
+        return false;
+    }
+    pcapng_interface interface = {to_dlt(read_file_u16(block + 8, swapped)), read_file_u32(block + 12, swapped),
+                                  1000000, 0};
+
+    uint32_t optionsEnd = length - 4;
+    for (uint32_t position = 16; position + 4 <= optionsEnd;) {
+        uint16_t code = read_file_u16(block + position, swapped);
+        uint16_t optionLength = read_file_u16(block + position + 2, swapped);
+        const uint8_t *value = block + position + 4;
+        if (code == PCAPNG_OPT_ENDOFOPT) {
+            break;
+        }
+        if (position + 4 + optionLength > optionsEnd) {
+            error = "invalid pcapng option length";
+            return false;
+        }
+        if (code == PCAPNG_IF_TSRESOL && optionLength >= 1) {
+            // The most significant bit selects a negative power of 2 instead of 10
+            uint8_t exponent = value[0] & 0x7f;
+            if ((value[0] & 0x80) ? exponent > 63 : exponent > 19) {
+                error = "unsupported pcapng timestamp resolution";
+                return false;
+            }
+            interface.unitsPerSecond = 1;
+            for (uint8_t i = 0; i < exponent; i++) {
+                interface.unitsPerSecond *= (value[0] & 0x80) ? 2 : 10;
+            }
+        } else if (code == PCAPNG_IF_TSOFFSET && optionLength >= 8) {
+            uint64_t seconds;
+            std::memcpy(&seconds, value, sizeof(seconds));
+            interface.offsetSeconds = static_cast<int64_t>(swapped ? __builtin_bswap64(seconds) : seconds);
+        }
+        position += 4 + ((optionLength + 3u) & ~3u);
+    }
+
+    interfaces.push_back(interface);
+    if (linkType < 0) {
+        linkType = interface.linkType;
+    }
+    return true;
+}
+
+/**
+ * Reads an enhanced, simple or obsolete packet block in place. Like libpcap, the captured length is limited to the
+ * snapshot length of the interface and simple packet blocks get the timestamp 0.
+ * @param block The packet block.
+ * @param type The type of the block.
+ * @param length The total length of the block.
+ * @param interfaceId Set to the interface of the packet.
+ * @param data Set to the captured packet bytes within the mapping.
+ * @return false if the block is damaged or refers to an interface which was not described.
+ */
+bool pcapng_mmap_reader::read_packet(const uint8_t *block, uint32_t type, uint32_t length, uint32_t &interfaceId,
+                                     const u_char *&data) {
+    uint32_t caplen;
+    uint64_t timestamp = 0;
+    if (type == PCAPNG_SIMPLE_PACKET_BLOCK) {
+        if (length < PCAPNG_SIMPLE_PACKET_BLOCK_SIZE) {
+            error = "invalid pcapng packet block";
+            return false;
+        }
+        interfaceId = 0;
+        currentHeader.len = read_file_u32(block + 8, swapped);
+        caplen = std::min(currentHeader.len, length - PCAPNG_SIMPLE_PACKET_BLOCK_SIZE);
+        data = block + 12;
+    } else {
+        if (length < PCAPNG_PACKET_BLOCK_SIZE) {
+            error = "invalid pcapng packet block";
+            return false;
+        }
+        interfaceId = type == PCAPNG_ENHANCED_PACKET_BLOCK ? read_file_u32(block + 8, swapped)
+                                                           : read_file_u16(block + 8, swapped);
+        timestamp = (static_cast<uint64_t>(read_file_u32(block + 12, swapped)) << 32) | read_file_u32(block + 16, swapped);
+        caplen = read_file_u32(block + 20, swapped);
+        currentHeader.len = read_file_u32(block + 24, swapped);
+        data = block + 28;
+        if (caplen > length - PCAPNG_PACKET_BLOCK_SIZE) {
+            error = "invalid pcapng packet block";
+            return false;
+        }
+    }
+    if (interfaceId >= interfaces.size()) {
+        error = "packet of an interface which was not described";
+        return false;
+    }
+
+    const pcapng_interface &interface = interfaces[interfaceId];
+    currentHeader.caplen = interface.snaplen != 0 && caplen > interface.snaplen ? interface.snaplen : caplen;
+    if (type == PCAPNG_SIMPLE_PACKET_BLOCK) {
+        currentHeader.ts.tv_sec = 0;
+        currentHeader.ts.tv_usec = 0;
+    } else {
+        set_timestamp(interface, timestamp);
+    }
+    return true;
+}
+
+/**
+ * Converts a timestamp in the units of an interface to the timestamp of the current packet header.
+ * @param interface The interface of the packet.
+ * @param timestamp The timestamp in units of the interface's timestamp resolution.
+ */
+void pcapng_mmap_reader::set_timestamp(const pcapng_interface &interface, uint64_t timestamp) {
+    uint64_t fraction = timestamp % interface.unitsPerSecond;
+    currentHeader.ts.tv_sec = static_cast<time_t>(static_cast<int64_t>(timestamp / interface.unitsPerSecond) +
+                                                  interface.offsetSeconds);
+    currentHeader.ts.tv_usec = static_cast<suseconds_t>(interface.unitsPerSecond == 1000000 ? fraction :
+            static_cast<uint64_t>(static_cast<unsigned __int128>(fraction) * 1000000 / interface.unitsPerSecond));
+}
+
+/**
+ * @return true if the pcapng file could be mapped and describes an interface.
+ */
+bool pcapng_mmap_reader::is_open() const {
+    return mapping != nullptr;
+}
+
+/**
+ * @return the error message of the last failed operation.
+ */
+const std::string &pcapng_mmap_reader::get_error() const {
+    return error;
+}
+
+/**
+ * Reads the blocks up to the next packet of an interface with the link type of the first interface.
+ * Section headers and interface descriptions are processed on the way, other blocks are skipped.
+ * @param header Set to the header of the packet.
+ * @param data Set to the captured packet bytes within the mapping.
+ * @return false if there are no more packets or the file is damaged.
+ */
+bool pcapng_mmap_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    uint32_t type;
+    uint32_t length;
+    while (read_block_header(offset, type, length)) {
+        uint64_t blockOffset = offset;
+        offset += length;
+        prefetch_mapping(mapping, fileSize, offset, prefetchEnd);
+
+        if (type == PCAPNG_SECTION_HEADER_BLOCK) {
+            if (!read_section_header(blockOffset)) return false;
+        } else if (type == PCAPNG_INTERFACE_DESCRIPTION_BLOCK) {
+            if (!read_interface(mapping + blockOffset, length)) return false;
+        } else if (type == PCAPNG_ENHANCED_PACKET_BLOCK || type == PCAPNG_SIMPLE_PACKET_BLOCK ||
+                   type == PCAPNG_PACKET_BLOCK) {
+            uint32_t interfaceId;
+            if (!read_packet(mapping + blockOffset, type, length, interfaceId, data)) return false;
+            if (interfaces[interfaceId].linkType != linkType) {
+                skippedCount++;
+                continue;
+            }
+            header = &currentHeader;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return true, the packet data stays valid as long as the file is mapped.
+ */
+bool pcapng_mmap_reader::keeps_data() const {
+    return true;
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the first interface.
+ */
+int pcapng_mmap_reader::get_link_type() const {
+    return linkType;
+}
+
+/**
+ * @return the number of bytes of the file read so far.
+ */
+uint64_t pcapng_mmap_reader::get_position() const {
+    return offset;
+}
+
+/**
+ * @return the size of the pcapng file in bytes.
+ */
+uint64_t pcapng_mmap_reader::get_file_size() const {
+    return fileSize;
+}
+
+/**
+ * @return the number of packets skipped so far, because their interface has another link type than the first one.
+ */
+uint64_t pcapng_mmap_reader::get_skipped_count() const {
+    return skippedCount;
+}
+
+/**
+ * Determines the timestamp of the last packet of a pcapng file by following the trailing block lengths backwards
+ * from the end of the file. Only packets of the interfaces described at the start of the first section are
+ * considered, the search stops at another section header.
+ * @param filePath The path to the pcapng file.
+ * @param timestamp Set to the timestamp of the last packet.
+ * @return false if the timestamp could not be determined this way.
+ */
+bool pcapng_mmap_reader::read_last_timestamp(const std::string &filePath, timeval &timestamp) {
+    pcapng_mmap_reader reader(filePath);
+    if (!reader.is_open()) {
+        return false;
+    }
+    const uint8_t *mapping = reader.mapping;
+    uint64_t scanStart = reader.fileSize > TAIL_SCAN_MAX_WINDOW ? reader.fileSize - TAIL_SCAN_MAX_WINDOW : 0;
+    scanStart = std::max(scanStart, reader.offset);
+
+    for (uint64_t end = reader.fileSize; end >= scanStart + PCAPNG_MIN_BLOCK_SIZE;) {
+        uint32_t length = read_file_u32(mapping + end - 4, reader.swapped);
+        if (length < PCAPNG_MIN_BLOCK_SIZE || length % 4 != 0 || length > end - scanStart ||
+            read_file_u32(mapping + end - length + 4, reader.swapped) != length) {
+            return false;
+        }
+        const uint8_t *block = mapping + end - length;
+        uint32_t type = read_file_u32(block, reader.swapped);
+        if (type == PCAPNG_SECTION_HEADER_BLOCK) {
+            return false;
+        }
+        if ((type == PCAPNG_ENHANCED_PACKET_BLOCK || type == PCAPNG_PACKET_BLOCK) && length >= PCAPNG_PACKET_BLOCK_SIZE) {
+            uint32_t interfaceId = type == PCAPNG_ENHANCED_PACKET_BLOCK ? read_file_u32(block + 8, reader.swapped)
+                                                                        : read_file_u16(block + 8, reader.swapped);
+            if (interfaceId >= reader.interfaces.size()) {
+                return false;
+            }
+            if (reader.interfaces[interfaceId].linkType == reader.linkType) {
+                reader.set_timestamp(reader.interfaces[interfaceId],
+                                     (static_cast<uint64_t>(read_file_u32(block + 12, reader.swapped)) << 32) |
+                                     read_file_u32(block + 16, reader.swapped));
+                timestamp = reader.currentHeader.ts;
+                return true;
+            }
+        }
+        end -= length;
+    }
+    return false;
+}
+
+/*
+ * Heap order of the active files of a capture set: the file with the earliest next packet comes first, files with
+ * equal timestamps in the order of the set
+ */
+struct capture_set_order {
+    const std::vector<capture_set_file> *files;
+
+    bool operator()(std::size_t a, std::size_t b) const {
+        const timeval &timestampA = (*files)[a].header->ts;
+        const timeval &timestampB = (*files)[b].header->ts;
+        if (timercmp(&timestampA, &timestampB, !=)) {
+            return timercmp(&timestampA, &timestampB, >);
+        }
+        return a > b;
+    }
+};
+
+/**
+ * Compares two files of a capture set by the timestamp of their first packet.
+ * @return true if the first packet of a is earlier than the first packet of b.
+ */
+static bool starts_earlier(const capture_set_file &a, const capture_set_file &b) {
+    return timercmp(&a.firstTimestamp, &b.firstTimestamp, <);
+}
+
+/**
+ * Determines the first timestamp of every file of a capture set and sorts the files by it. Empty files are skipped.
+ * @param filePaths The paths to the PCAP files, which need to have the same link type.
+ */
+pcap_set_reader::pcap_set_reader(const std::vector<std::string> &filePaths) : nextFile(0), current(0),
+        hasCurrent(false), keepsData(true), opened(false), linkType(0), fileSize(0), finishedSize(0) {
+    for (std::size_t i = 0; i < filePaths.size(); i++) {
+        std::unique_ptr<pcap_reader> reader = pcap_reader::open(filePaths[i]);
+        if (!reader->is_open()) {
+            error = filePaths[i] + ": " + reader->get_error();
+            return;
+        }
+        if (i == 0) {
+            linkType = reader->get_link_type();
+        } else if (reader->get_link_type() != linkType) {
+            error = filePaths[i] + ": the link type differs from the first file";
+            return;
+        }
+        keepsData = keepsData && reader->keeps_data();
+        fileSize += reader->get_file_size();
+
+        const pcap_pkthdr *header;
+        const u_char *data;
+        if (!reader->next(header, data)) {
+            if (!reader->get_error().empty()) {
+                error = filePaths[i] + ": " + reader->get_error();
+                return;
+            }
+            finishedSize += reader->get_file_size();
+            continue;
+        }
+        capture_set_file file = {filePaths[i], reader->get_file_size(), header->ts, nullptr, nullptr, nullptr};
+        files.push_back(std::move(file));
+    }
+
+    // The files are opened again once the timeline reaches them, so only overlapping files are open at the same time
+    std::stable_sort(files.begin(), files.end(), starts_earlier);
+    opened = true;
+}
+
+/**
+ * Opens a file of the capture set and adds it to the active files.
+ * @param index The index of the file in files.
+ * @return false if the file could not be read.
+ */
+bool pcap_set_reader::open_file(std::size_t index) {
+    capture_set_file &file = files[index];
+    file.reader = pcap_reader::open(file.path);
+    if (!file.reader->is_open() || !file.reader->next(file.header, file.data)) {
+        error = file.path + ": " + (file.reader->get_error().empty() ? "the file changed while reading"
+                                                                     : file.reader->get_error());
+        return false;
+    }
+    active.push_back(index);
+    capture_set_order order = {&files};
+    std::push_heap(active.begin(), active.end(), order);
+    return true;
+}
+
+/**
+ * Closes a file of the capture set after its last packet. Readers whose packet data stays valid are kept until the
+ * whole set was read.
+ * @param index The index of the file in files.
+ * @return false if the file is damaged.
+ */
+bool pcap_set_reader::close_file(std::size_t index) {
+    capture_set_file &file = files[index];
+    if (!file.reader->get_error().empty()) {
+        error = file.path + ": " + file.reader->get_error();
+        return false;
+    }
+    finishedSize += file.fileSize;
+    if (keepsData) {
+        finishedReaders.push_back(std::move(file.reader));
+    }
+    file.reader.reset();
+    return true;
+}
+
+/**
+ * @return true if all files of the capture set could be opened.
+ */
+bool pcap_set_reader::is_open() const {
+    return opened;
+}
+
+/**
+ * @return the error message of the last failed operation, starting with the path of the affected file.
+ */
+const std::string &pcap_set_reader::get_error() const {
+    return error;
+}
+
+/**
+ * Reads the next packet of the timeline. The returned header and data stay valid until the next call.
+ * @param header Set to the record header of the packet.
+ * @param data Set to the captured packet bytes.
+ * @return false if there are no more packets or a file is damaged.
+ */
+bool pcap_set_reader::next(const pcap_pkthdr *&header, const u_char *&data) {
+    capture_set_order order = {&files};
+    if (hasCurrent) {
+        hasCurrent = false;
+        capture_set_file &file = files[current];
+        if (file.reader->next(file.header, file.data)) {
+            // Sequential files: no other file is active and the next file starts later, so there is nothing to merge
+            if (active.empty() && (nextFile == files.size() ||
+                                   timercmp(&files[nextFile].firstTimestamp, &file.header->ts, >))) {
+                hasCurrent = true;
+                header = file.header;
+                data = file.data;
+                return true;
+            }
+            active.push_back(current);
+            std::push_heap(active.begin(), active.end(), order);
+        } else if (!close_file(current)) {
+            return false;
+        }
+    }
+
+    while (nextFile < files.size() &&
+           (active.empty() || !timercmp(&files[nextFile].firstTimestamp, &files[active.front()].header->ts, >))) {
+        if (!open_file(nextFile++)) {
+            return false;
+        }
+    }
+    if (active.empty()) {
+        return false;
+    }
+
+    std::pop_heap(active.begin(), active.end(), order);
+    current = active.back();
+    active.pop_back();
+    hasCurrent = true;
+    header = files[current].header;
+    data = files[current].data;
+    return true;
+}
+
+/**
+ * @return true if the packet data of every file stays valid while the reader exists.
+ */
+bool pcap_set_reader::keeps_data() const {
+    return keepsData;
+}
+
+/**
+ * @return the libpcap link type (DLT_*) of the files.
+ */
+int pcap_set_reader::get_link_type() const {
+    return linkType;
+}
+
+/**
+ * @return the number of bytes of all files read so far.
+ */
+uint64_t pcap_set_reader::get_position() const {
+    uint64_t position = finishedSize;
+    for (std::size_t index: active) {
+        position += files[index].reader->get_position();
+    }
+    if (hasCurrent && files[current].reader != nullptr) {
+        position += files[current].reader->get_position();
+    }
+    return position;
+}
+
+/**
+ * @return the size of all files in bytes.
+ */
+uint64_t pcap_set_reader::get_file_size() const {
+    return fileSize;
+}
+
+/**
+ * Opens a PCAP file with the fastest reader available for it. Classic PCAP and pcapng files are mapped into memory,
+ * compressed files are decompressed while reading, other formats or files which cannot be mapped are read with libpcap.
+ * The standard input and named pipes are read with libpcap, as their bytes can only be read once.
+ * @param filePath The path to the PCAP file.
+ * @return the reader, check is_open() before using it.
+ */
+std::unique_ptr<pcap_reader> pcap_reader::open(const std::string &filePath) {
+    if (is_stream(filePath)) {
+        return std::unique_ptr<pcap_reader>(new pcap_stream_reader(filePath));
+    }
+
+    compression_format format = detect_compression(filePath);
+    if (format != COMPRESSION_NONE) {
+        return std::unique_ptr<pcap_reader>(new pcap_compressed_reader(filePath, format));
+    }
+
+    std::unique_ptr<pcap_reader> reader(new pcap_mmap_reader(filePath));
+    if (!reader->is_open()) {
+        reader.reset(new pcapng_mmap_reader(filePath));
+    }
+    if (!reader->is_open()) {
+        reader.reset(new pcap_stream_reader(filePath));
+    }
+    return reader;
+}
+
+/**
+ * Opens a capture set, whose files are read as one timeline ordered by timestamp.
+ * @param filePaths The paths to the PCAP files.
+ * @return the reader, check is_open() before using it.
+ */
+std::unique_ptr<pcap_reader> pcap_reader::open(const std::vector<std::string> &filePaths) {
+    if (filePaths.size() == 1) {
+        return open(filePaths[0]);
+    }
+    return std::unique_ptr<pcap_reader>(new pcap_set_reader(filePaths));
+}
+
+/**
+ * Expands a glob pattern like "capture_*.pcap" to the paths of a capture set.
+ * @param pattern The pattern or the path to a single PCAP file.
+ * @return the sorted paths of the matching files, the pattern itself if it is no pattern or matches no file.
+ */
+std::vector<std::string> pcap_reader::expand_capture_set(const std::string &pattern) {
+    std::vector<std::string> filePaths;
+    glob_t matches;
+    if (pattern.find_first_of("*?[") != std::string::npos && glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+        for (std::size_t i = 0; i < matches.gl_pathc; i++) {
+            filePaths.push_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+    }
+    if (filePaths.empty()) {
+        filePaths.push_back(pattern);
+    }
+    return filePaths;
+}
+
+/**
+ * Checks whether a path refers to a stream, which can only be read once from start to end.
+ * @param filePath The path to the PCAP file.
+ * @return true for the standard input (PCAP_STDIN_PATH) and named pipes.
+ */
+bool pcap_reader::is_stream(const std::string &filePath) {
+    struct stat buffer;
+    return filePath == PCAP_STDIN_PATH || (stat(filePath.c_str(), &buffer) == 0 && S_ISFIFO(buffer.st_mode));
+}
+
+/**
+ * Reads the global header of a classic PCAP file.
+ * @param filePath The path to the PCAP file.
+ * @param info Set to the information of the global header.
+ * @return false if the file could not be read or is not a classic PCAP file (e.g. pcapng).
+ */
+bool pcap_reader::read_file_info(const std::string &filePath, pcap_file_info &info) {
+    std::ifstream file(filePath, std::ios::binary);
+    uint8_t header[PCAP_FILE_HEADER_SIZE];
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+
+    uint32_t magic = read_file_u32(header, false);
+    if (magic == PCAP_MAGIC_MICRO || magic == PCAP_MAGIC_NANO) {
+        info.swapped = false;
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_MICRO || __builtin_bswap32(magic) == PCAP_MAGIC_NANO) {
+        info.swapped = true;
+        magic = __builtin_bswap32(magic);
+    } else {
+        return false;
+    }
+    info.nanoseconds = (magic == PCAP_MAGIC_NANO);
+    info.snaplen = read_file_u32(header + 16, info.swapped);
+    info.linkType = read_file_u32(header + 20, info.swapped);
+    return true;
+}
+
+/**
+ * Determines the timestamp of the last packet record of a classic PCAP file by scanning only the end of the file.
+ * Starting from the end of a window at the end of the file, every offset whose chain of plausible record headers
+ * ends exactly at the end of the file is marked. The first marked offset whose chain has enough records with
+ * consistent timestamps is taken as a record boundary, the last record of its chain is the last record of the file.
+ * The window is enlarged if no such chain is found. pcapng files are passed to pcapng_mmap_reader::read_last_timestamp.
+ * @param filePath The path to the PCAP file.
+ * @param timestamp Set to the timestamp of the last packet.
+ * @return false if the timestamp could not be determined this way, e.g. because the file is truncated.
+ */
+bool pcap_reader::read_last_timestamp(const std::string &filePath, timeval &timestamp) {
+    pcap_file_info info;
+    if (!read_file_info(filePath, info)) {
+        return pcapng_mmap_reader::read_last_timestamp(filePath, timestamp);
+    }
+
+    struct stat buffer;
+    if (stat(filePath.c_str(), &buffer) != 0 || static_cast<uint64_t>(buffer.st_size) <= PCAP_FILE_HEADER_SIZE) {
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(buffer.st_size);
+
+    std::ifstream file(filePath, std::ios::binary);
+    uint8_t firstRecord[PCAP_RECORD_HEADER_SIZE];
+    file.seekg(PCAP_FILE_HEADER_SIZE);
+    if (!file.read(reinterpret_cast<char *>(firstRecord), sizeof(firstRecord))) {
+        return false;
+    }
+    uint32_t firstSeconds = read_file_u32(firstRecord, info.swapped);
+
+    uint32_t maxCaplen = info.snaplen > PCAP_MAX_RECORD_SIZE ? info.snaplen : PCAP_MAX_RECORD_SIZE;
+    uint32_t maxFraction = info.nanoseconds ? 1000000000 : 1000000;
+
+    for (uint64_t window = TAIL_SCAN_WINDOW; window <= TAIL_SCAN_MAX_WINDOW; window *= 4) {
+        uint64_t start = fileSize - PCAP_FILE_HEADER_SIZE > window ? fileSize - window : PCAP_FILE_HEADER_SIZE;
+        std::size_t length = static_cast<std::size_t>(fileSize - start);
+
+        std::vector<uint8_t> tail(length);
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(start));
+        if (!file.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(length))) {
+            return false;
+        }
+
+        // chainEnds[i]: a chain of plausible records starting at offset i ends exactly at the end of the file
+        std::vector<bool> chainEnds(length + 1, false);
+        chainEnds[length] = true;
+        for (std::size_t i = length >= PCAP_RECORD_HEADER_SIZE ? length - PCAP_RECORD_HEADER_SIZE + 1 : 0; i-- > 0;) {
+            const uint8_t *record = tail.data() + i;
+            uint32_t fraction = read_file_u32(record + 4, info.swapped);
+            uint32_t caplen = read_file_u32(record + 8, info.swapped);
+            uint32_t len = read_file_u32(record + 12, info.swapped);
+            if (fraction >= maxFraction || caplen > maxCaplen || caplen > len) {
+                continue;
+            }
+            std::size_t next = i + PCAP_RECORD_HEADER_SIZE + caplen;
+            if (next <= length && chainEnds[next]) {
+                chainEnds[i] = true;
+            }
+        }
+
+        for (std::size_t i = 0; i < length; i++) {
+            if (!chainEnds[i]) {
+                continue;
+            }
+            // Follow the chain to its last record, random data rarely forms a chain with consistent timestamps
+            std::size_t last = i;
+            std::size_t next = i;
+            std::size_t records = 0;
+            uint32_t previousSeconds = firstSeconds;
+            bool consistent = true;
+            while (next < length && consistent) {
+                uint32_t seconds = read_file_u32(tail.data() + next, info.swapped);
+                uint32_t gap = seconds > previousSeconds ? seconds - previousSeconds : previousSeconds - seconds;
+                consistent = seconds + TAIL_SCAN_MAX_TIME_GAP >= firstSeconds && (records == 0 || gap <= TAIL_SCAN_MAX_TIME_GAP);
+                previousSeconds = seconds;
+                records++;
+                last = next;
+                next += PCAP_RECORD_HEADER_SIZE + read_file_u32(tail.data() + next + 8, info.swapped);
+            }
+            if (!consistent || (records < TAIL_SCAN_MIN_RECORDS && start + i != PCAP_FILE_HEADER_SIZE)) {
+                continue;
+            }
+            uint32_t fraction = read_file_u32(tail.data() + last + 4, info.swapped);
+            timestamp.tv_sec = static_cast<time_t>(read_file_u32(tail.data() + last, info.swapped));
+            timestamp.tv_usec = static_cast<suseconds_t>(info.nanoseconds ? fraction / 1000 : fraction);
+            return true;
+        }
+
+        if (start == PCAP_FILE_HEADER_SIZE) {
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Determines the timestamp of the last packet of a capture set, see read_last_timestamp for a single file.
+ * @param filePaths The paths to the PCAP files.
+ * @param timestamp Set to the latest timestamp of the last packets of the files.
+ * @return false if the timestamp could not be determined for one of the files with packets.
+ */
+bool pcap_reader::read_last_timestamp(const std::vector<std::string> &filePaths, timeval &timestamp) {
+    bool found = false;
+    timerclear(&timestamp);
+    for (const std::string &filePath: filePaths) {
+        timeval fileTimestamp;
+        if (!read_last_timestamp(filePath, fileTimestamp)) {
+            // Files without packets, e.g. the last file of a rotation, do not matter
+            const pcap_pkthdr *header;
+            const u_char *data;
+            std::unique_ptr<pcap_reader> reader = open(filePath);
+            if (!reader->is_open() || reader->next(header, data) || !reader->get_error().empty()) {
+                return false;
+            }
+            continue;
+        }
+        if (!found || timercmp(&fileTimestamp, &timestamp, >)) {
+            timestamp = fileTimestamp;
+            found = true;
+        }
+    }
+    return found;
+}
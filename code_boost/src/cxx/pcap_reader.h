@@ -0,0 +1,444 @@
+/**
+ * Classes reading the packet records of a PCAP file sequentially.
+ */
+
+#ifndef CPP_PCAPREADER_PCAP_READER_H
+#define CPP_PCAPREADER_PCAP_READER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pcap.h>
+#include "compressed_file.h"
+
+/*
+ * Magic numbers of the classic PCAP file format (in file byte order)
+ */
+#define PCAP_MAGIC_MICRO 0xa1b2c3d4
+#define PCAP_MAGIC_NANO 0xa1b23c4d
+
+#define PCAP_FILE_HEADER_SIZE 24
+#define PCAP_RECORD_HEADER_SIZE 16
+
+/*
+ * Path under which a PCAP is read from the standard input
+ */
+#define PCAP_STDIN_PATH "-"
+
+/*
+ * Struct used to represent the global header of a classic PCAP file:
+ * - Whether the file was written with the opposite byte order
+ * - Whether the timestamps have nanosecond resolution
+ * - Snapshot length
+ * - Link type
+ */
+struct pcap_file_info {
+    bool swapped;
+    bool nanoseconds;
+    uint32_t snaplen;
+    uint32_t linkType;
+};
+
+/*
+ * Struct used to represent an interface of a pcapng section:
+ * - Link type (DLT_*)
+ * - Snapshot length
+ * - Number of timestamp units per second
+ * - Offset of the timestamps in seconds
+ */
+struct pcapng_interface {
+    int linkType;
+    uint32_t snaplen;
+    uint64_t unitsPerSecond;
+    int64_t offsetSeconds;
+};
+
+/*
+ * Number of packets between two entries of a packet index
+ */
+#define PACKET_INDEX_INTERVAL 1024
+
+/*
+ * Struct used to represent an entry of the packet index of a classic PCAP file:
+ * - Number of the packet, starting with 1
+ * - Offset of the packet record in the file
+ * - Timestamp of the packet in microseconds
+ */
+struct packet_index_entry {
+    uint64_t packetNumber;
+    uint64_t offset;
+    int64_t timestamp;
+};
+
+/*
+ * Time in microseconds by which the packets read around a time window extend it, so that slightly reordered
+ * timestamps at its edges are not missed
+ */
+#define TIME_WINDOW_MARGIN 1000000
+
+/*
+ * Struct used to represent the time window of the packets to be processed:
+ * - Timestamp of the first packet to be processed in microseconds, or the minimum of int64_t
+ * - Timestamp of the last packet to be processed in microseconds, or the maximum of int64_t
+ */
+struct time_window {
+    int64_t start;
+    int64_t end;
+
+    bool is_restricted() const;
+
+    bool contains(int64_t timestamp) const;
+
+    int64_t get_read_start() const;
+
+    int64_t get_read_end() const;
+
+    bool is_passed(int64_t timestamp) const;
+};
+
+time_window unrestricted_time_window();
+
+int64_t get_packet_timestamp(const pcap_pkthdr &header);
+
+/*
+ * Interface of the PCAP readers. The header and data returned by next() stay valid until the next call.
+ */
+class pcap_reader {
+public:
+    virtual ~pcap_reader() {}
+
+    /*
+     * Methods
+     */
+    virtual bool is_open() const = 0;
+
+    virtual const std::string &get_error() const = 0;
+
+    virtual bool next(const pcap_pkthdr *&header, const u_char *&data) = 0;
+
+    virtual bool keeps_data() const = 0;
+
+    virtual int get_link_type() const = 0;
+
+    virtual uint64_t get_position() const = 0;
+
+    virtual uint64_t get_file_size() const = 0;
+
+    static std::unique_ptr<pcap_reader> open(const std::string &filePath);
+
+    static std::unique_ptr<pcap_reader> open(const std::vector<std::string> &filePaths);
+
+    static std::vector<std::string> expand_capture_set(const std::string &pattern);
+
+    static bool is_stream(const std::string &filePath);
+
+    static bool read_file_info(const std::string &filePath, pcap_file_info &info);
+
+    static bool read_last_timestamp(const std::string &filePath, timeval &timestamp);
+
+    static bool read_last_timestamp(const std::vector<std::string> &filePaths, timeval &timestamp);
+};
+
+/*
+ * BPF filter compiled with libpcap. matches() may be called by several threads at the same time.
+ */
+class packet_filter {
+public:
+    packet_filter();
+
+    ~packet_filter();
+
+    packet_filter(const packet_filter &) = delete;
+
+    packet_filter &operator=(const packet_filter &) = delete;
+
+    bool compile(const std::string &expression, int linkType);
+
+    bool matches(const pcap_pkthdr &header, const u_char *data) const;
+
+    const std::string &get_error() const;
+
+private:
+    bpf_program program;
+    bool compiled;
+    std::string error;
+};
+
+/*
+ * Reader passing on only the packets of another reader which match a BPF filter and lie within a time window.
+ * The filter may be null. Reading stops once the packets are past the time window.
+ */
+class pcap_filtered_reader : public pcap_reader {
+public:
+    pcap_filtered_reader(std::unique_ptr<pcap_reader> reader, std::shared_ptr<const packet_filter> filter,
+                         const time_window &window);
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+private:
+    std::unique_ptr<pcap_reader> reader;
+    std::shared_ptr<const packet_filter> filter;
+    time_window window;
+};
+
+/*
+ * Reader using libpcap, supports every file format libpcap can read
+ */
+class pcap_stream_reader : public pcap_reader {
+public:
+    pcap_stream_reader(const std::string &filePath);
+
+    ~pcap_stream_reader();
+
+    pcap_stream_reader(const pcap_stream_reader &) = delete;
+
+    pcap_stream_reader &operator=(const pcap_stream_reader &) = delete;
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+private:
+    pcap_t *handle;
+    uint64_t fileSize;
+    std::string error;
+};
+
+/*
+ * Reader using libpcap on a gzip, xz or zstd compressed file, which is decompressed on a separate thread
+ */
+class pcap_compressed_reader : public pcap_reader {
+public:
+    pcap_compressed_reader(const std::string &filePath, compression_format format);
+
+    ~pcap_compressed_reader();
+
+    pcap_compressed_reader(const pcap_compressed_reader &) = delete;
+
+    pcap_compressed_reader &operator=(const pcap_compressed_reader &) = delete;
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+private:
+    compressed_file_reader stream;
+    pcap_t *handle;
+    std::string error;
+};
+
+/*
+ * Reader mapping a classic PCAP file into memory, the packet data is returned without copying it
+ */
+class pcap_mmap_reader : public pcap_reader {
+public:
+    pcap_mmap_reader(const std::string &filePath);
+
+    ~pcap_mmap_reader();
+
+    pcap_mmap_reader(const pcap_mmap_reader &) = delete;
+
+    pcap_mmap_reader &operator=(const pcap_mmap_reader &) = delete;
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+    void set_range(uint64_t begin, uint64_t end);
+
+    uint64_t find_record_boundary(uint64_t position) const;
+
+    uint64_t find_timestamp(int64_t timestamp) const;
+
+    bool seek(const packet_index_entry &entry);
+
+    void resume(uint64_t position, uint64_t records, const std::vector<packet_index_entry> &entries);
+
+    void set_index_interval(std::size_t interval);
+
+    const std::vector<packet_index_entry> &get_index() const;
+
+    uint64_t get_record_count() const;
+
+    uint64_t get_fingerprint(uint64_t end) const;
+
+private:
+    const uint8_t *mapping;
+    uint64_t fileSize;
+    uint64_t offset;
+    uint64_t rangeEnd;
+    uint64_t prefetchEnd;
+    uint64_t recordCount;
+    std::size_t indexInterval;
+    std::vector<packet_index_entry> index;
+    pcap_file_info info;
+    pcap_pkthdr currentHeader;
+    std::string error;
+
+    void prefetch();
+
+    int64_t read_record_timestamp(uint64_t position) const;
+};
+
+/*
+ * Reader mapping a pcapng file into memory, the packet data is returned without copying it. Only the packets of
+ * interfaces with the link type of the first interface are returned, see get_skipped_count.
+ */
+class pcapng_mmap_reader : public pcap_reader {
+public:
+    pcapng_mmap_reader(const std::string &filePath);
+
+    ~pcapng_mmap_reader();
+
+    pcapng_mmap_reader(const pcapng_mmap_reader &) = delete;
+
+    pcapng_mmap_reader &operator=(const pcapng_mmap_reader &) = delete;
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+    uint64_t get_skipped_count() const;
+
+    static bool read_last_timestamp(const std::string &filePath, timeval &timestamp);
+
+private:
+    const uint8_t *mapping;
+    uint64_t fileSize;
+    uint64_t offset;
+    uint64_t prefetchEnd;
+    bool swapped;
+    int linkType;
+    std::vector<pcapng_interface> interfaces;
+    uint64_t skippedCount;
+    pcap_pkthdr currentHeader;
+    std::string error;
+
+    bool read_block_header(uint64_t blockOffset, uint32_t &type, uint32_t &length);
+
+    bool read_section_header(uint64_t blockOffset);
+
+    bool read_interface(const uint8_t *block, uint32_t length);
+
+    bool read_packet(const uint8_t *block, uint32_t type, uint32_t length, uint32_t &interfaceId,
+                     const u_char *&data);
+
+    void set_timestamp(const pcapng_interface &interface, uint64_t timestamp);
+};
+
+/*
+ * Struct used to represent a file of a capture set:
+ * - Path of the file
+ * - Size of the file in bytes
+ * - Timestamp of the first packet
+ * - Reader while the file is read
+ * - Record header and data of the next packet of the file
+ */
+struct capture_set_file {
+    std::string path;
+    uint64_t fileSize;
+    timeval firstTimestamp;
+    std::unique_ptr<pcap_reader> reader;
+    const pcap_pkthdr *header;
+    const u_char *data;
+};
+
+/*
+ * Reader merging the packets of several PCAP files by timestamp into one timeline. A file is only opened once the
+ * timeline reaches its first packet, so sequential files are read one after the other without merging.
+ */
+class pcap_set_reader : public pcap_reader {
+public:
+    pcap_set_reader(const std::vector<std::string> &filePaths);
+
+    pcap_set_reader(const pcap_set_reader &) = delete;
+
+    pcap_set_reader &operator=(const pcap_set_reader &) = delete;
+
+    bool is_open() const override;
+
+    const std::string &get_error() const override;
+
+    bool next(const pcap_pkthdr *&header, const u_char *&data) override;
+
+    bool keeps_data() const override;
+
+    int get_link_type() const override;
+
+    uint64_t get_position() const override;
+
+    uint64_t get_file_size() const override;
+
+private:
+    std::vector<capture_set_file> files;
+    std::vector<std::size_t> active;
+    std::vector<std::unique_ptr<pcap_reader>> finishedReaders;
+    std::size_t nextFile;
+    std::size_t current;
+    bool hasCurrent;
+    bool keepsData;
+    bool opened;
+    int linkType;
+    uint64_t fileSize;
+    uint64_t finishedSize;
+    std::string error;
+
+    bool open_file(std::size_t index);
+
+    bool close_file(std::size_t index);
+};
+
+#endif //CPP_PCAPREADER_PCAP_READER_H
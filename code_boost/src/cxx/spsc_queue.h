@@ -0,0 +1,106 @@
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ */
+
+#ifndef CPP_PCAPREADER_SPSC_QUEUE_H
+#define CPP_PCAPREADER_SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#define CACHE_LINE_SIZE 64
+#define SPSC_QUEUE_SPIN_LIMIT 64
+#define SPSC_QUEUE_SLEEP_MICROSECONDS 50
+
+template<typename T>
+class spsc_queue {
+public:
+    /*
+     * Constructor: Creates a queue holding at most capacity items
+     */
+    explicit spsc_queue(std::size_t capacity) : slots(capacity + 1), head(0), tail(0) {}
+
+    spsc_queue(const spsc_queue &) = delete;
+
+    spsc_queue &operator=(const spsc_queue &) = delete;
+
+    /*
+     * Appends item to the queue, returns false if the queue is full. Must only be called by the producer.
+     */
+    bool try_push(const T &item) {
+        std::size_t currentTail = tail.load(std::memory_order_relaxed);
+        std::size_t nextTail = increment(currentTail);
+        if (nextTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots[currentTail] = item;
+        tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    /*
+     * Removes the oldest item from the queue, returns false if the queue is empty. Must only be called by the consumer.
+     */
+    bool try_pop(T &item) {
+        std::size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[currentHead];
+        head.store(increment(currentHead), std::memory_order_release);
+        return true;
+    }
+
+    /*
+     * Appends item to the queue, waits while the queue is full. Returns false if stopped is set while waiting.
+     */
+    bool push(const T &item, const std::atomic<bool> &stopped) {
+        for (unsigned int spins = 0; !try_push(item); spins++) {
+            if (stopped.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            wait(spins);
+        }
+        return true;
+    }
+
+    /*
+     * Removes the oldest item from the queue, waits while the queue is empty. Returns false if stopped is set while waiting.
+     */
+    bool pop(T &item, const std::atomic<bool> &stopped) {
+        for (unsigned int spins = 0; !try_pop(item); spins++) {
+            if (stopped.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            wait(spins);
+        }
+        return true;
+    }
+
+private:
+    std::vector<T> slots;
+    // Producer and consumer positions on separate cache lines to avoid false sharing
+    char paddingSlots[CACHE_LINE_SIZE];
+    std::atomic<std::size_t> head;
+    char paddingHead[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> tail;
+    char paddingTail[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+
+    std::size_t increment(std::size_t position) const {
+        return position + 1 == slots.size() ? 0 : position + 1;
+    }
+
+    // Yields for short waits, sleeps for long waits to not keep a core busy
+    static void wait(unsigned int spins) {
+        if (spins < SPSC_QUEUE_SPIN_LIMIT) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(SPSC_QUEUE_SLEEP_MICROSECONDS));
+        }
+    }
+};
+
+#endif //CPP_PCAPREADER_SPSC_QUEUE_H
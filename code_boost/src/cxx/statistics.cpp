@@ -1,10 +1,12 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 #include <math.h>
 #include "statistics.h"
 #include <sstream>
 #include <SQLiteCpp/SQLiteCpp.h>
+#include "statistics_checkpoint.h"
 #include "statistics_db.h"
 #include "statistics.h"
 #include "utilities.h"
@@ -16,7 +18,7 @@ using namespace Tins;
  * @param pdu_l4 The packet that should be checked if it has a payload or not.
  */
 void statistics::checkPayload(const PDU *pdu_l4) {
-    if(this->getDoExtraTests()) {
+    if(this->getDoExtraTests() && ownsCaptureCounters()) {
         // pdu_l4: Tarnsport layer 4
         int pktSize = pdu_l4->size();
         int headerSize = pdu_l4->header_size(); // TCP/UDP header
@@ -26,6 +28,17 @@ void statistics::checkPayload(const PDU *pdu_l4) {
     }
 }
 
+/**
+ * Increments the payloads counter if the transport layer payload size of a packet is non-zero.
+ * @param payloadSize The transport layer payload size of the packet.
+ */
+void statistics::checkPayload(uint32_t payloadSize) {
+    if(this->getDoExtraTests() && ownsCaptureCounters()) {
+        if (payloadSize > 0)
+            payloadCount++;
+    }
+}
+
 /**
  * Checks the correctness of TCP checksum and increments counter if the checksum was incorrect.
  * @param ipAddressSender The source IP.
@@ -33,7 +46,7 @@ void statistics::checkPayload(const PDU *pdu_l4) {
  * @param tcpPkt The packet to get checked.
  */
 void statistics::checkTCPChecksum(const std::string &ipAddressSender, const std::string &ipAddressReceiver, TCP tcpPkt) {
-    if(this->getDoExtraTests()) {
+    if(this->getDoExtraTests() && ownsCaptureCounters()) {
         if(check_tcpChecksum(ipAddressSender, ipAddressReceiver, tcpPkt))
             correctTCPChecksumCount++;
         else incorrectTCPChecksumCount++;
@@ -41,121 +54,130 @@ void statistics::checkTCPChecksum(const std::string &ipAddressSender, const std:
 }
 
 /**
- * Calculates entropy of the source and destination IPs in a time interval.
- * @param intervalStartTimestamp The timstamp where the interval starts.
+ * Checks the correctness of the TCP checksum of a raw TCP segment and increments the respective counter.
+ * @param ipAddressSender The source IP in host byte order.
+ * @param ipAddressReceiver The destination IP in host byte order.
+ * @param segment Pointer to the TCP header, followed by the TCP payload.
+ * @param segmentSize The size of the TCP header and payload.
+ */
+void statistics::checkTCPChecksum(uint32_t ipAddressSender, uint32_t ipAddressReceiver, const uint8_t *segment, uint32_t segmentSize) {
+    if(this->getDoExtraTests() && ownsCaptureCounters()) {
+        if(check_tcpChecksum(ipAddressSender, ipAddressReceiver, segment, segmentSize))
+            correctTCPChecksumCount++;
+        else incorrectTCPChecksumCount++;
+    }
+}
+
+/**
+ * Calculates entropy of the source and destination IPs in the time interval since the last interval.
  * @return a vector: contains source IP entropy and destination IP entropy.
  */
-std::vector<double> statistics::calculateLastIntervalIPsEntropy(std::chrono::microseconds intervalStartTimestamp){
+std::vector<double> statistics::calculateLastIntervalIPsEntropy(){
     if(this->getDoExtraTests()) {
-        // TODO: change datastructures
-        std::vector<long> IPsSrcPktsCounts;
-        std::vector<long> IPsDstPktsCounts;
-        std::vector<long> IPsSrcNovelPktsCounts;
-        std::vector<long> IPsDstNovelPktsCounts;
-
-        std::vector<double> IPsSrcProb;
-        std::vector<double> IPsDstProb;
-        std::vector<double> IPsSrcNovelProb;
-        std::vector<double> IPsDstNovelProb;
-
-        long pktsSent = 0, pktsReceived = 0, novelPktsSent = 0, novelPktsReceived = 0;
-
-        for (auto i = ip_statistics.begin(); i != ip_statistics.end(); i++) {
-            long IPsSrcPktsCount = 0;
-            long IPsSrcNovelPktsCount = 0;
-            if (intervalCumIPStats.count(i->first) == 0) {
-                IPsSrcPktsCount = i->second.pkts_sent;
-                IPsSrcNovelPktsCount = i->second.pkts_sent;
-                IPsSrcNovelPktsCounts.push_back(IPsSrcNovelPktsCount);
-                novelPktsSent += IPsSrcNovelPktsCount;
-            } else {
-                IPsSrcPktsCount = i->second.pkts_sent-intervalCumIPStats[i->first].pkts_sent;
-            }
-            if(IPsSrcPktsCount != 0) {
-                IPsSrcPktsCounts.push_back(IPsSrcPktsCount);
-                pktsSent += IPsSrcPktsCount;
-            }
-
-            long IPsDstPktsCount = 0;
-            long IPsDstNovelPktsCount = 0;
-            if (intervalCumIPStats.count(i->first) == 0) {
-                IPsDstPktsCount = i->second.pkts_received;
-                IPsDstNovelPktsCount = i->second.pkts_received;
-                IPsDstNovelPktsCounts.push_back(IPsDstNovelPktsCount);
-                novelPktsReceived += IPsDstNovelPktsCount;
-            } else {
-                IPsDstPktsCount = i->second.pkts_received-intervalCumIPStats[i->first].pkts_received;
-            }
-            if(IPsDstPktsCount != 0) {
-                IPsDstPktsCounts.push_back(IPsDstPktsCount);
-                pktsReceived += IPsDstPktsCount;
-            }
-        }
-
-        for (auto i = IPsSrcPktsCounts.begin(); i != IPsSrcPktsCounts.end(); i++) {
-            IPsSrcProb.push_back(static_cast<double>(*i) / static_cast<double>(pktsSent));
-        }
-        for (auto i = IPsDstPktsCounts.begin(); i != IPsDstPktsCounts.end(); i++) {
-            IPsDstProb.push_back(static_cast<double>(*i) / static_cast<double>(pktsReceived));
-        }
-        for (auto i = IPsSrcNovelPktsCounts.begin(); i != IPsSrcNovelPktsCounts.end(); i++) {
-            IPsSrcNovelProb.push_back(static_cast<double>(*i) / static_cast<double>(novelPktsSent));
-        }
-        for (auto i = IPsDstNovelPktsCounts.begin(); i != IPsDstNovelPktsCounts.end(); i++) {
-            IPsDstNovelProb.push_back(static_cast<double>(*i) / static_cast<double>(novelPktsReceived));
-        }
+        entry_shardIntervalStat counts;
+        collectIntervalIPsPktsCounts(counts);
+        return calculateIPsEntropy(counts);
+    }
+    else {
+        return {-1, -1, -1, -1, -1, -1, -1, -1};
+    }
+}
 
-        // Calculate IP source entropy
-        double IPsSrcEntropy = 0;
-        for (unsigned i = 0; i < IPsSrcProb.size(); i++) {
-            if (IPsSrcProb[i] > 0)
-                IPsSrcEntropy += -IPsSrcProb[i] * log2(IPsSrcProb[i]);
-        }
-        // Calculate IP destination entropy
-        double IPsDstEntropy = 0;
-        for (unsigned i = 0; i < IPsDstProb.size(); i++) {
-            if (IPsDstProb[i] > 0)
-                IPsDstEntropy += -IPsDstProb[i] * log2(IPsDstProb[i]);
+/**
+ * Collects the number of packets every IP sent and received since the last interval. Only the IPs which sent or
+ * received packets since then are visited, an IP is novel if all its packets lie in this interval.
+ * @param counts The packet counts of all IPs and of the novel IPs are added to this struct.
+ */
+void statistics::collectIntervalIPsPktsCounts(entry_shardIntervalStat &counts) {
+    for (address_id ipAddress: intervalIPs) {
+        const entry_ipStat &ipStat = ip_statistics.find(ipAddress)->second;
+        long IPsSrcPktsCount = ipStat.interval_pkts_sent;
+        long IPsDstPktsCount = ipStat.interval_pkts_received;
+        if (ipStat.pkts_sent == IPsSrcPktsCount && ipStat.pkts_received == IPsDstPktsCount) {
+            counts.ip_src_novel_pkts_counts[IPsSrcPktsCount]++;
+            counts.ip_dst_novel_pkts_counts[IPsDstPktsCount]++;
         }
-        // Calculate IP source novel entropy
-        double IPsSrcNovelEntropy = 0;
-        for (unsigned i = 0; i < IPsSrcNovelProb.size(); i++) {
-            if (IPsSrcNovelProb[i] > 0)
-                IPsSrcNovelEntropy += -IPsSrcNovelProb[i] * log2(IPsSrcNovelProb[i]);
+        if (IPsSrcPktsCount != 0) {
+            counts.ip_src_pkts_counts[IPsSrcPktsCount]++;
         }
-        // Calculate IP destination novel entropy
-        double IPsDstNovelEntropy = 0;
-        for (unsigned i = 0; i < IPsDstNovelProb.size(); i++) {
-            if (IPsDstNovelProb[i] > 0)
-                IPsDstNovelEntropy += -IPsDstNovelProb[i] * log2(IPsDstNovelProb[i]);
+        if (IPsDstPktsCount != 0) {
+            counts.ip_dst_pkts_counts[IPsDstPktsCount]++;
         }
+    }
+}
 
-        this->ip_src_novel_count = IPsSrcNovelPktsCounts.size();
-        this->ip_dst_novel_count = IPsDstNovelPktsCounts.size();
-
-        double norm_src_entropy = 0;
-        if (IPsSrcPktsCounts.size() > 0 && log2(IPsSrcPktsCounts.size()) > 0) {
-            norm_src_entropy = IPsSrcEntropy / log2(IPsSrcPktsCounts.size());
-        }
-        double norm_dst_entropy = 0;
-        if (IPsDstPktsCounts.size() > 0 && log2(IPsDstPktsCounts.size()) > 0) {
-            norm_dst_entropy = IPsDstEntropy / log2(IPsDstPktsCounts.size());
-        }
-        double norm_novel_src_entropy = 0;
-        if (IPsSrcNovelPktsCounts.size() > 0 && log2(IPsSrcNovelPktsCounts.size()) > 0) {
-            norm_novel_src_entropy = IPsSrcNovelEntropy / log2(IPsSrcNovelPktsCounts.size());
-        }
-        double norm_novel_dst_entropy = 0;
-        if (IPsDstNovelPktsCounts.size() > 0 && log2(IPsDstNovelPktsCounts.size()) > 0) {
-            norm_novel_dst_entropy = IPsDstNovelEntropy / log2(IPsDstNovelPktsCounts.size());
-        }
+/**
+ * Calculates the entropy of packet counts given as the number of hosts per packet count. The summands are added in
+ * the order of the packet counts, so the entropy does not depend on the order in which the hosts were counted.
+ * @param hostCounts The number of hosts per packet count.
+ * @param total The number of packets the probabilities of the packet counts relate to.
+ * @return the entropy.
+ */
+static double calculateCountsEntropy(const std::map<long, long> &hostCounts, long total) {
+    double entropy = 0;
+    for (auto &count: hostCounts) {
+        double prob = static_cast<double>(count.first) / static_cast<double>(total);
+        if (prob > 0)
+            entropy += -prob * log2(prob) * static_cast<double>(count.second);
+    }
+    return entropy;
+}
 
-        std::vector<double> entropies = {IPsSrcEntropy, IPsDstEntropy, IPsSrcNovelEntropy, IPsDstNovelEntropy, norm_src_entropy, norm_dst_entropy, norm_novel_src_entropy, norm_novel_dst_entropy};
-        return entropies;
+/**
+ * Sums up packet counts given as the number of hosts per packet count.
+ * @param hostCounts The number of hosts per packet count.
+ * @param hosts Set to the number of hosts.
+ * @return the sum of the packet counts.
+ */
+static long sumCounts(const std::map<long, long> &hostCounts, long &hosts) {
+    long total = 0;
+    hosts = 0;
+    for (auto &count: hostCounts) {
+        total += count.first * count.second;
+        hosts += count.second;
     }
-    else {
-        return {-1, -1, -1, -1, -1, -1, -1, -1};
+    return total;
+}
+
+/**
+ * Normalizes an entropy by the maximum entropy of the given number of hosts.
+ * @param entropy The entropy.
+ * @param hosts The number of hosts.
+ * @return the normalized entropy, 0 for less than two hosts.
+ */
+static double normalizeEntropy(double entropy, long hosts) {
+    if (hosts > 0 && log2(hosts) > 0) {
+        return entropy / log2(hosts);
     }
+    return 0;
+}
+
+/**
+ * Calculates entropy of the source and destination IPs from the packet counts of an interval.
+ * Sets the number of novel source and destination IPs.
+ * @param counts The packet counts collected by collectIntervalIPsPktsCounts.
+ * @return a vector: contains source IP entropy and destination IP entropy.
+ */
+std::vector<double> statistics::calculateIPsEntropy(const entry_shardIntervalStat &counts) {
+    long srcHosts, dstHosts, srcNovelHosts, dstNovelHosts;
+    long pktsSent = sumCounts(counts.ip_src_pkts_counts, srcHosts);
+    long pktsReceived = sumCounts(counts.ip_dst_pkts_counts, dstHosts);
+    long novelPktsSent = sumCounts(counts.ip_src_novel_pkts_counts, srcNovelHosts);
+    long novelPktsReceived = sumCounts(counts.ip_dst_novel_pkts_counts, dstNovelHosts);
+
+    double IPsSrcEntropy = calculateCountsEntropy(counts.ip_src_pkts_counts, pktsSent);
+    double IPsDstEntropy = calculateCountsEntropy(counts.ip_dst_pkts_counts, pktsReceived);
+    double IPsSrcNovelEntropy = calculateCountsEntropy(counts.ip_src_novel_pkts_counts, novelPktsSent);
+    double IPsDstNovelEntropy = calculateCountsEntropy(counts.ip_dst_novel_pkts_counts, novelPktsReceived);
+
+    this->ip_src_novel_count = srcNovelHosts;
+    this->ip_dst_novel_count = dstNovelHosts;
+
+    std::vector<double> entropies = {IPsSrcEntropy, IPsDstEntropy, IPsSrcNovelEntropy, IPsDstNovelEntropy,
+                                     normalizeEntropy(IPsSrcEntropy, srcHosts), normalizeEntropy(IPsDstEntropy, dstHosts),
+                                     normalizeEntropy(IPsSrcNovelEntropy, srcNovelHosts),
+                                     normalizeEntropy(IPsDstNovelEntropy, dstNovelHosts)};
+    return entropies;
 }
 
 /**
@@ -164,97 +186,210 @@ std::vector<double> statistics::calculateLastIntervalIPsEntropy(std::chrono::mic
  */
 std::vector<double> statistics::calculateIPsCumEntropy(){
     if(this->getDoExtraTests()) {
-        std::vector <std::string> IPs;
-        std::vector <double> IPsSrcProb;
-        std::vector <double> IPsDstProb;
+        entry_shardIntervalStat counts;
+        collectIPsCumPktsCounts(counts);
+        return calculateIPsCumEntropy(counts);
+    }
+    else {
+        return {-1, -1, -1, -1};
+    }
+}
 
-        for (auto i = ip_statistics.begin(); i != ip_statistics.end(); i++) {
-            IPs.push_back(i->first);
-            IPsSrcProb.push_back(static_cast<double>(i->second.pkts_sent)/static_cast<double>(packetCount));
-            IPsDstProb.push_back(static_cast<double>(i->second.pkts_received)/static_cast<double>(packetCount));
-        }
+/**
+ * Collects the number of packets every IP sent and received since the start of the capture, which countIntervalIPs
+ * updated for the IPs of the interval.
+ * @param counts Its cumulative packet counts, number of IPs and number of packets are set.
+ */
+void statistics::collectIPsCumPktsCounts(entry_shardIntervalStat &counts) {
+    counts.ip_count = ip_statistics.size();
+    counts.packet_count = packetCount;
+    counts.ip_src_cum_pkts_counts = intervalCumIPSrcPktsCounts;
+    counts.ip_dst_cum_pkts_counts = intervalCumIPDstPktsCounts;
+}
 
-        // Calculate IP source entropy
-        double IPsSrcEntropy = 0;
-        for(unsigned i=0; i < IPsSrcProb.size();i++){
-            if (IPsSrcProb[i] > 0)
-                IPsSrcEntropy += - IPsSrcProb[i]*log2(IPsSrcProb[i]);
-        }
+/**
+ * Calculates the cumulative source and destination IP entropy.
+ * @param counts The cumulative packet counts, number of IPs and number of packets collected by collectIPsCumPktsCounts.
+ * @return a vector: contains the cumulative entropies of source and destination IPs
+ */
+std::vector<double> statistics::calculateIPsCumEntropy(const entry_shardIntervalStat &counts) {
+    double IPsSrcEntropy = calculateCountsEntropy(counts.ip_src_cum_pkts_counts, counts.packet_count);
+    double IPsDstEntropy = calculateCountsEntropy(counts.ip_dst_cum_pkts_counts, counts.packet_count);
+    long hosts = static_cast<long>(counts.ip_count);
+
+    std::vector<double> entropies = {IPsSrcEntropy, IPsDstEntropy, normalizeEntropy(IPsSrcEntropy, hosts),
+                                     normalizeEntropy(IPsDstEntropy, hosts)};
+    return entropies;
+}
 
-        // Calculate IP destination entropy
-        double IPsDstEntropy = 0;
-        for(unsigned i=0; i < IPsDstProb.size();i++){
-            if (IPsDstProb[i] > 0)
-                IPsDstEntropy += - IPsDstProb[i]*log2(IPsDstProb[i]);
-        }
+/**
+ * Adds the packet and kbyte rate of an IP in a time interval to its min and max rates. A rate of 0 is not taken as
+ * min or max, but resets the min rate.
+ * @param ipStat The statistics of the IP.
+ * @param interval_pkt_rate The packet rate of the IP in the interval.
+ * @param interval_kbyte_rate The kbyte rate of the IP in the interval.
+ */
+static void updateIntervalRates(entry_ipStat &ipStat, float interval_pkt_rate, float interval_kbyte_rate) {
+    // save interval pkt rate and min, max if applicable
+    if (interval_pkt_rate > ipStat.max_interval_pkt_rate || ipStat.max_interval_pkt_rate == 0) {
+        ipStat.max_interval_pkt_rate = interval_pkt_rate;
+    }
+    if (interval_pkt_rate < ipStat.min_interval_pkt_rate || ipStat.min_interval_pkt_rate == 0) {
+        ipStat.min_interval_pkt_rate = interval_pkt_rate;
+    }
+
+    // save interval kbyte rate and min, max if applicable
+    if (interval_kbyte_rate > ipStat.max_interval_kybte_rate || ipStat.max_interval_kybte_rate == 0) {
+        ipStat.max_interval_kybte_rate = interval_kbyte_rate;
+    }
+    if (interval_kbyte_rate < ipStat.min_interval_kybte_rate || ipStat.min_interval_kybte_rate == 0) {
+        ipStat.min_interval_kybte_rate = interval_kbyte_rate;
+    }
+}
 
-        double norm_src_entropy = 0;
-        if (IPsSrcProb.size() > 0 && log2(IPsDstProb.size()) > 0) {
-            norm_src_entropy = IPsSrcEntropy / log2(IPsSrcProb.size());
+/**
+ * Finds the counters of an interval length in the statistics of the IPs. The counters of a new interval length are
+ * added with everything the IPs sent so far, which all lies in its first interval.
+ * @param interval The interval length in microseconds.
+ * @return the index of the interval length in rateIntervals and entry_ipStat::interval_counts.
+ */
+std::size_t statistics::findRateInterval(int interval) {
+    for (std::size_t j = 0; j < rateIntervals.size(); j++) {
+        if (rateIntervals[j] == interval)
+            return j;
+    }
+    rateIntervals.push_back(interval);
+    rateIntervalSenders.emplace_back();
+    for (auto &ip: ip_statistics) {
+        if (ip.second.pkts_sent > 0) {
+            ip.second.interval_counts.resize(rateIntervals.size());
+            ip.second.interval_counts.back() = {ip.second.pkts_sent, ip.second.bytes_sent};
+            rateIntervalSenders.back().push_back(ip.first);
         }
-        double norm_dst_entropy = 0;
-        if (IPsDstProb.size() > 0 && log2(IPsDstProb.size()) > 0) {
-            norm_dst_entropy = IPsDstEntropy / log2(IPsDstProb.size());
+    }
+    return rateIntervals.size() - 1;
+}
+
+/**
+ * Collects the IPs which sent in the current intervals and the IPs with a min rate other than 0 from the statistics
+ * of all IPs, after they were merged or restored.
+ */
+void statistics::collectRateIPs() {
+    rateIntervalSenders.assign(rateIntervals.size(), std::vector<address_id>());
+    ratedIPs.clear();
+    for (auto &ip: ip_statistics) {
+        for (std::size_t j = 0; j < ip.second.interval_counts.size(); j++) {
+            if (ip.second.interval_counts[j].pkts_sent > 0)
+                rateIntervalSenders[j].push_back(ip.first);
         }
+        if (ip.second.min_interval_pkt_rate != 0 || ip.second.min_interval_kybte_rate != 0)
+            ratedIPs.push_back(ip.first);
+    }
+}
 
-        std::vector<double> entropies = {IPsSrcEntropy, IPsDstEntropy, norm_src_entropy, norm_dst_entropy};
-        return entropies;
+/**
+ * Moves an IP from the number of IPs with one packet count to the number of IPs with another packet count.
+ * Packet counts of 0 are not counted.
+ * @param hostCounts The number of IPs per packet count.
+ * @param from The previous packet count of the IP.
+ * @param to The current packet count of the IP.
+ */
+static void moveHostCount(std::map<long, long> &hostCounts, long from, long to) {
+    if (from == to) {
+        return;
     }
-    else {
-        return {-1, -1, -1, -1};
+    if (from > 0) {
+        auto count = hostCounts.find(from);
+        if (--count->second == 0)
+            hostCounts.erase(count);
+    }
+    if (to > 0) {
+        hostCounts[to]++;
     }
 }
 
 /**
- * Calculates sending packet rate for each IP in a time interval. Finds min and max packet rate and adds them to ip_statistics map.
- * @param intervalStartTimestamp The timstamp where the interval starts.
+ * Adds the packets the IPs sent and received since the last interval to the number of IPs per cumulative packet
+ * count, so that they include this interval. Only the IPs which sent or received packets since then are visited.
  */
-void statistics::calculateIPIntervalPacketRate(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds intervalStartTimestamp){
-    for (auto ip = ip_statistics.begin(); ip != ip_statistics.end(); ip++) {
-        int IPsSrcPktsCount = 0;
-        float IPsSrcPktsKBytes = 0;
-
-        // iterate over all relevant pkts for the interval
-        auto pktTS = ip->second.pkts_sent_timestamp.begin();
-        auto kbytes = ip->second.pkts_kbytes.begin();
-        for (; pktTS != ip->second.pkts_sent_timestamp.end() && kbytes != ip->second.pkts_kbytes.end(); pktTS++, kbytes++) {
-            if (*pktTS >= intervalStartTimestamp) {
-                IPsSrcPktsCount++;
-                IPsSrcPktsKBytes += *kbytes;
-            }
-        }
+void statistics::countIntervalIPs() {
+    for (address_id ipAddress: intervalIPs) {
+        const entry_ipStat &ipStat = ip_statistics.find(ipAddress)->second;
+        moveHostCount(intervalCumIPSrcPktsCounts, ipStat.pkts_sent - ipStat.interval_pkts_sent, ipStat.pkts_sent);
+        moveHostCount(intervalCumIPDstPktsCounts, ipStat.pkts_received - ipStat.interval_pkts_received,
+                      ipStat.pkts_received);
+    }
+}
 
-        // multiply by 10^6 because interval count is in microseconds
-        float interval_pkt_rate = static_cast<float>(IPsSrcPktsCount) * 1000000 / interval.count();
-        float interval_kbyte_rate = IPsSrcPktsKBytes * 100000 / interval.count();
+/**
+ * Starts the next interval for the IPs which sent or received packets since the last interval.
+ */
+void statistics::clearIntervalIPs() {
+    for (address_id ipAddress: intervalIPs) {
+        entry_ipStat &ipStat = ip_statistics.find(ipAddress)->second;
+        ipStat.interval_pkts_sent = 0;
+        ipStat.interval_pkts_received = 0;
+        ipStat.interval_bytes_sent = 0;
+    }
+    intervalIPs.clear();
+}
 
-        // save interval pkt rate and min, max if applicable
-        ip->second.interval_pkt_rate.push_back(interval_pkt_rate);
-        if (interval_pkt_rate > ip->second.max_interval_pkt_rate || ip->second.max_interval_pkt_rate == 0) {
-            ip->second.max_interval_pkt_rate = interval_pkt_rate;
-        }
-        if (interval_pkt_rate < ip->second.min_interval_pkt_rate || ip->second.min_interval_pkt_rate == 0) {
-            ip->second.min_interval_pkt_rate = interval_pkt_rate;
-        }
+/**
+ * Collects the IPs which sent or received packets since the last interval and the number of IPs per cumulative packet
+ * count up to the last interval from the statistics of all IPs, after they were merged or restored.
+ */
+void statistics::collectIntervalIPs() {
+    intervalIPs.clear();
+    intervalCumIPSrcPktsCounts.clear();
+    intervalCumIPDstPktsCounts.clear();
+    for (auto &ip: ip_statistics) {
+        if (ip.second.interval_pkts_sent != 0 || ip.second.interval_pkts_received != 0)
+            intervalIPs.push_back(ip.first);
+        moveHostCount(intervalCumIPSrcPktsCounts, 0, ip.second.pkts_sent - ip.second.interval_pkts_sent);
+        moveHostCount(intervalCumIPDstPktsCounts, 0, ip.second.pkts_received - ip.second.interval_pkts_received);
+    }
+}
 
-        // save interval kbyte rate and min, max if applicable
-        ip->second.interval_kbyte_rate.push_back(interval_kbyte_rate);
-        if (interval_kbyte_rate > ip->second.max_interval_kybte_rate || ip->second.max_interval_kybte_rate == 0) {
-            ip->second.max_interval_kybte_rate = interval_kbyte_rate;
-        }
-        if (interval_kbyte_rate < ip->second.min_interval_kybte_rate || ip->second.min_interval_kybte_rate == 0) {
-            ip->second.min_interval_kybte_rate = interval_kbyte_rate;
-        }
+/**
+ * Calculates sending packet rate for each IP in a time interval. Finds min and max packet rate and adds them to ip_statistics map.
+ * Only the IPs which sent in the interval and the IPs whose min rate the interval resets to 0 are visited, the packets
+ * and kbytes they sent are counted when the packets are added.
+ * @param interval The length of the interval.
+ */
+void statistics::calculateIPIntervalPacketRate(std::chrono::duration<int, std::micro> interval){
+    std::size_t j = findRateInterval(interval.count());
+
+    // An IP which did not send in the interval has the rate 0, which only changes a min rate other than 0
+    for (address_id ipAddress: ratedIPs) {
+        entry_ipStat &ipStat = ip_statistics[ipAddress];
+        if (ipStat.interval_counts[j].pkts_sent == 0)
+            updateIntervalRates(ipStat, 0, 0);
     }
+
+    std::vector<address_id> &senders = rateIntervalSenders[j];
+    for (address_id ipAddress: senders) {
+        entry_ipStat &ipStat = ip_statistics[ipAddress];
+        entry_ipIntervalCount &count = ipStat.interval_counts[j];
+
+        // multiply by 10^6 because interval count is in microseconds
+        float interval_pkt_rate = static_cast<float>(count.pkts_sent) * 1000000 / interval.count();
+        float interval_kbyte_rate = static_cast<float>(count.bytes_sent) / 1024 * 100000 / interval.count();
+        updateIntervalRates(ipStat, interval_pkt_rate, interval_kbyte_rate);
+        count = {0, 0};
+    }
+
+    // Only the IPs which sent in this interval are left with a min rate other than 0
+    ratedIPs.swap(senders);
+    senders.clear();
 }
 
 /**
  * Calculates the entropies for the count of integer values.
- * @param current map containing the values with counts
- * @param an old map containing the values with counts (from last iteration)
+ * @param values the counts of all values
+ * @param old the counts of all values from the last iteration, empty if no value was counted then
  * @return a vector containing the calculated entropies: entropy of all updated values, entropy of all novel values, normalized entropy of all, normalized entropy of novel
  */
-std::vector<double> statistics::calculateEntropies(std::unordered_map<int, int> &map, std::unordered_map<int, int> &old) {
+std::vector<double> statistics::calculateEntropies(const std::vector<int> &values, const std::vector<int> &old) {
     std::vector<double> counts;
     int count_total = 0;
     double entropy = 0.0;
@@ -264,21 +399,24 @@ std::vector<double> statistics::calculateEntropies(std::unordered_map<int, int>
     double novel_entropy = 0.0;
 
     // iterate over all values
-    for (auto iter: map) {
-        if (old.count(iter.first) == 0) {
+    for (std::size_t value = 0; value < values.size(); value++) {
+        int current = values[value];
+        int previous = old.empty() ? 0 : old[value];
+        if (current == 0) {
+            continue;
+        }
+        if (previous == 0) {
             // count novel values
-            double novel_count = static_cast<double>(iter.second);
+            double novel_count = static_cast<double>(current);
             counts.push_back(novel_count);
             count_total += novel_count;
             novel_counts.push_back(novel_count);
             novel_count_total += novel_count;
-        } else if (iter.second != old[iter.first]) {
+        } else if (current != previous) {
             // count all increased values
-            double count = static_cast<double>(iter.second-old[iter.first]);
-            if (count != 0.0) {
-                counts.push_back(count);
-                count_total += count;
-            }
+            double count = static_cast<double>(current - previous);
+            counts.push_back(count);
+            count_total += count;
         }
     }
 
@@ -313,12 +451,34 @@ std::vector<double> statistics::calculateEntropies(std::unordered_map<int, int>
  * @param previousPacketCount The total number of packets in last interval.
  */
 void statistics::addIntervalStat(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds intervalStartTimestamp, std::chrono::microseconds intervalEndTimestamp){
+    // The rates, novel values and entropies of a deferred interval are calculated when it is merged
+    if (deferredIntervals) {
+        interval_deltas.push_back(getIntervalDelta(interval, intervalStartTimestamp, intervalEndTimestamp));
+        resetIntervalState();
+        return;
+    }
+
     // Add packet rate for each IP to ip_statistics map
-    calculateIPIntervalPacketRate(interval, intervalStartTimestamp);
+    calculateIPIntervalPacketRate(interval);
+    countIntervalIPs();
 
-    std::vector<double> ipEntopies = calculateLastIntervalIPsEntropy(intervalStartTimestamp);
-    std::vector<double> ipCumEntopies = calculateIPsCumEntropy();
     std::string lastPktTimestamp_s = std::to_string(intervalEndTimestamp.count());
+    std::vector<double> ipEntopies;
+    std::vector<double> ipCumEntopies;
+    if (shardCount == 1) {
+        ipEntopies = calculateLastIntervalIPsEntropy();
+        ipCumEntopies = calculateIPsCumEntropy();
+    } else {
+        // The IP entropies depend on the hosts of all shards, they are calculated when the shards are combined
+        entry_shardIntervalStat partial = {};
+        collectIntervalIPsPktsCounts(partial);
+        collectIPsCumPktsCounts(partial);
+        shard_interval_statistics.push_back(partial);
+        clearIntervalIPs();
+        if (!ownsCaptureCounters())
+            return;
+        shard_interval_keys.push_back(lastPktTimestamp_s);
+    }
     std::string  intervalStartTimestamp_s = std::to_string(intervalStartTimestamp.count());
 
     // The intervalStartTimestamp_s is the previous interval lastPktTimestamp_s
@@ -333,20 +493,34 @@ void statistics::addIntervalStat(std::chrono::duration<int, std::micro> interval
     interval_statistics[lastPktTimestamp_s].payload_count = payloadCount - intervalPayloadCount;
     interval_statistics[lastPktTimestamp_s].incorrect_tcp_checksum_count = incorrectTCPChecksumCount - intervalIncorrectTCPChecksumCount;
     interval_statistics[lastPktTimestamp_s].correct_tcp_checksum_count = correctTCPChecksumCount - intervalCorrectTCPChecksumCount;
-    interval_statistics[lastPktTimestamp_s].novel_ip_src_count = this->ip_src_novel_count;
-    interval_statistics[lastPktTimestamp_s].novel_ip_dst_count = this->ip_dst_novel_count;
+    if (shardCount == 1) {
+        interval_statistics[lastPktTimestamp_s].novel_ip_src_count = this->ip_src_novel_count;
+        interval_statistics[lastPktTimestamp_s].novel_ip_dst_count = this->ip_dst_novel_count;
+    }
     interval_statistics[lastPktTimestamp_s].novel_ttl_count = static_cast<int>(ttl_values.size()) - intervalCumNovelTTLCount;
     interval_statistics[lastPktTimestamp_s].novel_win_size_count = static_cast<int>(win_values.size()) - intervalCumNovelWinSizeCount;
     interval_statistics[lastPktTimestamp_s].novel_tos_count = static_cast<int>(tos_values.size()) - intervalCumNovelToSCount;
     interval_statistics[lastPktTimestamp_s].novel_mss_count = static_cast<int>(mss_values.size()) - intervalCumNovelMSSCount;
     interval_statistics[lastPktTimestamp_s].novel_port_count = static_cast<int>(port_values.size()) - intervalCumNovelPortCount;
 
-    interval_statistics[lastPktTimestamp_s].ttl_entropies = calculateEntropies(ttl_values, intervalCumTTLValues);
-    interval_statistics[lastPktTimestamp_s].win_size_entropies = calculateEntropies(win_values, intervalCumWinSizeValues);
-    interval_statistics[lastPktTimestamp_s].tos_entropies = calculateEntropies(tos_values, intervalCumTosValues);
-    interval_statistics[lastPktTimestamp_s].mss_entropies = calculateEntropies(mss_values, intervalCumMSSValues);
-    interval_statistics[lastPktTimestamp_s].port_entropies = calculateEntropies(port_values, intervalCumPortValues);
+    interval_statistics[lastPktTimestamp_s].ttl_entropies = calculateEntropies(ttl_values.get_counts(), intervalCumTTLValues.get_counts());
+    interval_statistics[lastPktTimestamp_s].win_size_entropies = calculateEntropies(win_values.get_counts(), intervalCumWinSizeValues.get_counts());
+    interval_statistics[lastPktTimestamp_s].tos_entropies = calculateEntropies(tos_values.get_counts(), intervalCumTosValues.get_counts());
+    interval_statistics[lastPktTimestamp_s].mss_entropies = calculateEntropies(mss_values.get_counts(), intervalCumMSSValues.get_counts());
+    interval_statistics[lastPktTimestamp_s].port_entropies = calculateEntropies(port_values.get_counts(), intervalCumPortValues.get_counts());
+
+    resetIntervalState();
+
+    if (shardCount == 1) {
+        interval_statistics[lastPktTimestamp_s].ip_entropies = ipEntopies;
+        interval_statistics[lastPktTimestamp_s].ip_cum_entropies = ipCumEntopies;
+    }
+}
 
+/**
+ * Starts the next time interval: the packets counted so far lie before it.
+ */
+void statistics::resetIntervalState() {
     intervalPayloadCount = payloadCount;
     intervalIncorrectTCPChecksumCount = incorrectTCPChecksumCount;
     intervalCorrectTCPChecksumCount = correctTCPChecksumCount;
@@ -358,15 +532,143 @@ void statistics::addIntervalStat(std::chrono::duration<int, std::micro> interval
     intervalCumNovelToSCount =static_cast<int>(tos_values.size());
     intervalCumNovelMSSCount = static_cast<int>(mss_values.size());
     intervalCumNovelPortCount = static_cast<int>(port_values.size());
-    intervalCumIPStats = ip_statistics;
+    clearIntervalIPs();
     intervalCumTTLValues = ttl_values;
     intervalCumWinSizeValues = win_values;
     intervalCumTosValues = tos_values;
     intervalCumMSSValues = mss_values;
     intervalCumPortValues = port_values;
+}
+
+/**
+ * Collects the values whose counts changed since the last interval, with the change of their count.
+ * @param deltas The values and changes of their counts are appended to this vector.
+ * @param values The counts of the values.
+ * @param intervalValues The counts of the values at the last interval.
+ */
+template<uint32_t Width>
+static void collectValueDeltas(std::vector<std::pair<uint32_t, int>> &deltas, const dense_histogram<Width> &values,
+                               const dense_histogram<Width> &intervalValues) {
+    const std::vector<int> &counts = values.get_counts();
+    const std::vector<int> &intervalCounts = intervalValues.get_counts();
+    for (std::size_t value = 0; value < counts.size(); value++) {
+        int count = counts[value] - (intervalCounts.empty() ? 0 : intervalCounts[value]);
+        if (count != 0)
+            deltas.push_back(std::make_pair(static_cast<uint32_t>(value), count));
+    }
+}
+
+/**
+ * Returns what the packets since the last interval added to the statistics.
+ * @param interval The length of the interval.
+ * @param intervalStartTimestamp The timestamp where the interval starts.
+ * @param intervalEndTimestamp The timestamp where the interval ends.
+ * @return the deferred interval.
+ */
+entry_intervalDelta statistics::getIntervalDelta(std::chrono::duration<int, std::micro> interval,
+                                                 std::chrono::microseconds intervalStartTimestamp,
+                                                 std::chrono::microseconds intervalEndTimestamp) const {
+    entry_intervalDelta delta = {};
+    delta.interval = interval;
+    delta.start = intervalStartTimestamp;
+    delta.end = intervalEndTimestamp;
+    delta.pkts_count = packetCount - intervalCumPktCount;
+    delta.bytes = sumPacketSize - intervalCumSumPktSize;
+    delta.payload_count = payloadCount - intervalPayloadCount;
+    delta.incorrect_tcp_checksum_count = incorrectTCPChecksumCount - intervalIncorrectTCPChecksumCount;
+    delta.correct_tcp_checksum_count = correctTCPChecksumCount - intervalCorrectTCPChecksumCount;
+    for (address_id ipAddress: intervalIPs) {
+        const entry_ipStat &ipStat = ip_statistics.find(ipAddress)->second;
+        entry_ipIntervalDelta ipDelta = {ipStat.interval_pkts_sent, ipStat.interval_pkts_received,
+                                         ipStat.interval_bytes_sent};
+        delta.ips.push_back(std::make_pair(ipAddress, ipDelta));
+    }
+    collectValueDeltas(delta.ttl_values, ttl_values, intervalCumTTLValues);
+    collectValueDeltas(delta.win_values, win_values, intervalCumWinSizeValues);
+    collectValueDeltas(delta.tos_values, tos_values, intervalCumTosValues);
+    collectValueDeltas(delta.mss_values, mss_values, intervalCumMSSValues);
+    collectValueDeltas(delta.port_values, port_values, intervalCumPortValues);
+    return delta;
+}
 
-    interval_statistics[lastPktTimestamp_s].ip_entropies = ipEntopies;
-    interval_statistics[lastPktTimestamp_s].ip_cum_entropies = ipCumEntopies;
+/**
+ * Adds the changes of value counts collected by collectValueDeltas.
+ * @param values The counts of the values.
+ * @param deltas The values and changes of their counts.
+ */
+template<uint32_t Width>
+static void addValueDeltas(dense_histogram<Width> &values, const std::vector<std::pair<uint32_t, int>> &deltas) {
+    for (auto &delta: deltas) {
+        values.add(delta.first, delta.second);
+    }
+}
+
+/**
+ * Adds what the packets of a deferred interval added to other statistics, as if they had been processed here.
+ * @param delta The deferred interval.
+ * @param remap The ids of the addresses of the other statistics in this object, see address_table::import.
+ */
+void statistics::addIntervalDelta(const entry_intervalDelta &delta, const std::vector<address_id> &remap) {
+    packetCount += delta.pkts_count;
+    sumPacketSize += delta.bytes;
+    payloadCount += delta.payload_count;
+    incorrectTCPChecksumCount += delta.incorrect_tcp_checksum_count;
+    correctTCPChecksumCount += delta.correct_tcp_checksum_count;
+    addValueDeltas(ttl_values, delta.ttl_values);
+    addValueDeltas(win_values, delta.win_values);
+    addValueDeltas(tos_values, delta.tos_values);
+    addValueDeltas(mss_values, delta.mss_values);
+    addValueDeltas(port_values, delta.port_values);
+
+    for (auto &ip: delta.ips) {
+        address_id ipAddress = remap[ip.first];
+        entry_ipStat &ipStat = ip_statistics[ipAddress];
+        const entry_ipIntervalDelta &ipDelta = ip.second;
+        if (ipStat.interval_pkts_sent == 0 && ipStat.interval_pkts_received == 0)
+            intervalIPs.push_back(ipAddress);
+        ipStat.pkts_sent += ipDelta.pkts_sent;
+        ipStat.pkts_received += ipDelta.pkts_received;
+        ipStat.bytes_sent += ipDelta.bytes_sent;
+        ipStat.interval_pkts_sent += ipDelta.pkts_sent;
+        ipStat.interval_pkts_received += ipDelta.pkts_received;
+        ipStat.interval_bytes_sent += ipDelta.bytes_sent;
+        if (ipDelta.pkts_sent == 0)
+            continue;
+
+        // Count the packets for the current interval of every length
+        ipStat.interval_counts.resize(rateIntervals.size());
+        for (std::size_t j = 0; j < rateIntervals.size(); j++) {
+            if (ipStat.interval_counts[j].pkts_sent == 0)
+                rateIntervalSenders[j].push_back(ipAddress);
+            ipStat.interval_counts[j].pkts_sent += ipDelta.pkts_sent;
+            ipStat.interval_counts[j].bytes_sent += ipDelta.bytes_sent;
+        }
+    }
+}
+
+/**
+ * Enables deferring the time intervals: instead of registering an interval, addIntervalStat records what the packets
+ * of the interval added, and merge registers the recorded intervals. Has to be set before the first packet.
+ * @param enabled Whether the intervals are deferred.
+ */
+void statistics::setDeferredIntervals(bool enabled) {
+    deferredIntervals = enabled;
+}
+
+/**
+ * Lets the first deferred interval of a length start earlier, when it continues an interval of the packets before.
+ * @param interval The length of the interval.
+ * @param start The timestamp where the interval starts.
+ * @return false if there is no deferred interval of the length.
+ */
+bool statistics::continueDeferredInterval(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds start) {
+    for (entry_intervalDelta &delta: interval_deltas) {
+        if (delta.interval == interval) {
+            delta.start = start;
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
@@ -380,8 +682,14 @@ void statistics::storeConvStat(conv *conversation, const std::chrono::microsecon
     if ((conv_statistics[*conversation].pkts_timestamp.size() || conv_statistics[*conversation].pkts_timestamp.size() > 0) && conv_statistics[*conversation].pkts_count <= 3) {
         auto interarrival_time = std::chrono::duration_cast<std::chrono::microseconds>(timestamp - conv_statistics[*conversation].pkts_timestamp.back());
         conv_statistics[*conversation].interarrival_time.push_back(interarrival_time);
-        ip_statistics[conversation->ipAddressA].interarrival_times.push_back(interarrival_time);
-        ip_statistics[conversation->ipAddressB].interarrival_times.push_back(interarrival_time);
+        if (shardCount == 1) {
+            ip_statistics[conversation->ipAddressA].interarrival_times.push_back(interarrival_time);
+            ip_statistics[conversation->ipAddressB].interarrival_times.push_back(interarrival_time);
+        } else {
+            // Keep the packet number, so the times of all shards can be put in packet order when combining
+            shard_ip_updates[conversation->ipAddressA].interarrival_times.emplace_back(packetCount, interarrival_time);
+            shard_ip_updates[conversation->ipAddressB].interarrival_times.emplace_back(packetCount, interarrival_time);
+        }
     }
     conv_statistics[*conversation].pkts_timestamp.push_back(timestamp);
     conv_statistics[*conversation].tcp_types.push_back(*flags);
@@ -398,7 +706,10 @@ void statistics::storeConvStat(conv *conversation, const std::chrono::microsecon
  * @param timestamp The timestamp of the packet.
  * @param flags TCP flags in one hot encode.
  */
-void statistics::addConvStat(const std::string &ipAddressSender,int sport,const std::string &ipAddressReceiver,int dport, std::chrono::microseconds timestamp, small_uint<12> flags) {
+void statistics::addConvStat(address_id ipAddressSender,int sport,address_id ipAddressReceiver,int dport, std::chrono::microseconds timestamp, small_uint<12> flags) {
+    if (!ownsHostPair(ipAddressSender, ipAddressReceiver))
+        return;
+
     conv f1 = {ipAddressReceiver, dport, ipAddressSender, sport};
     conv f2 = {ipAddressSender, sport, ipAddressReceiver, dport};
 
@@ -423,8 +734,8 @@ void statistics::addConvStat(const std::string &ipAddressSender,int sport,const
  * @param protocol The used protocol.
  * @param timestamp The timestamp of the packet.
  */
-void statistics::addConvStatExt(const std::string &ipAddressSender,int sport,const std::string &ipAddressReceiver,int dport,const std::string &protocol, std::chrono::microseconds timestamp){
-    if(this->getDoExtraTests()) {
+void statistics::addConvStatExt(address_id ipAddressSender,int sport,address_id ipAddressReceiver,int dport,const std::string &protocol, std::chrono::microseconds timestamp){
+    if(this->getDoExtraTests() && ownsHostPair(ipAddressSender, ipAddressReceiver)) {
         convWithProt f1 = {ipAddressReceiver, dport, ipAddressSender, sport, protocol};
         convWithProt f2 = {ipAddressSender, sport, ipAddressReceiver, dport, protocol};
         convWithProt f;
@@ -469,6 +780,40 @@ void statistics::addConvStatExt(const std::string &ipAddressSender,int sport,con
     }
 }
 
+/**
+ * Aggregate the collected information about all communication intervals of a conversation.
+ * @param entry The extended statistics of the conversation.
+ */
+static void aggregateCommIntervals(entry_convStatExt &entry) {
+    std::vector<commInterval> &intervals = entry.comm_intervals;
+
+    // if there is only one interval, the time between intervals cannot be computed and is therefore set to 0
+    if (intervals.size() == 1){
+        double interval_duration = (double) (intervals[0].end - intervals[0].start).count() / (double) 1e6;
+        entry.avg_int_pkts_count = (double) intervals[0].pkts_count;
+        entry.avg_time_between_ints = (double) 0;
+        entry.avg_interval_time = interval_duration;
+    }
+    // If there is more than one interval, compute the specified averages
+    else if (intervals.size() > 1){
+        long summed_pkts_count = intervals[0].pkts_count;
+        std::chrono::microseconds time_between_ints_sum = (std::chrono::microseconds) 0;
+        std::chrono::microseconds summed_int_duration = intervals[0].end - intervals[0].start;
+
+        for (std::size_t i = 1; i < intervals.size(); i++) {
+            summed_pkts_count += intervals[i].pkts_count;
+            summed_int_duration += intervals[i].end - intervals[i].start;
+            time_between_ints_sum += intervals[i].start - intervals[i - 1].end;
+        }
+
+        entry.avg_int_pkts_count = static_cast<double>(summed_pkts_count) / static_cast<double>(intervals.size());
+        entry.avg_time_between_ints = (time_between_ints_sum.count() / (double) (intervals.size() - 1)) / (double) 1e6;
+        entry.avg_interval_time = (summed_int_duration.count() / (double) intervals.size()) / (double) 1e6;
+
+    }
+    entry.total_comm_duration = (double) (entry.pkts_timestamp.back() - entry.pkts_timestamp.front()).count() / (double) 1e6;
+}
+
 /**
  * Aggregate the collected information about all communication intervals within conv_statistics_extended of every conversation.
  * Do this by computing the average packet rate per interval and the average time between intervals.
@@ -477,34 +822,7 @@ void statistics::addConvStatExt(const std::string &ipAddressSender,int sport,con
 void statistics::createCommIntervalStats(){
     // iterate over all <convWithProt, entry_convStatExt> pairs
     for (auto &cur_elem : conv_statistics_extended) {
-        entry_convStatExt &entry = cur_elem.second;
-        std::vector<commInterval> &intervals = entry.comm_intervals;
-
-        // if there is only one interval, the time between intervals cannot be computed and is therefore set to 0
-        if (intervals.size() == 1){
-            double interval_duration = (double) (intervals[0].end - intervals[0].start).count() / (double) 1e6;
-            entry.avg_int_pkts_count = (double) intervals[0].pkts_count;
-            entry.avg_time_between_ints = (double) 0;
-            entry.avg_interval_time = interval_duration;
-        }
-        // If there is more than one interval, compute the specified averages
-        else if (intervals.size() > 1){
-            long summed_pkts_count = intervals[0].pkts_count;
-            std::chrono::microseconds time_between_ints_sum = (std::chrono::microseconds) 0;
-            std::chrono::microseconds summed_int_duration = intervals[0].end - intervals[0].start;
-
-            for (std::size_t i = 1; i < intervals.size(); i++) {
-                summed_pkts_count += intervals[i].pkts_count;
-                summed_int_duration += intervals[i].end - intervals[i].start;
-                time_between_ints_sum += intervals[i].start - intervals[i - 1].end;
-            }
-
-            entry.avg_int_pkts_count = static_cast<double>(summed_pkts_count) / static_cast<double>(intervals.size());
-            entry.avg_time_between_ints = (time_between_ints_sum.count() / (double) (intervals.size() - 1)) / (double) 1e6;
-            entry.avg_interval_time = (summed_int_duration.count() / (double) intervals.size()) / (double) 1e6;
-
-        }
-        entry.total_comm_duration = (double) (entry.pkts_timestamp.back() - entry.pkts_timestamp.front()).count() / (double) 1e6;
+        aggregateCommIntervals(cur_elem.second);
     }
 }
 
@@ -513,9 +831,15 @@ void statistics::createCommIntervalStats(){
  * @param ipAddress The IP address whose MSS packet counter should be incremented.
  * @param mssValue The MSS value of the packet.
  */
-void statistics::incrementMSScount(const std::string &ipAddress, int mssValue) {
-    mss_values[mssValue]++;
-    mss_distribution[{ipAddress, mssValue}]++;
+void statistics::incrementMSScount(address_id ipAddress, int mssValue) {
+    if (ownsCaptureCounters())
+        mss_values.increment(static_cast<uint32_t>(mssValue));
+    if (!ownsHost(ipAddress))
+        return;
+    if (sketchMode)
+        sketch.add_value(SKETCH_MSS, addresses.get(ipAddress), static_cast<uint32_t>(mssValue));
+    else
+        mss_distribution[{ipAddress, static_cast<uint32_t>(mssValue)}]++;
 }
 
 /**
@@ -523,9 +847,15 @@ void statistics::incrementMSScount(const std::string &ipAddress, int mssValue) {
  * @param ipAddress The IP address whose window size packet counter should be incremented.
  * @param winSize The window size of the packet.
  */
-void statistics::incrementWinCount(const std::string &ipAddress, int winSize) {
-    win_values[winSize]++;
-    win_distribution[{ipAddress, winSize}]++;
+void statistics::incrementWinCount(address_id ipAddress, int winSize) {
+    if (ownsCaptureCounters())
+        win_values.increment(static_cast<uint32_t>(winSize));
+    if (!ownsHost(ipAddress))
+        return;
+    if (sketchMode)
+        sketch.add_value(SKETCH_WIN, addresses.get(ipAddress), static_cast<uint32_t>(winSize));
+    else
+        win_distribution[{ipAddress, static_cast<uint32_t>(winSize)}]++;
 }
 
 /**
@@ -533,9 +863,15 @@ void statistics::incrementWinCount(const std::string &ipAddress, int winSize) {
  * @param ipAddress The IP address whose TTL packet counter should be incremented.
  * @param ttlValue The TTL value of the packet.
  */
-void statistics::incrementTTLcount(const std::string &ipAddress, int ttlValue) {
-    ttl_values[ttlValue]++;
-    ttl_distribution[{ipAddress, ttlValue}]++;
+void statistics::incrementTTLcount(address_id ipAddress, int ttlValue) {
+    if (ownsCaptureCounters())
+        ttl_values.increment(static_cast<uint32_t>(ttlValue));
+    if (!ownsHost(ipAddress))
+        return;
+    if (sketchMode)
+        sketch.add_value(SKETCH_TTL, addresses.get(ipAddress), static_cast<uint32_t>(ttlValue));
+    else
+        ttl_distribution[{ipAddress, static_cast<uint32_t>(ttlValue)}]++;
 }
 
 /**
@@ -543,9 +879,15 @@ void statistics::incrementTTLcount(const std::string &ipAddress, int ttlValue) {
  * @param ipAddress The IP address whose ToS packet counter should be incremented.
  * @param tosValue The ToS value of the packet.
  */
-void statistics::incrementToScount(const std::string &ipAddress, int tosValue) {
-    tos_values[tosValue]++;
-    tos_distribution[{ipAddress, tosValue}]++;
+void statistics::incrementToScount(address_id ipAddress, int tosValue) {
+    if (ownsCaptureCounters())
+        tos_values.increment(static_cast<uint32_t>(tosValue));
+    if (!ownsHost(ipAddress))
+        return;
+    if (sketchMode)
+        sketch.add_value(SKETCH_TOS, addresses.get(ipAddress), static_cast<uint32_t>(tosValue));
+    else
+        tos_distribution[{ipAddress, static_cast<uint32_t>(tosValue)}]++;
 }
 
 /**
@@ -553,8 +895,9 @@ void statistics::incrementToScount(const std::string &ipAddress, int tosValue) {
  * @param ipAddress The IP address whose protocol packet counter should be incremented.
  * @param protocol The protocol of the packet.
  */
-void statistics::incrementProtocolCount(const std::string &ipAddress, const std::string &protocol) {
-    protocol_distribution[{ipAddress, protocol}].count++;
+void statistics::incrementProtocolCount(address_id ipAddress, const std::string &protocol) {
+    if (ownsHost(ipAddress))
+        protocol_distribution[{ipAddress, protocol}].count++;
 }
 
 /**
@@ -563,7 +906,10 @@ void statistics::incrementProtocolCount(const std::string &ipAddress, const std:
  * @param protocol The protocol whose packet count is wanted.
  */
 int statistics::getProtocolCount(const std::string &ipAddress, const std::string &protocol) {
-    return protocol_distribution[{ipAddress, protocol}].count;
+    address_id id = 0;
+    if (!addresses.find(ipAddress, id))
+        return 0;
+    return protocol_distribution[{id, protocol}].count;
 }
 
 /**
@@ -572,8 +918,9 @@ int statistics::getProtocolCount(const std::string &ipAddress, const std::string
  * @param protocol The protocol of the packet.
  * @param byteSent The packet's size.
  */
-void statistics::increaseProtocolByteCount(const std::string &ipAddress, const std::string &protocol, long bytesSent) {
-    protocol_distribution[{ipAddress, protocol}].byteCount += bytesSent;
+void statistics::increaseProtocolByteCount(address_id ipAddress, const std::string &protocol, long bytesSent) {
+    if (ownsHost(ipAddress))
+        protocol_distribution[{ipAddress, protocol}].byteCount += bytesSent;
 }
 
 /**
@@ -583,7 +930,10 @@ void statistics::increaseProtocolByteCount(const std::string &ipAddress, const s
  * @return a float: The number of bytes
  */
 float statistics::getProtocolByteCount(const std::string &ipAddress, const std::string &protocol) {
-    return protocol_distribution[{ipAddress, protocol}].byteCount;
+    address_id id = 0;
+    if (!addresses.find(ipAddress, id))
+        return 0;
+    return protocol_distribution[{id, protocol}].byteCount;
 }
 
 /**
@@ -595,12 +945,24 @@ float statistics::getProtocolByteCount(const std::string &ipAddress, const std::
  * @param ipAddressReceiver The IP address of the packet receiver.
  * @param incomingPort The port used by the receiver.
  */
-void statistics::incrementPortCount(const std::string &ipAddressSender, int outgoingPort, const std::string &ipAddressReceiver,
+void statistics::incrementPortCount(address_id ipAddressSender, int outgoingPort, address_id ipAddressReceiver,
                                     int incomingPort, const std::string &protocol) {
-    port_values[outgoingPort]++;
-    port_values[incomingPort]++;
-    ip_ports[{ipAddressSender, "out", outgoingPort, protocol}].count++;
-    ip_ports[{ipAddressReceiver, "in", incomingPort, protocol}].count++;
+    if (ownsCaptureCounters()) {
+        port_values.increment(static_cast<uint32_t>(outgoingPort));
+        port_values.increment(static_cast<uint32_t>(incomingPort));
+    }
+    bool udp = protocol == "UDP";
+    if (sketchMode) {
+        if (ownsHost(ipAddressSender))
+            sketch.add_value(SKETCH_PORT, addresses.get(ipAddressSender), statistics_sketch::encode_port(outgoingPort, false, udp));
+        if (ownsHost(ipAddressReceiver))
+            sketch.add_value(SKETCH_PORT, addresses.get(ipAddressReceiver), statistics_sketch::encode_port(incomingPort, true, udp));
+        return;
+    }
+    if (ownsHost(ipAddressSender))
+        ip_ports[{ipAddressSender, static_cast<uint16_t>(outgoingPort), false, udp}].count++;
+    if (ownsHost(ipAddressReceiver))
+        ip_ports[{ipAddressReceiver, static_cast<uint16_t>(incomingPort), true, udp}].count++;
 }
 
 /**
@@ -613,10 +975,20 @@ void statistics::incrementPortCount(const std::string &ipAddressSender, int outg
  * @param incomingPort The port used by the receiver.
  * @param byteSent The packet's size.
  */
-void statistics::increasePortByteCount(const std::string &ipAddressSender, int outgoingPort, const std::string &ipAddressReceiver,
+void statistics::increasePortByteCount(address_id ipAddressSender, int outgoingPort, address_id ipAddressReceiver,
                                        int incomingPort, long bytesSent, const std::string &protocol) {
-    ip_ports[{ipAddressSender, "out", outgoingPort, protocol}].byteCount += bytesSent;
-    ip_ports[{ipAddressReceiver, "in", incomingPort, protocol}].byteCount += bytesSent;
+    bool udp = protocol == "UDP";
+    if (sketchMode) {
+        if (ownsHost(ipAddressSender))
+            sketch.add_bytes(addresses.get(ipAddressSender), statistics_sketch::encode_port(outgoingPort, false, udp), bytesSent);
+        if (ownsHost(ipAddressReceiver))
+            sketch.add_bytes(addresses.get(ipAddressReceiver), statistics_sketch::encode_port(incomingPort, true, udp), bytesSent);
+        return;
+    }
+    if (ownsHost(ipAddressSender))
+        ip_ports[{ipAddressSender, static_cast<uint16_t>(outgoingPort), false, udp}].byteCount += bytesSent;
+    if (ownsHost(ipAddressReceiver))
+        ip_ports[{ipAddressReceiver, static_cast<uint16_t>(incomingPort), true, udp}].byteCount += bytesSent;
 }
 
 /**
@@ -627,10 +999,13 @@ void statistics::increasePortByteCount(const std::string &ipAddressSender, int o
  * @param dstMac The MAC address of the packet receiver.
  * @param typeNumber The payload type number of the packet.
  */
-void statistics::incrementUnrecognizedPDUCount(const std::string &srcMac, const std::string &dstMac, uint32_t typeNumber,
+void statistics::incrementUnrecognizedPDUCount(address_id srcMac, address_id dstMac, uint32_t typeNumber,
                                                const std::string &timestamp) {
-    unrecognized_PDUs[{srcMac, dstMac, typeNumber}].count++;
-    unrecognized_PDUs[{srcMac, dstMac, typeNumber}].timestamp_last_occurrence = timestamp;
+    if (!ownsCaptureCounters())
+        return;
+    unrecognized_PDU_stat &pduStat = unrecognized_PDUs[{srcMac, dstMac, typeNumber}];
+    pduStat.count++;
+    pduStat.timestamp_last_occurrence = timestamp;
 }
 
 /**
@@ -645,8 +1020,9 @@ statistics::statistics(std::string resourcePath) {;
  * @param ipAddress The IP address belonging to the given MAC address.
  * @param macAddress The MAC address belonging to the given IP address.
  */
-void statistics::assignMacAddress(const std::string &ipAddress, const std::string &macAddress) {
-    ip_mac_mapping[ipAddress] = macAddress;
+void statistics::assignMacAddress(address_id ipAddress, address_id macAddress) {
+    if (ownsHost(ipAddress))
+        ip_mac_mapping[ipAddress] = macAddress;
 }
 
 /**
@@ -656,47 +1032,74 @@ void statistics::assignMacAddress(const std::string &ipAddress, const std::strin
  * @param ipAddressReceiver The IP address of the packet receiver.
  * @param bytesSent The packet's size.
  */
-void statistics::addIpStat_packetSent(const std::string &ipAddressSender, const std::string &ipAddressReceiver, long bytesSent, std::chrono::microseconds timestamp) {
-    // Adding IP as a sender for first time
-    if (ip_statistics[ipAddressSender].pkts_sent==0) {
-        // Add the IP class
-        ip_statistics[ipAddressSender].ip_class = getIPv4Class(ipAddressSender);
-    }
+void statistics::addIpStat_packetSent(address_id ipAddressSender, address_id ipAddressReceiver, long bytesSent) {
+    float kbytes = (float(bytesSent) / 1024);
 
-    // Adding IP as a receiver for first time
-    if (ip_statistics[ipAddressReceiver].pkts_received==0){
-        // Add the IP class
-        ip_statistics[ipAddressReceiver].ip_class = getIPv4Class(ipAddressReceiver);
-    }
+    if (ownsHost(ipAddressSender)) {
+        // Adding IP as a sender for first time
+        if (ip_statistics[ipAddressSender].pkts_sent==0) {
+            // Add the IP class
+            ip_statistics[ipAddressSender].ip_class = getIPv4Class(addresses.get(ipAddressSender));
+        }
 
-    float kbytes = (float(bytesSent) / 1024);
+        // Update stats for packet sender
+        entry_ipStat &senderStat = ip_statistics[ipAddressSender];
+        senderStat.kbytes_sent += kbytes;
+        senderStat.bytes_sent += bytesSent;
+        senderStat.pkts_sent++;
+        if (senderStat.interval_pkts_sent++ == 0 && senderStat.interval_pkts_received == 0)
+            intervalIPs.push_back(ipAddressSender);
+        senderStat.interval_bytes_sent += bytesSent;
+
+        // Count the packet for the current interval of every length
+        senderStat.interval_counts.resize(rateIntervals.size());
+        for (std::size_t j = 0; j < rateIntervals.size(); j++) {
+            if (senderStat.interval_counts[j].pkts_sent++ == 0)
+                rateIntervalSenders[j].push_back(ipAddressSender);
+            senderStat.interval_counts[j].bytes_sent += bytesSent;
+        }
+    }
 
-    // Update stats for packet sender
-    ip_statistics[ipAddressSender].kbytes_sent += kbytes;
-    ip_statistics[ipAddressSender].pkts_kbytes.push_back(kbytes);
-    ip_statistics[ipAddressSender].pkts_sent++;
-    ip_statistics[ipAddressSender].pkts_sent_timestamp.push_back(timestamp);
+    if (ownsHost(ipAddressReceiver)) {
+        // Adding IP as a receiver for first time
+        if (ip_statistics[ipAddressReceiver].pkts_received==0){
+            // Add the IP class
+            ip_statistics[ipAddressReceiver].ip_class = getIPv4Class(addresses.get(ipAddressReceiver));
+        }
 
-    // Update stats for packet receiver
-    ip_statistics[ipAddressReceiver].kbytes_received += kbytes;
-    ip_statistics[ipAddressReceiver].pkts_kbytes.push_back(kbytes);
-    ip_statistics[ipAddressReceiver].pkts_received++;
-    ip_statistics[ipAddressReceiver].pkts_received_timestamp.push_back(timestamp);
+        // Update stats for packet receiver
+        entry_ipStat &receiverStat = ip_statistics[ipAddressReceiver];
+        receiverStat.kbytes_received += kbytes;
+        receiverStat.pkts_received++;
+        if (receiverStat.interval_pkts_received++ == 0 && receiverStat.interval_pkts_sent == 0)
+            intervalIPs.push_back(ipAddressReceiver);
+    }
 
-    if (this->getDoExtraTests()) {
+    // In sketch mode, the contacted hosts are counted by the sketch of the shard owning the host
+    if (this->getDoExtraTests() && sketchMode) {
+        if (ownsHost(ipAddressSender))
+            sketch.add_contact(addresses.get(ipAddressSender), addresses.get(ipAddressReceiver), true);
+        if (ownsHost(ipAddressReceiver))
+            sketch.add_contact(addresses.get(ipAddressReceiver), addresses.get(ipAddressSender), false);
+    } else if (this->getDoExtraTests() && ownsHostPair(ipAddressSender, ipAddressReceiver)) {
         // Increment Degrees for sender and receiver, if Sender sends its first packet to this receiver
-        std::unordered_set<std::string>::const_iterator found_receiver = contacted_ips[ipAddressSender].find(ipAddressReceiver);
+        std::unordered_set<address_id>::const_iterator found_receiver = contacted_ips[ipAddressSender].find(ipAddressReceiver);
         if(found_receiver == contacted_ips[ipAddressSender].end()){
             // Receiver is NOT contained in the List of IPs, that the Sender has contacted, therefore this is the first packet in this direction
-            ip_statistics[ipAddressSender].out_degree++;
-            ip_statistics[ipAddressReceiver].in_degree++;
+            // The degrees of hosts owned by other shards are kept aside until the shards are combined
+            int &senderOutDegree = shardCount == 1 ? ip_statistics[ipAddressSender].out_degree : shard_ip_updates[ipAddressSender].out_degree;
+            int &receiverInDegree = shardCount == 1 ? ip_statistics[ipAddressReceiver].in_degree : shard_ip_updates[ipAddressReceiver].in_degree;
+            senderOutDegree++;
+            receiverInDegree++;
 
             // Increment overall_degree only if this is the first packet for the connection (both directions)
             // Therefore check, whether Receiver has contacted Sender before
-            std::unordered_set<std::string>::const_iterator sender_contacted = contacted_ips[ipAddressReceiver].find(ipAddressSender);
+            std::unordered_set<address_id>::const_iterator sender_contacted = contacted_ips[ipAddressReceiver].find(ipAddressSender);
             if (sender_contacted == contacted_ips[ipAddressReceiver].end()) {
-                ip_statistics[ipAddressSender].overall_degree++;
-                ip_statistics[ipAddressReceiver].overall_degree++;
+                int &senderOverallDegree = shardCount == 1 ? ip_statistics[ipAddressSender].overall_degree : shard_ip_updates[ipAddressSender].overall_degree;
+                int &receiverOverallDegree = shardCount == 1 ? ip_statistics[ipAddressReceiver].overall_degree : shard_ip_updates[ipAddressReceiver].overall_degree;
+                senderOverallDegree++;
+                receiverOverallDegree++;
             }
 
             contacted_ips[ipAddressSender].insert(ipAddressReceiver);
@@ -755,7 +1158,7 @@ int statistics::getSumPacketSize() {
  */
 float statistics::getAvgPacketSize() const {
     // AvgPktSize = (Sum of all packet sizes / #Packets)
-    return (sumPacketSize / static_cast<float>(packetCount)) / 1024;
+    return (static_cast<float>(sumPacketSize) / static_cast<float>(packetCount)) / 1024;
 }
 
 /**
@@ -763,7 +1166,24 @@ float statistics::getAvgPacketSize() const {
  * @param packetSize The size of the current packet in bytes.
  */
 void statistics::addPacketSize(uint32_t packetSize) {
-    sumPacketSize += ((float) packetSize);
+    if (ownsCaptureCounters())
+        sumPacketSize += packetSize;
+}
+
+/**
+ * Enables counting the per-host distributions and degrees with sketches in bounded memory, see statistics_sketch.
+ * Has to be set before the first packet.
+ * @param enabled Whether sketch mode is enabled.
+ */
+void statistics::setSketchMode(bool enabled) {
+    sketchMode = enabled;
+}
+
+/**
+ * @return whether the per-host distributions and degrees are counted with sketches.
+ */
+bool statistics::getSketchMode() const {
+    return sketchMode;
 }
 
 /**
@@ -834,8 +1254,10 @@ std::string statistics::getFormattedTimestamp(time_t seconds, suseconds_t micros
     tv.tv_sec = seconds;
     tv.tv_usec = microseconds;
     char tmbuf[20], buf[64];
-    auto nowtm = gmtime(&(tv.tv_sec));
-    strftime(tmbuf, sizeof(tmbuf), "%Y-%m-%d %H:%M:%S", nowtm);
+    // gmtime_r, as the statistics of several chunks or shards are collected concurrently
+    tm nowtm;
+    gmtime_r(&(tv.tv_sec), &nowtm);
+    strftime(tmbuf, sizeof(tmbuf), "%Y-%m-%d %H:%M:%S", &nowtm);
     snprintf(buf, sizeof(buf), "%s.%06u", tmbuf, static_cast<uint>(tv.tv_usec));
     return std::string(buf);
 }
@@ -847,7 +1269,11 @@ std::string statistics::getFormattedTimestamp(time_t seconds, suseconds_t micros
  */
 ip_stats statistics::getStatsForIP(const std::string &ipAddress) {
     float duration = getCaptureDurationSeconds();
-    entry_ipStat ipStatEntry = ip_statistics[ipAddress];
+    entry_ipStat ipStatEntry = {};
+    address_id id = 0;
+    if (addresses.find(ipAddress, id) && ip_statistics.count(id) > 0) {
+        ipStatEntry = ip_statistics[id];
+    }
 
     ip_stats s;
     s.bandwidthKBitsIn = (ipStatEntry.kbytes_received / duration) * 8;
@@ -867,6 +1293,884 @@ void statistics::setDefaultInterval(int interval) {
     this->default_interval = interval;
 }
 
+/**
+ * Makes this object one of several shards collecting the statistics of the same packets.
+ * @param index The number of this shard, shard 0 keeps the capture-wide counters and the other shards the hosts.
+ * @param count The number of shards.
+ */
+void statistics::setShard(unsigned int index, unsigned int count) {
+    shardIndex = index;
+    shardCount = count > 0 ? count : 1;
+}
+
+/**
+ * Replaces the address ids of a key, which refer to the address dictionary of other statistics, with the ids of the
+ * same addresses in this dictionary.
+ * @param key The key of the other statistics.
+ * @param remap The ids in this dictionary, indexed by the ids in the other dictionary, see address_dictionary::import.
+ * @return the key of this statistics.
+ */
+static inline address_id remapKey(address_id key, const std::vector<address_id> &remap) {
+    return remap[key];
+}
+
+static inline conv remapKey(const conv &key, const std::vector<address_id> &remap) {
+    return {remap[key.ipAddressA], key.portA, remap[key.ipAddressB], key.portB};
+}
+
+static inline convWithProt remapKey(const convWithProt &key, const std::vector<address_id> &remap) {
+    return {remap[key.ipAddressA], key.portA, remap[key.ipAddressB], key.portB, key.protocol};
+}
+
+static inline ipAddress_value remapKey(const ipAddress_value &key, const std::vector<address_id> &remap) {
+    return {remap[key.ipAddress], key.value};
+}
+
+static inline ipAddress_protocol remapKey(const ipAddress_protocol &key, const std::vector<address_id> &remap) {
+    return {remap[key.ipAddress], key.protocol};
+}
+
+static inline ipAddress_inOut_port remapKey(const ipAddress_inOut_port &key, const std::vector<address_id> &remap) {
+    return {remap[key.ipAddress], key.portNumber, key.incoming, key.udp};
+}
+
+static inline unrecognized_PDU remapKey(const unrecognized_PDU &key, const std::vector<address_id> &remap) {
+    return {remap[key.srcMacAddress], remap[key.dstMacAddress], key.typeNumber};
+}
+
+/**
+ * Inserts the entries of other statistics, whose keys are disjoint from the keys of this statistics.
+ */
+template<typename Map>
+static void insertRemapped(Map &entries, const Map &other, const std::vector<address_id> &remap) {
+    for (auto &entry: other) {
+        entries.insert(std::make_pair(remapKey(entry.first, remap), entry.second));
+    }
+}
+
+/**
+ * Orders inter-arrival times by the number of the packet they belong to.
+ */
+static bool comparePacketNumber(const std::pair<int, std::chrono::microseconds> &a,
+                                const std::pair<int, std::chrono::microseconds> &b) {
+    return a.first < b.first;
+}
+
+/**
+ * Adds the number of hosts per packet count of a shard to the number of hosts per packet count of all shards.
+ * @param hostCounts The number of hosts per packet count of all shards.
+ * @param shardHostCounts The number of hosts per packet count of a shard.
+ */
+static void addHostCounts(std::map<long, long> &hostCounts, const std::map<long, long> &shardHostCounts) {
+    for (auto &count: shardHostCounts) {
+        hostCounts[count.first] += count.second;
+    }
+}
+
+/**
+ * Combines the statistics of the other shards into this shard, which has to be shard 0.
+ * The shards have to have processed the same packets and intervals.
+ * @param shards The other shards.
+ */
+void statistics::combineShards(const std::vector<statistics *> &shards) {
+    std::vector<statistics *> all = {this};
+    all.insert(all.end(), shards.begin(), shards.end());
+
+    // Every shard interned the addresses of its packets into its own dictionary
+    std::vector<std::vector<address_id>> remaps;
+    for (auto shard: all) {
+        remaps.push_back(shard == this ? std::vector<address_id>() : addresses.import(shard->addresses));
+    }
+
+    // The entries of hosts and host pairs are disjoint between the shards
+    for (std::size_t i = 1; i < all.size(); i++) {
+        statistics *shard = all[i];
+        const std::vector<address_id> &remap = remaps[i];
+        insertRemapped(ttl_distribution, shard->ttl_distribution, remap);
+        insertRemapped(mss_distribution, shard->mss_distribution, remap);
+        insertRemapped(tos_distribution, shard->tos_distribution, remap);
+        insertRemapped(win_distribution, shard->win_distribution, remap);
+        insertRemapped(protocol_distribution, shard->protocol_distribution, remap);
+        insertRemapped(ip_ports, shard->ip_ports, remap);
+        for (auto &mac: shard->ip_mac_mapping) {
+            ip_mac_mapping.insert(std::make_pair(remap[mac.first], remap[mac.second]));
+        }
+        insertRemapped(conv_statistics, shard->conv_statistics, remap);
+        insertRemapped(conv_statistics_extended, shard->conv_statistics_extended, remap);
+        insertRemapped(ip_statistics, shard->ip_statistics, remap);
+        for (auto &contacted: shard->contacted_ips) {
+            std::unordered_set<address_id> &contacts = contacted_ips[remap[contacted.first]];
+            for (address_id receiver: contacted.second) {
+                contacts.insert(remap[receiver]);
+            }
+        }
+        sketch.merge(shard->sketch);
+    }
+    // The shards passed the same intervals, so their IPs count the interval lengths in the same order
+    collectRateIPs();
+    collectIntervalIPs();
+
+    // Degrees and inter-arrival times were collected by the shard of the host pair
+    std::unordered_map<address_id, std::vector<std::pair<int, std::chrono::microseconds>>> interarrivalTimes;
+    for (std::size_t i = 0; i < all.size(); i++) {
+        for (auto &update: all[i]->shard_ip_updates) {
+            address_id ipAddress = i == 0 ? update.first : remaps[i][update.first];
+            entry_ipStat &ipStat = ip_statistics[ipAddress];
+            ipStat.in_degree += update.second.in_degree;
+            ipStat.out_degree += update.second.out_degree;
+            ipStat.overall_degree += update.second.overall_degree;
+            std::vector<std::pair<int, std::chrono::microseconds>> &times = interarrivalTimes[ipAddress];
+            times.insert(times.end(), update.second.interarrival_times.begin(), update.second.interarrival_times.end());
+        }
+    }
+    for (auto &times: interarrivalTimes) {
+        std::stable_sort(times.second.begin(), times.second.end(), comparePacketNumber);
+        std::vector<std::chrono::microseconds> &ipTimes = ip_statistics[times.first].interarrival_times;
+        for (auto &time: times.second) {
+            ipTimes.push_back(time.second);
+        }
+    }
+
+    // The IP entropies of every interval are calculated from the packet counts of all shards
+    for (std::size_t i = 0; i < shard_interval_keys.size(); i++) {
+        entry_shardIntervalStat interval = {};
+        // Only the first shard counts every packet
+        interval.packet_count = shard_interval_statistics[i].packet_count;
+        for (auto shard: all) {
+            const entry_shardIntervalStat &partial = shard->shard_interval_statistics[i];
+            addHostCounts(interval.ip_src_pkts_counts, partial.ip_src_pkts_counts);
+            addHostCounts(interval.ip_dst_pkts_counts, partial.ip_dst_pkts_counts);
+            addHostCounts(interval.ip_src_novel_pkts_counts, partial.ip_src_novel_pkts_counts);
+            addHostCounts(interval.ip_dst_novel_pkts_counts, partial.ip_dst_novel_pkts_counts);
+            addHostCounts(interval.ip_src_cum_pkts_counts, partial.ip_src_cum_pkts_counts);
+            addHostCounts(interval.ip_dst_cum_pkts_counts, partial.ip_dst_cum_pkts_counts);
+            interval.ip_count += partial.ip_count;
+        }
+        entry_intervalStat &intervalStat = interval_statistics[shard_interval_keys[i]];
+        intervalStat.ip_entropies = calculateIPsEntropy(interval);
+        intervalStat.ip_cum_entropies = calculateIPsCumEntropy(interval);
+        intervalStat.novel_ip_src_count = this->ip_src_novel_count;
+        intervalStat.novel_ip_dst_count = this->ip_dst_novel_count;
+    }
+
+    for (auto shard: all) {
+        shard->shard_ip_updates.clear();
+        shard->shard_interval_statistics.clear();
+        shard->shard_interval_keys.clear();
+    }
+    setShard(0, 1);
+}
+
+/**
+ * Adds the counts of one value distribution of other statistics, keyed by the addresses of their dictionary.
+ */
+template<typename Map>
+static void addCounts(Map &counts, const Map &other, const std::vector<address_id> &remap) {
+    for (auto &count: other) {
+        counts[remapKey(count.first, remap)] += count.second;
+    }
+}
+
+/**
+ * Sets the inter-arrival times of a conversation, which are kept for its second and third packet.
+ */
+static void setConvInterarrivalTimes(const std::vector<std::chrono::microseconds> &timestamps,
+                                     std::vector<std::chrono::microseconds> &interarrivalTimes) {
+    interarrivalTimes.clear();
+    for (std::size_t i = 1; i < timestamps.size() && i < 3; i++) {
+        interarrivalTimes.push_back(timestamps[i] - timestamps[i - 1]);
+    }
+}
+
+/**
+ * Orders inter-arrival times by the timestamp of the packet they belong to.
+ */
+static bool comparePacketTimestamp(const std::pair<std::chrono::microseconds, std::chrono::microseconds> &a,
+                                   const std::pair<std::chrono::microseconds, std::chrono::microseconds> &b) {
+    return a.first < b.first;
+}
+
+/**
+ * Tells whether the packets of a second part interleave with the packets of a first part, instead of following them.
+ */
+static bool packetsInterleave(const std::vector<std::chrono::microseconds> &timestamps,
+                              const std::vector<std::chrono::microseconds> &otherTimestamps) {
+    return !timestamps.empty() && !otherTimestamps.empty() && otherTimestamps.front() < timestamps.back();
+}
+
+/**
+ * Adds the packets of a second part to the packet timestamps and per-packet values of a conversation. Interleaving
+ * packets are merged in timestamp order, the packets of the first part go first on equal timestamps.
+ */
+template<typename T>
+static void mergePackets(std::vector<std::chrono::microseconds> &timestamps, std::vector<T> &values,
+                         const std::vector<std::chrono::microseconds> &otherTimestamps, const std::vector<T> &otherValues) {
+    if (!packetsInterleave(timestamps, otherTimestamps) || values.size() != timestamps.size() ||
+        otherValues.size() != otherTimestamps.size()) {
+        timestamps.insert(timestamps.end(), otherTimestamps.begin(), otherTimestamps.end());
+        values.insert(values.end(), otherValues.begin(), otherValues.end());
+        return;
+    }
+
+    std::vector<std::chrono::microseconds> mergedTimestamps;
+    std::vector<T> mergedValues;
+    mergedTimestamps.reserve(timestamps.size() + otherTimestamps.size());
+    mergedValues.reserve(values.size() + otherValues.size());
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < timestamps.size() || j < otherTimestamps.size()) {
+        if (j == otherTimestamps.size() || (i < timestamps.size() && timestamps[i] <= otherTimestamps[j])) {
+            mergedTimestamps.push_back(timestamps[i]);
+            mergedValues.push_back(values[i]);
+            i++;
+        } else {
+            mergedTimestamps.push_back(otherTimestamps[j]);
+            mergedValues.push_back(otherValues[j]);
+            j++;
+        }
+    }
+    timestamps.swap(mergedTimestamps);
+    values.swap(mergedValues);
+}
+
+/**
+ * Adds the packet timestamps of a second part to the packet timestamps of a conversation, in timestamp order if the
+ * packets interleave.
+ */
+static void mergePackets(std::vector<std::chrono::microseconds> &timestamps,
+                         const std::vector<std::chrono::microseconds> &otherTimestamps) {
+    if (!packetsInterleave(timestamps, otherTimestamps)) {
+        timestamps.insert(timestamps.end(), otherTimestamps.begin(), otherTimestamps.end());
+        return;
+    }
+    std::vector<std::chrono::microseconds> mergedTimestamps(timestamps.size() + otherTimestamps.size());
+    std::merge(timestamps.begin(), timestamps.end(), otherTimestamps.begin(), otherTimestamps.end(), mergedTimestamps.begin());
+    timestamps.swap(mergedTimestamps);
+}
+
+/**
+ * Sets the communication intervals of a conversation from its packet timestamps, like addConvStatExt does packet by
+ * packet.
+ */
+static void setCommIntervals(const std::vector<std::chrono::microseconds> &timestamps, std::vector<commInterval> &intervals) {
+    intervals.clear();
+    for (auto timestamp: timestamps) {
+        if (intervals.empty() || timestamp - intervals.back().end > (std::chrono::microseconds) ((unsigned long) COMM_INTERVAL_THRESHOLD)) {
+            commInterval interval = {timestamp, timestamp, 1};
+            intervals.push_back(interval);
+        } else {
+            intervals.back().end = timestamp;
+            intervals.back().pkts_count++;
+        }
+    }
+}
+
+/**
+ * Adds the interval rows of packets interleaving with the packets of this object to the rows of this object. The
+ * packets of a row of other are counted in every row of this object containing its last packet, i.e. in one row per
+ * interval length. Rows outside of the intervals of this object are added as they are.
+ * The novelty and entropy values of the rows stay those of the packets of this object.
+ */
+static void foldIntervalStats(std::unordered_map<std::string, entry_intervalStat> &intervalStatistics,
+                              const std::unordered_map<std::string, entry_intervalStat> &otherIntervalStatistics) {
+    struct interval_row {
+        long long start;
+        long long end;
+        entry_intervalStat *stat;
+    };
+    std::vector<interval_row> rows;
+    rows.reserve(intervalStatistics.size());
+    for (auto &interval: intervalStatistics) {
+        rows.push_back({std::stoll(interval.second.start), std::stoll(interval.second.end), &interval.second});
+    }
+
+    for (auto &otherInterval: otherIntervalStatistics) {
+        const entry_intervalStat &otherStat = otherInterval.second;
+        long long lastPacket = std::stoll(otherStat.end);
+        bool contained = false;
+        for (auto &row: rows) {
+            if (lastPacket <= row.start || lastPacket > row.end) {
+                continue;
+            }
+            entry_intervalStat &stat = *row.stat;
+            if (stat.pkts_count > 0) {
+                stat.pkt_rate = stat.pkt_rate * (stat.pkts_count + otherStat.pkts_count) / stat.pkts_count;
+            }
+            if (stat.kbytes > 0) {
+                stat.kbyte_rate = stat.kbyte_rate * (stat.kbytes + otherStat.kbytes) / stat.kbytes;
+            }
+            stat.pkts_count += otherStat.pkts_count;
+            stat.kbytes += otherStat.kbytes;
+            stat.payload_count += otherStat.payload_count;
+            stat.incorrect_tcp_checksum_count += otherStat.incorrect_tcp_checksum_count;
+            stat.correct_tcp_checksum_count += otherStat.correct_tcp_checksum_count;
+            contained = true;
+        }
+        if (!contained) {
+            intervalStatistics.insert(otherInterval);
+        }
+    }
+}
+
+/**
+ * Merges the statistics of the packets following the packets of this object into this object. The result
+ * equals the statistics of a single pass over both parts, except for the interval statistics, which are only
+ * combined: the interval rows of the result are the rows of both parts, and the min and max interval rates of an IP
+ * are the min and max rates of both parts, ignoring a min rate of 0. The intervals of other start at its own first
+ * packet instead of continuing the intervals of this object, so an interval spanning both parts is split into the
+ * last interval of this object and the first interval of other, and the novelty and entropy values of the rows of
+ * other only relate to the packets of other.
+ * If other deferred its intervals, see setDeferredIntervals, its intervals are instead registered here one after
+ * the other, so the interval statistics equal those of a single pass as well, as long as the interval barriers of
+ * other continue the barriers of this object.
+ * The packets of other may also interleave with the packets of this object, like injected attack packets do. Their
+ * conversations are then merged in timestamp order, and the interval rows of other are added to the rows of this
+ * object containing them, see foldIntervalStats.
+ * The inter-arrival times of an IP address are ordered by packet timestamp.
+ * @param other The statistics of the packets following or interleaving with the packets of this object.
+ */
+void statistics::merge(const statistics &other) {
+    if (other.packetCount == 0 && other.interval_deltas.empty()) {
+        return;
+    }
+    bool interleaved = !other.deferredIntervals && packetCount > 0 &&
+                       static_cast<std::chrono::microseconds>(other.timestamp_firstPacket) <
+                       static_cast<std::chrono::microseconds>(timestamp_lastPacket);
+    std::vector<address_id> remap = addresses.import(other.addresses);
+
+    // File statistics
+    if (packetCount == 0 || static_cast<std::chrono::microseconds>(other.timestamp_firstPacket) < static_cast<std::chrono::microseconds>(timestamp_firstPacket)) {
+        timestamp_firstPacket = other.timestamp_firstPacket;
+    }
+    if (packetCount == 0 || static_cast<std::chrono::microseconds>(other.timestamp_lastPacket) > static_cast<std::chrono::microseconds>(timestamp_lastPacket)) {
+        timestamp_lastPacket = other.timestamp_lastPacket;
+    }
+    if (default_interval == 0) {
+        default_interval = other.default_interval;
+    }
+
+    if (other.deferredIntervals) {
+        // The deferred intervals of other are registered after the intervals of this object, the packets of other
+        // after its last interval continue the current interval
+        for (const entry_intervalDelta &delta: other.interval_deltas) {
+            addIntervalDelta(delta, remap);
+            addIntervalStat(delta.interval, delta.start, delta.end);
+        }
+        addIntervalDelta(other.getIntervalDelta(std::chrono::duration<int, std::micro>(0), std::chrono::microseconds(0),
+                                                std::chrono::microseconds(0)), remap);
+    } else {
+        // The interval state continues with the state of other, shifted by the totals of this object
+        intervalPayloadCount = payloadCount + other.intervalPayloadCount;
+        intervalIncorrectTCPChecksumCount = incorrectTCPChecksumCount + other.intervalIncorrectTCPChecksumCount;
+        intervalCorrectTCPChecksumCount = correctTCPChecksumCount + other.intervalCorrectTCPChecksumCount;
+        intervalCumPktCount = packetCount + other.intervalCumPktCount;
+        intervalCumSumPktSize = sumPacketSize + other.intervalCumSumPktSize;
+        intervalCumTTLValues = ttl_values;
+        intervalCumWinSizeValues = win_values;
+        intervalCumTosValues = tos_values;
+        intervalCumMSSValues = mss_values;
+        intervalCumPortValues = port_values;
+        intervalCumTTLValues += other.intervalCumTTLValues;
+        intervalCumWinSizeValues += other.intervalCumWinSizeValues;
+        intervalCumTosValues += other.intervalCumTosValues;
+        intervalCumMSSValues += other.intervalCumMSSValues;
+        intervalCumPortValues += other.intervalCumPortValues;
+        clearIntervalIPs();
+        intervalCumNovelTTLCount = static_cast<int>(intervalCumTTLValues.size());
+        intervalCumNovelWinSizeCount = static_cast<int>(intervalCumWinSizeValues.size());
+        intervalCumNovelToSCount = static_cast<int>(intervalCumTosValues.size());
+        intervalCumNovelMSSCount = static_cast<int>(intervalCumMSSValues.size());
+        intervalCumNovelPortCount = static_cast<int>(intervalCumPortValues.size());
+
+        packetCount += other.packetCount;
+        sumPacketSize += other.sumPacketSize;
+        payloadCount += other.payloadCount;
+        incorrectTCPChecksumCount += other.incorrectTCPChecksumCount;
+        correctTCPChecksumCount += other.correctTCPChecksumCount;
+        ttl_values += other.ttl_values;
+        win_values += other.win_values;
+        tos_values += other.tos_values;
+        mss_values += other.mss_values;
+        port_values += other.port_values;
+    }
+
+    // Distributions
+    addCounts(ttl_distribution, other.ttl_distribution, remap);
+    addCounts(mss_distribution, other.mss_distribution, remap);
+    addCounts(win_distribution, other.win_distribution, remap);
+    addCounts(tos_distribution, other.tos_distribution, remap);
+    for (auto &protocol: other.protocol_distribution) {
+        entry_protocolStat &protocolStat = protocol_distribution[remapKey(protocol.first, remap)];
+        protocolStat.count += protocol.second.count;
+        protocolStat.byteCount += protocol.second.byteCount;
+    }
+    for (auto &port: other.ip_ports) {
+        entry_portStat &portStat = ip_ports[remapKey(port.first, remap)];
+        portStat.count += port.second.count;
+        portStat.byteCount += port.second.byteCount;
+    }
+    for (auto &mac: other.ip_mac_mapping) {
+        ip_mac_mapping[remap[mac.first]] = remap[mac.second];
+    }
+    for (auto &pdu: other.unrecognized_PDUs) {
+        unrecognized_PDU_stat &pduStat = unrecognized_PDUs[remapKey(pdu.first, remap)];
+        pduStat.count += pdu.second.count;
+        // The timestamps are formatted with fixed width, so the later one compares greater
+        if (!interleaved || pdu.second.timestamp_last_occurrence > pduStat.timestamp_last_occurrence)
+            pduStat.timestamp_last_occurrence = pdu.second.timestamp_last_occurrence;
+    }
+
+    // IP statistics, the degrees and inter-arrival times are derived from the merged conversations below
+    // Interval lengths new here are added first, so that only what was sent here lies in their first interval
+    std::vector<std::size_t> rateIntervalRemap;
+    for (int interval: other.rateIntervals) {
+        rateIntervalRemap.push_back(findRateInterval(interval));
+    }
+    for (auto &ip: other.ip_statistics) {
+        entry_ipStat &ipStat = ip_statistics[remap[ip.first]];
+        const entry_ipStat &otherStat = ip.second;
+        if (ipStat.ip_class.empty()) {
+            ipStat.ip_class = otherStat.ip_class;
+        }
+        ipStat.kbytes_received += otherStat.kbytes_received;
+        ipStat.kbytes_sent += otherStat.kbytes_sent;
+        // The packets of deferred intervals were added with the intervals, which also set the rates
+        if (other.deferredIntervals)
+            continue;
+        ipStat.pkts_received += otherStat.pkts_received;
+        ipStat.pkts_sent += otherStat.pkts_sent;
+        ipStat.bytes_sent += otherStat.bytes_sent;
+        ipStat.interval_pkts_sent += otherStat.interval_pkts_sent;
+        ipStat.interval_pkts_received += otherStat.interval_pkts_received;
+        ipStat.interval_bytes_sent += otherStat.interval_bytes_sent;
+        ipStat.interval_counts.resize(rateIntervals.size());
+        for (std::size_t j = 0; j < otherStat.interval_counts.size(); j++) {
+            ipStat.interval_counts[rateIntervalRemap[j]].pkts_sent += otherStat.interval_counts[j].pkts_sent;
+            ipStat.interval_counts[rateIntervalRemap[j]].bytes_sent += otherStat.interval_counts[j].bytes_sent;
+        }
+        if (otherStat.max_interval_pkt_rate > ipStat.max_interval_pkt_rate || ipStat.max_interval_pkt_rate == 0)
+            ipStat.max_interval_pkt_rate = otherStat.max_interval_pkt_rate;
+        if ((otherStat.min_interval_pkt_rate < ipStat.min_interval_pkt_rate && otherStat.min_interval_pkt_rate != 0) || ipStat.min_interval_pkt_rate == 0)
+            ipStat.min_interval_pkt_rate = otherStat.min_interval_pkt_rate;
+        if (otherStat.max_interval_kybte_rate > ipStat.max_interval_kybte_rate || ipStat.max_interval_kybte_rate == 0)
+            ipStat.max_interval_kybte_rate = otherStat.max_interval_kybte_rate;
+        if ((otherStat.min_interval_kybte_rate < ipStat.min_interval_kybte_rate && otherStat.min_interval_kybte_rate != 0) || ipStat.min_interval_kybte_rate == 0)
+            ipStat.min_interval_kybte_rate = otherStat.min_interval_kybte_rate;
+    }
+    if (!other.deferredIntervals) {
+        collectRateIPs();
+        collectIntervalIPs();
+    }
+    for (auto &contacted: other.contacted_ips) {
+        std::unordered_set<address_id> &contacts = contacted_ips[remap[contacted.first]];
+        for (address_id receiver: contacted.second) {
+            contacts.insert(remap[receiver]);
+        }
+    }
+    sketch.merge(other.sketch);
+
+    // Conversations, a conversation continues in the direction it was first seen in
+    for (auto &conversation: other.conv_statistics) {
+        const conv c = remapKey(conversation.first, remap);
+        conv reverse = {c.ipAddressB, c.portB, c.ipAddressA, c.portA};
+        bool reversed = conv_statistics.count(c) == 0 && conv_statistics.count(reverse) > 0;
+        entry_convStat &entry = reversed ? conv_statistics[reverse] : conv_statistics[c];
+        bool seenFirstByOther = reversed && packetsInterleave(entry.pkts_timestamp, conversation.second.pkts_timestamp) &&
+                                conversation.second.pkts_timestamp.front() < entry.pkts_timestamp.front();
+        entry.pkts_count += conversation.second.pkts_count;
+        mergePackets(entry.pkts_timestamp, entry.tcp_types, conversation.second.pkts_timestamp, conversation.second.tcp_types);
+        setConvInterarrivalTimes(entry.pkts_timestamp, entry.interarrival_time);
+        if (seenFirstByOther) {
+            conv_statistics[c] = std::move(entry);
+            conv_statistics.erase(reverse);
+        }
+    }
+    for (auto &conversation: other.conv_statistics_extended) {
+        const convWithProt c = remapKey(conversation.first, remap);
+        const entry_convStatExt &otherEntry = conversation.second;
+        convWithProt reverse = {c.ipAddressB, c.portB, c.ipAddressA, c.portA, c.protocol};
+        if (conv_statistics_extended.count(c) == 0 && conv_statistics_extended.count(reverse) == 0) {
+            conv_statistics_extended[c] = otherEntry;
+            continue;
+        }
+        bool reversed = conv_statistics_extended.count(c) == 0;
+        entry_convStatExt &entry = reversed ? conv_statistics_extended[reverse] : conv_statistics_extended[c];
+        entry.pkts_count += otherEntry.pkts_count;
+        if (packetsInterleave(entry.pkts_timestamp, otherEntry.pkts_timestamp)) {
+            bool seenFirstByOther = reversed && otherEntry.pkts_timestamp.front() < entry.pkts_timestamp.front();
+            mergePackets(entry.pkts_timestamp, otherEntry.pkts_timestamp);
+            setConvInterarrivalTimes(entry.pkts_timestamp, entry.interarrival_time);
+            setCommIntervals(entry.pkts_timestamp, entry.comm_intervals);
+            if (seenFirstByOther) {
+                conv_statistics_extended[c] = std::move(entry);
+                conv_statistics_extended.erase(reverse);
+            }
+            continue;
+        }
+        mergePackets(entry.pkts_timestamp, otherEntry.pkts_timestamp);
+        setConvInterarrivalTimes(entry.pkts_timestamp, entry.interarrival_time);
+
+        // The first interval of other continues the last interval, unless the threshold is exceeded in between
+        auto otherInterval = otherEntry.comm_intervals.begin();
+        if (otherInterval != otherEntry.comm_intervals.end() && !entry.comm_intervals.empty() &&
+            otherInterval->start - entry.comm_intervals.back().end <= (std::chrono::microseconds) ((unsigned long) COMM_INTERVAL_THRESHOLD)) {
+            entry.comm_intervals.back().end = otherInterval->end;
+            entry.comm_intervals.back().pkts_count += otherInterval->pkts_count;
+            otherInterval++;
+        }
+        entry.comm_intervals.insert(entry.comm_intervals.end(), otherInterval, otherEntry.comm_intervals.end());
+    }
+    createCommIntervalStats();
+
+    // Inter-arrival times of the IP addresses, taken from the second and third packet of their conversations
+    std::unordered_map<address_id, std::vector<std::pair<std::chrono::microseconds, std::chrono::microseconds>>> interarrivalTimes;
+    for (auto &conversation: conv_statistics) {
+        const std::vector<std::chrono::microseconds> &timestamps = conversation.second.pkts_timestamp;
+        for (std::size_t i = 0; i < conversation.second.interarrival_time.size(); i++) {
+            std::pair<std::chrono::microseconds, std::chrono::microseconds> time(timestamps[i + 1], conversation.second.interarrival_time[i]);
+            interarrivalTimes[conversation.first.ipAddressA].push_back(time);
+            interarrivalTimes[conversation.first.ipAddressB].push_back(time);
+        }
+    }
+    for (auto &ip: ip_statistics) {
+        ip.second.interarrival_times.clear();
+    }
+    for (auto &times: interarrivalTimes) {
+        std::stable_sort(times.second.begin(), times.second.end(), comparePacketTimestamp);
+        std::vector<std::chrono::microseconds> &ipTimes = ip_statistics[times.first].interarrival_times;
+        for (auto &time: times.second) {
+            ipTimes.push_back(time.second);
+        }
+    }
+
+    // Degrees, counted from the contacted IP addresses, in sketch mode see materializeSketches
+    if (this->getDoExtraTests() && !sketchMode) {
+        for (auto &ip: ip_statistics) {
+            ip.second.in_degree = 0;
+            ip.second.out_degree = 0;
+            ip.second.overall_degree = 0;
+        }
+        for (auto &contacted: contacted_ips) {
+            address_id sender = contacted.first;
+            for (auto &receiver: contacted.second) {
+                ip_statistics[sender].out_degree++;
+                ip_statistics[receiver].in_degree++;
+
+                // A connection in both directions is counted once, by the smaller address id
+                auto receiverContacts = contacted_ips.find(receiver);
+                bool bothDirections = receiverContacts != contacted_ips.end() && receiverContacts->second.count(sender) > 0;
+                if (!bothDirections || sender <= receiver) {
+                    ip_statistics[sender].overall_degree++;
+                    ip_statistics[receiver].overall_degree++;
+                }
+            }
+        }
+    }
+
+    // Interval statistics
+    if (interleaved) {
+        foldIntervalStats(interval_statistics, other.interval_statistics);
+    } else {
+        interval_statistics.insert(other.interval_statistics.begin(), other.interval_statistics.end());
+    }
+}
+
+/**
+ * Scales the counts of the value distributions of all hosts up by the sampling rate.
+ * @return the sum of the counts before scaling.
+ */
+static long scaleCounts(host_values &counts, int rate) {
+    long sampled = 0;
+    for (auto &count: counts) {
+        sampled += count.second;
+        count.second *= rate;
+    }
+    return sampled;
+}
+
+/**
+ * Estimates the relative standard error of a count scaled up from a sample, in which every unit (packet or flow)
+ * was selected with probability 1 / rate: sqrt((1 - 1 / rate) / sampledUnits).
+ * @param sampledUnits The number of sampled units the count was computed from.
+ * @param rate The sampling rate.
+ * @return the relative standard error, 1 if nothing was sampled.
+ */
+static double samplingRelativeError(long sampledUnits, int rate) {
+    if (sampledUnits <= 0) {
+        return 1.0;
+    }
+    return sqrt((1.0 - 1.0 / rate) / static_cast<double>(sampledUnits));
+}
+
+/**
+ * Scales the counts and byte totals collected from a sample of the packets up to estimates for the whole capture,
+ * and records the sampling of every table. Distributions keep their shape, so e.g. ip_ttl and tcp_win stay
+ * representative. The conversation tables are not scaled, their rows describe the sampled conversations.
+ * Has to be called once, after the last packet and createCommIntervalStats.
+ * @param mode The sampling mode, "packet" or "flow".
+ * @param rate The sampling rate N, the statistics of one in N packets or flows were collected.
+ */
+void statistics::scaleSampledCounts(const std::string &mode, int rate) {
+    sampling_statistics.clear();
+    if (rate <= 1) {
+        return;
+    }
+
+    std::vector<std::pair<std::string, long>> scaledTables;
+    scaledTables.push_back(std::make_pair("file_statistics", static_cast<long>(packetCount)));
+    scaledTables.push_back(std::make_pair("interval_statistics_*", static_cast<long>(packetCount)));
+    packetCount *= rate;
+    sumPacketSize *= rate;
+    payloadCount *= rate;
+    incorrectTCPChecksumCount *= rate;
+    correctTCPChecksumCount *= rate;
+
+    long sampledIP = 0;
+    for (auto &ip: ip_statistics) {
+        entry_ipStat &ipStat = ip.second;
+        sampledIP += ipStat.pkts_sent;
+        ipStat.pkts_received *= rate;
+        ipStat.pkts_sent *= rate;
+        ipStat.kbytes_received *= rate;
+        ipStat.kbytes_sent *= rate;
+        ipStat.bytes_sent *= rate;
+        ipStat.max_interval_pkt_rate *= rate;
+        ipStat.min_interval_pkt_rate *= rate;
+        ipStat.max_interval_kybte_rate *= rate;
+        ipStat.min_interval_kybte_rate *= rate;
+        ipStat.interval_pkts_sent *= rate;
+        ipStat.interval_bytes_sent *= rate;
+        ipStat.interval_pkts_received *= rate;
+        for (auto &count: ipStat.interval_counts) {
+            count.pkts_sent *= rate;
+            count.bytes_sent *= rate;
+        }
+    }
+    collectIntervalIPs();
+    scaledTables.push_back(std::make_pair("ip_statistics", sampledIP));
+
+    scaledTables.push_back(std::make_pair("ip_ttl", scaleCounts(ttl_distribution, rate)));
+    scaledTables.push_back(std::make_pair("tcp_mss", scaleCounts(mss_distribution, rate)));
+    scaledTables.push_back(std::make_pair("tcp_win", scaleCounts(win_distribution, rate)));
+    scaledTables.push_back(std::make_pair("ip_tos", scaleCounts(tos_distribution, rate)));
+
+    long sampledProtocols = 0;
+    for (auto &protocol: protocol_distribution) {
+        sampledProtocols += protocol.second.count;
+        protocol.second.count *= rate;
+        protocol.second.byteCount *= rate;
+    }
+    scaledTables.push_back(std::make_pair("ip_protocols", sampledProtocols));
+
+    long sampledPorts = 0;
+    for (auto &port: ip_ports) {
+        sampledPorts += port.second.count;
+        port.second.count *= rate;
+        port.second.byteCount *= rate;
+    }
+    scaledTables.push_back(std::make_pair("ip_ports", sampledPorts));
+
+    long sampledPDUs = 0;
+    for (auto &pdu: unrecognized_PDUs) {
+        sampledPDUs += pdu.second.count;
+        pdu.second.count *= rate;
+    }
+    scaledTables.push_back(std::make_pair("unrecognized_pdus", sampledPDUs));
+
+    for (auto &interval: interval_statistics) {
+        entry_intervalStat &intervalStat = interval.second;
+        intervalStat.pkts_count *= rate;
+        intervalStat.pkt_rate *= rate;
+        intervalStat.kbytes *= rate;
+        intervalStat.kbyte_rate *= rate;
+        intervalStat.payload_count *= rate;
+        intervalStat.incorrect_tcp_checksum_count *= rate;
+        intervalStat.correct_tcp_checksum_count *= rate;
+    }
+
+    // With flow sampling, the sampled units are the flows, which the sampled conversations approximate
+    bool flowSampling = mode == "flow";
+    long sampledFlows = static_cast<long>(conv_statistics_extended.size());
+    for (auto &table: scaledTables) {
+        double error = samplingRelativeError(flowSampling ? sampledFlows : table.second, rate);
+        sampling_statistics.push_back({table.first, mode, rate, table.second, true, error});
+    }
+    long sampledConversations = static_cast<long>(conv_statistics.size());
+    sampling_statistics.push_back({"conv_statistics", mode, rate, sampledConversations, false,
+                                   samplingRelativeError(sampledConversations, rate)});
+    sampling_statistics.push_back({"conv_statistics_extended", mode, rate, sampledFlows, false,
+                                   samplingRelativeError(sampledFlows, rate)});
+}
+
+/**
+ * Fills the per-host TTL, MSS, window size, ToS and port distributions with the listed values of every host and their
+ * estimated counts, and sets the degrees of the hosts to the estimated numbers of contacted hosts.
+ * Has to be called once, after the last packet and after all shards and chunks are combined.
+ */
+void statistics::materializeSketches() {
+    if (!sketchMode) {
+        return;
+    }
+    for (auto &host: sketch.get_hosts()) {
+        // The sketches are keyed by the text of the addresses
+        const std::string &address = host.first;
+        address_id ipAddress = addresses.intern(address);
+        const entry_sketchHost &hostSketch = host.second;
+        for (uint32_t value: hostSketch.values[SKETCH_TTL]) {
+            ttl_distribution[{ipAddress, value}] = static_cast<int>(sketch.estimate_count(SKETCH_TTL, address, value));
+        }
+        for (uint32_t value: hostSketch.values[SKETCH_MSS]) {
+            mss_distribution[{ipAddress, value}] = static_cast<int>(sketch.estimate_count(SKETCH_MSS, address, value));
+        }
+        for (uint32_t value: hostSketch.values[SKETCH_WIN]) {
+            win_distribution[{ipAddress, value}] = static_cast<int>(sketch.estimate_count(SKETCH_WIN, address, value));
+        }
+        for (uint32_t value: hostSketch.values[SKETCH_TOS]) {
+            tos_distribution[{ipAddress, value}] = static_cast<int>(sketch.estimate_count(SKETCH_TOS, address, value));
+        }
+        for (uint32_t value: hostSketch.values[SKETCH_PORT]) {
+            bool incoming = (value >> 16) & 1;
+            bool udp = (value >> 17) & 1;
+            entry_portStat &portStat = ip_ports[{ipAddress, static_cast<uint16_t>(value & 0xffff), incoming, udp}];
+            portStat.count = static_cast<int>(sketch.estimate_count(SKETCH_PORT, address, value));
+            portStat.byteCount = static_cast<float>(sketch.estimate_bytes(address, value));
+        }
+
+        if (this->getDoExtraTests()) {
+            auto ipStat = ip_statistics.find(ipAddress);
+            if (ipStat != ip_statistics.end()) {
+                ipStat->second.out_degree = static_cast<int>(hostSketch.contacted_out.estimate());
+                ipStat->second.in_degree = static_cast<int>(hostSketch.contacted_in.estimate());
+                ipStat->second.overall_degree = static_cast<int>(hostSketch.contacted.estimate());
+            }
+        }
+    }
+}
+
+/**
+ * @return the amount by which the estimated per-host packet counts exceed the true counts at most, with a
+ * probability of 1 - e^-CMS_DEPTH.
+ */
+uint64_t statistics::getSketchErrorBound() const {
+    return sketch.get_count_error_bound();
+}
+
+/**
+ * Writes the collected statistics to a checkpoint, including the state of the interval-wise statistics.
+ * @param out The checkpoint.
+ */
+void statistics::saveCheckpoint(checkpoint_writer &out) const {
+    checkpoint_save(out, timestamp_firstPacket);
+    checkpoint_save(out, timestamp_lastPacket);
+    checkpoint_save(out, sumPacketSize);
+    checkpoint_save(out, packetCount);
+    checkpoint_save(out, doExtraTests);
+    checkpoint_save(out, payloadCount);
+    checkpoint_save(out, incorrectTCPChecksumCount);
+    checkpoint_save(out, correctTCPChecksumCount);
+    checkpoint_save(out, intervalPayloadCount);
+    checkpoint_save(out, intervalIncorrectTCPChecksumCount);
+    checkpoint_save(out, intervalCorrectTCPChecksumCount);
+    checkpoint_save(out, intervalCumPktCount);
+    checkpoint_save(out, intervalCumSumPktSize);
+    checkpoint_save(out, ip_src_novel_count);
+    checkpoint_save(out, ip_dst_novel_count);
+    checkpoint_save(out, intervalCumNovelIPCount);
+    checkpoint_save(out, intervalCumNovelTTLCount);
+    checkpoint_save(out, intervalCumNovelWinSizeCount);
+    checkpoint_save(out, intervalCumNovelToSCount);
+    checkpoint_save(out, intervalCumNovelMSSCount);
+    checkpoint_save(out, intervalCumNovelPortCount);
+    addresses.save(out);
+    checkpoint_save(out, intervalCumTTLValues);
+    checkpoint_save(out, intervalCumWinSizeValues);
+    checkpoint_save(out, intervalCumTosValues);
+    checkpoint_save(out, intervalCumMSSValues);
+    checkpoint_save(out, intervalCumPortValues);
+    checkpoint_save(out, default_interval);
+    checkpoint_save(out, sketchMode);
+    sketch.save(out);
+    checkpoint_save(out, ttl_distribution);
+    checkpoint_save(out, mss_distribution);
+    checkpoint_save(out, win_distribution);
+    checkpoint_save(out, tos_distribution);
+    checkpoint_save(out, conv_statistics);
+    checkpoint_save(out, conv_statistics_extended);
+    checkpoint_save(out, interval_statistics);
+    checkpoint_save(out, ttl_values);
+    checkpoint_save(out, win_values);
+    checkpoint_save(out, tos_values);
+    checkpoint_save(out, mss_values);
+    checkpoint_save(out, port_values);
+    checkpoint_save(out, contacted_ips);
+    checkpoint_save(out, protocol_distribution);
+    checkpoint_save(out, ip_statistics);
+    checkpoint_save(out, rateIntervals);
+    checkpoint_save(out, ip_ports);
+    checkpoint_save(out, ip_mac_mapping);
+    checkpoint_save(out, unrecognized_PDUs);
+    checkpoint_save(out, sampling_statistics);
+}
+
+/**
+ * Restores the statistics written by saveCheckpoint, replacing the statistics collected so far.
+ * @param in The checkpoint, which is marked as damaged if it ends early.
+ */
+void statistics::loadCheckpoint(checkpoint_reader &in) {
+    checkpoint_load(in, timestamp_firstPacket);
+    checkpoint_load(in, timestamp_lastPacket);
+    checkpoint_load(in, sumPacketSize);
+    checkpoint_load(in, packetCount);
+    checkpoint_load(in, doExtraTests);
+    checkpoint_load(in, payloadCount);
+    checkpoint_load(in, incorrectTCPChecksumCount);
+    checkpoint_load(in, correctTCPChecksumCount);
+    checkpoint_load(in, intervalPayloadCount);
+    checkpoint_load(in, intervalIncorrectTCPChecksumCount);
+    checkpoint_load(in, intervalCorrectTCPChecksumCount);
+    checkpoint_load(in, intervalCumPktCount);
+    checkpoint_load(in, intervalCumSumPktSize);
+    checkpoint_load(in, ip_src_novel_count);
+    checkpoint_load(in, ip_dst_novel_count);
+    checkpoint_load(in, intervalCumNovelIPCount);
+    checkpoint_load(in, intervalCumNovelTTLCount);
+    checkpoint_load(in, intervalCumNovelWinSizeCount);
+    checkpoint_load(in, intervalCumNovelToSCount);
+    checkpoint_load(in, intervalCumNovelMSSCount);
+    checkpoint_load(in, intervalCumNovelPortCount);
+    addresses.load(in);
+    checkpoint_load(in, intervalCumTTLValues);
+    checkpoint_load(in, intervalCumWinSizeValues);
+    checkpoint_load(in, intervalCumTosValues);
+    checkpoint_load(in, intervalCumMSSValues);
+    checkpoint_load(in, intervalCumPortValues);
+    checkpoint_load(in, default_interval);
+    checkpoint_load(in, sketchMode);
+    sketch.load(in);
+    checkpoint_load(in, ttl_distribution);
+    checkpoint_load(in, mss_distribution);
+    checkpoint_load(in, win_distribution);
+    checkpoint_load(in, tos_distribution);
+    checkpoint_load(in, conv_statistics);
+    checkpoint_load(in, conv_statistics_extended);
+    checkpoint_load(in, interval_statistics);
+    checkpoint_load(in, ttl_values);
+    checkpoint_load(in, win_values);
+    checkpoint_load(in, tos_values);
+    checkpoint_load(in, mss_values);
+    checkpoint_load(in, port_values);
+    checkpoint_load(in, contacted_ips);
+    checkpoint_load(in, protocol_distribution);
+    checkpoint_load(in, ip_statistics);
+    checkpoint_load(in, rateIntervals);
+    collectRateIPs();
+    collectIntervalIPs();
+    checkpoint_load(in, ip_ports);
+    checkpoint_load(in, ip_mac_mapping);
+    checkpoint_load(in, unrecognized_PDUs);
+    checkpoint_load(in, sampling_statistics);
+}
+
 /**
  * Increments the packet counter.
  */
@@ -874,6 +2178,14 @@ void statistics::incrementPacketCount() {
     packetCount++;
 }
 
+/**
+ * Sets the packet counter, e.g. of a shard to the number of the packet in the capture.
+ * @param count The number of packets.
+ */
+void statistics::setPacketCount(int count) {
+    packetCount = count;
+}
+
 /**
  * Prints the statistics of the PCAP and IP specific statistics for the given IP address.
  * @param ipAddress The IP address whose statistics should be printed. Can be empty "" to print only general file statistics.
@@ -887,8 +2199,9 @@ void statistics::printStats(const std::string &ipAddress) {
     ss << std::endl;
 
     // Print IP address specific statistics only if IP address was given
-    if (ipAddress != "") {
-        entry_ipStat e = ip_statistics[ipAddress];
+    address_id id = 0;
+    if (ipAddress != "" && addresses.find(ipAddress, id)) {
+        entry_ipStat e = ip_statistics[id];
         ss << "\n----- STATS FOR IP ADDRESS [" << ipAddress << "] -------" << std::endl;
         ss << std::endl << "KBytes sent: " << e.kbytes_sent << std::endl;
         ss << "KBytes received: " << e.kbytes_received << std::endl;
@@ -907,15 +2220,16 @@ void statistics::printStats(const std::string &ipAddress) {
 }
 
 /**
- * Derives general PCAP file statistics from the collected statistical data and
- * writes all data into a SQLite database, located at database_path.
- * @param database_path The path of the SQLite database file ending with .sqlite3.
+ * Derives general PCAP file statistics from the collected statistical data and writes them into the database.
+ * @param db The statistics database.
+ * @return false if no statistics could be collected from the PCAP.
  */
-void statistics::writeToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del) {
+bool statistics::writeFileStatistics(statistics_db &db) {
     // Generate general file statistics
     float duration = getCaptureDurationSeconds();
     long sumPacketsSent = 0, senderCountIP = 0;
-    float sumBandwidthIn = 0.0, sumBandwidthOut = 0.0;
+    // Summed in double precision, the float sums would depend on the order of the IPs, which differs after a merge
+    double sumBandwidthIn = 0.0, sumBandwidthOut = 0.0;
     for (auto i = ip_statistics.begin(); i != ip_statistics.end(); i++) {
         sumPacketsSent += i->second.pkts_sent;
         // Consumed bandwith (bytes) for sending packets
@@ -923,44 +2237,135 @@ void statistics::writeToDatabase(std::string database_path, std::vector<std::chr
         sumBandwidthOut += (i->second.kbytes_sent / duration);
         senderCountIP++;
     }
+    if (senderCountIP == 0) {
+        return false;
+    }
 
     float avgPacketRate = (packetCount / duration);
     float avgPacketSize = this->getAvgPacketSize();
-    if(senderCountIP>0) {
-        float avgPacketsSentPerHost = (sumPacketsSent / senderCountIP);
-        float avgBandwidthInKBits = (sumBandwidthIn / senderCountIP) * 8;
-        float avgBandwidthOutInKBits = (sumBandwidthOut / senderCountIP) * 8;
-
-        // Create database and write information
-        statistics_db db(database_path, resourcePath);
-        db.writeStatisticsFile(packetCount, getCaptureDurationSeconds(),
-                               getFormattedTimestamp(timestamp_firstPacket.seconds(), timestamp_firstPacket.microseconds()),
-                               getFormattedTimestamp(timestamp_lastPacket.seconds(), timestamp_lastPacket.microseconds()),
-                               avgPacketRate, avgPacketSize, avgPacketsSentPerHost, avgBandwidthInKBits,
-                               avgBandwidthOutInKBits, doExtraTests);
-        db.writeStatisticsIP(ip_statistics);
-        db.writeStatisticsTTL(ttl_distribution);
-        db.writeStatisticsIpMac(ip_mac_mapping);
-        db.writeStatisticsDegree(ip_statistics);
-        db.writeStatisticsPorts(ip_ports);
-        db.writeStatisticsProtocols(protocol_distribution);
-        db.writeStatisticsMSS(mss_distribution);
-        db.writeStatisticsToS(tos_distribution);
-        db.writeStatisticsWin(win_distribution);
-        db.writeStatisticsConv(conv_statistics);
-        db.writeStatisticsConvExt(conv_statistics_extended);
-        db.writeStatisticsInterval(interval_statistics, timeIntervals, del, this->default_interval, this->getDoExtraTests());
-        db.writeDbVersion();
-        db.writeStatisticsUnrecognizedPDUs(unrecognized_PDUs);
-    }
-    else {
+    float avgPacketsSentPerHost = (sumPacketsSent / senderCountIP);
+    float avgBandwidthInKBits = (sumBandwidthIn / senderCountIP) * 8;
+    float avgBandwidthOutInKBits = (sumBandwidthOut / senderCountIP) * 8;
+    db.writeStatisticsFile(packetCount, getCaptureDurationSeconds(),
+                           getFormattedTimestamp(timestamp_firstPacket.seconds(), timestamp_firstPacket.microseconds()),
+                           getFormattedTimestamp(timestamp_lastPacket.seconds(), timestamp_lastPacket.microseconds()),
+                           avgPacketRate, avgPacketSize, avgPacketsSentPerHost, avgBandwidthInKBits,
+                           avgBandwidthOutInKBits, doExtraTests);
+    return true;
+}
+
+/**
+ * Writes the statistics of the hosts into the database. The value distributions are grouped by host for writing,
+ * see buildHostHistograms.
+ * @param db The statistics database.
+ */
+void statistics::writeHostStatistics(statistics_db &db) {
+    db.writeStatisticsIP(ip_statistics, addresses);
+    db.writeStatisticsTTL(buildHostHistograms<HISTOGRAM_BYTE_VALUES>(ttl_distribution), addresses);
+    db.writeStatisticsIpMac(ip_mac_mapping, addresses);
+    db.writeStatisticsDegree(ip_statistics, addresses);
+    db.writeStatisticsPorts(ip_ports, addresses);
+    db.writeStatisticsProtocols(protocol_distribution, addresses);
+    db.writeStatisticsMSS(buildHostHistograms<HISTOGRAM_SHORT_VALUES>(mss_distribution), addresses);
+    db.writeStatisticsToS(buildHostHistograms<HISTOGRAM_BYTE_VALUES>(tos_distribution), addresses);
+    db.writeStatisticsWin(buildHostHistograms<HISTOGRAM_SHORT_VALUES>(win_distribution), addresses);
+}
+
+/**
+ * Derives general PCAP file statistics from the collected statistical data and
+ * writes all data into a SQLite database, located at database_path.
+ * @param database_path The path of the SQLite database file ending with .sqlite3.
+ */
+void statistics::writeToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del) {
+    if (ip_statistics.empty()) {
         // Tinslib failed to recognize the types of the packets in the input PCAP
         std::cerr<<"ERROR: Statistics could not be collected from the input PCAP!"<<"\n";
         return;
     }
+
+    // Create database and write information
+    statistics_db db(database_path, resourcePath);
+    writeFileStatistics(db);
+    writeHostStatistics(db);
+    db.writeStatisticsConv(conv_statistics, addresses, false);
+    db.writeStatisticsConvExt(conv_statistics_extended, addresses, false);
+    db.writeStatisticsInterval(interval_statistics, timeIntervals, del, this->default_interval, this->getDoExtraTests(), false);
+    db.writeDbVersion();
+    db.writeStatisticsUnrecognizedPDUs(unrecognized_PDUs, addresses);
+    db.writeStatisticsSampling(sampling_statistics);
+}
+
+/**
+ * Writes the statistics collected from a stream so far into the database and evicts the written state: The
+ * intervals completed since the last flush and the conversations idle since idleBefore are added to their tables
+ * and removed from memory, the file statistics are replaced by the current ones. The last flush also writes the
+ * remaining conversations and the statistics of the hosts. A conversation continued after it was evicted replaces its
+ * earlier row by a row of both instances, see statistics_db::readStreamConversations.
+ * @param database_path The path of the SQLite database file ending with .sqlite3.
+ * @param timeIntervals The time intervals of the interval statistics.
+ * @param idleBefore Conversations without packets from this timestamp on are evicted.
+ * @param first Whether this is the first flush, which replaces the tables of earlier runs.
+ * @param last Whether this is the last flush, after the last packet of the stream.
+ */
+void statistics::writeStreamToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals,
+                                       std::chrono::microseconds idleBefore, bool first, bool last) {
+    std::unordered_map<conv, entry_convStat> idleConversations;
+    for (auto it = conv_statistics.begin(); it != conv_statistics.end();) {
+        if (last || it->second.pkts_timestamp.empty() || it->second.pkts_timestamp.back() < idleBefore) {
+            idleConversations.insert(std::move(*it));
+            it = conv_statistics.erase(it);
+        } else {
+            it++;
+        }
+    }
+    std::unordered_map<convWithProt, entry_convStatExt> idleConversationsExtended;
+    for (auto it = conv_statistics_extended.begin(); it != conv_statistics_extended.end();) {
+        if (last || it->second.pkts_timestamp.empty() || it->second.pkts_timestamp.back() < idleBefore) {
+            idleConversationsExtended.insert(std::move(*it));
+            it = conv_statistics_extended.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    // A conversation continued after it was evicted is written with the packets written before, the inter-arrival
+    // times of its hosts are those of its first three packets as well
+    statistics_db db(database_path, resourcePath);
+    std::vector<entry_continuedConv> continuedTimes;
+    db.readStreamConversations(idleConversations, idleConversationsExtended, continuedTimes, addresses, first);
+    for (auto &continued: continuedTimes) {
+        for (address_id ip: {continued.conversation.ipAddressA, continued.conversation.ipAddressB}) {
+            std::vector<std::chrono::microseconds> &ipTimes = ip_statistics[ip].interarrival_times;
+            for (auto &time: continued.replaced_times) {
+                auto replaced = std::find(ipTimes.begin(), ipTimes.end(), time);
+                if (replaced != ipTimes.end())
+                    ipTimes.erase(replaced);
+            }
+            ipTimes.insert(ipTimes.end(), continued.added_times.begin(), continued.added_times.end());
+        }
+    }
+    for (auto &conversation: idleConversationsExtended) {
+        if (!conversation.second.pkts_timestamp.empty()) {
+            aggregateCommIntervals(conversation.second);
+        }
+    }
+    writeFileStatistics(db);
+    db.writeStatisticsConv(idleConversations, addresses, !first);
+    db.writeStatisticsConvExt(idleConversationsExtended, addresses, !first);
+    db.writeStreamConversations(idleConversations, idleConversationsExtended, addresses, last);
+    db.writeStatisticsInterval(interval_statistics, timeIntervals, first, this->default_interval, this->getDoExtraTests(), !first);
+    interval_statistics.clear();
+    if (first || last) {
+        db.writeDbVersion();
+    }
+    if (last) {
+        writeHostStatistics(db);
+        db.writeStatisticsUnrecognizedPDUs(unrecognized_PDUs, addresses);
+        db.writeStatisticsSampling(sampling_statistics);
+    }
 }
 
 void statistics::writeIntervalsToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del) {
     statistics_db db(database_path, resourcePath);
-    db.writeStatisticsInterval(interval_statistics, timeIntervals, del, this->default_interval, this->getDoExtraTests());
+    db.writeStatisticsInterval(interval_statistics, timeIntervals, del, this->default_interval, this->getDoExtraTests(), false);
 }
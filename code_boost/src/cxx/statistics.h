@@ -5,6 +5,7 @@
 #define CPP_PCAPREADER_STATISTICS_H
 
 #include <vector>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
@@ -12,12 +13,20 @@
 #include <tins/timestamp.h>
 #include <tins/ip_address.h>
 
+#include "address_dictionary.h"
+#include "flat_hash_map.h"
+#include "value_histogram.h"
+#include "statistics_sketch.h"
 #include "utilities.h"
 
 using namespace Tins;
 
 #define COMM_INTERVAL_THRESHOLD 10e6  // in microseconds; i.e. here 10s
 
+class statistics_db;
+class checkpoint_writer;
+class checkpoint_reader;
+
 /*
  * Definition of structs used in unordered_map fields
  */
@@ -44,15 +53,15 @@ struct ip_stats {
 
 /*
  * Struct used to represent a conversation by:
- * - IP address A
+ * - Id of IP address A
  * - Port A
- * - IP address B
+ * - Id of IP address B
  * - Port B
  */
 struct conv{
-    std::string ipAddressA;
+    address_id ipAddressA;
     int portA;
-    std::string ipAddressB;
+    address_id ipAddressB;
     int portB;
 
     bool operator==(const conv &other) const {
@@ -65,16 +74,16 @@ struct conv{
 
 /*
  * Struct used to represent a conversation by:
- * - IP address A
+ * - Id of IP address A
  * - Port A
- * - IP address B
+ * - Id of IP address B
  * - Port B
  * - Protocol
  */
 struct convWithProt{
-    std::string ipAddressA;
+    address_id ipAddressA;
     int portA;
-    std::string ipAddressB;
+    address_id ipAddressB;
     int portB;
     std::string protocol;
 
@@ -89,76 +98,50 @@ struct convWithProt{
 
 /*
  * Struct used to represent:
- * - IP address (IPv4 or IPv6)
- * - MSS value
+ * - Id of the IP address (IPv4 or IPv6), see address_dictionary
+ * - TTL, ToS, MSS value or window size
+ * Both are packed into one 64 bit key, see pack.
  */
-struct ipAddress_mss {
-    std::string ipAddress;
-    int mssValue;
+struct ipAddress_value {
+    address_id ipAddress;
+    uint32_t value;
 
-    bool operator==(const ipAddress_mss &other) const {
-        return ipAddress == other.ipAddress
-               && mssValue == other.mssValue;
+    uint64_t pack() const {
+        return (static_cast<uint64_t>(ipAddress) << 32) | value;
     }
-};
 
-/*
- * Struct used to represent:
- * - IP address (IPv4 or IPv6)
- * - ToS value
- */
-struct ipAddress_tos {
-    std::string ipAddress;
-    int tosValue;
-
-    bool operator==(const ipAddress_tos &other) const {
-        return ipAddress == other.ipAddress
-               && tosValue == other.tosValue;
+    bool operator==(const ipAddress_value &other) const {
+        return pack() == other.pack();
     }
 };
 
 /*
  * Struct used to represent:
- * - IP address (IPv4 or IPv6)
- * - Window size
- */
-struct ipAddress_win {
-    std::string ipAddress;
-    int winSize;
-
-    bool operator==(const ipAddress_win &other) const {
-        return ipAddress == other.ipAddress
-               && winSize == other.winSize;
-    }
-};
-
-/*
- * Struct used to represent:
- * - IP address (IPv4 or IPv6)
- * - TTL value
+ * - Id of the IP address (IPv4 or IPv6), see address_dictionary
+ * - Protocol (e.g. TCP, UDP, IPv4, IPv6)
  */
-struct ipAddress_ttl {
-    std::string ipAddress;
-    int ttlValue;
+struct ipAddress_protocol {
+    address_id ipAddress;
+    std::string protocol;
 
-    bool operator==(const ipAddress_ttl &other) const {
+    bool operator==(const ipAddress_protocol &other) const {
         return ipAddress == other.ipAddress
-               && ttlValue == other.ttlValue;
+               && protocol == other.protocol;
     }
 };
 
 /*
- * Struct used to represent:
- * - IP address (IPv4 or IPv6)
- * - Protocol (e.g. TCP, UDP, IPv4, IPv6)
+ * Struct used to represent what a host sent in the current time interval of one interval length:
+ * - Number of sent packets
+ * - Number of sent bytes
  */
-struct ipAddress_protocol {
-    std::string ipAddress;
-    std::string protocol;
+struct entry_ipIntervalCount {
+    long pkts_sent;
+    long bytes_sent;
 
-    bool operator==(const ipAddress_protocol &other) const {
-        return ipAddress == other.ipAddress
-               && protocol == other.protocol;
+    bool operator==(const entry_ipIntervalCount &other) const {
+        return pkts_sent == other.pkts_sent
+               && bytes_sent == other.bytes_sent;
     }
 };
 
@@ -168,43 +151,46 @@ struct ipAddress_protocol {
  * - Number of sent packets
  * - Data received in kbytes
  * - Data sent in kbytes
+ * - Data sent in bytes
  */
 struct entry_ipStat {
     long pkts_received;
     long pkts_sent;
     float kbytes_received;
     float kbytes_sent;
+    long bytes_sent;
     std::string ip_class;
     int in_degree;
     int out_degree;
     int overall_degree;
     // Collects statstics over time interval
-    std::vector<float> interval_pkt_rate;
     float max_interval_pkt_rate;
     float min_interval_pkt_rate;
-    std::vector<float> pkts_kbytes;
-    std::vector<float> interval_kbyte_rate;
     float max_interval_kybte_rate;
     float min_interval_kybte_rate;
     std::vector<std::chrono::microseconds> interarrival_times;
-    std::vector<std::chrono::microseconds> pkts_sent_timestamp;
-    std::vector<std::chrono::microseconds> pkts_received_timestamp;
+    // Sent in the current interval of every interval length, in the order of statistics::rateIntervals
+    std::vector<entry_ipIntervalCount> interval_counts;
+    // Sent and received since the last interval of any length, the IP is listed in statistics::intervalIPs then
+    long interval_pkts_sent;
+    long interval_pkts_received;
+    long interval_bytes_sent;
 
     bool operator==(const entry_ipStat &other) const {
         return pkts_received == other.pkts_received
                && pkts_sent == other.pkts_sent
                && kbytes_sent == other.kbytes_sent
                && kbytes_received == other.kbytes_received
-               && interval_pkt_rate == other.interval_pkt_rate
+               && bytes_sent == other.bytes_sent
                && max_interval_pkt_rate == other.max_interval_pkt_rate
                && min_interval_pkt_rate == other.min_interval_pkt_rate
-               && pkts_kbytes == other.pkts_kbytes
-               && interval_kbyte_rate == other.interval_kbyte_rate
                && max_interval_kybte_rate == other.max_interval_kybte_rate
                && min_interval_kybte_rate == other.min_interval_kybte_rate
                && ip_class == other.ip_class
-               && pkts_sent_timestamp == other.pkts_sent_timestamp
-               && pkts_received_timestamp == other.pkts_received_timestamp;
+               && interval_counts == other.interval_counts
+               && interval_pkts_sent == other.interval_pkts_sent
+               && interval_pkts_received == other.interval_pkts_received
+               && interval_bytes_sent == other.interval_bytes_sent;
     }
 };
 /*
@@ -297,6 +283,25 @@ struct entry_intervalStat {
     }
 };
 
+/*
+ * Struct used to represent the sampling of a statistics table:
+ * - Table name
+ * - Sampling mode ("packet" or "flow")
+ * - Sampling rate N, the statistics of one in N packets or flows were collected
+ * - # sampled observations the table was computed from
+ * - Whether the counts of the table were scaled up by the sampling rate
+ * - Estimated relative standard error of the scaled counts of the table, for tables whose counts are not scaled
+ *   of the number of rows scaled up by the sampling rate
+ */
+struct entry_samplingStat {
+    std::string table;
+    std::string mode;
+    int rate;
+    long sampledCount;
+    bool scaled;
+    double relativeError;
+};
+
 /*
  * Struct used to represent converstaion statistics:
  * - # packets
@@ -323,23 +328,39 @@ struct entry_convStat {
     }
 };
 
+/*
+ * Struct used to represent the inter-arrival times of a conversation continued after it was evicted by a flush of
+ * stream_statistics, see statistics_db::readStreamConversations:
+ * - The conversation
+ * - Inter-arrival times of the later instance, replaced by the continued conversation
+ * - Inter-arrival times added to the earlier instance by the continued conversation
+ */
+struct entry_continuedConv {
+    conv conversation;
+    std::vector<std::chrono::microseconds> replaced_times;
+    std::vector<std::chrono::microseconds> added_times;
+};
+
 /*
  * Struct used to represent:
- * - IP address (IPv4 or IPv6)
-   - Traffic direction (out: outgoing connection, in: incoming connection)
+ * - Id of the IP address (IPv4 or IPv6), see address_dictionary
  * - Port number
+ * - Traffic direction (true: incoming connection, false: outgoing connection)
+ * - Transport protocol (true: UDP, false: TCP)
+ * All fields are packed into one 64 bit key, see pack.
  */
 struct ipAddress_inOut_port {
-    std::string ipAddress;
-    std::string trafficDirection;
-    int portNumber;
-    std::string protocol;
+    address_id ipAddress;
+    uint16_t portNumber;
+    bool incoming;
+    bool udp;
+
+    uint64_t pack() const {
+        return (static_cast<uint64_t>(ipAddress) << 32) | statistics_sketch::encode_port(portNumber, incoming, udp);
+    }
 
     bool operator==(const ipAddress_inOut_port &other) const {
-        return ipAddress == other.ipAddress
-               && trafficDirection == other.trafficDirection
-               && portNumber == other.portNumber
-               && protocol == other.protocol;
+        return pack() == other.pack();
     }
 };
 
@@ -403,13 +424,13 @@ struct entry_convStatExt {
 
 /*
  * Struct used to represent:
- * - Source MAC address
- * - Destination MAC address
+ * - Id of the source MAC address
+ * - Id of the destination MAC address
  * - Payload type number
  */
 struct unrecognized_PDU {
-    std::string srcMacAddress;
-    std::string dstMacAddress;
+    address_id srcMacAddress;
+    address_id dstMacAddress;
     uint32_t typeNumber;
 
     bool operator==(const unrecognized_PDU &other) const {
@@ -430,62 +451,90 @@ struct unrecognized_PDU_stat {
 };
 
 /*
- * Definition of hash functions for structs used as key in unordered_map
+ * Struct used to represent the updates of a statistics shard to a host, which are combined after all packets
+ * were processed, because the host pair determines the shard instead of the host:
+ * - In-degree, out-degree and overall degree increments
+ * - Inter-arrival times with the number of the packet they belong to
  */
-namespace std {
-    template<>
-    struct hash<ipAddress_ttl> {
-        std::size_t operator()(const ipAddress_ttl &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.ipAddress)
-                     ^ (hash<int>()(k.ttlValue) << 1)) >> 1);
-        }
-    };
+struct entry_shardIpStat {
+    int in_degree;
+    int out_degree;
+    int overall_degree;
+    std::vector<std::pair<int, std::chrono::microseconds>> interarrival_times;
+};
 
-      template<>
-    struct hash<ipAddress_mss> {
-        std::size_t operator()(const ipAddress_mss &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.ipAddress)
-                     ^ (hash<int>()(k.mssValue) << 1)) >> 1);
-        }
-    };
+/*
+ * Struct used to represent the contribution of a statistics shard to the IP entropies of an interval. The packet
+ * counts are kept as the number of hosts per packet count, which do not depend on the order of the hosts:
+ * - Packet counts of all hosts that sent/received packets in the interval
+ * - Packet counts of the novel hosts that sent/received packets in the interval
+ * - Packet counts of all hosts that sent/received packets since the start of the capture
+ * - Number of hosts
+ * - Number of packets since the start of the capture
+ */
+struct entry_shardIntervalStat {
+    std::map<long, long> ip_src_pkts_counts;
+    std::map<long, long> ip_dst_pkts_counts;
+    std::map<long, long> ip_src_novel_pkts_counts;
+    std::map<long, long> ip_dst_novel_pkts_counts;
+    std::map<long, long> ip_src_cum_pkts_counts;
+    std::map<long, long> ip_dst_cum_pkts_counts;
+    size_t ip_count;
+    long packet_count;
+};
 
-    template<>
-    struct hash<ipAddress_tos> {
-        std::size_t operator()(const ipAddress_tos &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.ipAddress)
-                     ^ (hash<int>()(k.tosValue) << 1)) >> 1);
-        }
-    };
+/*
+ * Struct used to represent what the packets of an IP added to a deferred time interval:
+ * - Number of sent packets
+ * - Number of received packets
+ * - Number of sent bytes
+ */
+struct entry_ipIntervalDelta {
+    long pkts_sent;
+    long pkts_received;
+    long bytes_sent;
+};
 
-      template<>
-    struct hash<ipAddress_win> {
-        std::size_t operator()(const ipAddress_win &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.ipAddress)
-                     ^ (hash<int>()(k.winSize) << 1)) >> 1);
-        }
-    };
+/*
+ * Struct used to represent what the packets of a deferred time interval added to the statistics, see
+ * statistics::setDeferredIntervals:
+ * - Interval length, 0 for the packets after the last interval
+ * - Timestamps of the first packet of the interval and of the packet ending it
+ * - Number of packets, bytes, packets with payload and incorrect and correct TCP checksums
+ * - Packets and bytes of every IP which sent or received packets in the interval
+ * - Counts added to the TTL, window size, ToS, MSS and port values
+ */
+struct entry_intervalDelta {
+    std::chrono::duration<int, std::micro> interval;
+    std::chrono::microseconds start;
+    std::chrono::microseconds end;
+    int pkts_count;
+    double bytes;
+    int payload_count;
+    int incorrect_tcp_checksum_count;
+    int correct_tcp_checksum_count;
+    std::vector<std::pair<address_id, entry_ipIntervalDelta>> ips;
+    std::vector<std::pair<uint32_t, int>> ttl_values;
+    std::vector<std::pair<uint32_t, int>> win_values;
+    std::vector<std::pair<uint32_t, int>> tos_values;
+    std::vector<std::pair<uint32_t, int>> mss_values;
+    std::vector<std::pair<uint32_t, int>> port_values;
+};
 
+/*
+ * Definition of hash functions for structs used as key in unordered_map and flat_hash_map. The keys of the
+ * flat_hash_map are mixed, as it takes the slot from the low bits of the hash.
+ */
+namespace std {
     template<>
     struct hash<conv> {
         std::size_t operator()(const conv &k) const {
             using std::size_t;
             using std::hash;
             using std::string;
-            return ((hash<string>()(k.ipAddressA)
+            return ((hash<address_id>()(k.ipAddressA)
                      ^ (hash<int>()(k.portA) << 1)) >> 1)
-                     ^ ((hash<string>()(k.ipAddressB)
+                     ^ ((hash<address_id>()(k.ipAddressB)
                      ^ (hash<int>()(k.portB) << 1)) >> 1);
         }
     };
@@ -496,9 +545,9 @@ namespace std {
             using std::size_t;
             using std::hash;
             using std::string;
-            return ((hash<string>()(c.ipAddressA)
+            return ((hash<address_id>()(c.ipAddressA)
                      ^ (hash<int>()(c.portA) << 1)) >> 1)
-                     ^ ((hash<string>()(c.ipAddressB)
+                     ^ ((hash<address_id>()(c.ipAddressB)
                      ^ (hash<int>()(c.portB) << 1)) >> 1)
                      ^ (hash<string>()(c.protocol));
         }
@@ -510,36 +559,56 @@ namespace std {
             using std::size_t;
             using std::hash;
             using std::string;
-            return ((hash<string>()(k.ipAddress)
+            return ((hash<address_id>()(k.ipAddress)
                      ^ (hash<string>()(k.protocol) << 1)) >> 1);
         }
     };
 
+    template<>
+    struct hash<ipAddress_value> {
+        std::size_t operator()(const ipAddress_value &k) const {
+            return mix_bits(k.pack());
+        }
+    };
+
     template<>
     struct hash<ipAddress_inOut_port> {
         std::size_t operator()(const ipAddress_inOut_port &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.ipAddress)
-                     ^ (hash<string>()(k.trafficDirection) << 1)) >> 1)
-                   ^ (hash<int>()(k.portNumber) << 1);
+            return mix_bits(k.pack());
         }
     };
 
     template<>
     struct hash<unrecognized_PDU> {
         std::size_t operator()(const unrecognized_PDU &k) const {
-            using std::size_t;
-            using std::hash;
-            using std::string;
-            return ((hash<string>()(k.srcMacAddress)
-                     ^ (hash<string>()(k.dstMacAddress) << 1)) >> 1)
-                   ^ (hash<uint32_t>()(k.typeNumber) << 1);
+            return mix_bits(mix_bits((static_cast<uint64_t>(k.srcMacAddress) << 32) | k.dstMacAddress) ^ k.typeNumber);
         }
     };
 }
 
+/*
+ * Value distributions of the hosts: the count of each 8 or 16 bit value of each host, updated with one lookup per value
+ */
+using host_values = flat_hash_map<ipAddress_value, int>;
+
+/*
+ * Value distributions of the hosts: the histogram of the 8 or 16 bit values of each host, see buildHostHistograms
+ */
+template<uint32_t Width>
+using host_histograms = flat_hash_map<address_id, adaptive_histogram<Width>, mixed_integer_hash>;
+
+/*
+ * Groups the counted values by host, when the distributions are written
+ */
+template<uint32_t Width>
+host_histograms<Width> buildHostHistograms(const host_values &values) {
+    host_histograms<Width> histograms;
+    for (const host_values::value_type &count: values) {
+        histograms[count.first.ipAddress][count.first.value] += count.second;
+    }
+    return histograms;
+}
+
 class statistics {
 public:
     /*
@@ -557,47 +626,61 @@ public:
     */
     void incrementPacketCount();
 
-    void calculateIPIntervalPacketRate(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds intervalStartTimestamp);
+    void setPacketCount(int count);
+
+    void calculateIPIntervalPacketRate(std::chrono::duration<int, std::micro> interval);
 
-    void incrementMSScount(const std::string &ipAddress, int mssValue);
+    void incrementMSScount(address_id ipAddress, int mssValue);
 
-    void incrementWinCount(const std::string &ipAddress, int winSize);
+    void incrementWinCount(address_id ipAddress, int winSize);
 
-    void addConvStat(const std::string &ipAddressSender,int sport, const std::string &ipAddressReceiver,int dport, std::chrono::microseconds timestamp, small_uint<12> flags);
+    void addConvStat(address_id ipAddressSender,int sport, address_id ipAddressReceiver,int dport, std::chrono::microseconds timestamp, small_uint<12> flags);
 
-    void addConvStatExt(const std::string &ipAddressSender,int sport, const std::string &ipAddressReceiver,int dport, const std::string &protocol, std::chrono::microseconds timestamp);
+    void addConvStatExt(address_id ipAddressSender,int sport, address_id ipAddressReceiver,int dport, const std::string &protocol, std::chrono::microseconds timestamp);
 
     void createCommIntervalStats();
 
     std::vector<double> calculateIPsCumEntropy();
 
-    std::vector<double> calculateLastIntervalIPsEntropy(std::chrono::microseconds intervalStartTimestamp);
+    std::vector<double> calculateLastIntervalIPsEntropy();
+
+    void collectIntervalIPsPktsCounts(entry_shardIntervalStat &counts);
+
+    std::vector<double> calculateIPsEntropy(const entry_shardIntervalStat &counts);
 
-    std::vector<double> calculateEntropies(std::unordered_map<int, int> &map, std::unordered_map<int, int> &old);
+    void collectIPsCumPktsCounts(entry_shardIntervalStat &counts);
+
+    std::vector<double> calculateIPsCumEntropy(const entry_shardIntervalStat &counts);
+
+    std::vector<double> calculateEntropies(const std::vector<int> &values, const std::vector<int> &old);
 
     void addIntervalStat(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds intervalStartTimestamp, std::chrono::microseconds lastPktTimestamp);
 
     void checkPayload(const PDU *pdu_l4);
 
+    void checkPayload(uint32_t payloadSize);
+
     void checkTCPChecksum(const std::string &ipAddressSender, const std::string &ipAddressReceiver, TCP tcpPkt);
 
+    void checkTCPChecksum(uint32_t ipAddressSender, uint32_t ipAddressReceiver, const uint8_t *segment, uint32_t segmentSize);
+
     void checkToS(uint8_t ToS);
 
-    void incrementToScount(const std::string &ipAddress, int tosValue);
+    void incrementToScount(address_id ipAddress, int tosValue);
 
-    void incrementTTLcount(const std::string &ipAddress, int ttlValue);
+    void incrementTTLcount(address_id ipAddress, int ttlValue);
 
-    void incrementProtocolCount(const std::string &ipAddress, const std::string &protocol);
+    void incrementProtocolCount(address_id ipAddress, const std::string &protocol);
 
-    void increaseProtocolByteCount(const std::string &ipAddress, const std::string &protocol, long bytesSent);
+    void increaseProtocolByteCount(address_id ipAddress, const std::string &protocol, long bytesSent);
 
-    void incrementUnrecognizedPDUCount(const std::string &srcMac, const std::string &dstMac, uint32_t typeNumber,
+    void incrementUnrecognizedPDUCount(address_id srcMac, address_id dstMac, uint32_t typeNumber,
                                        const std::string &timestamp);
 
-    void incrementPortCount(const std::string &ipAddressSender, int outgoingPort, const std::string &ipAddressReceiver,
+    void incrementPortCount(address_id ipAddressSender, int outgoingPort, address_id ipAddressReceiver,
                             int incomingPort, const std::string &protocol);
 
-    void increasePortByteCount(const std::string &ipAddressSender, int outgoingPort, const std::string &ipAddressReceiver,
+    void increasePortByteCount(address_id ipAddressSender, int outgoingPort, address_id ipAddressReceiver,
                                int incomingPort, long bytesSent, const std::string &protocol);
 
     int getProtocolCount(const std::string &ipAddress, const std::string &protocol);
@@ -611,20 +694,23 @@ public:
     Tins::Timestamp getTimestampFirstPacket();
     Tins::Timestamp getTimestampLastPacket();
 
-    void assignMacAddress(const std::string &ipAddress, const std::string &macAddress);
+    void assignMacAddress(address_id ipAddress, address_id macAddress);
 
-    void addIpStat_packetSent(const std::string &ipAddressSender, const std::string &ipAddressReceiver, long bytesSent, std::chrono::microseconds timestamp);
+    void addIpStat_packetSent(address_id ipAddressSender, address_id ipAddressReceiver, long bytesSent);
 
     int getPacketCount();
 
     int getSumPacketSize();
 
-    void addMSS(const std::string &ipAddress, int MSSvalue);
+    void addMSS(address_id ipAddress, int MSSvalue);
 
     void writeToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeInterval, bool del);
 
     void writeIntervalsToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del);
 
+    void writeStreamToDatabase(std::string database_path, std::vector<std::chrono::duration<int, std::micro>> timeIntervals,
+                               std::chrono::microseconds idleBefore, bool first, bool last);
+
     void addPacketSize(uint32_t packetSize);
 
     std::string getCaptureDurationTimestamp() const;
@@ -643,6 +729,72 @@ public:
 
     void setDefaultInterval(int interval);
 
+    /*
+     * Sharded aggregation: every shard only processes the packets routed to it and only updates the entries of the
+     * hosts and host pairs it owns. The capture-wide counters are kept by the first shard, which sees all packets, owns
+     * no hosts and which all shards are combined into.
+     */
+    void setShard(unsigned int index, unsigned int count);
+
+    static unsigned int getHostShard(std::size_t hash, unsigned int count) {
+        return count == 1 ? 0 : 1 + static_cast<unsigned int>(hash % (count - 1));
+    }
+
+    static unsigned int getHostPairShard(std::size_t hashA, std::size_t hashB, unsigned int count) {
+        return getHostShard(hashA + hashB, count);
+    }
+
+    bool ownsCaptureCounters() const { return shardIndex == 0; }
+
+    bool ownsHost(address_id ipAddress) const {
+        return shardCount == 1 || getHostShard(addresses.get_hash(ipAddress), shardCount) == shardIndex;
+    }
+
+    bool ownsHostPair(address_id ipAddressA, address_id ipAddressB) const {
+        return shardCount == 1 ||
+               getHostPairShard(addresses.get_hash(ipAddressA), addresses.get_hash(ipAddressB), shardCount) == shardIndex;
+    }
+
+    void combineShards(const std::vector<statistics *> &shards);
+
+    void merge(const statistics &other);
+
+    void scaleSampledCounts(const std::string &mode, int rate);
+
+    /*
+     * Deferred intervals: the statistics of a part of a capture processed by its own thread record what the packets
+     * of every time interval added instead of registering the interval statistics, as these depend on the packets
+     * before. merge registers the recorded intervals as if the packets had been processed after its own packets.
+     */
+    void setDeferredIntervals(bool enabled);
+
+    bool continueDeferredInterval(std::chrono::duration<int, std::micro> interval, std::chrono::microseconds start);
+
+    /*
+     * Sketch mode: the per-host TTL, MSS, window size, ToS and port distributions are counted by a Count-Min Sketch
+     * and the degrees by HyperLogLog, see statistics_sketch. materializeSketches fills the tables with the estimates.
+     */
+    void setSketchMode(bool enabled);
+
+    bool getSketchMode() const;
+
+    void materializeSketches();
+
+    uint64_t getSketchErrorBound() const;
+
+    /*
+     * Checkpoints: the collected statistics are written to and restored from a binary snapshot, see
+     * statistics_checkpoint. The shard fields are not part of it, as checkpoints are only written by a single thread.
+     */
+    void saveCheckpoint(checkpoint_writer &out) const;
+
+    void loadCheckpoint(checkpoint_reader &in);
+
+    /*
+     * The containers are keyed by the ids of the addresses, which are interned when the packets are processed
+     */
+    address_dictionary &getAddresses() { return addresses; }
+
     /*
      * IP Address-specific statistics
      */
@@ -654,7 +806,7 @@ private:
      */
     Tins::Timestamp timestamp_firstPacket;
     Tins::Timestamp timestamp_lastPacket;
-    float sumPacketSize = 0;
+    double sumPacketSize = 0;
     int packetCount = 0;
     std::string resourcePath;
 
@@ -675,7 +827,7 @@ private:
     int intervalIncorrectTCPChecksumCount = 0;
     int intervalCorrectTCPChecksumCount = 0;
     int intervalCumPktCount = 0;
-    float intervalCumSumPktSize = 0;
+    double intervalCumSumPktSize = 0;
     size_t ip_src_novel_count = 0;
     size_t ip_dst_novel_count = 0;
     int intervalCumNovelIPCount = 0;
@@ -684,29 +836,57 @@ private:
     int intervalCumNovelToSCount = 0;
     int intervalCumNovelMSSCount = 0;
     int intervalCumNovelPortCount = 0;
-    std::unordered_map<std::string, entry_ipStat> intervalCumIPStats;
-    std::unordered_map<int,int> intervalCumTTLValues;
-    std::unordered_map<int,int> intervalCumWinSizeValues;
-    std::unordered_map<int,int> intervalCumTosValues;
-    std::unordered_map<int,int> intervalCumMSSValues;
-    std::unordered_map<int,int> intervalCumPortValues;
+    // The IPs which sent or received packets since the last interval of any length
+    std::vector<address_id> intervalIPs;
+    // The number of IPs per number of packets sent and received up to the last interval of any length
+    std::map<long, long> intervalCumIPSrcPktsCounts;
+    std::map<long, long> intervalCumIPDstPktsCounts;
+    dense_histogram<HISTOGRAM_BYTE_VALUES> intervalCumTTLValues;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> intervalCumWinSizeValues;
+    dense_histogram<HISTOGRAM_BYTE_VALUES> intervalCumTosValues;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> intervalCumMSSValues;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> intervalCumPortValues;
+    // Lengths of the intervals, whose packet and kbyte rates of the IPs were calculated, in microseconds
+    std::vector<int> rateIntervals;
+    // The IPs which sent in the current interval of every length, in the order of rateIntervals
+    std::vector<std::vector<address_id>> rateIntervalSenders;
+    // The IPs with a minimal interval rate other than 0, which an interval without sent packets resets to 0
+    std::vector<address_id> ratedIPs;
 
     int default_interval = 0;
 
+    // Variables that are used for deferred intervals
+    bool deferredIntervals = false;
+    std::vector<entry_intervalDelta> interval_deltas;
+
+    // Variables that are used in sketch mode
+    bool sketchMode = false;
+    statistics_sketch sketch;
+
+    // Variables that are used for sharded aggregation
+    unsigned int shardIndex = 0;
+    unsigned int shardCount = 1;
+    std::unordered_map<address_id, entry_shardIpStat> shard_ip_updates;
+    std::vector<entry_shardIntervalStat> shard_interval_statistics;
+    std::vector<std::string> shard_interval_keys;
+
     /*
      * Data containers
      */
+    // {Address id, IP or MAC Address}, the keys of all containers below
+    address_dictionary addresses;
+
     // {IP Address, TTL value, count}
-    std::unordered_map<ipAddress_ttl, int> ttl_distribution;
+    host_values ttl_distribution;
 
     // {IP Address, MSS value, count}
-    std::unordered_map<ipAddress_mss, int> mss_distribution;
+    host_values mss_distribution;
 
     // {IP Address, Win size, count}
-    std::unordered_map<ipAddress_win, int> win_distribution;
+    host_values win_distribution;
 
     // {IP Address, ToS value, count}
-    std::unordered_map<ipAddress_tos, int> tos_distribution;
+    host_values tos_distribution;
 
     // {IP Address A, Port A, IP Address B, Port B,   #packets, packets timestamps, inter-arrival times,
     // average of inter-arrival times}
@@ -723,43 +903,68 @@ private:
     std::unordered_map<std::string, entry_intervalStat> interval_statistics;
 
     // {TTL value, count}
-    std::unordered_map<int, int> ttl_values;
+    dense_histogram<HISTOGRAM_BYTE_VALUES> ttl_values;
 
     // {Win size, count}
-    std::unordered_map<int, int> win_values;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> win_values;
 
     // {ToS, count}
-    std::unordered_map<int, int> tos_values;
+    dense_histogram<HISTOGRAM_BYTE_VALUES> tos_values;
 
     // {MSS, count}
-    std::unordered_map<int, int> mss_values;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> mss_values;
 
     // {Port, count}
-    std::unordered_map<int, int> port_values;
+    dense_histogram<HISTOGRAM_SHORT_VALUES> port_values;
 
 
     //{IP Address, contacted IP Addresses}
-    std::unordered_map<std::string, std::unordered_set<std::string>> contacted_ips;
+    std::unordered_map<address_id, std::unordered_set<address_id>> contacted_ips;
 
     // {IP Address, Protocol,  #count, #Data transmitted in bytes}
     std::unordered_map<ipAddress_protocol, entry_protocolStat> protocol_distribution;
 
     // {IP Address,  #received packets, #sent packets, Data received in kbytes, Data sent in kbytes}
-    std::unordered_map<std::string, entry_ipStat> ip_statistics;
+    std::unordered_map<address_id, entry_ipStat> ip_statistics;
 
-    // {IP Address, in_out, Port Number,  #count, #Data transmitted in bytes}
-    std::unordered_map<ipAddress_inOut_port, entry_portStat> ip_ports;
+    // {IP Address, in_out, Port Number, Protocol,  #count, #Data transmitted in bytes}
+    flat_hash_map<ipAddress_inOut_port, entry_portStat> ip_ports;
 
     // {IP Address, MAC Address}
-    std::unordered_map<std::string, std::string> ip_mac_mapping;
+    std::unordered_map<address_id, address_id> ip_mac_mapping;
 
     // {Source MAC, Destination MAC, typeNumber, #count, #timestamp of last occurrence}
-    std::unordered_map<unrecognized_PDU, unrecognized_PDU_stat> unrecognized_PDUs;
+    flat_hash_map<unrecognized_PDU, unrecognized_PDU_stat> unrecognized_PDUs;
+
+    // {Table name, sampling mode, sampling rate, #sampled observations, scaled, relative error}
+    std::vector<entry_samplingStat> sampling_statistics;
 
     /*
      * Helper functions
      */
     void storeConvStat(conv *conversation, const std::chrono::microseconds timestamp, const small_uint<12> *flags);
+
+    std::size_t findRateInterval(int interval);
+
+    void collectRateIPs();
+
+    void countIntervalIPs();
+
+    void clearIntervalIPs();
+
+    void collectIntervalIPs();
+
+    entry_intervalDelta getIntervalDelta(std::chrono::duration<int, std::micro> interval,
+                                         std::chrono::microseconds intervalStartTimestamp,
+                                         std::chrono::microseconds intervalEndTimestamp) const;
+
+    void addIntervalDelta(const entry_intervalDelta &delta, const std::vector<address_id> &remap);
+
+    void resetIntervalState();
+
+    bool writeFileStatistics(statistics_db &db);
+
+    void writeHostStatistics(statistics_db &db);
 };
 
 
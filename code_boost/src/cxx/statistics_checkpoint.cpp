@@ -0,0 +1,509 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "statistics_checkpoint.h"
+
+/**
+ * Creates the temporary file of a checkpoint.
+ * @param filePath The path of the checkpoint file.
+ */
+checkpoint_writer::checkpoint_writer(const std::string &filePath) : filePath(filePath), tempPath(filePath + ".tmp"),
+                                                                    file(nullptr) {
+    file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        error = std::strerror(errno);
+        return;
+    }
+    buffer.reserve(CHECKPOINT_BUFFER_SIZE);
+}
+
+/**
+ * Removes the temporary file, unless the checkpoint was committed.
+ */
+checkpoint_writer::~checkpoint_writer() {
+    if (file != nullptr) {
+        fclose(file);
+        std::remove(tempPath.c_str());
+    }
+}
+
+/**
+ * Appends bytes to the checkpoint.
+ * @param bytes The bytes.
+ * @param size The number of bytes.
+ */
+void checkpoint_writer::write(const void *bytes, std::size_t size) {
+    if (file == nullptr || !error.empty()) {
+        return;
+    }
+    if (buffer.size() + size > CHECKPOINT_BUFFER_SIZE) {
+        flush();
+        // Large arrays are written without copying them into the buffer
+        if (size > CHECKPOINT_BUFFER_SIZE) {
+            if (fwrite(bytes, 1, size, file) != size) {
+                error = std::strerror(errno);
+            }
+            return;
+        }
+    }
+    const char *begin = static_cast<const char *>(bytes);
+    buffer.insert(buffer.end(), begin, begin + size);
+}
+
+/**
+ * Writes the buffered bytes to the temporary file.
+ */
+void checkpoint_writer::flush() {
+    if (!buffer.empty() && error.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        error = std::strerror(errno);
+    }
+    buffer.clear();
+}
+
+/**
+ * Writes the rest of the checkpoint to disk and replaces the previous checkpoint file with it.
+ * @return false if the checkpoint could not be written, the previous checkpoint file is kept then.
+ */
+bool checkpoint_writer::commit() {
+    if (file == nullptr) {
+        return false;
+    }
+    flush();
+    if (error.empty() && (fflush(file) != 0 || fsync(fileno(file)) != 0)) {
+        error = std::strerror(errno);
+    }
+    if (fclose(file) != 0 && error.empty()) {
+        error = std::strerror(errno);
+    }
+    file = nullptr;
+    if (error.empty() && std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        error = std::strerror(errno);
+    }
+    if (!error.empty()) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @return the error message of the first failed operation.
+ */
+const std::string &checkpoint_writer::get_error() const {
+    return error;
+}
+
+/**
+ * Opens a checkpoint file.
+ * @param filePath The path of the checkpoint file.
+ */
+checkpoint_reader::checkpoint_reader(const std::string &filePath) : file(nullptr), remaining(0), damaged(false) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        return;
+    }
+    file = fopen(filePath.c_str(), "rb");
+    if (file != nullptr) {
+        buffer.resize(CHECKPOINT_BUFFER_SIZE);
+        setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+        remaining = static_cast<uint64_t>(fileStat.st_size);
+    }
+}
+
+checkpoint_reader::~checkpoint_reader() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+/**
+ * @return true if the checkpoint file exists and could be opened.
+ */
+bool checkpoint_reader::is_open() const {
+    return file != nullptr;
+}
+
+/**
+ * Reads bytes of the checkpoint.
+ * @param bytes Set to the bytes read, or to zero if the checkpoint is damaged.
+ * @param size The number of bytes.
+ */
+void checkpoint_reader::read(void *bytes, std::size_t size) {
+    if (file == nullptr || damaged || size > remaining || fread(bytes, 1, size, file) != size) {
+        damaged = true;
+        std::memset(bytes, 0, size);
+        return;
+    }
+    remaining -= size;
+}
+
+/**
+ * Reads the number of elements of a container.
+ * @param elementSize The minimum number of bytes of an element, to detect lengths larger than the rest of the file.
+ * @return the number of elements, 0 if the checkpoint is damaged.
+ */
+std::size_t checkpoint_reader::read_length(std::size_t elementSize) {
+    uint64_t length = 0;
+    read(&length, sizeof(length));
+    if (length > remaining / elementSize) {
+        damaged = true;
+        return 0;
+    }
+    return static_cast<std::size_t>(length);
+}
+
+/**
+ * @return true if the checkpoint file ended early or contains an invalid length.
+ */
+bool checkpoint_reader::is_damaged() const {
+    return damaged;
+}
+
+void checkpoint_save(checkpoint_writer &out, const std::string &value) {
+    checkpoint_save(out, static_cast<uint64_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+void checkpoint_load(checkpoint_reader &in, std::string &value) {
+    value.resize(in.read_length(1));
+    if (!value.empty()) {
+        in.read(&value[0], value.size());
+    }
+}
+
+void checkpoint_save(checkpoint_writer &out, const Tins::Timestamp &value) {
+    checkpoint_save(out, static_cast<std::chrono::microseconds>(value));
+}
+
+void checkpoint_load(checkpoint_reader &in, Tins::Timestamp &value) {
+    std::chrono::microseconds timestamp;
+    checkpoint_load(in, timestamp);
+    value = Tins::Timestamp(timestamp);
+}
+
+void checkpoint_save(checkpoint_writer &out, const small_uint<12> &value) {
+    checkpoint_save(out, static_cast<uint16_t>(value));
+}
+
+void checkpoint_load(checkpoint_reader &in, small_uint<12> &value) {
+    uint16_t flags = 0;
+    checkpoint_load(in, flags);
+    value = small_uint<12>(flags);
+}
+
+void checkpoint_save(checkpoint_writer &out, const conv &value) {
+    checkpoint_save(out, value.ipAddressA);
+    checkpoint_save(out, value.portA);
+    checkpoint_save(out, value.ipAddressB);
+    checkpoint_save(out, value.portB);
+}
+
+void checkpoint_load(checkpoint_reader &in, conv &value) {
+    checkpoint_load(in, value.ipAddressA);
+    checkpoint_load(in, value.portA);
+    checkpoint_load(in, value.ipAddressB);
+    checkpoint_load(in, value.portB);
+}
+
+void checkpoint_save(checkpoint_writer &out, const convWithProt &value) {
+    checkpoint_save(out, value.ipAddressA);
+    checkpoint_save(out, value.portA);
+    checkpoint_save(out, value.ipAddressB);
+    checkpoint_save(out, value.portB);
+    checkpoint_save(out, value.protocol);
+}
+
+void checkpoint_load(checkpoint_reader &in, convWithProt &value) {
+    checkpoint_load(in, value.ipAddressA);
+    checkpoint_load(in, value.portA);
+    checkpoint_load(in, value.ipAddressB);
+    checkpoint_load(in, value.portB);
+    checkpoint_load(in, value.protocol);
+}
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_value &value) {
+    checkpoint_save(out, value.ipAddress);
+    checkpoint_save(out, value.value);
+}
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_value &value) {
+    checkpoint_load(in, value.ipAddress);
+    checkpoint_load(in, value.value);
+}
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_protocol &value) {
+    checkpoint_save(out, value.ipAddress);
+    checkpoint_save(out, value.protocol);
+}
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_protocol &value) {
+    checkpoint_load(in, value.ipAddress);
+    checkpoint_load(in, value.protocol);
+}
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_inOut_port &value) {
+    checkpoint_save(out, value.ipAddress);
+    checkpoint_save(out, value.portNumber);
+    checkpoint_save(out, value.incoming);
+    checkpoint_save(out, value.udp);
+}
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_inOut_port &value) {
+    checkpoint_load(in, value.ipAddress);
+    checkpoint_load(in, value.portNumber);
+    checkpoint_load(in, value.incoming);
+    checkpoint_load(in, value.udp);
+}
+
+void checkpoint_save(checkpoint_writer &out, const unrecognized_PDU &value) {
+    checkpoint_save(out, value.srcMacAddress);
+    checkpoint_save(out, value.dstMacAddress);
+    checkpoint_save(out, value.typeNumber);
+}
+
+void checkpoint_load(checkpoint_reader &in, unrecognized_PDU &value) {
+    checkpoint_load(in, value.srcMacAddress);
+    checkpoint_load(in, value.dstMacAddress);
+    checkpoint_load(in, value.typeNumber);
+}
+
+void checkpoint_save(checkpoint_writer &out, const unrecognized_PDU_stat &value) {
+    checkpoint_save(out, value.count);
+    checkpoint_save(out, value.timestamp_last_occurrence);
+}
+
+void checkpoint_load(checkpoint_reader &in, unrecognized_PDU_stat &value) {
+    checkpoint_load(in, value.count);
+    checkpoint_load(in, value.timestamp_last_occurrence);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_ipIntervalCount &value) {
+    checkpoint_save(out, value.pkts_sent);
+    checkpoint_save(out, value.bytes_sent);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_ipIntervalCount &value) {
+    checkpoint_load(in, value.pkts_sent);
+    checkpoint_load(in, value.bytes_sent);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_ipStat &value) {
+    checkpoint_save(out, value.pkts_received);
+    checkpoint_save(out, value.pkts_sent);
+    checkpoint_save(out, value.kbytes_received);
+    checkpoint_save(out, value.kbytes_sent);
+    checkpoint_save(out, value.bytes_sent);
+    checkpoint_save(out, value.ip_class);
+    checkpoint_save(out, value.in_degree);
+    checkpoint_save(out, value.out_degree);
+    checkpoint_save(out, value.overall_degree);
+    checkpoint_save(out, value.max_interval_pkt_rate);
+    checkpoint_save(out, value.min_interval_pkt_rate);
+    checkpoint_save(out, value.max_interval_kybte_rate);
+    checkpoint_save(out, value.min_interval_kybte_rate);
+    checkpoint_save(out, value.interarrival_times);
+    checkpoint_save(out, value.interval_counts);
+    checkpoint_save(out, value.interval_pkts_sent);
+    checkpoint_save(out, value.interval_pkts_received);
+    checkpoint_save(out, value.interval_bytes_sent);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_ipStat &value) {
+    checkpoint_load(in, value.pkts_received);
+    checkpoint_load(in, value.pkts_sent);
+    checkpoint_load(in, value.kbytes_received);
+    checkpoint_load(in, value.kbytes_sent);
+    checkpoint_load(in, value.bytes_sent);
+    checkpoint_load(in, value.ip_class);
+    checkpoint_load(in, value.in_degree);
+    checkpoint_load(in, value.out_degree);
+    checkpoint_load(in, value.overall_degree);
+    checkpoint_load(in, value.max_interval_pkt_rate);
+    checkpoint_load(in, value.min_interval_pkt_rate);
+    checkpoint_load(in, value.max_interval_kybte_rate);
+    checkpoint_load(in, value.min_interval_kybte_rate);
+    checkpoint_load(in, value.interarrival_times);
+    checkpoint_load(in, value.interval_counts);
+    checkpoint_load(in, value.interval_pkts_sent);
+    checkpoint_load(in, value.interval_pkts_received);
+    checkpoint_load(in, value.interval_bytes_sent);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_portStat &value) {
+    checkpoint_save(out, value.count);
+    checkpoint_save(out, value.byteCount);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_portStat &value) {
+    checkpoint_load(in, value.count);
+    checkpoint_load(in, value.byteCount);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_protocolStat &value) {
+    checkpoint_save(out, value.count);
+    checkpoint_save(out, value.byteCount);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_protocolStat &value) {
+    checkpoint_load(in, value.count);
+    checkpoint_load(in, value.byteCount);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_intervalStat &value) {
+    checkpoint_save(out, value.start);
+    checkpoint_save(out, value.end);
+    checkpoint_save(out, value.pkts_count);
+    checkpoint_save(out, value.pkt_rate);
+    checkpoint_save(out, value.kbytes);
+    checkpoint_save(out, value.kbyte_rate);
+    checkpoint_save(out, value.ip_entropies);
+    checkpoint_save(out, value.ip_cum_entropies);
+    checkpoint_save(out, value.ttl_entropies);
+    checkpoint_save(out, value.win_size_entropies);
+    checkpoint_save(out, value.tos_entropies);
+    checkpoint_save(out, value.mss_entropies);
+    checkpoint_save(out, value.port_entropies);
+    checkpoint_save(out, value.payload_count);
+    checkpoint_save(out, value.incorrect_tcp_checksum_count);
+    checkpoint_save(out, value.correct_tcp_checksum_count);
+    checkpoint_save(out, value.novel_ip_src_count);
+    checkpoint_save(out, value.novel_ip_dst_count);
+    checkpoint_save(out, value.novel_ttl_count);
+    checkpoint_save(out, value.novel_win_size_count);
+    checkpoint_save(out, value.novel_tos_count);
+    checkpoint_save(out, value.novel_mss_count);
+    checkpoint_save(out, value.novel_port_count);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_intervalStat &value) {
+    checkpoint_load(in, value.start);
+    checkpoint_load(in, value.end);
+    checkpoint_load(in, value.pkts_count);
+    checkpoint_load(in, value.pkt_rate);
+    checkpoint_load(in, value.kbytes);
+    checkpoint_load(in, value.kbyte_rate);
+    checkpoint_load(in, value.ip_entropies);
+    checkpoint_load(in, value.ip_cum_entropies);
+    checkpoint_load(in, value.ttl_entropies);
+    checkpoint_load(in, value.win_size_entropies);
+    checkpoint_load(in, value.tos_entropies);
+    checkpoint_load(in, value.mss_entropies);
+    checkpoint_load(in, value.port_entropies);
+    checkpoint_load(in, value.payload_count);
+    checkpoint_load(in, value.incorrect_tcp_checksum_count);
+    checkpoint_load(in, value.correct_tcp_checksum_count);
+    checkpoint_load(in, value.novel_ip_src_count);
+    checkpoint_load(in, value.novel_ip_dst_count);
+    checkpoint_load(in, value.novel_ttl_count);
+    checkpoint_load(in, value.novel_win_size_count);
+    checkpoint_load(in, value.novel_tos_count);
+    checkpoint_load(in, value.novel_mss_count);
+    checkpoint_load(in, value.novel_port_count);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_samplingStat &value) {
+    checkpoint_save(out, value.table);
+    checkpoint_save(out, value.mode);
+    checkpoint_save(out, value.rate);
+    checkpoint_save(out, value.sampledCount);
+    checkpoint_save(out, value.scaled);
+    checkpoint_save(out, value.relativeError);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_samplingStat &value) {
+    checkpoint_load(in, value.table);
+    checkpoint_load(in, value.mode);
+    checkpoint_load(in, value.rate);
+    checkpoint_load(in, value.sampledCount);
+    checkpoint_load(in, value.scaled);
+    checkpoint_load(in, value.relativeError);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_convStat &value) {
+    checkpoint_save(out, value.pkts_count);
+    checkpoint_save(out, value.avg_pkt_rate);
+    checkpoint_save(out, value.pkts_timestamp);
+    checkpoint_save(out, value.interarrival_time);
+    checkpoint_save(out, value.avg_interarrival_time);
+    checkpoint_save(out, value.tcp_types);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_convStat &value) {
+    checkpoint_load(in, value.pkts_count);
+    checkpoint_load(in, value.avg_pkt_rate);
+    checkpoint_load(in, value.pkts_timestamp);
+    checkpoint_load(in, value.interarrival_time);
+    checkpoint_load(in, value.avg_interarrival_time);
+    checkpoint_load(in, value.tcp_types);
+}
+
+void checkpoint_save(checkpoint_writer &out, const commInterval &value) {
+    checkpoint_save(out, value.start);
+    checkpoint_save(out, value.end);
+    checkpoint_save(out, value.pkts_count);
+}
+
+void checkpoint_load(checkpoint_reader &in, commInterval &value) {
+    checkpoint_load(in, value.start);
+    checkpoint_load(in, value.end);
+    checkpoint_load(in, value.pkts_count);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_convStatExt &value) {
+    checkpoint_save(out, value.comm_intervals);
+    checkpoint_save(out, value.pkts_count);
+    checkpoint_save(out, value.avg_pkt_rate);
+    checkpoint_save(out, value.avg_int_pkts_count);
+    checkpoint_save(out, value.avg_time_between_ints);
+    checkpoint_save(out, value.avg_interval_time);
+    checkpoint_save(out, value.total_comm_duration);
+    checkpoint_save(out, value.timeInterval);
+    checkpoint_save(out, value.pkts_timestamp);
+    checkpoint_save(out, value.interarrival_time);
+    checkpoint_save(out, value.avg_interarrival_time);
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_convStatExt &value) {
+    checkpoint_load(in, value.comm_intervals);
+    checkpoint_load(in, value.pkts_count);
+    checkpoint_load(in, value.avg_pkt_rate);
+    checkpoint_load(in, value.avg_int_pkts_count);
+    checkpoint_load(in, value.avg_time_between_ints);
+    checkpoint_load(in, value.avg_interval_time);
+    checkpoint_load(in, value.total_comm_duration);
+    checkpoint_load(in, value.timeInterval);
+    checkpoint_load(in, value.pkts_timestamp);
+    checkpoint_load(in, value.interarrival_time);
+    checkpoint_load(in, value.avg_interarrival_time);
+}
+
+void checkpoint_save(checkpoint_writer &out, const entry_sketchHost &value) {
+    value.contacted_out.save(out);
+    value.contacted_in.save(out);
+    value.contacted.save(out);
+    for (int distribution = 0; distribution < SKETCH_DISTRIBUTIONS; distribution++) {
+        checkpoint_save(out, value.values[distribution]);
+    }
+}
+
+void checkpoint_load(checkpoint_reader &in, entry_sketchHost &value) {
+    value.contacted_out.load(in);
+    value.contacted_in.load(in);
+    value.contacted.load(in);
+    for (int distribution = 0; distribution < SKETCH_DISTRIBUTIONS; distribution++) {
+        checkpoint_load(in, value.values[distribution]);
+    }
+}
+
+void checkpoint_save(checkpoint_writer &out, const packet_index_entry &value) {
+    checkpoint_save(out, value.packetNumber);
+    checkpoint_save(out, value.offset);
+    checkpoint_save(out, value.timestamp);
+}
+
+void checkpoint_load(checkpoint_reader &in, packet_index_entry &value) {
+    checkpoint_load(in, value.packetNumber);
+    checkpoint_load(in, value.offset);
+    checkpoint_load(in, value.timestamp);
+}
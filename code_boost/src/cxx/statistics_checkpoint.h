@@ -0,0 +1,350 @@
+/**
+ * Binary snapshots of the statistics collected so far, from which a later run resumes collect_statistics.
+ */
+
+#ifndef CPP_PCAPREADER_STATISTICS_CHECKPOINT_H
+#define CPP_PCAPREADER_STATISTICS_CHECKPOINT_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "pcap_reader.h"
+#include "statistics.h"
+
+/*
+ * Magic number and format version at the beginning of a checkpoint file. The version has to be increased whenever
+ * the layout of the checkpoint or of one of the serialized structs changes.
+ */
+#define CHECKPOINT_MAGIC 0x54504b4354324449ULL
+#define CHECKPOINT_VERSION 10
+
+/*
+ * Magic number of a statistics snapshot, the finished statistics of a capture in the checkpoint format, see
+ * pcap_processor::write_snapshot
+ */
+#define SNAPSHOT_MAGIC 0x50414e5354324449ULL
+
+/*
+ * Number of bytes buffered before they are written to the checkpoint file
+ */
+#define CHECKPOINT_BUFFER_SIZE (1 << 20)
+
+/*
+ * Writer of a checkpoint file. The checkpoint is written to a temporary file, which replaces the checkpoint file
+ * once it is complete, so that an interrupted write keeps the previous checkpoint.
+ */
+class checkpoint_writer {
+public:
+    checkpoint_writer(const std::string &filePath);
+
+    ~checkpoint_writer();
+
+    checkpoint_writer(const checkpoint_writer &) = delete;
+
+    checkpoint_writer &operator=(const checkpoint_writer &) = delete;
+
+    void write(const void *bytes, std::size_t size);
+
+    bool commit();
+
+    const std::string &get_error() const;
+
+private:
+    std::string filePath;
+    std::string tempPath;
+    FILE *file;
+    std::vector<char> buffer;
+    std::string error;
+
+    void flush();
+};
+
+/*
+ * Reader of a checkpoint file. A read past the end of the file or a length larger than the rest of the file marks
+ * the checkpoint as damaged, the values read afterwards are zero.
+ */
+class checkpoint_reader {
+public:
+    checkpoint_reader(const std::string &filePath);
+
+    ~checkpoint_reader();
+
+    checkpoint_reader(const checkpoint_reader &) = delete;
+
+    checkpoint_reader &operator=(const checkpoint_reader &) = delete;
+
+    bool is_open() const;
+
+    void read(void *bytes, std::size_t size);
+
+    std::size_t read_length(std::size_t elementSize);
+
+    bool is_damaged() const;
+
+private:
+    FILE *file;
+    std::vector<char> buffer;
+    uint64_t remaining;
+    bool damaged;
+};
+
+/*
+ * Serialization of the values kept by the statistics. Arithmetic values are stored in native byte order, checkpoints
+ * are only resumed on the machine which wrote them. Unordered containers are stored with their bucket count, so
+ * that they are restored with the same iteration order, which keeps sums of floating point values identical.
+ */
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type checkpoint_save(checkpoint_writer &out, const T &value) {
+    out.write(&value, sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type checkpoint_load(checkpoint_reader &in, T &value) {
+    in.read(&value, sizeof(T));
+}
+
+void checkpoint_save(checkpoint_writer &out, const std::string &value);
+
+void checkpoint_load(checkpoint_reader &in, std::string &value);
+
+template<typename Rep, typename Period>
+void checkpoint_save(checkpoint_writer &out, const std::chrono::duration<Rep, Period> &value) {
+    checkpoint_save(out, value.count());
+}
+
+template<typename Rep, typename Period>
+void checkpoint_load(checkpoint_reader &in, std::chrono::duration<Rep, Period> &value) {
+    Rep count = 0;
+    checkpoint_load(in, count);
+    value = std::chrono::duration<Rep, Period>(count);
+}
+
+void checkpoint_save(checkpoint_writer &out, const Tins::Timestamp &value);
+
+void checkpoint_load(checkpoint_reader &in, Tins::Timestamp &value);
+
+void checkpoint_save(checkpoint_writer &out, const small_uint<12> &value);
+
+void checkpoint_load(checkpoint_reader &in, small_uint<12> &value);
+
+void checkpoint_save(checkpoint_writer &out, const conv &value);
+
+void checkpoint_load(checkpoint_reader &in, conv &value);
+
+void checkpoint_save(checkpoint_writer &out, const convWithProt &value);
+
+void checkpoint_load(checkpoint_reader &in, convWithProt &value);
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_value &value);
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_value &value);
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_protocol &value);
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_protocol &value);
+
+void checkpoint_save(checkpoint_writer &out, const ipAddress_inOut_port &value);
+
+void checkpoint_load(checkpoint_reader &in, ipAddress_inOut_port &value);
+
+void checkpoint_save(checkpoint_writer &out, const unrecognized_PDU &value);
+
+void checkpoint_load(checkpoint_reader &in, unrecognized_PDU &value);
+
+void checkpoint_save(checkpoint_writer &out, const unrecognized_PDU_stat &value);
+
+void checkpoint_load(checkpoint_reader &in, unrecognized_PDU_stat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_ipIntervalCount &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_ipIntervalCount &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_ipStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_ipStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_portStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_portStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_protocolStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_protocolStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_intervalStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_intervalStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_samplingStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_samplingStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_convStat &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_convStat &value);
+
+void checkpoint_save(checkpoint_writer &out, const commInterval &value);
+
+void checkpoint_load(checkpoint_reader &in, commInterval &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_convStatExt &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_convStatExt &value);
+
+void checkpoint_save(checkpoint_writer &out, const entry_sketchHost &value);
+
+void checkpoint_load(checkpoint_reader &in, entry_sketchHost &value);
+
+void checkpoint_save(checkpoint_writer &out, const packet_index_entry &value);
+
+void checkpoint_load(checkpoint_reader &in, packet_index_entry &value);
+
+template<typename T>
+void checkpoint_save(checkpoint_writer &out, const std::vector<T> &values) {
+    checkpoint_save(out, static_cast<uint64_t>(values.size()));
+    if (std::is_arithmetic<T>::value) {
+        out.write(values.data(), values.size() * sizeof(T));
+        return;
+    }
+    for (const T &value: values) {
+        checkpoint_save(out, value);
+    }
+}
+
+template<typename T>
+void checkpoint_load(checkpoint_reader &in, std::vector<T> &values) {
+    values.resize(in.read_length(std::is_arithmetic<T>::value ? sizeof(T) : 1));
+    if (std::is_arithmetic<T>::value) {
+        in.read(values.data(), values.size() * sizeof(T));
+        return;
+    }
+    for (T &value: values) {
+        checkpoint_load(in, value);
+    }
+}
+
+template<typename Key, typename Value>
+void checkpoint_save(checkpoint_writer &out, const std::pair<const Key, Value> &value) {
+    checkpoint_save(out, value.first);
+    checkpoint_save(out, value.second);
+}
+
+/*
+ * Unordered containers are saved in reverse iteration order: Inserted in this order into as many buckets, the
+ * elements are iterated in the original order again.
+ */
+template<typename Container>
+void checkpoint_save_unordered(checkpoint_writer &out, const Container &values) {
+    checkpoint_save(out, static_cast<uint64_t>(values.bucket_count()));
+    checkpoint_save(out, static_cast<uint64_t>(values.size()));
+    std::vector<const typename Container::value_type *> elements;
+    elements.reserve(values.size());
+    for (const typename Container::value_type &value: values) {
+        elements.push_back(&value);
+    }
+    for (auto i = elements.rbegin(); i != elements.rend(); i++) {
+        checkpoint_save(out, **i);
+    }
+}
+
+template<typename Value>
+void checkpoint_save(checkpoint_writer &out, const std::unordered_set<Value> &values) {
+    checkpoint_save_unordered(out, values);
+}
+
+template<typename Value>
+void checkpoint_load(checkpoint_reader &in, std::unordered_set<Value> &values) {
+    uint64_t bucketCount = 0;
+    checkpoint_load(in, bucketCount);
+    std::size_t size = in.read_length(1);
+    values.clear();
+    values.rehash(static_cast<std::size_t>(bucketCount));
+    for (std::size_t i = 0; i < size && !in.is_damaged(); i++) {
+        Value value;
+        checkpoint_load(in, value);
+        values.insert(value);
+    }
+}
+
+template<typename Key, typename Value>
+void checkpoint_save(checkpoint_writer &out, const std::unordered_map<Key, Value> &values) {
+    checkpoint_save_unordered(out, values);
+}
+
+template<typename Key, typename Value>
+void checkpoint_load(checkpoint_reader &in, std::unordered_map<Key, Value> &values) {
+    uint64_t bucketCount = 0;
+    checkpoint_load(in, bucketCount);
+    std::size_t size = in.read_length(1);
+    values.clear();
+    values.rehash(static_cast<std::size_t>(bucketCount));
+    for (std::size_t i = 0; i < size && !in.is_damaged(); i++) {
+        Key key;
+        checkpoint_load(in, key);
+        checkpoint_load(in, values[key]);
+    }
+}
+
+/*
+ * Histograms are saved as the values with a count other than 0 and their counts, in the order of the values
+ */
+template<uint32_t Width>
+void checkpoint_save(checkpoint_writer &out, const dense_histogram<Width> &values) {
+    const std::vector<int> &counts = values.get_counts();
+    checkpoint_save(out, static_cast<uint64_t>(values.size()));
+    for (std::size_t value = 0; value < counts.size(); value++) {
+        if (counts[value] != 0) {
+            checkpoint_save(out, static_cast<uint32_t>(value));
+            checkpoint_save(out, counts[value]);
+        }
+    }
+}
+
+template<uint32_t Width>
+void checkpoint_load(checkpoint_reader &in, dense_histogram<Width> &values) {
+    std::size_t size = in.read_length(sizeof(uint32_t) + sizeof(int));
+    values.clear();
+    for (std::size_t i = 0; i < size && !in.is_damaged(); i++) {
+        uint32_t value = 0;
+        int count = 0;
+        checkpoint_load(in, value);
+        checkpoint_load(in, count);
+        values.add(value, count);
+    }
+}
+
+/*
+ * Flat hash maps are saved in iteration order with their capacity: Inserted in this order into as many slots, the
+ * entries take the same slots and are iterated in the original order again.
+ */
+template<typename Key, typename Value, typename Hash>
+void checkpoint_save(checkpoint_writer &out, const flat_hash_map<Key, Value, Hash> &values) {
+    checkpoint_save(out, static_cast<uint64_t>(values.capacity()));
+    checkpoint_save(out, static_cast<uint64_t>(values.size()));
+    for (const typename flat_hash_map<Key, Value, Hash>::value_type &value: values) {
+        checkpoint_save(out, value.first);
+        checkpoint_save(out, value.second);
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void checkpoint_load(checkpoint_reader &in, flat_hash_map<Key, Value, Hash> &values) {
+    uint64_t capacity = 0;
+    checkpoint_load(in, capacity);
+    std::size_t size = in.read_length(1);
+    values.clear();
+    values.reserve(static_cast<std::size_t>(capacity) / 4 * 3);
+    for (std::size_t i = 0; i < size && !in.is_damaged(); i++) {
+        Key key;
+        checkpoint_load(in, key);
+        checkpoint_load(in, values[key]);
+    }
+}
+
+#endif //CPP_PCAPREADER_STATISTICS_CHECKPOINT_H
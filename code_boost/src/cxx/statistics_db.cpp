@@ -58,11 +58,35 @@ void statistics_db::getNoneExtraTestsInveralStats(std::vector<double>& intervals
     }
 }
 
+/**
+ * Reads the packet index entry of the given packet or of the closest packet before it.
+ * @param packetNumber The number of the packet, starting with 1.
+ * @param entry Set to the packet index entry.
+ * @return false if the database has no packet index or no entry before the packet.
+ */
+bool statistics_db::readPacketIndex(uint64_t packetNumber, packet_index_entry &entry) {
+    try {
+        SQLite::Statement query(*db, "SELECT packetNumber, fileOffset, timestamp FROM packet_index "
+                "WHERE packetNumber <= ? ORDER BY packetNumber DESC LIMIT 1;");
+        query.bind(1, static_cast<long long>(packetNumber));
+        if (query.executeStep()) {
+            entry.packetNumber = static_cast<uint64_t>(query.getColumn(0).getInt64());
+            entry.offset = static_cast<uint64_t>(query.getColumn(1).getInt64());
+            entry.timestamp = query.getColumn(2).getInt64();
+            return true;
+        }
+    } catch (std::exception &e) {
+        // Databases written by earlier versions have no packet index
+    }
+    return false;
+}
+
 /**
  * Writes the IP statistics into the database.
  * @param ipStatistics The IP statistics from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsIP(const std::unordered_map<std::string, entry_ipStat> &ipStatistics) {
+void statistics_db::writeStatisticsIP(const std::unordered_map<address_id, entry_ipStat> &ipStatistics, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_statistics");
         SQLite::Transaction transaction(*db);
@@ -89,7 +113,7 @@ void statistics_db::writeStatisticsIP(const std::unordered_map<std::string, entr
             int maxDelay;
             std::chrono::microseconds avgDelay;
             calculate_latency(&e.interarrival_times, &maxDelay, &minDelay, &avgDelay);
-            query.bindNoCopy(1, it->first);
+            query.bindNoCopy(1, addresses.get(it->first));
             query.bind(2, (int) e.pkts_received);
             query.bind(3, (int) e.pkts_sent);
             query.bind(4, e.kbytes_received);
@@ -118,8 +142,9 @@ void statistics_db::writeStatisticsIP(const std::unordered_map<std::string, entr
  * Writes the IP Degrees into the database.
  * @param ipStatistics The IP statistics from class statistics. Degree Statistics are supposed to be integrated into the ip_statistics table later on,
  *        therefore they use the same parameter. But for now they are inserted into their own table.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsDegree(const std::unordered_map<std::string, entry_ipStat> &ipStatistics){
+void statistics_db::writeStatisticsDegree(const std::unordered_map<address_id, entry_ipStat> &ipStatistics, const address_dictionary &addresses){
     try {
         db->exec("DROP TABLE IF EXISTS ip_degrees");
         SQLite::Transaction transaction(*db);
@@ -133,7 +158,7 @@ void statistics_db::writeStatisticsDegree(const std::unordered_map<std::string,
         SQLite::Statement query(*db, "INSERT INTO ip_degrees VALUES (?, ?, ?, ?)");
         for (auto it = ipStatistics.begin(); it != ipStatistics.end(); ++it) {
             const entry_ipStat &e = it->second;
-            query.bindNoCopy(1, it->first);
+            query.bindNoCopy(1, addresses.get(it->first));
             query.bind(2, e.in_degree);
             query.bind(3, e.out_degree);
             query.bind(4, e.overall_degree);
@@ -152,8 +177,9 @@ void statistics_db::writeStatisticsDegree(const std::unordered_map<std::string,
 /**
  * Writes the TTL distribution into the database.
  * @param ttlDistribution The TTL distribution from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsTTL(const std::unordered_map<ipAddress_ttl, int> &ttlDistribution) {
+void statistics_db::writeStatisticsTTL(const host_histograms<HISTOGRAM_BYTE_VALUES> &ttlDistribution, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_ttl");
         SQLite::Transaction transaction(*db);
@@ -166,12 +192,14 @@ void statistics_db::writeStatisticsTTL(const std::unordered_map<ipAddress_ttl, i
         db->exec(createTable);
         SQLite::Statement query(*db, "INSERT INTO ip_ttl VALUES (?, ?, ?)");
         for (auto it = ttlDistribution.begin(); it != ttlDistribution.end(); ++it) {
-            const ipAddress_ttl &e = it->first;
-            query.bindNoCopy(1, e.ipAddress);
-            query.bind(2, e.ttlValue);
-            query.bind(3, it->second);
-            query.exec();
-            query.reset();
+            const std::string &ipAddress = addresses.get(it->first);
+            for (auto &value: it->second.get_values()) {
+                query.bindNoCopy(1, ipAddress);
+                query.bind(2, static_cast<int>(value.first));
+                query.bind(3, value.second);
+                query.exec();
+                query.reset();
+            }
 
             if (PyErr_CheckSignals()) throw py::error_already_set();
         }
@@ -185,8 +213,9 @@ void statistics_db::writeStatisticsTTL(const std::unordered_map<ipAddress_ttl, i
 /**
  * Writes the MSS distribution into the database.
  * @param mssDistribution The MSS distribution from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsMSS(const std::unordered_map<ipAddress_mss, int> &mssDistribution) {
+void statistics_db::writeStatisticsMSS(const host_histograms<HISTOGRAM_SHORT_VALUES> &mssDistribution, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS tcp_mss");
         SQLite::Transaction transaction(*db);
@@ -199,12 +228,14 @@ void statistics_db::writeStatisticsMSS(const std::unordered_map<ipAddress_mss, i
         db->exec(createTable);
         SQLite::Statement query(*db, "INSERT INTO tcp_mss VALUES (?, ?, ?)");
         for (auto it = mssDistribution.begin(); it != mssDistribution.end(); ++it) {
-            const ipAddress_mss &e = it->first;
-            query.bindNoCopy(1, e.ipAddress);
-            query.bind(2, e.mssValue);
-            query.bind(3, it->second);
-            query.exec();
-            query.reset();
+            const std::string &ipAddress = addresses.get(it->first);
+            for (auto &value: it->second.get_values()) {
+                query.bindNoCopy(1, ipAddress);
+                query.bind(2, static_cast<int>(value.first));
+                query.bind(3, value.second);
+                query.exec();
+                query.reset();
+            }
 
             if (PyErr_CheckSignals()) throw py::error_already_set();
         }
@@ -218,8 +249,9 @@ void statistics_db::writeStatisticsMSS(const std::unordered_map<ipAddress_mss, i
 /**
  * Writes the ToS distribution into the database.
  * @param tosDistribution The ToS distribution from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsToS(const std::unordered_map<ipAddress_tos, int> &tosDistribution) {
+void statistics_db::writeStatisticsToS(const host_histograms<HISTOGRAM_BYTE_VALUES> &tosDistribution, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_tos");
         SQLite::Transaction transaction(*db);
@@ -231,12 +263,14 @@ void statistics_db::writeStatisticsToS(const std::unordered_map<ipAddress_tos, i
         db->exec(createTable);
         SQLite::Statement query(*db, "INSERT INTO ip_tos VALUES (?, ?, ?)");
         for (auto it = tosDistribution.begin(); it != tosDistribution.end(); ++it) {
-            const ipAddress_tos &e = it->first;
-            query.bindNoCopy(1, e.ipAddress);
-            query.bind(2, e.tosValue);
-            query.bind(3, it->second);
-            query.exec();
-            query.reset();
+            const std::string &ipAddress = addresses.get(it->first);
+            for (auto &value: it->second.get_values()) {
+                query.bindNoCopy(1, ipAddress);
+                query.bind(2, static_cast<int>(value.first));
+                query.bind(3, value.second);
+                query.exec();
+                query.reset();
+            }
 
             if (PyErr_CheckSignals()) throw py::error_already_set();
         }
@@ -250,8 +284,9 @@ void statistics_db::writeStatisticsToS(const std::unordered_map<ipAddress_tos, i
 /**
  * Writes the window size distribution into the database.
  * @param winDistribution The window size distribution from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsWin(const std::unordered_map<ipAddress_win, int> &winDistribution) {
+void statistics_db::writeStatisticsWin(const host_histograms<HISTOGRAM_SHORT_VALUES> &winDistribution, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS tcp_win");
         SQLite::Transaction transaction(*db);
@@ -264,12 +299,14 @@ void statistics_db::writeStatisticsWin(const std::unordered_map<ipAddress_win, i
         db->exec(createTable);
         SQLite::Statement query(*db, "INSERT INTO tcp_win VALUES (?, ?, ?)");
         for (auto it = winDistribution.begin(); it != winDistribution.end(); ++it) {
-            const ipAddress_win &e = it->first;
-            query.bindNoCopy(1, e.ipAddress);
-            query.bind(2, e.winSize);
-            query.bind(3, it->second);
-            query.exec();
-            query.reset();
+            const std::string &ipAddress = addresses.get(it->first);
+            for (auto &value: it->second.get_values()) {
+                query.bindNoCopy(1, ipAddress);
+                query.bind(2, static_cast<int>(value.first));
+                query.bind(3, value.second);
+                query.exec();
+                query.reset();
+            }
 
             if (PyErr_CheckSignals()) throw py::error_already_set();
         }
@@ -283,8 +320,9 @@ void statistics_db::writeStatisticsWin(const std::unordered_map<ipAddress_win, i
 /**
  * Writes the protocol distribution into the database.
  * @param protocolDistribution The protocol distribution from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsProtocols(const std::unordered_map<ipAddress_protocol, entry_protocolStat> &protocolDistribution) {
+void statistics_db::writeStatisticsProtocols(const std::unordered_map<ipAddress_protocol, entry_protocolStat> &protocolDistribution, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_protocols");
         SQLite::Transaction transaction(*db);
@@ -298,7 +336,7 @@ void statistics_db::writeStatisticsProtocols(const std::unordered_map<ipAddress_
         SQLite::Statement query(*db, "INSERT INTO ip_protocols VALUES (?, ?, ?, ?)");
         for (auto it = protocolDistribution.begin(); it != protocolDistribution.end(); ++it) {
             const ipAddress_protocol &e = it->first;
-            query.bindNoCopy(1, e.ipAddress);
+            query.bindNoCopy(1, addresses.get(e.ipAddress));
             query.bindNoCopy(2, e.protocol);
             query.bind(3, it->second.count);
             query.bind(4, it->second.byteCount);
@@ -317,8 +355,9 @@ void statistics_db::writeStatisticsProtocols(const std::unordered_map<ipAddress_
 /**
  * Writes the port statistics into the database.
  * @param portsStatistics The ports statistics from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsPorts(const std::unordered_map<ipAddress_inOut_port, entry_portStat> &portsStatistics) {
+void statistics_db::writeStatisticsPorts(const flat_hash_map<ipAddress_inOut_port, entry_portStat> &portsStatistics, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_ports");
         SQLite::Transaction transaction(*db);
@@ -342,12 +381,12 @@ void statistics_db::writeStatisticsPorts(const std::unordered_map<ipAddress_inOu
                 else {portService = "unknown";}
             }
 
-            query.bindNoCopy(1, e.ipAddress);
-            query.bindNoCopy(2, e.trafficDirection);
+            query.bindNoCopy(1, addresses.get(e.ipAddress));
+            query.bind(2, e.incoming ? "in" : "out");
             query.bind(3, e.portNumber);
             query.bind(4, it->second.count);
             query.bind(5, it->second.byteCount);
-            query.bindNoCopy(6, e.protocol);
+            query.bind(6, e.udp ? "UDP" : "TCP");
             query.bindNoCopy(7, portService);
             query.exec();
             query.reset();
@@ -364,8 +403,9 @@ void statistics_db::writeStatisticsPorts(const std::unordered_map<ipAddress_inOu
 /**
  *  Writes the IP address -> MAC address mapping into the database.
  * @param IpMacStatistics The IP address -> MAC address mapping from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsIpMac(const std::unordered_map<std::string, std::string> &IpMacStatistics) {
+void statistics_db::writeStatisticsIpMac(const std::unordered_map<address_id, address_id> &IpMacStatistics, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS ip_mac");
         SQLite::Transaction transaction(*db);
@@ -376,8 +416,8 @@ void statistics_db::writeStatisticsIpMac(const std::unordered_map<std::string, s
         db->exec(createTable);
         SQLite::Statement query(*db, "INSERT INTO ip_mac VALUES (?, ?)");
         for (auto it = IpMacStatistics.begin(); it != IpMacStatistics.end(); ++it) {
-            query.bindNoCopy(1, it->first);
-            query.bindNoCopy(2, it->second);
+            query.bindNoCopy(1, addresses.get(it->first));
+            query.bindNoCopy(2, addresses.get(it->second));
             query.exec();
             query.reset();
 
@@ -470,12 +510,15 @@ void statistics_db::calculate_latency(const std::vector<std::chrono::microsecond
 /**
  * Writes the conversation statistics into the database.
  * @param convStatistics The conversation from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
+ * @param append Whether the conversations are added to the table, replacing earlier rows of the same conversation.
  */
-void statistics_db::writeStatisticsConv(std::unordered_map<conv, entry_convStat> &convStatistics){
+void statistics_db::writeStatisticsConv(std::unordered_map<conv, entry_convStat> &convStatistics, const address_dictionary &addresses, bool append){
     try {
-        db->exec("DROP TABLE IF EXISTS conv_statistics");
+        if (!append)
+            db->exec("DROP TABLE IF EXISTS conv_statistics");
         SQLite::Transaction transaction(*db);
-        const char *createTable = "CREATE TABLE conv_statistics ("
+        const char *createTable = "CREATE TABLE IF NOT EXISTS conv_statistics ("
                 "ipAddressA TEXT,"
                 "portA INTEGER,"
                 "ipAddressB TEXT,"
@@ -488,7 +531,7 @@ void statistics_db::writeStatisticsConv(std::unordered_map<conv, entry_convStat>
                 "roundTripTime INTEGER,"
                 "PRIMARY KEY(ipAddressA,portA,ipAddressB,portB));";
         db->exec(createTable);
-        SQLite::Statement query(*db, "INSERT INTO conv_statistics VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        SQLite::Statement query(*db, "INSERT OR REPLACE INTO conv_statistics VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
 
         // Calculate average of inter-arrival times and average packet rate
         for (auto it = convStatistics.begin(); it != convStatistics.end(); ++it) {
@@ -536,9 +579,9 @@ void statistics_db::writeStatisticsConv(std::unordered_map<conv, entry_convStat>
                 std::chrono::microseconds conn_duration = end_timesttamp - start_timesttamp;
                 e.avg_pkt_rate = (float) e.pkts_count * 1000000 / conn_duration.count(); // pkt per sec
 
-                query.bindNoCopy(1, f.ipAddressA);
+                query.bindNoCopy(1, addresses.get(f.ipAddressA));
                 query.bind(2, f.portA);
-                query.bindNoCopy(3, f.ipAddressB);
+                query.bindNoCopy(3, addresses.get(f.ipAddressB));
                 query.bind(4, f.portB);
                 query.bind(5, (int) e.pkts_count);
                 query.bind(6, (float) e.avg_pkt_rate);
@@ -562,12 +605,15 @@ void statistics_db::writeStatisticsConv(std::unordered_map<conv, entry_convStat>
 /**
  * Writes the extended statistics for every conversation into the database.
  * @param conv_statistics_extended The extended conversation statistics from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
+ * @param append Whether the conversations are added to the table, replacing earlier rows of the same conversation.
  */
-void statistics_db::writeStatisticsConvExt(std::unordered_map<convWithProt, entry_convStatExt> &conv_statistics_extended){
+void statistics_db::writeStatisticsConvExt(std::unordered_map<convWithProt, entry_convStatExt> &conv_statistics_extended, const address_dictionary &addresses, bool append){
     try {
-        db->exec("DROP TABLE IF EXISTS conv_statistics_extended");
+        if (!append)
+            db->exec("DROP TABLE IF EXISTS conv_statistics_extended");
         SQLite::Transaction transaction(*db);
-        const char *createTable = "CREATE TABLE conv_statistics_extended ("
+        const char *createTable = "CREATE TABLE IF NOT EXISTS conv_statistics_extended ("
                 "ipAddressA TEXT,"
                 "portA INTEGER,"
                 "ipAddressB TEXT,"
@@ -584,7 +630,7 @@ void statistics_db::writeStatisticsConvExt(std::unordered_map<convWithProt, entr
                 "totalConversationDuration REAL,"
                 "PRIMARY KEY(ipAddressA,portA,ipAddressB,portB,protocol));";
         db->exec(createTable);
-        SQLite::Statement query(*db, "INSERT INTO conv_statistics_extended VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        SQLite::Statement query(*db, "INSERT OR REPLACE INTO conv_statistics_extended VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
         // iterate over every conversation and interval aggregation pair and store the respective values in the database
         for (auto it = conv_statistics_extended.begin(); it != conv_statistics_extended.end(); ++it) {
             const convWithProt &f = it->first;
@@ -614,9 +660,9 @@ void statistics_db::writeStatisticsConvExt(std::unordered_map<convWithProt, entr
                 e.avg_pkt_rate = e.pkts_count / e.total_comm_duration;
 
             if (e.avg_int_pkts_count > 0){
-                query.bindNoCopy(1, f.ipAddressA);
+                query.bindNoCopy(1, addresses.get(f.ipAddressA));
                 query.bind(2, f.portA);
-                query.bindNoCopy(3, f.ipAddressB);
+                query.bindNoCopy(3, addresses.get(f.ipAddressB));
                 query.bind(4, f.portB);
                 query.bindNoCopy(5, f.protocol);
                 query.bind(6, static_cast<int>(e.pkts_count));
@@ -658,8 +704,9 @@ void statistics_db::writeStatisticsConvExt(std::unordered_map<convWithProt, entr
 /**
  * Writes the interval statistics into the database.
  * @param intervalStatistics The interval entries from class statistics.
+ * @param append Whether the intervals are added to the interval table, instead of replacing it.
  */
-void statistics_db::writeStatisticsInterval(const std::unordered_map<std::string, entry_intervalStat> &intervalStatistics, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del, int defaultInterval, bool extraTests){
+void statistics_db::writeStatisticsInterval(const std::unordered_map<std::string, entry_intervalStat> &intervalStatistics, std::vector<std::chrono::duration<int, std::micro>> timeIntervals, bool del, int defaultInterval, bool extraTests, bool append){
     try {
         // remove old tables produced by prior database versions
         db->exec("DROP TABLE IF EXISTS interval_statistics");
@@ -725,9 +772,10 @@ void statistics_db::writeStatisticsInterval(const std::unordered_map<std::string
             db->exec("INSERT INTO interval_tables VALUES ('" + table_name + "', '" + is_default + "', '" + extra + "');");
 
             // new interval statistics implementation
-            db->exec("DROP TABLE IF EXISTS " + table_name);
+            if (!append)
+                db->exec("DROP TABLE IF EXISTS " + table_name);
             SQLite::Transaction transaction(*db);
-            db->exec("CREATE TABLE " + table_name + " ("
+            db->exec("CREATE TABLE IF NOT EXISTS " + table_name + " ("
                     "last_pkt_timestamp TEXT,"
                     "first_pkt_timestamp TEXT,"
                     "pkts_count INTEGER,"
@@ -778,7 +826,7 @@ void statistics_db::writeStatisticsInterval(const std::unordered_map<std::string
                     "ip_dst_novel_entropy_normalized REAL,"
                     "PRIMARY KEY(last_pkt_timestamp));");
 
-            SQLite::Statement query(*db, "INSERT INTO " + table_name + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+            SQLite::Statement query(*db, "INSERT OR REPLACE INTO " + table_name + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
             for (auto it = intervalStatistics.begin(); it != intervalStatistics.end(); ++it) {
                 const entry_intervalStat &e = it->second;
 
@@ -896,9 +944,10 @@ void statistics_db::readPortServicesFromNmap()
 /**
  * Writes the unrecognized PDUs into the database.
  * @param unrecognized_PDUs The unrecognized PDUs from class statistics.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
  */
-void statistics_db::writeStatisticsUnrecognizedPDUs(const std::unordered_map<unrecognized_PDU, unrecognized_PDU_stat>
-                                                    &unrecognized_PDUs) {
+void statistics_db::writeStatisticsUnrecognizedPDUs(const flat_hash_map<unrecognized_PDU, unrecognized_PDU_stat>
+                                                    &unrecognized_PDUs, const address_dictionary &addresses) {
     try {
         db->exec("DROP TABLE IF EXISTS unrecognized_pdus");
         SQLite::Transaction transaction(*db);
@@ -913,8 +962,8 @@ void statistics_db::writeStatisticsUnrecognizedPDUs(const std::unordered_map<unr
         SQLite::Statement query(*db, "INSERT INTO unrecognized_pdus VALUES (?, ?, ?, ?, ?)");
         for (auto it = unrecognized_PDUs.begin(); it != unrecognized_PDUs.end(); ++it) {
             const unrecognized_PDU &e = it->first;
-            query.bindNoCopy(1, e.srcMacAddress);
-            query.bindNoCopy(2, e.dstMacAddress);
+            query.bindNoCopy(1, addresses.get(e.srcMacAddress));
+            query.bindNoCopy(2, addresses.get(e.dstMacAddress));
             query.bind(3, e.typeNumber);
             query.bind(4, it->second.count);
             query.bindNoCopy(5, it->second.timestamp_last_occurrence);
@@ -929,3 +978,355 @@ void statistics_db::writeStatisticsUnrecognizedPDUs(const std::unordered_map<unr
         std::cerr << "Exception in statistics_db::" << __func__ << ": " << e.what() << std::endl;
     }
 }
+
+/**
+ * Writes the packet index into the database, which maps every PACKET_INDEX_INTERVAL-th packet number to the offset
+ * of its record in the PCAP file and its timestamp.
+ * @param packetIndex The packet index from class pcap_processor.
+ */
+void statistics_db::writePacketIndex(const std::vector<packet_index_entry> &packetIndex) {
+    try {
+        db->exec("DROP TABLE IF EXISTS packet_index");
+        SQLite::Transaction transaction(*db);
+        const char *createTable = "CREATE TABLE packet_index ("
+                "packetNumber INTEGER,"
+                "fileOffset INTEGER,"
+                "timestamp INTEGER,"
+                "PRIMARY KEY(packetNumber));";
+        db->exec(createTable);
+        SQLite::Statement query(*db, "INSERT INTO packet_index VALUES (?, ?, ?)");
+        for (auto it = packetIndex.begin(); it != packetIndex.end(); ++it) {
+            query.bind(1, static_cast<long long>(it->packetNumber));
+            query.bind(2, static_cast<long long>(it->offset));
+            query.bind(3, static_cast<long long>(it->timestamp));
+            query.exec();
+            query.reset();
+
+            if (PyErr_CheckSignals()) throw py::error_already_set();
+        }
+        transaction.commit();
+    }
+    catch (std::exception &e) {
+        std::cerr << "Exception in statistics_db::" << __func__ << ": " << e.what() << std::endl;
+    }
+}
+
+/**
+ * Writes the sampling rate and estimated error of every statistics table into the database. The table has no rows,
+ * if the statistics of every packet were collected.
+ * @param samplingStatistics The sampling statistics from class statistics.
+ */
+void statistics_db::writeStatisticsSampling(const std::vector<entry_samplingStat> &samplingStatistics) {
+    try {
+        db->exec("DROP TABLE IF EXISTS sampling");
+        SQLite::Transaction transaction(*db);
+        const char *createTable = "CREATE TABLE sampling ("
+                "tableName TEXT,"
+                "mode TEXT,"
+                "rate INTEGER,"
+                "sampledCount INTEGER,"
+                "scaled INTEGER,"
+                "relativeError REAL,"
+                "PRIMARY KEY(tableName));";
+        db->exec(createTable);
+        SQLite::Statement query(*db, "INSERT INTO sampling VALUES (?, ?, ?, ?, ?, ?)");
+        for (auto it = samplingStatistics.begin(); it != samplingStatistics.end(); ++it) {
+            query.bindNoCopy(1, it->table);
+            query.bindNoCopy(2, it->mode);
+            query.bind(3, it->rate);
+            query.bind(4, static_cast<long long>(it->sampledCount));
+            query.bind(5, it->scaled);
+            query.bind(6, it->relativeError);
+            query.exec();
+            query.reset();
+        }
+        transaction.commit();
+    }
+    catch (std::exception &e) {
+        std::cerr << "Exception in statistics_db::" << __func__ << ": " << e.what() << std::endl;
+    }
+}
+
+/**
+ * Binds the values of a vector as blob, the values are stored in native byte order.
+ * @param query The statement.
+ * @param index The index of the parameter.
+ * @param values The values.
+ */
+template<typename T>
+static void bindVector(SQLite::Statement &query, int index, const std::vector<T> &values) {
+    query.bind(index, static_cast<const void *>(values.data()), static_cast<int>(values.size() * sizeof(T)));
+}
+
+/**
+ * Reads the values of a vector bound by bindVector.
+ * @param column The column of the blob.
+ * @return the values.
+ */
+template<typename T>
+static std::vector<T> getVector(const SQLite::Column &column) {
+    const T *values = static_cast<const T *>(column.getBlob());
+    return values == nullptr ? std::vector<T>() : std::vector<T>(values, values + column.getBytes() / sizeof(T));
+}
+
+/**
+ * Appends the inter-arrival times of a later instance of a conversation to the times of an earlier instance, as if
+ * the packets of both had been collected together: only the first three packets of a conversation have one.
+ * @param interarrivalTimes The times of the earlier instance, the times of both instances afterwards.
+ * @param earlierCount The number of packets of the earlier instance.
+ * @param earlierLast The timestamp of the last packet of the earlier instance.
+ * @param later The times of the later instance.
+ * @param laterFirst The timestamp of the first packet of the later instance.
+ */
+static void appendInterarrivalTimes(std::vector<std::chrono::microseconds> &interarrivalTimes, long earlierCount,
+                                    std::chrono::microseconds earlierLast,
+                                    const std::vector<std::chrono::microseconds> &later,
+                                    std::chrono::microseconds laterFirst) {
+    if (earlierCount >= 3)
+        return;
+    interarrivalTimes.push_back(laterFirst - earlierLast);
+    for (std::size_t i = 0; i < later.size() && interarrivalTimes.size() < 2; i++) {
+        interarrivalTimes.push_back(later[i]);
+    }
+}
+
+/**
+ * Keeps the values of a conversation needed to continue it: the number of packets, the inter-arrival times, the first
+ * and the last packet and the SYN and ACK packets the round trip times are calculated from, see writeStatisticsConv.
+ * @param entry The statistics of the conversation.
+ * @return the statistics without the other packets.
+ */
+static entry_convStat compactConvStat(const entry_convStat &entry) {
+    entry_convStat compact = {};
+    compact.pkts_count = entry.pkts_count;
+    compact.interarrival_time = entry.interarrival_time;
+    if (entry.pkts_timestamp.empty())
+        return compact;
+    compact.pkts_timestamp.push_back(entry.pkts_timestamp.front());
+    compact.tcp_types.push_back(small_uint<12>(0));
+    bool flag = false;
+    for (std::size_t i = 0; i < entry.pkts_timestamp.size() && i < entry.tcp_types.size(); i++) {
+        if ((entry.tcp_types[i] == TCP::SYN && !flag) || (entry.tcp_types[i] == TCP::ACK && flag)) {
+            compact.pkts_timestamp.push_back(entry.pkts_timestamp[i]);
+            compact.tcp_types.push_back(entry.tcp_types[i]);
+            flag = !flag;
+        }
+    }
+    compact.pkts_timestamp.push_back(entry.pkts_timestamp.back());
+    compact.tcp_types.push_back(small_uint<12>(0));
+    return compact;
+}
+
+/**
+ * Continues an earlier instance of a conversation with the packets of a later instance.
+ * @param entry The statistics of the later instance, the statistics of both instances afterwards.
+ * @param earlier The compact statistics of the earlier instance, see compactConvStat.
+ */
+static void prependConvStat(entry_convStat &entry, const entry_convStat &earlier) {
+    std::vector<std::chrono::microseconds> interarrivalTimes = earlier.interarrival_time;
+    if (!earlier.pkts_timestamp.empty() && !entry.pkts_timestamp.empty()) {
+        appendInterarrivalTimes(interarrivalTimes, earlier.pkts_count, earlier.pkts_timestamp.back(),
+                                entry.interarrival_time, entry.pkts_timestamp.front());
+    }
+    entry.interarrival_time = interarrivalTimes;
+    entry.pkts_count += earlier.pkts_count;
+    entry.pkts_timestamp.insert(entry.pkts_timestamp.begin(), earlier.pkts_timestamp.begin(),
+                                earlier.pkts_timestamp.end());
+    entry.tcp_types.insert(entry.tcp_types.begin(), earlier.tcp_types.begin(), earlier.tcp_types.end());
+}
+
+/**
+ * Continues an earlier instance of an extended conversation with the packets of a later instance. The first
+ * communication interval of the later instance continues the last interval of the earlier instance, unless the
+ * time between them exceeds COMM_INTERVAL_THRESHOLD.
+ * @param entry The statistics of the later instance, the statistics of both instances afterwards.
+ * @param earlier The statistics of the earlier instance, of which only the first and the last packet timestamp are
+ * kept.
+ */
+static void prependConvStatExt(entry_convStatExt &entry, const entry_convStatExt &earlier) {
+    std::vector<std::chrono::microseconds> interarrivalTimes = earlier.interarrival_time;
+    if (!earlier.pkts_timestamp.empty() && !entry.pkts_timestamp.empty()) {
+        appendInterarrivalTimes(interarrivalTimes, earlier.pkts_count, earlier.pkts_timestamp.back(),
+                                entry.interarrival_time, entry.pkts_timestamp.front());
+    }
+    entry.interarrival_time = interarrivalTimes;
+    entry.pkts_count += earlier.pkts_count;
+    if (!earlier.pkts_timestamp.empty())
+        entry.pkts_timestamp.insert(entry.pkts_timestamp.begin(), earlier.pkts_timestamp.front());
+
+    std::vector<commInterval> intervals = earlier.comm_intervals;
+    std::size_t next = 0;
+    if (!intervals.empty() && !entry.comm_intervals.empty() &&
+        entry.comm_intervals[0].start - intervals.back().end <=
+        (std::chrono::microseconds) ((unsigned long) COMM_INTERVAL_THRESHOLD)) {
+        intervals.back().end = entry.comm_intervals[0].end;
+        intervals.back().pkts_count += entry.comm_intervals[0].pkts_count;
+        next = 1;
+    }
+    intervals.insert(intervals.end(), entry.comm_intervals.begin() + next, entry.comm_intervals.end());
+    entry.comm_intervals = intervals;
+}
+
+/**
+ * Continues the conversations written by an earlier flush of stream_statistics, which were evicted after
+ * idle_timeout and later continued, so that their rows equal the rows of a single pass over the capture. The
+ * conversations are looked up in both directions, a continued conversation keeps the direction of its first packet.
+ * @param convStatistics The conversations to write, extended by their earlier packets.
+ * @param convStatisticsExt The extended conversations to write, extended by their earlier packets.
+ * @param continuedTimes The inter-arrival times replaced and added by the continued conversations, the inter-arrival
+ * times of their hosts are corrected by them.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
+ * @param first Whether this is the first flush, which drops the conversations of an earlier stream.
+ */
+void statistics_db::readStreamConversations(std::unordered_map<conv, entry_convStat> &convStatistics,
+                                            std::unordered_map<convWithProt, entry_convStatExt> &convStatisticsExt,
+                                            std::vector<entry_continuedConv> &continuedTimes,
+                                            const address_dictionary &addresses, bool first) {
+    try {
+        if (first) {
+            db->exec("DROP TABLE IF EXISTS stream_conversations");
+            db->exec("DROP TABLE IF EXISTS stream_conversations_extended");
+        }
+        db->exec("CREATE TABLE IF NOT EXISTS stream_conversations ("
+                 "ipAddressA TEXT, portA INTEGER, ipAddressB TEXT, portB INTEGER, pktsCount INTEGER, "
+                 "timestamps BLOB, tcpTypes BLOB, interarrivalTimes BLOB, "
+                 "PRIMARY KEY(ipAddressA,portA,ipAddressB,portB));");
+        db->exec("CREATE TABLE IF NOT EXISTS stream_conversations_extended ("
+                 "ipAddressA TEXT, portA INTEGER, ipAddressB TEXT, portB INTEGER, protocol TEXT, pktsCount INTEGER, "
+                 "firstTimestamp INTEGER, lastTimestamp INTEGER, interarrivalTimes BLOB, commIntervals BLOB, "
+                 "PRIMARY KEY(ipAddressA,portA,ipAddressB,portB,protocol));");
+        if (first)
+            return;
+
+        SQLite::Statement query(*db, "SELECT pktsCount, timestamps, tcpTypes, interarrivalTimes "
+                "FROM stream_conversations WHERE ipAddressA=? AND portA=? AND ipAddressB=? AND portB=?");
+        std::vector<std::pair<conv, entry_convStat>> continued;
+        for (auto it = convStatistics.begin(); it != convStatistics.end();) {
+            conv directions[] = {it->first, {it->first.ipAddressB, it->first.portB, it->first.ipAddressA, it->first.portA}};
+            bool found = false;
+            for (const conv &f: directions) {
+                query.bindNoCopy(1, addresses.get(f.ipAddressA));
+                query.bind(2, f.portA);
+                query.bindNoCopy(3, addresses.get(f.ipAddressB));
+                query.bind(4, f.portB);
+                if (query.executeStep()) {
+                    entry_convStat earlier = {};
+                    earlier.pkts_count = query.getColumn(0).getInt64();
+                    earlier.pkts_timestamp = getVector<std::chrono::microseconds>(query.getColumn(1));
+                    for (uint16_t type: getVector<uint16_t>(query.getColumn(2))) {
+                        earlier.tcp_types.push_back(small_uint<12>(type));
+                    }
+                    earlier.interarrival_time = getVector<std::chrono::microseconds>(query.getColumn(3));
+                    entry_continuedConv times = {f, it->second.interarrival_time, {}};
+                    prependConvStat(it->second, earlier);
+                    times.added_times.assign(it->second.interarrival_time.begin() + earlier.interarrival_time.size(),
+                                             it->second.interarrival_time.end());
+                    continuedTimes.push_back(times);
+                    continued.push_back(std::make_pair(f, std::move(it->second)));
+                    found = true;
+                }
+                query.reset();
+                if (found) break;
+            }
+            it = found ? convStatistics.erase(it) : std::next(it);
+        }
+        convStatistics.insert(continued.begin(), continued.end());
+
+        SQLite::Statement queryExt(*db, "SELECT pktsCount, firstTimestamp, lastTimestamp, interarrivalTimes, "
+                "commIntervals FROM stream_conversations_extended WHERE ipAddressA=? AND portA=? AND ipAddressB=? AND portB=? "
+                "AND protocol=?");
+        std::vector<std::pair<convWithProt, entry_convStatExt>> continuedExt;
+        for (auto it = convStatisticsExt.begin(); it != convStatisticsExt.end();) {
+            const convWithProt &key = it->first;
+            convWithProt directions[] = {key, {key.ipAddressB, key.portB, key.ipAddressA, key.portA, key.protocol}};
+            bool found = false;
+            for (const convWithProt &f: directions) {
+                queryExt.bindNoCopy(1, addresses.get(f.ipAddressA));
+                queryExt.bind(2, f.portA);
+                queryExt.bindNoCopy(3, addresses.get(f.ipAddressB));
+                queryExt.bind(4, f.portB);
+                queryExt.bindNoCopy(5, f.protocol);
+                if (queryExt.executeStep()) {
+                    entry_convStatExt earlier = {};
+                    earlier.pkts_count = queryExt.getColumn(0).getInt64();
+                    earlier.pkts_timestamp.push_back(std::chrono::microseconds(queryExt.getColumn(1).getInt64()));
+                    earlier.pkts_timestamp.push_back(std::chrono::microseconds(queryExt.getColumn(2).getInt64()));
+                    earlier.interarrival_time = getVector<std::chrono::microseconds>(queryExt.getColumn(3));
+                    earlier.comm_intervals = getVector<commInterval>(queryExt.getColumn(4));
+                    prependConvStatExt(it->second, earlier);
+                    continuedExt.push_back(std::make_pair(f, std::move(it->second)));
+                    found = true;
+                }
+                queryExt.reset();
+                if (found) break;
+            }
+            it = found ? convStatisticsExt.erase(it) : std::next(it);
+        }
+        convStatisticsExt.insert(continuedExt.begin(), continuedExt.end());
+    }
+    catch (std::exception &e) {
+        std::cerr << "Exception in statistics_db::" << __func__ << ": " << e.what() << std::endl;
+    }
+}
+
+/**
+ * Keeps the conversations written by a flush of stream_statistics, so that they can be continued by a later flush,
+ * see readStreamConversations. Only the values needed to continue a conversation are kept, see compactConvStat.
+ * @param convStatistics The written conversations.
+ * @param convStatisticsExt The written extended conversations.
+ * @param addresses The dictionary of the address ids the statistics are keyed by.
+ * @param last Whether this is the last flush, after which no conversation is continued.
+ */
+void statistics_db::writeStreamConversations(const std::unordered_map<conv, entry_convStat> &convStatistics,
+                                             const std::unordered_map<convWithProt, entry_convStatExt> &convStatisticsExt,
+                                             const address_dictionary &addresses, bool last) {
+    try {
+        if (last) {
+            db->exec("DROP TABLE IF EXISTS stream_conversations");
+            db->exec("DROP TABLE IF EXISTS stream_conversations_extended");
+            return;
+        }
+        SQLite::Transaction transaction(*db);
+        SQLite::Statement query(*db, "INSERT OR REPLACE INTO stream_conversations VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+        for (auto it = convStatistics.begin(); it != convStatistics.end(); ++it) {
+            entry_convStat compact = compactConvStat(it->second);
+            std::vector<uint16_t> tcpTypes;
+            for (auto type: compact.tcp_types) {
+                tcpTypes.push_back(static_cast<uint16_t>(type));
+            }
+            query.bindNoCopy(1, addresses.get(it->first.ipAddressA));
+            query.bind(2, it->first.portA);
+            query.bindNoCopy(3, addresses.get(it->first.ipAddressB));
+            query.bind(4, it->first.portB);
+            query.bind(5, static_cast<long long>(compact.pkts_count));
+            bindVector(query, 6, compact.pkts_timestamp);
+            bindVector(query, 7, tcpTypes);
+            bindVector(query, 8, compact.interarrival_time);
+            query.exec();
+            query.reset();
+        }
+
+        SQLite::Statement queryExt(*db, "INSERT OR REPLACE INTO stream_conversations_extended VALUES "
+                "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        for (auto it = convStatisticsExt.begin(); it != convStatisticsExt.end(); ++it) {
+            const entry_convStatExt &e = it->second;
+            if (e.pkts_timestamp.empty()) continue;
+            queryExt.bindNoCopy(1, addresses.get(it->first.ipAddressA));
+            queryExt.bind(2, it->first.portA);
+            queryExt.bindNoCopy(3, addresses.get(it->first.ipAddressB));
+            queryExt.bind(4, it->first.portB);
+            queryExt.bindNoCopy(5, it->first.protocol);
+            queryExt.bind(6, static_cast<long long>(e.pkts_count));
+            queryExt.bind(7, static_cast<long long>(e.pkts_timestamp.front().count()));
+            queryExt.bind(8, static_cast<long long>(e.pkts_timestamp.back().count()));
+            bindVector(queryExt, 9, e.interarrival_time);
+            bindVector(queryExt, 10, e.comm_intervals);
+            queryExt.exec();
+            queryExt.reset();
+        }
+        transaction.commit();
+    }
+    catch (std::exception &e) {
+        std::cerr << "Exception in statistics_db::" << __func__ << ": " << e.what() << std::endl;
+    }
+}
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include "pcap_reader.h"
 #include "statistics.h"
 #include <pybind11/pybind11.h>
 #include <SQLiteCpp/SQLiteCpp.h>
@@ -26,50 +27,65 @@ public:
     /*
      * Database version: Increment number on every change in the C++ code!
      */
-    static const int DB_VERSION = 29;
+    static const int DB_VERSION = 32;
 
     /*
      * Methods to read from database
      */
     void getNoneExtraTestsInveralStats(std::vector<double>& intervals);
 
+    bool readPacketIndex(uint64_t packetNumber, packet_index_entry &entry);
+
     /*
      * Methods for writing values into database
      */
-    void writeStatisticsIP(const std::unordered_map<std::string, entry_ipStat> &ipStatistics);
+    void writeStatisticsIP(const std::unordered_map<address_id, entry_ipStat> &ipStatistics, const address_dictionary &addresses);
 
-    void writeStatisticsDegree(const std::unordered_map<std::string, entry_ipStat> &ipStatistics);
+    void writeStatisticsDegree(const std::unordered_map<address_id, entry_ipStat> &ipStatistics, const address_dictionary &addresses);
 
-    void writeStatisticsTTL(const std::unordered_map<ipAddress_ttl, int> &ttlDistribution);
+    void writeStatisticsTTL(const host_histograms<HISTOGRAM_BYTE_VALUES> &ttlDistribution, const address_dictionary &addresses);
 
-    void writeStatisticsMSS(const std::unordered_map<ipAddress_mss, int> &mssDistribution);
+    void writeStatisticsMSS(const host_histograms<HISTOGRAM_SHORT_VALUES> &mssDistribution, const address_dictionary &addresses);
 
-    void writeStatisticsToS(const std::unordered_map<ipAddress_tos, int> &tosDistribution);
+    void writeStatisticsToS(const host_histograms<HISTOGRAM_BYTE_VALUES> &tosDistribution, const address_dictionary &addresses);
 
-    void writeStatisticsWin(const std::unordered_map<ipAddress_win, int> &winDistribution);
+    void writeStatisticsWin(const host_histograms<HISTOGRAM_SHORT_VALUES> &winDistribution, const address_dictionary &addresses);
 
-    void writeStatisticsProtocols(const std::unordered_map<ipAddress_protocol, entry_protocolStat> &protocolDistribution);
+    void writeStatisticsProtocols(const std::unordered_map<ipAddress_protocol, entry_protocolStat> &protocolDistribution, const address_dictionary &addresses);
 
-    void writeStatisticsPorts(const std::unordered_map<ipAddress_inOut_port, entry_portStat> &portsStatistics);
+    void writeStatisticsPorts(const flat_hash_map<ipAddress_inOut_port, entry_portStat> &portsStatistics, const address_dictionary &addresses);
 
-    void writeStatisticsIpMac(const std::unordered_map<std::string, std::string> &IpMacStatistics);
+    void writeStatisticsIpMac(const std::unordered_map<address_id, address_id> &IpMacStatistics, const address_dictionary &addresses);
 
     void writeStatisticsFile(int packetCount, float captureDuration, std::string timestampFirstPkt,
                              std::string timestampLastPkt, float avgPacketRate, float avgPacketSize,
                              float avgPacketsSentPerHost, float avgBandwidthIn, float avgBandwidthOut,
                              bool doExtraTests);
 
-    void writeStatisticsConv(std::unordered_map<conv, entry_convStat> &convStatistics);
+    void writeStatisticsConv(std::unordered_map<conv, entry_convStat> &convStatistics, const address_dictionary &addresses, bool append);
+
+    void writeStatisticsConvExt(std::unordered_map<convWithProt, entry_convStatExt> &conv_statistics_extended, const address_dictionary &addresses, bool append);
+
+    void readStreamConversations(std::unordered_map<conv, entry_convStat> &convStatistics,
+                                 std::unordered_map<convWithProt, entry_convStatExt> &convStatisticsExt,
+                                 std::vector<entry_continuedConv> &continuedTimes,
+                                 const address_dictionary &addresses, bool first);
 
-    void writeStatisticsConvExt(std::unordered_map<convWithProt, entry_convStatExt> &conv_statistics_extended);
+    void writeStreamConversations(const std::unordered_map<conv, entry_convStat> &convStatistics,
+                                  const std::unordered_map<convWithProt, entry_convStatExt> &convStatisticsExt,
+                                  const address_dictionary &addresses, bool last);
 
-    void writeStatisticsInterval(const std::unordered_map<std::string, entry_intervalStat> &intervalStatistics, std::vector<std::chrono::duration<int, std::micro>> timeInterval, bool del, int defaultInterval, bool extraTests);
+    void writeStatisticsInterval(const std::unordered_map<std::string, entry_intervalStat> &intervalStatistics, std::vector<std::chrono::duration<int, std::micro>> timeInterval, bool del, int defaultInterval, bool extraTests, bool append);
 
     void writeDbVersion();
 
     void readPortServicesFromNmap();
 
-    void writeStatisticsUnrecognizedPDUs(const std::unordered_map<unrecognized_PDU, unrecognized_PDU_stat> &unrecognized_PDUs);
+    void writeStatisticsUnrecognizedPDUs(const flat_hash_map<unrecognized_PDU, unrecognized_PDU_stat> &unrecognized_PDUs, const address_dictionary &addresses);
+
+    void writePacketIndex(const std::vector<packet_index_entry> &packetIndex);
+
+    void writeStatisticsSampling(const std::vector<entry_samplingStat> &samplingStatistics);
 
 private:
     // Pointer to the SQLite database
@@ -0,0 +1,152 @@
+#include "statistics_shards.h"
+#include "pcap_processor.h"
+
+/**
+ * Creates the shards and starts one thread per shard. Every shard only receives the packets of the hosts and host
+ * pairs whose address hash it owns and only collects their statistics, so the shards never share any data. The first
+ * shard receives all packets and collects the capture-wide statistics.
+ * @param processor The processor whose statistics are the first shard.
+ * @param shardCount The number of shards and threads.
+ * @param queueCapacity The number of batches dispatched at most without being completed.
+ */
+statistics_shards::statistics_shards(pcap_processor &processor, std::size_t shardCount, std::size_t queueCapacity)
+        : processor(processor), stopped(false), packetCount(0) {
+    if (shardCount == 0) {
+        shardCount = 1;
+    }
+    shards.push_back(&processor.stats);
+    for (std::size_t i = 1; i < shardCount; i++) {
+        ownedShards.emplace_back(new statistics(processor.resourcePath));
+        ownedShards.back()->setDoExtraTests(processor.stats.getDoExtraTests());
+        ownedShards.back()->setSketchMode(processor.stats.getSketchMode());
+        shards.push_back(ownedShards.back().get());
+    }
+    for (std::size_t i = 0; i < shardCount; i++) {
+        shards[i]->setShard(static_cast<unsigned int>(i), static_cast<unsigned int>(shardCount));
+        // One extra slot for the end marker
+        queues.emplace_back(new spsc_queue<packet_batch *>(queueCapacity + 1));
+        completed.emplace_back(new std::atomic<std::size_t>(0));
+    }
+
+    for (std::size_t i = 0; i < shardCount; i++) {
+        threads.emplace_back(&statistics_shards::process_batches, this, i);
+    }
+}
+
+/**
+ * Stops the threads, also if not all dispatched batches were processed.
+ */
+statistics_shards::~statistics_shards() {
+    stop();
+}
+
+/**
+ * Routes the packets of a batch to the shards owning their hosts and host pairs and passes the batch to all shards,
+ * which also register the interval barriers of the packets they do not receive. The batch must not be changed until
+ * get_completed_count shows that it was processed, batches are completed in the order they were dispatched.
+ * @param batch The batch of decoded packets, including the interval barriers.
+ */
+void statistics_shards::dispatch(packet_batch *batch) {
+    unsigned int shardCount = static_cast<unsigned int>(shards.size());
+    batch->numbers.resize(batch->packets.size());
+    batch->routes.resize(shards.size());
+    for (std::size_t i = 0; i < batch->routes.size(); i++) {
+        batch->routes[i].clear();
+    }
+    for (std::size_t i = 0; i < batch->packets.size(); i++) {
+        if (!batch->decoded[i]) continue;
+        batch->numbers[i] = ++packetCount;
+
+        // Packets without IPv4 layer are counted for the empty address, see pcap_processor::process_packets
+        const decoded_packet &pkt = batch->packets[i];
+        address_id sender = 0;
+        address_id receiver = 0;
+        if (pkt.l3 == l3_protocol::IPV4) {
+            sender = routeAddresses.intern_ipv4(pkt.ip_src);
+            receiver = routeAddresses.intern_ipv4(pkt.ip_dst);
+        }
+        std::size_t senderHash = routeAddresses.get_hash(sender);
+        std::size_t receiverHash = routeAddresses.get_hash(receiver);
+        unsigned int owners[] = {0, statistics::getHostShard(senderHash, shardCount),
+                                 statistics::getHostShard(receiverHash, shardCount),
+                                 statistics::getHostPairShard(senderHash, receiverHash, shardCount)};
+        for (unsigned int owner: owners) {
+            std::vector<uint32_t> &route = batch->routes[owner];
+            if (route.empty() || route.back() != i) {
+                route.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < queues.size(); i++) {
+        queues[i]->push(batch, stopped);
+    }
+}
+
+/**
+ * @return the number of dispatched batches processed by all shards.
+ */
+std::size_t statistics_shards::get_completed_count() const {
+    std::size_t count = completed[0]->load(std::memory_order_acquire);
+    for (std::size_t i = 1; i < completed.size(); i++) {
+        count = std::min(count, completed[i]->load(std::memory_order_acquire));
+    }
+    return count;
+}
+
+/**
+ * Waits until all dispatched batches are processed and combines the shards into the statistics of the processor.
+ */
+void statistics_shards::finish() {
+    for (std::size_t i = 0; i < queues.size(); i++) {
+        queues[i]->push(nullptr, stopped);
+    }
+    for (std::size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    std::vector<statistics *> otherShards(shards.begin() + 1, shards.end());
+    processor.stats.combineShards(otherShards);
+}
+
+/**
+ * Shard thread: Registers the intervals of every batch and collects the statistics of the packets routed to it.
+ * @param shard The number of the shard.
+ */
+void statistics_shards::process_batches(std::size_t shard) {
+    statistics &shardStats = *shards[shard];
+    packet_batch *batch;
+    while (queues[shard]->pop(batch, stopped)) {
+        if (batch == nullptr) {
+            return;
+        }
+
+        std::size_t nextBarrier = 0;
+        for (uint32_t i: batch->routes[shard]) {
+            for (; nextBarrier < batch->barriers.size() && batch->barriers[nextBarrier].packet <= i; nextBarrier++) {
+                const interval_barrier &barrier = batch->barriers[nextBarrier];
+                shardStats.addIntervalStat(barrier.interval, barrier.start, barrier.end);
+            }
+
+            // The inter-arrival times of the shards are put in packet order when the shards are combined
+            shardStats.setPacketCount(batch->numbers[i]);
+            processor.process_packets(batch->packets[i], shardStats);
+        }
+        for (; nextBarrier < batch->barriers.size(); nextBarrier++) {
+            const interval_barrier &barrier = batch->barriers[nextBarrier];
+            shardStats.addIntervalStat(barrier.interval, barrier.start, barrier.end);
+        }
+        completed[shard]->fetch_add(1, std::memory_order_release);
+    }
+}
+
+/**
+ * Signals all threads to stop and waits for them.
+ */
+void statistics_shards::stop() {
+    stopped.store(true);
+    for (std::size_t i = 0; i < threads.size(); i++) {
+        if (threads[i].joinable()) {
+            threads[i].join();
+        }
+    }
+}
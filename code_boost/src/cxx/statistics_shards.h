@@ -0,0 +1,61 @@
+/**
+ * Threads collecting the statistics of decoded packet batches, each thread keeping one statistics shard.
+ */
+
+#ifndef CPP_PCAPREADER_STATISTICS_SHARDS_H
+#define CPP_PCAPREADER_STATISTICS_SHARDS_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "address_dictionary.h"
+#include "packet_pipeline.h"
+#include "spsc_queue.h"
+#include "statistics.h"
+
+class pcap_processor;
+
+class statistics_shards {
+public:
+    /*
+     * Constructor: Starts shardCount threads. The first shard is the statistics of the processor, which the
+     * other shards are combined into by finish. queueCapacity is the number of batches dispatched at most
+     * without being completed.
+     */
+    statistics_shards(pcap_processor &processor, std::size_t shardCount, std::size_t queueCapacity);
+
+    ~statistics_shards();
+
+    statistics_shards(const statistics_shards &) = delete;
+
+    statistics_shards &operator=(const statistics_shards &) = delete;
+
+    /*
+     * Methods
+     */
+    void dispatch(packet_batch *batch);
+
+    std::size_t get_completed_count() const;
+
+    void finish();
+
+private:
+    pcap_processor &processor;
+    std::vector<statistics *> shards;
+    std::vector<std::unique_ptr<statistics>> ownedShards;
+    std::vector<std::unique_ptr<spsc_queue<packet_batch *>>> queues;
+    std::vector<std::unique_ptr<std::atomic<std::size_t>>> completed;
+    std::atomic<bool> stopped;
+    std::vector<std::thread> threads;
+
+    // Addresses of the dispatched packets, interned to look up their hash only once
+    address_dictionary routeAddresses;
+    int packetCount;
+
+    void process_batches(std::size_t shard);
+
+    void stop();
+};
+
+#endif //CPP_PCAPREADER_STATISTICS_SHARDS_H
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include "packet_sampler.h"
+#include "statistics_checkpoint.h"
+#include "statistics_sketch.h"
+
+/**
+ * @param ipAddress An IP address.
+ * @return the hash of the IP address.
+ */
+static inline uint64_t hash_address(const std::string &ipAddress) {
+    return mix_bits(std::hash<std::string>()(ipAddress));
+}
+
+/**
+ * @return the key of a value of a host in the Count-Min Sketch.
+ */
+static inline uint64_t value_key(sketch_distribution distribution, uint64_t addressHash, uint32_t value) {
+    return mix_bits(addressHash ^ mix_bits((static_cast<uint64_t>(distribution) << 32) | value));
+}
+
+/**
+ * Orders the values of a host by decreasing estimated count, values with the same count by increasing value.
+ */
+static bool has_higher_count(const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+hyperloglog::hyperloglog() {}
+
+/**
+ * Adds an element to the set.
+ * @param hash The 64 bit hash of the element.
+ */
+void hyperloglog::add(uint64_t hash) {
+    if (!dense.empty()) {
+        add_dense(hash);
+        return;
+    }
+    if (std::find(sparse.begin(), sparse.end(), hash) != sparse.end()) {
+        return;
+    }
+    sparse.push_back(hash);
+    if (sparse.size() > HLL_SPARSE_LIMIT) {
+        make_dense();
+    }
+}
+
+/**
+ * Updates the register selected by the first HLL_PRECISION bits of the hash with the position of the first set bit
+ * of the remaining bits.
+ * @param hash The 64 bit hash of the element.
+ */
+void hyperloglog::add_dense(uint64_t hash) {
+    std::size_t index = static_cast<std::size_t>(hash >> (64 - HLL_PRECISION));
+    uint64_t remaining = hash << HLL_PRECISION;
+    uint8_t rank = 1;
+    while (rank <= 64 - HLL_PRECISION && (remaining & (1ULL << 63)) == 0) {
+        remaining <<= 1;
+        rank++;
+    }
+    dense[index] = std::max(dense[index], rank);
+}
+
+/**
+ * Switches from the exact list of hashes to the registers.
+ */
+void hyperloglog::make_dense() {
+    dense.assign(HLL_REGISTERS, 0);
+    for (uint64_t hash: sparse) {
+        add_dense(hash);
+    }
+    std::vector<uint64_t>().swap(sparse);
+}
+
+/**
+ * Adds the elements of another set to this set.
+ * @param other The other set.
+ */
+void hyperloglog::merge(const hyperloglog &other) {
+    if (other.dense.empty()) {
+        for (uint64_t hash: other.sparse) {
+            add(hash);
+        }
+        return;
+    }
+    if (dense.empty()) {
+        make_dense();
+    }
+    for (std::size_t i = 0; i < dense.size(); i++) {
+        dense[i] = std::max(dense[i], other.dense[i]);
+    }
+}
+
+/**
+ * @return the number of distinct elements, exact for up to HLL_SPARSE_LIMIT elements.
+ */
+uint64_t hyperloglog::estimate() const {
+    if (dense.empty()) {
+        return sparse.size();
+    }
+    double sum = 0;
+    std::size_t zeros = 0;
+    for (uint8_t rank: dense) {
+        sum += std::ldexp(1.0, -rank);
+        if (rank == 0) {
+            zeros++;
+        }
+    }
+    double registers = HLL_REGISTERS;
+    double estimate = 0.7213 / (1 + 1.079 / registers) * registers * registers / sum;
+    // Linear counting is more accurate for small sets
+    if (estimate <= 2.5 * registers && zeros > 0) {
+        estimate = registers * std::log(registers / zeros);
+    }
+    return static_cast<uint64_t>(estimate + 0.5);
+}
+
+/**
+ * Writes the set to a checkpoint.
+ * @param out The checkpoint.
+ */
+void hyperloglog::save(checkpoint_writer &out) const {
+    checkpoint_save(out, sparse);
+    checkpoint_save(out, dense);
+}
+
+/**
+ * Restores the set from a checkpoint, see save.
+ * @param in The checkpoint.
+ */
+void hyperloglog::load(checkpoint_reader &in) {
+    checkpoint_load(in, sparse);
+    checkpoint_load(in, dense);
+}
+
+count_min_sketch::count_min_sketch() : total(0) {}
+
+/**
+ * Adds to the count of a key. The counters are allocated with the first count.
+ * @param key The 64 bit hash of the key.
+ * @param count The count to add.
+ */
+void count_min_sketch::add(uint64_t key, uint64_t count) {
+    if (counters.empty()) {
+        counters.assign(static_cast<std::size_t>(CMS_WIDTH) * CMS_DEPTH, 0);
+    }
+    for (std::size_t row = 0; row < CMS_DEPTH; row++) {
+        uint64_t column = mix_bits(key + row * 0x9e3779b97f4a7c15ULL) % CMS_WIDTH;
+        counters[row * CMS_WIDTH + column] += count;
+    }
+    total += count;
+}
+
+/**
+ * Adds the counts of another sketch to this sketch.
+ * @param other The other sketch.
+ */
+void count_min_sketch::merge(const count_min_sketch &other) {
+    if (other.counters.empty()) {
+        return;
+    }
+    if (counters.empty()) {
+        counters = other.counters;
+    } else {
+        for (std::size_t i = 0; i < counters.size(); i++) {
+            counters[i] += other.counters[i];
+        }
+    }
+    total += other.total;
+}
+
+/**
+ * @param key The 64 bit hash of the key.
+ * @return the estimated count of the key, which is never lower than the true count, see CMS_WIDTH.
+ */
+uint64_t count_min_sketch::estimate(uint64_t key) const {
+    if (counters.empty()) {
+        return 0;
+    }
+    uint64_t estimate = std::numeric_limits<uint64_t>::max();
+    for (std::size_t row = 0; row < CMS_DEPTH; row++) {
+        uint64_t column = mix_bits(key + row * 0x9e3779b97f4a7c15ULL) % CMS_WIDTH;
+        estimate = std::min(estimate, counters[row * CMS_WIDTH + column]);
+    }
+    return estimate;
+}
+
+/**
+ * @return the amount by which an estimate exceeds the true count at most, with a probability of 1 - e^-CMS_DEPTH.
+ */
+uint64_t count_min_sketch::get_error_bound() const {
+    return static_cast<uint64_t>(std::ceil(std::exp(1.0) / CMS_WIDTH * static_cast<double>(total)));
+}
+
+/**
+ * Writes the counters to a checkpoint.
+ * @param out The checkpoint.
+ */
+void count_min_sketch::save(checkpoint_writer &out) const {
+    checkpoint_save(out, counters);
+    checkpoint_save(out, total);
+}
+
+/**
+ * Restores the counters from a checkpoint, see save.
+ * @param in The checkpoint.
+ */
+void count_min_sketch::load(checkpoint_reader &in) {
+    checkpoint_load(in, counters);
+    checkpoint_load(in, total);
+}
+
+/**
+ * Counts a value of a distribution of a host.
+ * @param distribution The distribution.
+ * @param ipAddress The IP address of the host.
+ * @param value The value, for SKETCH_PORT see encode_port.
+ */
+void statistics_sketch::add_value(sketch_distribution distribution, const std::string &ipAddress, uint32_t value) {
+    uint64_t addressHash = hash_address(ipAddress);
+    uint64_t key = value_key(distribution, addressHash, value);
+    counts.add(key, 1);
+
+    std::vector<uint32_t> &values = hosts[ipAddress].values[distribution];
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+        return;
+    }
+    if (values.size() < SKETCH_MAX_HOST_VALUES) {
+        values.push_back(value);
+        return;
+    }
+    std::size_t lowest = 0;
+    uint64_t lowestCount = std::numeric_limits<uint64_t>::max();
+    for (std::size_t i = 0; i < values.size(); i++) {
+        uint64_t count = counts.estimate(value_key(distribution, addressHash, values[i]));
+        if (count < lowestCount) {
+            lowest = i;
+            lowestCount = count;
+        }
+    }
+    if (counts.estimate(key) > lowestCount) {
+        values[lowest] = value;
+    }
+}
+
+/**
+ * Counts the bytes of a packet sent or received with a port by a host.
+ * @param ipAddress The IP address of the host.
+ * @param portValue The port, see encode_port.
+ * @param packetSize The size of the packet.
+ */
+void statistics_sketch::add_bytes(const std::string &ipAddress, uint32_t portValue, uint64_t packetSize) {
+    bytes.add(value_key(SKETCH_PORT, hash_address(ipAddress), portValue), packetSize);
+}
+
+/**
+ * Registers that a host contacted another host or was contacted by it.
+ * @param ipAddress The IP address of the host.
+ * @param peer The IP address of the other host.
+ * @param outgoing Whether the host contacted the other host.
+ */
+void statistics_sketch::add_contact(const std::string &ipAddress, const std::string &peer, bool outgoing) {
+    entry_sketchHost &host = hosts[ipAddress];
+    uint64_t peerHash = hash_address(peer);
+    if (outgoing) {
+        host.contacted_out.add(peerHash);
+    } else {
+        host.contacted_in.add(peerHash);
+    }
+    host.contacted.add(peerHash);
+}
+
+/**
+ * Keeps the SKETCH_MAX_HOST_VALUES values of a host with the highest estimated counts.
+ * @param distribution The distribution of the values.
+ * @param ipAddress The IP address of the host.
+ * @param values The values of the host.
+ */
+void statistics_sketch::trim_values(sketch_distribution distribution, const std::string &ipAddress,
+                                    std::vector<uint32_t> &values) {
+    if (values.size() <= SKETCH_MAX_HOST_VALUES) {
+        return;
+    }
+    uint64_t addressHash = hash_address(ipAddress);
+    std::vector<std::pair<uint64_t, uint32_t>> ranked;
+    for (uint32_t value: values) {
+        ranked.push_back(std::make_pair(counts.estimate(value_key(distribution, addressHash, value)), value));
+    }
+    std::sort(ranked.begin(), ranked.end(), has_higher_count);
+    values.clear();
+    for (std::size_t i = 0; i < SKETCH_MAX_HOST_VALUES; i++) {
+        values.push_back(ranked[i].second);
+    }
+}
+
+/**
+ * Adds the statistics of another sketch to this sketch, e.g. of another shard or chunk.
+ * @param other The other sketch.
+ */
+void statistics_sketch::merge(const statistics_sketch &other) {
+    counts.merge(other.counts);
+    bytes.merge(other.bytes);
+    for (auto &otherHost: other.hosts) {
+        entry_sketchHost &host = hosts[otherHost.first];
+        host.contacted_out.merge(otherHost.second.contacted_out);
+        host.contacted_in.merge(otherHost.second.contacted_in);
+        host.contacted.merge(otherHost.second.contacted);
+        for (int distribution = 0; distribution < SKETCH_DISTRIBUTIONS; distribution++) {
+            std::vector<uint32_t> &values = host.values[distribution];
+            for (uint32_t value: otherHost.second.values[distribution]) {
+                if (std::find(values.begin(), values.end(), value) == values.end()) {
+                    values.push_back(value);
+                }
+            }
+            trim_values(static_cast<sketch_distribution>(distribution), otherHost.first, values);
+        }
+    }
+}
+
+/**
+ * @return the estimated number of packets of a host with a value, which is never lower than the true number.
+ */
+uint64_t statistics_sketch::estimate_count(sketch_distribution distribution, const std::string &ipAddress,
+                                           uint32_t value) const {
+    return counts.estimate(value_key(distribution, hash_address(ipAddress), value));
+}
+
+/**
+ * @return the estimated number of bytes of a host sent or received with a port, never lower than the true number.
+ */
+uint64_t statistics_sketch::estimate_bytes(const std::string &ipAddress, uint32_t portValue) const {
+    return bytes.estimate(value_key(SKETCH_PORT, hash_address(ipAddress), portValue));
+}
+
+/**
+ * @return the amount by which an estimated packet count exceeds the true count at most, with a probability of
+ * 1 - e^-CMS_DEPTH.
+ */
+uint64_t statistics_sketch::get_count_error_bound() const {
+    return counts.get_error_bound();
+}
+
+/**
+ * @return the sketched statistics of every host.
+ */
+const std::unordered_map<std::string, entry_sketchHost> &statistics_sketch::get_hosts() const {
+    return hosts;
+}
+
+/**
+ * Encodes a port with its traffic direction and transport protocol as a value of SKETCH_PORT.
+ * @param port The port number.
+ * @param incoming Whether the host received the packet.
+ * @param udp Whether the packet is a UDP packet, otherwise it is a TCP packet.
+ * @return the encoded value.
+ */
+uint32_t statistics_sketch::encode_port(int port, bool incoming, bool udp) {
+    return (static_cast<uint32_t>(port) & 0xffff) | (incoming ? 1u << 16 : 0u) | (udp ? 1u << 17 : 0u);
+}
+
+/**
+ * Writes the sketches and the listed values of every host to a checkpoint.
+ * @param out The checkpoint.
+ */
+void statistics_sketch::save(checkpoint_writer &out) const {
+    counts.save(out);
+    bytes.save(out);
+    checkpoint_save(out, hosts);
+}
+
+/**
+ * Restores the sketches from a checkpoint, see save.
+ * @param in The checkpoint.
+ */
+void statistics_sketch::load(checkpoint_reader &in) {
+    counts.load(in);
+    bytes.load(in);
+    checkpoint_load(in, hosts);
+}
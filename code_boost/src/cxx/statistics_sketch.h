@@ -0,0 +1,141 @@
+/**
+ * Sketches keeping approximate per-host statistics in bounded memory: HyperLogLog for the number of distinct
+ * contacted hosts and Count-Min Sketch for the per-host value distributions.
+ */
+
+#ifndef CPP_PCAPREADER_STATISTICS_SKETCH_H
+#define CPP_PCAPREADER_STATISTICS_SKETCH_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * HyperLogLog with 2^HLL_PRECISION registers, the standard error of its estimates is 1.04 / sqrt(HLL_REGISTERS),
+ * about 3.3%. Up to HLL_SPARSE_LIMIT distinct hashes are kept exactly, so that small sets are counted exactly and
+ * only take a few bytes.
+ */
+#define HLL_PRECISION 10
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+#define HLL_SPARSE_LIMIT 64
+
+/*
+ * Count-Min Sketch with CMS_DEPTH rows of CMS_WIDTH counters. An estimate exceeds the true count by at most
+ * e / CMS_WIDTH times the total of all counts (about 0.001%) with a probability of 1 - e^-CMS_DEPTH (98%).
+ */
+#define CMS_WIDTH (1 << 18)
+#define CMS_DEPTH 4
+
+/*
+ * Number of values of a distribution which are listed per host. Once a host has more distinct values, a new value
+ * replaces the listed value with the lowest estimated count, if its own estimate is higher.
+ */
+#define SKETCH_MAX_HOST_VALUES 32
+
+class checkpoint_writer;
+class checkpoint_reader;
+
+class hyperloglog {
+public:
+    hyperloglog();
+
+    void add(uint64_t hash);
+
+    void merge(const hyperloglog &other);
+
+    uint64_t estimate() const;
+
+    void save(checkpoint_writer &out) const;
+
+    void load(checkpoint_reader &in);
+
+private:
+    std::vector<uint64_t> sparse;
+    std::vector<uint8_t> dense;
+
+    void add_dense(uint64_t hash);
+
+    void make_dense();
+};
+
+class count_min_sketch {
+public:
+    count_min_sketch();
+
+    void add(uint64_t key, uint64_t count);
+
+    void merge(const count_min_sketch &other);
+
+    uint64_t estimate(uint64_t key) const;
+
+    uint64_t get_error_bound() const;
+
+    void save(checkpoint_writer &out) const;
+
+    void load(checkpoint_reader &in);
+
+private:
+    std::vector<uint64_t> counters;
+    uint64_t total;
+};
+
+/*
+ * Per-host distributions kept in the sketch
+ */
+enum sketch_distribution {
+    SKETCH_TTL,
+    SKETCH_MSS,
+    SKETCH_WIN,
+    SKETCH_TOS,
+    SKETCH_PORT,
+    SKETCH_DISTRIBUTIONS
+};
+
+/*
+ * Struct used to represent the sketched statistics of a host:
+ * - Hosts contacted by the host
+ * - Hosts which contacted the host
+ * - Hosts contacted by or which contacted the host
+ * - Listed values of every distribution, see SKETCH_MAX_HOST_VALUES
+ */
+struct entry_sketchHost {
+    hyperloglog contacted_out;
+    hyperloglog contacted_in;
+    hyperloglog contacted;
+    std::vector<uint32_t> values[SKETCH_DISTRIBUTIONS];
+};
+
+class statistics_sketch {
+public:
+    void add_value(sketch_distribution distribution, const std::string &ipAddress, uint32_t value);
+
+    void add_bytes(const std::string &ipAddress, uint32_t portValue, uint64_t packetSize);
+
+    void add_contact(const std::string &ipAddress, const std::string &peer, bool outgoing);
+
+    void merge(const statistics_sketch &other);
+
+    uint64_t estimate_count(sketch_distribution distribution, const std::string &ipAddress, uint32_t value) const;
+
+    uint64_t estimate_bytes(const std::string &ipAddress, uint32_t portValue) const;
+
+    uint64_t get_count_error_bound() const;
+
+    const std::unordered_map<std::string, entry_sketchHost> &get_hosts() const;
+
+    static uint32_t encode_port(int port, bool incoming, bool udp);
+
+    void save(checkpoint_writer &out) const;
+
+    void load(checkpoint_reader &in);
+
+private:
+    count_min_sketch counts;
+    count_min_sketch bytes;
+    std::unordered_map<std::string, entry_sketchHost> hosts;
+
+    void trim_values(sketch_distribution distribution, const std::string &ipAddress, std::vector<uint32_t> &values);
+};
+
+#endif //CPP_PCAPREADER_STATISTICS_SKETCH_H
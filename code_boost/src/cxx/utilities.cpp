@@ -191,6 +191,35 @@ bool check_tcpChecksum(const std::string &ipAddressSender, const std::string &ip
     return (calculatedChecsum == checksum);
 }
 
+/**
+ * Checks the TCP checksum of a raw TCP segment.
+ * @param ipAddressSender The source IP in host byte order.
+ * @param ipAddressReceiver The destination IP in host byte order.
+ * @param segment Pointer to the TCP header, followed by the TCP payload.
+ * @param segmentSize The size of the TCP header and payload.
+ */
+bool check_tcpChecksum(uint32_t ipAddressSender, uint32_t ipAddressReceiver, const uint8_t *segment, uint32_t segmentSize) {
+    uint16_t checksum = static_cast<uint16_t>((segment[16] << 8) | segment[17]);
+
+    // TCP pseudo header: addresses, protocol and TCP length
+    u32 sum = (ipAddressSender >> 16) + (ipAddressSender & 0xFFFF)
+              + (ipAddressReceiver >> 16) + (ipAddressReceiver & 0xFFFF)
+              + 6 + (segmentSize & 0xFFFF);
+
+    // Sum up all 16 bit words with the checksum field treated as zero, pad an odd trailing byte
+    for (uint32_t i = 0; i + 1 < segmentSize; i += 2) {
+        if (i != 16)
+            sum += static_cast<u16>((segment[i] << 8) | segment[i + 1]);
+    }
+    if (segmentSize % 2 != 0)
+        sum += static_cast<u16>(segment[segmentSize - 1] << 8);
+
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return static_cast<u16>(~sum) == checksum;
+}
+
 PYBIND11_MODULE (libcpputils, m) {
     m.def("getIPv4Class", getIPv4Class, "");
 }
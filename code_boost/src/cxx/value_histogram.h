@@ -0,0 +1,176 @@
+/**
+ * Histograms of the 8 and 16 bit header values (TTL, ToS, window size, MSS and ports): dense arrays for the
+ * distributions of the whole capture, sparse arrays switching to dense ones for the distributions of single hosts.
+ */
+
+#ifndef CPP_PCAPREADER_VALUE_HISTOGRAM_H
+#define CPP_PCAPREADER_VALUE_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define HISTOGRAM_BYTE_VALUES 256
+#define HISTOGRAM_SHORT_VALUES 65536
+
+// Number of values kept in a host histogram itself, before further values are allocated
+#define HISTOGRAM_INLINE_VALUES 4
+// A sparse histogram becomes dense when it holds more than this fraction of all values
+#define HISTOGRAM_DENSE_FRACTION 8
+
+/*
+ * Counts of the values 0 to Width - 1 in one array, which is allocated when the first value is counted.
+ * Width has to be a power of two, values of wider fields are folded into the range.
+ */
+template<uint32_t Width>
+class dense_histogram {
+public:
+    dense_histogram() : distinct(0) {}
+
+    void increment(uint32_t value) {
+        if (counts.empty()) {
+            counts.assign(Width, 0);
+        }
+        if (counts[value & (Width - 1)]++ == 0) {
+            distinct++;
+        }
+    }
+
+    void add(uint32_t value, int count) {
+        if (count == 0) {
+            return;
+        }
+        if (counts.empty()) {
+            counts.assign(Width, 0);
+        }
+        int &current = counts[value & (Width - 1)];
+        if (current == 0) {
+            distinct++;
+        }
+        current += count;
+    }
+
+    dense_histogram &operator+=(const dense_histogram &other) {
+        for (std::size_t value = 0; value < other.counts.size(); value++) {
+            add(static_cast<uint32_t>(value), other.counts[value]);
+        }
+        return *this;
+    }
+
+    /*
+     * Returns the number of distinct values counted
+     */
+    std::size_t size() const { return distinct; }
+
+    /*
+     * Returns the count of every value, empty if no value was counted yet
+     */
+    const std::vector<int> &get_counts() const { return counts; }
+
+    void clear() {
+        std::vector<int>().swap(counts);
+        distinct = 0;
+    }
+
+private:
+    std::vector<int> counts;
+    std::size_t distinct;
+};
+
+/*
+ * Counts of the values 0 to Width - 1 of one host. Hosts usually send few distinct values, so the first
+ * HISTOGRAM_INLINE_VALUES values are kept in the histogram itself, further ones as sorted (value, count) pairs, until
+ * more than Width / HISTOGRAM_DENSE_FRACTION values are counted and one array of all values takes less memory per
+ * value. Width has to be a power of two, values of wider fields are folded into the range.
+ */
+template<uint32_t Width>
+class adaptive_histogram {
+public:
+    typedef std::pair<uint32_t, int> entry;
+
+    adaptive_histogram() : inlineCount(0) {}
+
+    /*
+     * Returns the count of a value, which is added with count 0 if it was not counted before
+     */
+    int &operator[](uint32_t value) {
+        value &= Width - 1;
+        for (uint32_t i = 0; i < inlineCount; i++) {
+            if (inlineValues[i].first == value) {
+                return inlineValues[i].second;
+            }
+        }
+        if (inlineCount < HISTOGRAM_INLINE_VALUES) {
+            inlineValues[inlineCount] = entry(value, 0);
+            return inlineValues[inlineCount++].second;
+        }
+        if (!dense.empty()) {
+            return dense[value];
+        }
+        auto found = std::lower_bound(sparse.begin(), sparse.end(), entry(value, 0), compare_value);
+        if (found != sparse.end() && found->first == value) {
+            return found->second;
+        }
+        if (inlineCount + sparse.size() + 1 > Width / HISTOGRAM_DENSE_FRACTION) {
+            // The inline values stay where they are, the dense array holds all other values
+            dense.assign(Width, 0);
+            for (const entry &counted: sparse) {
+                dense[counted.first] = counted.second;
+            }
+            std::vector<entry>().swap(sparse);
+            return dense[value];
+        }
+        return sparse.insert(found, entry(value, 0))->second;
+    }
+
+    int count(uint32_t value) const {
+        value &= Width - 1;
+        for (uint32_t i = 0; i < inlineCount; i++) {
+            if (inlineValues[i].first == value) {
+                return inlineValues[i].second;
+            }
+        }
+        if (!dense.empty()) {
+            return dense[value];
+        }
+        auto found = std::lower_bound(sparse.begin(), sparse.end(), entry(value, 0), compare_value);
+        return found != sparse.end() && found->first == value ? found->second : 0;
+    }
+
+    adaptive_histogram &operator+=(const adaptive_histogram &other) {
+        for (const entry &counted: other.get_values()) {
+            (*this)[counted.first] += counted.second;
+        }
+        return *this;
+    }
+
+    /*
+     * Returns the values with a count other than 0 and their counts, ordered by value
+     */
+    std::vector<entry> get_values() const {
+        std::vector<entry> values(inlineValues, inlineValues + inlineCount);
+        for (std::size_t value = 0; value < dense.size(); value++) {
+            if (dense[value] != 0) {
+                values.push_back(entry(static_cast<uint32_t>(value), dense[value]));
+            }
+        }
+        values.insert(values.end(), sparse.begin(), sparse.end());
+        values.erase(std::remove_if(values.begin(), values.end(), is_zero), values.end());
+        std::sort(values.begin(), values.end(), compare_value);
+        return values;
+    }
+
+private:
+    static bool compare_value(const entry &a, const entry &b) { return a.first < b.first; }
+
+    static bool is_zero(const entry &counted) { return counted.second == 0; }
+
+    entry inlineValues[HISTOGRAM_INLINE_VALUES];
+    uint32_t inlineCount;
+    std::vector<entry> sparse;
+    std::vector<int> dense;
+};
+
+#endif //CPP_PCAPREADER_VALUE_HISTOGRAM_H
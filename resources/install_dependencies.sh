@@ -1,7 +1,7 @@
 #!/bin/bash
 
 DEB_PKGS=''
-RPM_PKGS="cmake make tcpdump coreutils gcc gcc-c++ libpcap-devel python3 python3-devel"
+RPM_PKGS="cmake make tcpdump coreutils gcc gcc-c++ libpcap-devel zlib-devel xz-devel libzstd-devel python3 python3-devel"
 YES=''
 PATCH_DIR=../../../resources/patches
 
@@ -17,7 +17,7 @@ done
 
 install_pkg_arch()
 {
-    PACMAN_PKGS="gcc make cmake python python-pip sqlite tcpdump cairo"
+    PACMAN_PKGS="gcc make cmake python python-pip sqlite tcpdump cairo zlib xz zstd"
 
     # Check first to avoid unnecessary sudo
     echo -e "Packages: Checking..."
@@ -95,7 +95,7 @@ install_pkg_suse()
 
 install_pkg_ubuntu()
 {
-    APT_PKGS='build-essential cmake python3-dev python3-pip python3-venv sqlite tcpdump libpcap-dev libcairo2-dev'
+    APT_PKGS='build-essential cmake python3-dev python3-pip python3-venv sqlite tcpdump libpcap-dev zlib1g-dev liblzma-dev libzstd-dev libcairo2-dev'
 
     if [ "$OS" = 'ubuntu' ] && [ "$VERSION" = '16.04' ]; then
         DEB_LIBTINS='libtins-dev'
@@ -123,7 +123,7 @@ install_pkg_ubuntu()
 
 install_pkg_darwin()
 {
-    BREW_PKGS="cmake python coreutils libdnet libtins sqlite cairo"
+    BREW_PKGS="cmake python coreutils libdnet libtins sqlite cairo xz zstd"
 
     # Check first to avoid unnecessary update
     echo -e "Packages: Checking..."